@@ -83,19 +83,20 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
     double* lumpedMat_p = lumpedMat.getExpandedVectorReference(wantreal).data();
 
     if (funcspace==DUDLEY_POINTS) {
+        const index_t* colorOffsets = elements->borrowColorOffsets();
+        const index_t* coloredElements = elements->borrowColoredElements();
 #pragma omp parallel
         {
             for (int color=elements->minColor; color<=elements->maxColor; color++) {
-                // loop over all elements
+                // loop over the elements of this colour
 #pragma omp for
-                for (index_t e=0; e<elements->numElements; e++) {
-                    if (elements->Color[e]==color) {
-                        const double* D_p = D.getSampleDataRO(e, wantreal);
-                        util::addScatter(1,
-                                      &p.DOF[elements->Nodes[INDEX2(0,e,p.NN)]],
-                                      p.numEqu, D_p, lumpedMat_p,
-                                      p.DOF_UpperBound);
-                    } // end color check
+                for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                    const index_t e = coloredElements[k];
+                    const double* D_p = D.getSampleDataRO(e, wantreal);
+                    util::addScatter(1,
+                                  &p.DOF[elements->Nodes[INDEX2(0,e,p.NN)]],
+                                  p.numEqu, D_p, lumpedMat_p,
+                                  p.DOF_UpperBound);
                 } // end element loop
             } // end color loop
         } // end parallel region
@@ -105,6 +106,8 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
         if (!getQuadShape(elements->numDim, reducedIntegrationOrder, &S)) {
             throw DudleyException("Assemble_LumpedSystem: Unable to locate shape function.");
         }
+        const index_t* colorOffsets = elements->borrowColorOffsets();
+        const index_t* coloredElements = elements->borrowColoredElements();
 #pragma omp parallel
         {
             std::vector<double> EM_lumpedMat(p.numShapes * p.numEqu);
@@ -113,88 +116,86 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
             if (p.numEqu == 1) { // single equation
                 if (expandedD) { // with expanded D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                const double vol = p.jac->absD[e] * p.jac->quadweight;
-                                const double* D_p = D.getSampleDataRO(e, wantreal);
-                                if (useHRZ) {
-                                    double m_t = 0; // mass of the element
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            const double vol = p.jac->absD[e] * p.jac->quadweight;
+                            const double* D_p = D.getSampleDataRO(e, wantreal);
+                            if (useHRZ) {
+                                double m_t = 0; // mass of the element
+                                for (int q = 0; q < p.numQuad; q++)
+                                    m_t += vol * D_p[INDEX2(q, 0, p.numQuad)];
+                                double diagS = 0;  // diagonal sum
+                                double rtmp;
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    rtmp = 0.;
                                     for (int q = 0; q < p.numQuad; q++)
-                                        m_t += vol * D_p[INDEX2(q, 0, p.numQuad)];
-                                    double diagS = 0;  // diagonal sum
-                                    double rtmp;
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        rtmp = 0.;
-                                        for (int q = 0; q < p.numQuad; q++)
-                                            rtmp +=
-                                                vol * D_p[INDEX2(q, 0, p.numQuad)] * S[INDEX2(s, q, p.numShapes)] *
-                                                S[INDEX2(s, q, p.numShapes)];
-                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
-                                        diagS += rtmp;
-                                    }
-                                    // rescale diagonals by m_t/diagS to ensure
-                                    // consistent mass over element
-                                    rtmp = m_t / diagS;
-                                    for (int s = 0; s < p.numShapes; s++)
-                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
-                                } else { // row-sum lumping
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        double rtmp = 0.;
-                                        for (int q = 0; q < p.numQuad; q++)
-                                            rtmp += vol * S[INDEX2(s, q, p.numShapes)] * D_p[INDEX2(q, 0, p.numQuad)];
-                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
-                                    }
+                                        rtmp +=
+                                            vol * D_p[INDEX2(q, 0, p.numQuad)] * S[INDEX2(s, q, p.numShapes)] *
+                                            S[INDEX2(s, q, p.numShapes)];
+                                    EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
+                                    diagS += rtmp;
+                                }
+                                // rescale diagonals by m_t/diagS to ensure
+                                // consistent mass over element
+                                rtmp = m_t / diagS;
+                                for (int s = 0; s < p.numShapes; s++)
+                                    EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
+                            } else { // row-sum lumping
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    double rtmp = 0.;
+                                    for (int q = 0; q < p.numQuad; q++)
+                                        rtmp += vol * S[INDEX2(s, q, p.numShapes)] * D_p[INDEX2(q, 0, p.numQuad)];
+                                    EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
                                 }
-                                for (int q = 0; q < p.numShapes; q++)
-                                    row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
-                                util::addScatter(p.numShapes, &row_index[0],
-                                       p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
-                                       p.DOF_UpperBound);
-                            } // end color check
+                            }
+                            for (int q = 0; q < p.numShapes; q++)
+                                row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
+                            util::addScatter(p.numShapes, &row_index[0],
+                                   p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
+                                   p.DOF_UpperBound);
                         } // end element loop
                     } // end color loop
                 } else { // with constant D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                const double vol = p.jac->absD[e] * p.jac->quadweight;
-                                const double* D_p = D.getSampleDataRO(e, wantreal);
-                                if (useHRZ) { // HRZ lumping
-                                    // mass of the element
-                                    const double m_t = vol*p.numQuad;
-                                    double diagS = 0; // diagonal sum
-                                    double rtmp;
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        rtmp = 0.;
-                                        for (int q = 0; q < p.numQuad; q++) {
-                                            rtmp += vol * S[INDEX2(s, q, p.numShapes)] * S[INDEX2(s, q, p.numShapes)];
-                                        }
-                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
-                                        diagS += rtmp;
-                                    }
-                                    // rescale diagonals by m_t/diagS to ensure
-                                    // consistent mass over element
-                                    rtmp = m_t / diagS * D_p[0];
-                                    for (int s = 0; s < p.numShapes; s++)
-                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
-                                } else { // row-sum lumping
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        double rtmp = 0.;
-                                        for (int q = 0; q < p.numQuad; q++)
-                                            rtmp += vol * S[INDEX2(s, q, p.numShapes)];
-                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp * D_p[0];
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            const double vol = p.jac->absD[e] * p.jac->quadweight;
+                            const double* D_p = D.getSampleDataRO(e, wantreal);
+                            if (useHRZ) { // HRZ lumping
+                                // mass of the element
+                                const double m_t = vol*p.numQuad;
+                                double diagS = 0; // diagonal sum
+                                double rtmp;
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    rtmp = 0.;
+                                    for (int q = 0; q < p.numQuad; q++) {
+                                        rtmp += vol * S[INDEX2(s, q, p.numShapes)] * S[INDEX2(s, q, p.numShapes)];
                                     }
+                                    EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
+                                    diagS += rtmp;
+                                }
+                                // rescale diagonals by m_t/diagS to ensure
+                                // consistent mass over element
+                                rtmp = m_t / diagS * D_p[0];
+                                for (int s = 0; s < p.numShapes; s++)
+                                    EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
+                            } else { // row-sum lumping
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    double rtmp = 0.;
+                                    for (int q = 0; q < p.numQuad; q++)
+                                        rtmp += vol * S[INDEX2(s, q, p.numShapes)];
+                                    EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp * D_p[0];
                                 }
-                                for (int q = 0; q < p.numShapes; q++)
-                                    row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
-                                util::addScatter(p.numShapes, &row_index[0],
-                                       p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
-                                       p.DOF_UpperBound);
-                            } // end color check
+                            }
+                            for (int q = 0; q < p.numShapes; q++)
+                                row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
+                            util::addScatter(p.numShapes, &row_index[0],
+                                   p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
+                                   p.DOF_UpperBound);
                         } // end element loop
                     } // end color loop
                 }
@@ -202,100 +203,98 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
             } else { // system of equations
                 if (expandedD) { // with expanded D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                const double vol = p.jac->absD[e] * p.jac->quadweight;
-                                const double* D_p = D.getSampleDataRO(e, wantreal);
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            const double vol = p.jac->absD[e] * p.jac->quadweight;
+                            const double* D_p = D.getSampleDataRO(e, wantreal);
 
-                                if (useHRZ) { // HRZ lumping
-                                    for (int k = 0; k < p.numEqu; k++) {
-                                        double m_t = 0; // mass of the element
-                                        for (int q = 0; q < p.numQuad; q++)
-                                            m_t += vol * D_p[INDEX3(k, q, 0, p.numEqu, p.numQuad)];
+                            if (useHRZ) { // HRZ lumping
+                                for (int k = 0; k < p.numEqu; k++) {
+                                    double m_t = 0; // mass of the element
+                                    for (int q = 0; q < p.numQuad; q++)
+                                        m_t += vol * D_p[INDEX3(k, q, 0, p.numEqu, p.numQuad)];
 
-                                        double diagS = 0; // diagonal sum
-                                        double rtmp;
-                                        for (int s = 0; s < p.numShapes; s++) {
-                                            rtmp = 0.;
-                                            for (int q = 0; q < p.numQuad; q++)
-                                                rtmp +=
-                                                    vol * D_p[INDEX3(k, q, 0, p.numEqu, p.numQuad)] *
-                                                    S[INDEX2(s, q, p.numShapes)] * S[INDEX2(s, q, p.numShapes)];
-                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
-                                            diagS += rtmp;
-                                        }
-                                        // rescale diagonals by m_t/diagS to
-                                        // ensure consistent mass over element
-                                        rtmp = m_t / diagS;
-                                        for (int s = 0; s < p.numShapes; s++)
-                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] *= rtmp;
-                                    }
-                                } else { // row-sum lumping
+                                    double diagS = 0; // diagonal sum
+                                    double rtmp;
                                     for (int s = 0; s < p.numShapes; s++) {
-                                        for (int k = 0; k < p.numEqu; k++) {
-                                            double rtmp = 0.;
-                                            for (int q = 0; q < p.numQuad; q++)
-                                                rtmp +=
-                                                    vol * S[INDEX2(s, q, p.numShapes)] *
-                                                    D_p[INDEX3(k, q, 0, p.numEqu, p.numQuad)];
-                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
-                                        }
+                                        rtmp = 0.;
+                                        for (int q = 0; q < p.numQuad; q++)
+                                            rtmp +=
+                                                vol * D_p[INDEX3(k, q, 0, p.numEqu, p.numQuad)] *
+                                                S[INDEX2(s, q, p.numShapes)] * S[INDEX2(s, q, p.numShapes)];
+                                        EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
+                                        diagS += rtmp;
+                                    }
+                                    // rescale diagonals by m_t/diagS to
+                                    // ensure consistent mass over element
+                                    rtmp = m_t / diagS;
+                                    for (int s = 0; s < p.numShapes; s++)
+                                        EM_lumpedMat[INDEX2(k, s, p.numEqu)] *= rtmp;
+                                }
+                            } else { // row-sum lumping
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    for (int k = 0; k < p.numEqu; k++) {
+                                        double rtmp = 0.;
+                                        for (int q = 0; q < p.numQuad; q++)
+                                            rtmp +=
+                                                vol * S[INDEX2(s, q, p.numShapes)] *
+                                                D_p[INDEX3(k, q, 0, p.numEqu, p.numQuad)];
+                                        EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
                                     }
                                 }
-                                for (int q = 0; q < p.numShapes; q++)
-                                    row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
-                                util::addScatter(p.numShapes, &row_index[0],
-                                       p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
-                                       p.DOF_UpperBound);
-                            } // end color check
+                            }
+                            for (int q = 0; q < p.numShapes; q++)
+                                row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
+                            util::addScatter(p.numShapes, &row_index[0],
+                                   p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
+                                   p.DOF_UpperBound);
                         } // end element loop
                     } // end color loop
                 } else { // with constant D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                const double vol = p.jac->absD[e] * p.jac->quadweight;
-                                const double* D_p = D.getSampleDataRO(e, wantreal);
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            const double vol = p.jac->absD[e] * p.jac->quadweight;
+                            const double* D_p = D.getSampleDataRO(e, wantreal);
 
-                                if (useHRZ) { // HRZ lumping
-                                    double m_t = vol * p.numQuad; // mass of the element
-                                    double diagS = 0; // diagonal sum
-                                    double rtmp;
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        rtmp = 0.;
+                            if (useHRZ) { // HRZ lumping
+                                double m_t = vol * p.numQuad; // mass of the element
+                                double diagS = 0; // diagonal sum
+                                double rtmp;
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    rtmp = 0.;
+                                    for (int q = 0; q < p.numQuad; q++)
+                                        rtmp += vol * S[INDEX2(s, q, p.numShapes)] * S[INDEX2(s, q, p.numShapes)];
+                                    for (int k = 0; k < p.numEqu; k++)
+                                        EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
+                                    diagS += rtmp;
+                                }
+                                // rescale diagonals by m_t/diagS to ensure
+                                // consistent mass over element
+                                rtmp = m_t / diagS;
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    for (int k = 0; k < p.numEqu; k++)
+                                        EM_lumpedMat[INDEX2(k, s, p.numEqu)] *= rtmp * D_p[k];
+                                }
+                            } else { // row-sum lumping
+                                for (int s = 0; s < p.numShapes; s++) {
+                                    for (int k = 0; k < p.numEqu; k++) {
+                                        double rtmp = 0.;
                                         for (int q = 0; q < p.numQuad; q++)
-                                            rtmp += vol * S[INDEX2(s, q, p.numShapes)] * S[INDEX2(s, q, p.numShapes)];
-                                        for (int k = 0; k < p.numEqu; k++)
-                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
-                                        diagS += rtmp;
-                                    }
-                                    // rescale diagonals by m_t/diagS to ensure
-                                    // consistent mass over element
-                                    rtmp = m_t / diagS;
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        for (int k = 0; k < p.numEqu; k++)
-                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] *= rtmp * D_p[k];
-                                    }
-                                } else { // row-sum lumping
-                                    for (int s = 0; s < p.numShapes; s++) {
-                                        for (int k = 0; k < p.numEqu; k++) {
-                                            double rtmp = 0.;
-                                            for (int q = 0; q < p.numQuad; q++)
-                                                rtmp += vol * S[INDEX2(s, q, p.numShapes)];
-                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp * D_p[k];
-                                        }
+                                            rtmp += vol * S[INDEX2(s, q, p.numShapes)];
+                                        EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp * D_p[k];
                                     }
                                 }
-                                for (int q = 0; q < p.numShapes; q++)
-                                    row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
-                                util::addScatter(p.numShapes, &row_index[0],
-                                       p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
-                                       p.DOF_UpperBound);
-                            } // end color check
+                            }
+                            for (int q = 0; q < p.numShapes; q++)
+                                row_index[q] = p.DOF[elements->Nodes[INDEX2(q, e, p.NN)]];
+                            util::addScatter(p.numShapes, &row_index[0],
+                                   p.numEqu, &EM_lumpedMat[0], lumpedMat_p,
+                                   p.DOF_UpperBound);
                         } // end element loop
                     } // end color loop
                 }
@@ -54,30 +54,31 @@ void Assemble_PDE_Points(const AssembleParameters& p,
         F_p = p.F.getSampleDataRW(0, zero);
     }
 
+    const index_t* colorOffsets = p.elements->borrowColorOffsets();
+    const index_t* coloredElements = p.elements->borrowColoredElements();
 #pragma omp parallel
     {
         std::vector<index_t> rowIndex(1);
         std::vector<Scalar> values(p.numEqu*p.numEqu);
 
         for (index_t color = p.elements->minColor; color <= p.elements->maxColor; color++) {
-            // loop over all elements
+            // loop over the elements of this colour
 #pragma omp for
-            for (index_t e = 0; e < p.elements->numElements; e++) {
-                if (p.elements->Color[e] == color) {
-                    rowIndex[0] = p.DOF[p.elements->Nodes[INDEX2(0,e,p.NN)]];
-                    if (!y_dirac.isEmpty()) {
-                        const Scalar* y_dirac_p = y_dirac.getSampleDataRO(e, zero);
-                        util::addScatter(1, &rowIndex[0], p.numEqu,
-                                         y_dirac_p, F_p, p.DOF_UpperBound);
-                    }
+            for (index_t k = colorOffsets[color-p.elements->minColor]; k < colorOffsets[color-p.elements->minColor+1]; k++) {
+                const index_t e = coloredElements[k];
+                rowIndex[0] = p.DOF[p.elements->Nodes[INDEX2(0,e,p.NN)]];
+                if (!y_dirac.isEmpty()) {
+                    const Scalar* y_dirac_p = y_dirac.getSampleDataRO(e, zero);
+                    util::addScatter(1, &rowIndex[0], p.numEqu,
+                                     y_dirac_p, F_p, p.DOF_UpperBound);
+                }
                    
-                    if (!d_dirac.isEmpty()) {
-                        const Scalar* EM_S = d_dirac.getSampleDataRO(e, zero);
-                        values.assign(EM_S, EM_S+p.numEqu*p.numEqu);
-                        Assemble_addToSystemMatrix(p.S, rowIndex, p.numEqu,
-                                                   values);
-                    }
-                } // end color check
+                if (!d_dirac.isEmpty()) {
+                    const Scalar* EM_S = d_dirac.getSampleDataRO(e, zero);
+                    values.assign(EM_S, EM_S+p.numEqu*p.numEqu);
+                    Assemble_addToSystemMatrix(p.S, rowIndex, p.numEqu,
+                                               values);
+                }
             } // end element loop
         } // end color loop
     } // end parallel region
@@ -21,6 +21,8 @@
 #include <paso/SystemMatrix.h>
 #endif
 
+#include <algorithm>
+
 #ifdef ESYS_HAVE_TRILINOS
 #include <trilinoswrap/TrilinosMatrixAdapter.h>
 
@@ -33,6 +35,18 @@ using escript::DataTypes::real_t;
 using escript::DataTypes::cplx_t;
 
 #ifdef ESYS_HAVE_PASO
+/// returns the position of `idx` in the index range [begin, end) of a paso
+/// pattern or -1 if the entry is not in the pattern. paso::Pattern keeps the
+/// indices of each row sorted so a binary search can be used which is much
+/// faster than a linear scan for higher order elements and systems.
+static inline index_t findInPattern(const index_t* index, index_t begin,
+                                    index_t end, index_t idx)
+{
+    const index_t* last = index + end;
+    const index_t* p = std::lower_bound(index + begin, last, idx);
+    return (p != last && *p == idx ? p - index : -1);
+}
+
 static void addToSystemMatrixPasoCSC(paso::SystemMatrix* S,
                                      const std::vector<index_t>& Nodes,
                                      int numEq,
@@ -125,21 +139,20 @@ void addToSystemMatrixPasoCSC(paso::SystemMatrix* in,
                     for (int l_row = 0; l_row < num_subblocks_Eq; ++l_row) {
                         const index_t i_row = j_Eq * num_subblocks_Eq + index_offset + l_row;
                         if (i_row < numMyRows + index_offset) {
-                            for (index_t k = mainBlock_ptr[i_col]-index_offset;
-                                 k < mainBlock_ptr[i_col + 1]-index_offset; ++k) {
-                                if (mainBlock_index[k] == i_row) {
-                                    // Entry array(k_Eq, j_Sol) is a block
-                                    // (col_block_size x col_block_size)
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir + row_block_size * l_row;
-                                            mainBlock_val[k*block_size + ir + row_block_size*ic] +=
-                                                array[INDEX4
-                                                  (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
-                                        }
+                            const index_t k = findInPattern(mainBlock_index,
+                                    mainBlock_ptr[i_col]-index_offset,
+                                    mainBlock_ptr[i_col + 1]-index_offset, i_row);
+                            if (k >= 0) {
+                                // Entry array(k_Eq, j_Sol) is a block
+                                // (col_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        mainBlock_val[k*block_size + ir + row_block_size*ic] +=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
                                     }
-                                    break;
                                 }
                             }
                         } else {
@@ -168,19 +181,18 @@ void addToSystemMatrixPasoCSC(paso::SystemMatrix* in,
                     for (int l_row = 0; l_row < num_subblocks_Eq; ++l_row) {
                         const index_t i_row = j_Eq * num_subblocks_Eq + index_offset + l_row;
                         if (i_row < numMyRows + index_offset) {
-                            for (index_t k = col_coupleBlock_ptr[i_col-numMyCols]-index_offset;
-                                 k < col_coupleBlock_ptr[i_col - numMyCols + 1] - index_offset; ++k) {
-                                if (col_coupleBlock_index[k] == i_row) {
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir + row_block_size * l_row;
-                                            col_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
-                                                array[INDEX4
-                                                  (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
-                                        }
+                            const index_t k = findInPattern(col_coupleBlock_index,
+                                    col_coupleBlock_ptr[i_col-numMyCols]-index_offset,
+                                    col_coupleBlock_ptr[i_col - numMyCols + 1] - index_offset, i_row);
+                            if (k >= 0) {
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        col_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
                                     }
-                                    break;
                                 }
                             }
                         }
@@ -218,62 +230,61 @@ void addToSystemMatrixPasoCSR(paso::SystemMatrix* in,
     for (int k_Eq = 0; k_Eq < NN; ++k_Eq) { // Down columns of array
         const index_t j_Eq = Nodes[k_Eq];
         for (int l_row = 0; l_row < num_subblocks_Eq; ++l_row) {
-        const index_t i_row = j_Eq * num_subblocks_Eq + l_row;
-        // only look at the matrix rows stored on this processor
-        if (i_row < numMyRows) {
-            for (int k_Sol = 0; k_Sol < NN; ++k_Sol) { // Across rows of array
-            const index_t j_Sol = Nodes[k_Sol];
-            for (int l_col = 0; l_col < num_subblocks_Sol; ++l_col) {
-                // only look at the matrix rows stored on this processor
-                const index_t i_col = j_Sol * num_subblocks_Sol + index_offset + l_col;
-                if (i_col < numMyCols + index_offset) {
-                    for (index_t k = mainBlock_ptr[i_row] - index_offset;
-                         k < mainBlock_ptr[i_row + 1] - index_offset; ++k) {
-                        if (mainBlock_index[k] == i_col) {
-                            // Entry array(k_Sol, j_Eq) is a block
-                            // (row_block_size x col_block_size)
-                            for (int ic = 0; ic < col_block_size; ++ic) {
-                                const int i_Sol = ic + col_block_size * l_col;
-                                for (int ir = 0; ir < row_block_size; ++ir) {
-                                    const int i_Eq = ir + row_block_size * l_row;
-                                    mainBlock_val[k*block_size + ir + row_block_size*ic] +=
-                                        array[INDEX4
-                                          (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
+            const index_t i_row = j_Eq * num_subblocks_Eq + l_row;
+            // only look at the matrix rows stored on this processor
+            if (i_row < numMyRows) {
+                for (int k_Sol = 0; k_Sol < NN; ++k_Sol) { // Across rows of array
+                    const index_t j_Sol = Nodes[k_Sol];
+                    for (int l_col = 0; l_col < num_subblocks_Sol; ++l_col) {
+                        // only look at the matrix rows stored on this processor
+                        const index_t i_col = j_Sol * num_subblocks_Sol + index_offset + l_col;
+                        if (i_col < numMyCols + index_offset) {
+                            const index_t k = findInPattern(mainBlock_index,
+                                    mainBlock_ptr[i_row] - index_offset,
+                                    mainBlock_ptr[i_row + 1] - index_offset, i_col);
+                            if (k >= 0) {
+                                // Entry array(k_Sol, j_Eq) is a block
+                                // (row_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        mainBlock_val[k*block_size + ir + row_block_size*ic] +=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
+                                    }
                                 }
                             }
-                            break;
-                        }
-                    }
-                } else {
-                    for (index_t k = col_coupleBlock_ptr[i_row] - index_offset;
-                         k < col_coupleBlock_ptr[i_row + 1] - index_offset; ++k) {
-                        if (col_coupleBlock_index[k] == i_col - numMyCols) {
-                            // Entry array(k_Sol, j_Eq) is a block
-                            // (row_block_size x col_block_size)
-                            for (int ic = 0; ic < col_block_size; ++ic) {
-                                const int i_Sol = ic + col_block_size * l_col;
-                                for (int ir = 0; ir < row_block_size; ++ir) {
-                                    const int i_Eq = ir+row_block_size*l_row;
-                                    col_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
-                                        array[INDEX4
-                                          (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
+                        } else {
+                            const index_t k = findInPattern(col_coupleBlock_index,
+                                    col_coupleBlock_ptr[i_row] - index_offset,
+                                    col_coupleBlock_ptr[i_row + 1] - index_offset, i_col - numMyCols);
+                            if (k >= 0) {
+                                // Entry array(k_Sol, j_Eq) is a block
+                                // (row_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir+row_block_size*l_row;
+                                        col_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
                                     }
                                 }
-                                break;
                             }
                         }
                     }
                 }
-            }
-        } else {
-            for (int k_Sol = 0; k_Sol < NN; ++k_Sol) { // Across rows of array
-                const index_t j_Sol = Nodes[k_Sol];
-                for (int l_col = 0; l_col < num_subblocks_Sol; ++l_col) {
-                    const index_t i_col = j_Sol * num_subblocks_Sol + index_offset + l_col;
-                    if (i_col < numMyCols + index_offset) {
-                        for (index_t k = row_coupleBlock_ptr[i_row - numMyRows] - index_offset;
-                             k < row_coupleBlock_ptr[i_row - numMyRows + 1] - index_offset; ++k) {
-                            if (row_coupleBlock_index[k] == i_col) {
+            } else {
+                for (int k_Sol = 0; k_Sol < NN; ++k_Sol) { // Across rows of array
+                    const index_t j_Sol = Nodes[k_Sol];
+                    for (int l_col = 0; l_col < num_subblocks_Sol; ++l_col) {
+                        const index_t i_col = j_Sol * num_subblocks_Sol + index_offset + l_col;
+                        if (i_col < numMyCols + index_offset) {
+                            const index_t k = findInPattern(row_coupleBlock_index,
+                                    row_coupleBlock_ptr[i_row - numMyRows] - index_offset,
+                                    row_coupleBlock_ptr[i_row - numMyRows + 1] - index_offset, i_col);
+                            if (k >= 0) {
                                 // Entry array(k_Sol, j_Eq) is a block
                                 // (row_block_size x col_block_size)
                                 for (int ic = 0; ic < col_block_size; ++ic) {
@@ -283,9 +294,7 @@ void addToSystemMatrixPasoCSR(paso::SystemMatrix* in,
                                         row_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
                                             array[INDEX4
                                               (i_Eq, i_Sol, k_Eq, k_Sol, numEq, numEq, NN)];
-                                        }
                                     }
-                                    break;
                                 }
                             }
                         }
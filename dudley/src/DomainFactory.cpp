@@ -94,8 +94,10 @@ inline void cleanupAndThrow(DudleyDomain* dom, string msg)
 
 Domain_ptr DudleyDomain::load(const string& fileName)
 {
-#ifdef ESYS_HAVE_NETCDF
     JMPI mpiInfo = makeInfo(MPI_COMM_WORLD);
+    if (isCheckpointFile(fileName, mpiInfo))
+        return loadBinary(fileName);
+#ifdef ESYS_HAVE_NETCDF
     const string fName(mpiInfo->appendRankToFileName(fileName));
 
     // Open NetCDF file for reading
@@ -365,8 +367,10 @@ Domain_ptr DudleyDomain::load(const string& fileName)
 
 Domain_ptr DudleyDomain::load(const string& fileName)
 {
-#ifdef ESYS_HAVE_NETCDF
     JMPI mpiInfo = makeInfo(MPI_COMM_WORLD);
+    if (isCheckpointFile(fileName, mpiInfo))
+        return loadBinary(fileName);
+#ifdef ESYS_HAVE_NETCDF
     const string fName(mpiInfo->appendRankToFileName(fileName));
 
     // Open NetCDF file for reading
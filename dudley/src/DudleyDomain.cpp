@@ -22,6 +22,7 @@
 
 #include <escript/Data.h>
 #include <escript/DataFactory.h>
+#include <escript/EscriptParams.h>
 #include <escript/Random.h>
 #include <escript/SolverOptions.h>
 
@@ -2124,6 +2125,12 @@ void DudleyDomain::prepare(bool optimize)
         optimizeDOFDistribution(distribution);
         distributeByRankOfDOF(distribution);
     }
+    // nodes and DOFs can be renumbered along a space-filling curve for
+    // better memory locality. The elements follow the nodes in
+    // optimizeElementOrdering() below.
+    if (escript::escriptParams.getHilbertOrdering()) {
+        optimizeNodeOrdering(distribution);
+    }
     // the local labelling of the degrees of freedom is optimized
     if (optimize) {
         optimizeDOFLabeling(distribution);
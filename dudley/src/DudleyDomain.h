@@ -87,11 +87,23 @@ class DudleyDomain : public escript::AbstractContinuousDomain
 public:
     /**
      \brief
-     recovers domain from a dump file
+     recovers domain from a dump file. Binary checkpoint files written by
+     dumpBinary() are detected and passed on to loadBinary().
      \param filename the name of the file
     */
     static escript::Domain_ptr load(const std::string& filename);
 
+    /**
+     \brief
+     recovers domain from a binary checkpoint file written by dumpBinary().
+     If the number of ranks matches the number used for writing, the
+     distribution, DOF labelling and element colouring are restored as they
+     were. Otherwise the domain is repartitioned along the DOF labelling of
+     the checkpoint without running the optimizer.
+     \param filename the name of the file
+    */
+    static escript::Domain_ptr loadBinary(const std::string& filename);
+
     /**
      \brief
      reads a mesh from a fly file. For MPI parallel runs fans out the mesh
@@ -264,6 +276,15 @@ public:
     */
     void dump(const std::string& fileName) const;
 
+    /**
+     \brief
+     writes the mesh to a single binary checkpoint file which can be
+     restored on any number of ranks. All ranks write their part
+     collectively.
+     \param fileName Input - The name of the file
+    */
+    void dumpBinary(const std::string& fileName) const;
+
     /**
      \brief
      Return the tag key for the given sample number.
@@ -704,6 +725,11 @@ public:
 #endif
 
 private:
+    /// returns true if fileName starts with the checkpoint magic written by
+    /// dumpBinary(). The test is done on rank 0 and broadcast.
+    static bool isCheckpointFile(const std::string& fileName,
+                                 escript::JMPI mpiInfo);
+
     void prepare(bool optimize);
 
     /// Initially the element nodes refer to the numbering defined by the
@@ -724,6 +750,9 @@ private:
     void markNodes(std::vector<short>& mask, index_t offset) const;
     void optimizeDOFDistribution(IndexVector& distribution);
     void optimizeDOFLabeling(const IndexVector& distribution);
+    /// renumbers the local nodes and the DOFs of this rank along a Hilbert
+    /// curve through the node coordinates
+    void optimizeNodeOrdering(const IndexVector& distribution);
     void optimizeElementOrdering();
     void updateTagList();
     void printElementInfo(const ElementFile* e, const std::string& title,
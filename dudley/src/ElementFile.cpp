@@ -23,6 +23,7 @@
 namespace dudley {
 
 ElementFile::ElementFile(ElementTypeId type, escript::JMPI mpiInfo) :
+    colorOrderingValid(false),
     MPIInfo(mpiInfo),
     numElements(0),
     Id(NULL),
@@ -57,6 +58,7 @@ void ElementFile::allocTable(dim_t NE)
         freeTable();
 
     numElements = NE;
+    colorOrderingValid = false;
     Owner = new int[numElements];
     Id = new index_t[numElements];
     Nodes = new index_t[numElements * numNodes];
@@ -87,6 +89,7 @@ void ElementFile::freeTable()
     delete[] Color;
     tagsInUse.clear();
     numElements = 0;
+    colorOrderingValid = false;
     maxColor = -1;
     minColor = 0;
 }
@@ -146,6 +149,7 @@ void ElementFile::gather(const index_t* index, const ElementFile* in)
     }
     minColor = std::min(minColor, in->minColor + maxColor + 1);
     maxColor = std::max(maxColor, in->maxColor + maxColor + 1);
+    colorOrderingValid = false;
 }
 
 void ElementFile::swapTable(ElementFile* other)
@@ -158,6 +162,8 @@ void ElementFile::swapTable(ElementFile* other)
     std::swap(Color, other->Color);
     std::swap(minColor, other->minColor);
     std::swap(maxColor, other->maxColor);
+    colorOrderingValid = false;
+    other->colorOrderingValid = false;
     std::swap(tagsInUse, other->tagsInUse);
 }
 
@@ -186,6 +192,7 @@ void ElementFile::optimizeOrdering()
 
     out->gather(index, this);
     swapTable(out);
+    updateColorOrdering();
     delete out;
     delete[] index;
 }
@@ -246,5 +253,28 @@ void ElementFile::relabelNodes(const index_t* newNode, index_t offset)
     }
 }
 
+void ElementFile::updateColorOrdering() const
+{
+    const dim_t numColors = std::max(maxColor-minColor+1, index_t(0));
+    colorOffsets.assign(numColors+1, 0);
+    // counting sort by colour, elements without a valid colour are skipped
+    // as they are by the colour loops
+    for (index_t e = 0; e < numElements; e++) {
+        const index_t c = Color[e]-minColor;
+        if (c >= 0 && c < numColors)
+            colorOffsets[c+1]++;
+    }
+    for (index_t c = 0; c < numColors; c++)
+        colorOffsets[c+1] += colorOffsets[c];
+    coloredElements.resize(colorOffsets[numColors]);
+    IndexVector pos(colorOffsets.begin(), colorOffsets.end()-1);
+    for (index_t e = 0; e < numElements; e++) {
+        const index_t c = Color[e]-minColor;
+        if (c >= 0 && c < numColors)
+            coloredElements[pos[c]++] = e;
+    }
+    colorOrderingValid = true;
+}
+
 } // namespace dudley
 
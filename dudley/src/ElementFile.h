@@ -103,9 +103,33 @@ public:
 
     inline void updateTagList();
 
+    /// sorts the elements by colour into a contiguous list so assembly
+    /// loops only visit the elements of the current colour. This is called
+    /// by createColoring() and optimizeOrdering() and otherwise happens on
+    /// first use after the element table has been changed. Code that
+    /// modifies Color directly after that has to call this method again.
+    void updateColorOrdering() const;
+
+    /// returns the offsets of the colours into borrowColoredElements(), the
+    /// elements of colour c are at positions
+    /// offsets[c-minColor] to offsets[c-minColor+1]-1.
+    /// Must not be called from within a parallel region.
+    inline const index_t* borrowColorOffsets() const;
+
+    /// returns the element indices sorted by colour (see borrowColorOffsets).
+    /// Must not be called from within a parallel region.
+    inline const index_t* borrowColoredElements() const;
+
 private:
     void swapTable(ElementFile* other);
 
+    /// element indices sorted by colour
+    mutable IndexVector coloredElements;
+    /// offsets of the colours in coloredElements
+    mutable IndexVector colorOffsets;
+    /// true if coloredElements and colorOffsets match Color
+    mutable bool colorOrderingValid;
+
 public:
     escript::JMPI MPIInfo;
 
@@ -177,6 +201,20 @@ inline void ElementFile::updateTagList()
     util::setValuesInUse(Tag, numElements, tagsInUse, MPIInfo);
 }
 
+inline const index_t* ElementFile::borrowColorOffsets() const
+{
+    if (!colorOrderingValid)
+        updateColorOrdering();
+    return &colorOffsets[0];
+}
+
+inline const index_t* ElementFile::borrowColoredElements() const
+{
+    if (!colorOrderingValid)
+        updateColorOrdering();
+    return coloredElements.empty() ? NULL : &coloredElements[0];
+}
+
 
 } // namespace dudley
 
@@ -18,10 +18,24 @@
 #include "ElementFile.h"
 #include "Util.h"
 
+#include <escript/EscriptParams.h>
 #include <escript/index.h>
 
+#include <cstdint>
+#include <vector>
+
 namespace dudley {
 
+/// pseudo-random but reproducible priority of element e used by the
+/// colouring (splitmix64 finaliser)
+static inline uint64_t colorPriority(index_t e)
+{
+    uint64_t z = static_cast<uint64_t>(e) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
 void ElementFile::createColoring(dim_t nNodes, const index_t* dofMap)
 {
     if (numElements < 1)
@@ -35,53 +49,138 @@ void ElementFile::createColoring(dim_t nNodes, const index_t* dofMap)
     const int NN = numNodes;
     const dim_t len = idRange.second - idRange.first + 1;
 
+    // build the lists of elements touching each DOF
+    IndexVector dofElementPtr(len + 1, 0);
+    IndexVector dofElements(numElements * NN);
 #pragma omp parallel for
-    for (index_t e = 0; e < numElements; e++)
-        Color[e] = -1;
+    for (index_t e = 0; e < numElements; e++) {
+        for (int i = 0; i < NN; i++) {
+#ifdef BOUNDS_CHECK
+            ESYS_ASSERT(Nodes[INDEX2(i, e, NN)] >= 0, "BOUNDS_CHECK");
+            ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first < len, "BOUNDS_CHECK");
+            ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first >= 0, "BOUNDS_CHECK");
+#endif
+            const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+#pragma omp atomic
+            dofElementPtr[dof + 1]++;
+        }
+    }
+    for (index_t n = 0; n < len; n++)
+        dofElementPtr[n + 1] += dofElementPtr[n];
+    {
+        IndexVector pos(dofElementPtr.begin(), dofElementPtr.end() - 1);
+#pragma omp parallel for
+        for (index_t e = 0; e < numElements; e++) {
+            for (int i = 0; i < NN; i++) {
+                const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+                index_t k;
+#pragma omp atomic capture
+                k = pos[dof]++;
+                dofElements[k] = e;
+            }
+        }
+    }
 
-    dim_t numUncoloredElements = numElements;
+    // Jones-Plassmann colouring: in every round the uncoloured elements
+    // with a higher priority than all their uncoloured neighbours form an
+    // independent set and are coloured concurrently. The priorities only
+    // depend on the element index so the result does not depend on the
+    // number of threads.
+    const bool balanced = (escript::getEscriptParamInt("BALANCED_COLORING") > 0);
+    IndexVector uncolored(numElements);
+    std::vector<char> selected(numElements, 0);
+#pragma omp parallel for
+    for (index_t e = 0; e < numElements; e++) {
+        Color[e] = -1;
+        uncolored[e] = e;
+    }
+    std::vector<dim_t> colorCount;
     minColor = 0;
     maxColor = -1;
-    index_t* maskDOF = new index_t[len];
-    while (numUncoloredElements > 0) {
-        // initialize the mask marking nodes used by a color
+
+    while (!uncolored.empty()) {
+        const dim_t numUncolored = uncolored.size();
 #pragma omp parallel for
-        for (index_t n = 0; n < len; n++)
-            maskDOF[n] = -1;
-        numUncoloredElements = 0;
+        for (index_t k = 0; k < numUncolored; k++) {
+            const index_t e = uncolored[k];
+            const uint64_t prio = colorPriority(e);
+            bool isMax = true;
+            for (int i = 0; i < NN && isMax; i++) {
+                const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+                for (index_t j = dofElementPtr[dof]; j < dofElementPtr[dof + 1]; j++) {
+                    const index_t f = dofElements[j];
+                    if (f != e && Color[f] < 0) {
+                        const uint64_t fprio = colorPriority(f);
+                        if (fprio > prio || (fprio == prio && f > e)) {
+                            isMax = false;
+                            break;
+                        }
+                    }
+                }
+            }
+            selected[e] = isMax;
+        }
 
-        for (index_t e = 0; e < numElements; e++) {
-            if (Color[e] < 0) {
-                // find out if element e is independent from the elements
-                // already colored:
-                bool independent = true;
+        // the selected elements are not neighbours of each other so their
+        // colours can be chosen independently
+        const dim_t numColors = maxColor + 1;
+#pragma omp parallel
+        {
+            // forbidden[c]==e marks colour c as used by a neighbour of e
+            IndexVector forbidden(numColors + 1, -1);
+#pragma omp for
+            for (index_t k = 0; k < numUncolored; k++) {
+                const index_t e = uncolored[k];
+                if (!selected[e])
+                    continue;
                 for (int i = 0; i < NN; i++) {
-#ifdef BOUNDS_CHECK
-                    ESYS_ASSERT(Nodes[INDEX2(i, e, NN)] >= 0, "BOUNDS_CHECK");
-                    ESYS_ASSERT(Nodes[INDEX2(i, e, NN)] < nNodes, "BOUNDS_CHECK");
-                    ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first < len, "BOUNDS_CHECK");
-                    ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first >= 0, "BOUNDS_CHECK");
-#endif
-                    if (maskDOF[dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first] > 0)
-                    {
-                        independent = false;
-                        break;
+                    const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+                    for (index_t j = dofElementPtr[dof]; j < dofElementPtr[dof + 1]; j++) {
+                        const index_t c = Color[dofElements[j]];
+                        if (c >= 0) {
+                            if (c >= static_cast<index_t>(forbidden.size()))
+                                forbidden.resize(c + 1, -1);
+                            forbidden[c] = e;
+                        }
+                    }
+                }
+                index_t color = -1;
+                if (balanced) {
+                    // pick the least used colour that is still available
+                    for (index_t c = 0; c < numColors; c++) {
+                        if (forbidden[c] != e && (color < 0 ||
+                                    colorCount[c] < colorCount[color]))
+                            color = c;
                     }
                 }
-                // if e is independent a new color is assigned and the nodes
-                // are marked as being used
-                if (independent) {
-                    for (int i = 0; i < NN; i++)
-                        maskDOF[dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first] = 1;
-                    Color[e] = maxColor + 1;
-                } else {
-                    numUncoloredElements++;
+                if (color < 0) {
+                    color = 0;
+                    while (color < static_cast<index_t>(forbidden.size()) &&
+                        forbidden[color] == e)
+                        color++;
+                }
+                Color[e] = color;
+            }
+        }
+
+        // remove the coloured elements from the list
+        IndexVector remaining;
+        for (index_t k = 0; k < numUncolored; k++) {
+            const index_t e = uncolored[k];
+            if (selected[e]) {
+                const index_t c = Color[e];
+                if (c > maxColor) {
+                    maxColor = c;
+                    colorCount.resize(c + 1, 0);
                 }
+                colorCount[c]++;
+            } else {
+                remaining.push_back(e);
             }
-        } // for all elements
-        maxColor++;
-    } // end of while loop
-    delete[] maskDOF;
+        }
+        uncolored.swap(remaining);
+    }
+    updateColorOrdering();
 }
 
 } // namespace dudley
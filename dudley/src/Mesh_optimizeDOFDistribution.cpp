@@ -17,6 +17,9 @@
 
 #include "DudleyDomain.h"
 #include "IndexList.h"
+#include "Util.h"
+
+#include <escript/EscriptParams.h>
 
 #include <escript/index.h>
 
@@ -27,6 +30,7 @@ typedef float real_t;
 #endif
 #endif
 
+#include <algorithm>
 #include <boost/scoped_array.hpp>
 
 namespace dudley {
@@ -58,7 +62,112 @@ static bool allRanksHaveNodes(escript::JMPI mpiInfo,
 }
 #endif
 
-/// optimizes the distribution of DOFs across processors using ParMETIS.
+/// partitions the vertices by cutting a Hilbert curve through their
+/// coordinates into mpiSize pieces with (almost) the same number of vertices.
+/// Pieces of a space-filling curve are compact so the number of vertices
+/// shared with other ranks stays small.
+static void partitionAlongHilbertCurve(const NodeFile* nodes,
+                                       escript::JMPI mpiInfo,
+                                       const IndexVector& distribution,
+                                       index_t* partition)
+{
+    const int mpiSize = mpiInfo->size;
+    const int myRank = mpiInfo->rank;
+    const index_t myFirstVertex = distribution[myRank];
+    const dim_t myNumVertices = distribution[myRank + 1] - myFirstVertex;
+    const dim_t numNodes = nodes->getNumNodes();
+    const int dim = nodes->numDim;
+    const int bits = (dim == 1 ? 32 : 63 / dim);
+
+    // get the coordinates of the vertices
+    std::vector<double> xyz(myNumVertices * dim);
+#pragma omp parallel for
+    for (index_t i = 0; i < numNodes; ++i) {
+        const index_t k = nodes->globalDegreesOfFreedom[i] - myFirstVertex;
+        if (k >= 0 && k < myNumVertices) {
+            for (int j = 0; j < dim; ++j)
+                xyz[INDEX2(j, k, dim)] = nodes->Coordinates[INDEX2(j, i, dim)];
+        }
+    }
+
+    // get the global bounding box
+    double lo[3], hi[3], scale[3];
+    for (int j = 0; j < dim; ++j) {
+        lo[j] = std::numeric_limits<double>::max();
+        hi[j] = -std::numeric_limits<double>::max();
+    }
+    for (index_t k = 0; k < myNumVertices; ++k) {
+        for (int j = 0; j < dim; ++j) {
+            lo[j] = std::min(lo[j], xyz[INDEX2(j, k, dim)]);
+            hi[j] = std::max(hi[j], xyz[INDEX2(j, k, dim)]);
+        }
+    }
+#ifdef ESYS_MPI
+    double lo_local[3], hi_local[3];
+    std::copy(lo, lo + dim, lo_local);
+    std::copy(hi, hi + dim, hi_local);
+    MPI_Allreduce(lo_local, lo, dim, MPI_DOUBLE, MPI_MIN, mpiInfo->comm);
+    MPI_Allreduce(hi_local, hi, dim, MPI_DOUBLE, MPI_MAX, mpiInfo->comm);
+#endif
+    const double maxGrid = static_cast<double>((uint64_t(1) << bits) - 1);
+    for (int j = 0; j < dim; ++j)
+        scale[j] = (hi[j] > lo[j] ? maxGrid / (hi[j] - lo[j]) : 0.);
+
+    std::vector<uint64_t> key(myNumVertices);
+#pragma omp parallel for
+    for (index_t k = 0; k < myNumVertices; ++k)
+        key[k] = util::hilbertKey(&xyz[INDEX2(0, k, dim)], dim, lo, scale, bits);
+    std::vector<uint64_t> sortedKey(key);
+    std::sort(sortedKey.begin(), sortedKey.end());
+
+    // the curve is cut before the smallest key which has at least
+    // p*globalNumVertices/mpiSize vertices in front of it, p=1,...,mpiSize-1.
+    // The cuts are found by bisection over the keys using one reduction per
+    // bit of the key.
+    const dim_t globalNumVertices = distribution[mpiSize];
+    std::vector<uint64_t> cut(mpiSize - 1, 0);
+    if (mpiSize > 1) {
+        std::vector<uint64_t> cutHi(mpiSize - 1, uint64_t(1) << (dim * bits));
+        IndexVector target(mpiSize - 1);
+        IndexVector count(mpiSize - 1);
+        IndexVector globalCount(mpiSize - 1);
+        for (int p = 0; p < mpiSize - 1; ++p) {
+            target[p] = static_cast<index_t>(
+                    static_cast<double>(globalNumVertices) * (p + 1) / mpiSize);
+        }
+        for (int b = 0; b <= dim * bits; ++b) {
+            for (int p = 0; p < mpiSize - 1; ++p) {
+                const uint64_t mid = cut[p] + (cutHi[p] - cut[p]) / 2;
+                count[p] = std::lower_bound(sortedKey.begin(), sortedKey.end(),
+                                            mid) - sortedKey.begin();
+            }
+#ifdef ESYS_MPI
+            MPI_Allreduce(&count[0], &globalCount[0], mpiSize - 1, MPI_DIM_T,
+                          MPI_SUM, mpiInfo->comm);
+#else
+            globalCount = count;
+#endif
+            for (int p = 0; p < mpiSize - 1; ++p) {
+                const uint64_t mid = cut[p] + (cutHi[p] - cut[p]) / 2;
+                if (globalCount[p] >= target[p]) {
+                    cutHi[p] = mid;
+                } else {
+                    cut[p] = mid + 1;
+                }
+            }
+        }
+    }
+
+#pragma omp parallel for
+    for (index_t k = 0; k < myNumVertices; ++k) {
+        partition[k] = std::upper_bound(cut.begin(), cut.end(), key[k])
+                            - cut.begin();
+    }
+}
+
+/// optimizes the distribution of DOFs across processors using ParMETIS or,
+/// if it is not available or the BUILTIN_PARTITIONER escript parameter is
+/// set, by cutting a Hilbert curve through the DOF coordinates.
 /// On return a new distribution is given and the globalDOF are relabeled
 /// accordingly but the mesh has not been redistributed yet
 void DudleyDomain::optimizeDOFDistribution(std::vector<index_t>& distribution)
@@ -78,7 +187,8 @@ void DudleyDomain::optimizeDOFDistribution(std::vector<index_t>& distribution)
     index_t* partition = new index_t[len];
 
 #ifdef ESYS_HAVE_PARMETIS
-    if (mpiSize > 1 && allRanksHaveNodes(m_mpiInfo, distribution)) {
+    if (!escript::escriptParams.getBuiltinPartitioner() && mpiSize > 1
+            && allRanksHaveNodes(m_mpiInfo, distribution)) {
         boost::scoped_array<IndexList> index_list(new IndexList[myNumVertices]);
         int dim = m_nodes->numDim;
 
@@ -147,13 +257,11 @@ void DudleyDomain::optimizeDOFDistribution(std::vector<index_t>& distribution)
         delete[] index;
         delete[] ptr;
     } else {
-        for (index_t i = 0; i < myNumVertices; ++i)
-            partition[i] = 0; // CPU 0 owns all
+        partitionAlongHilbertCurve(m_nodes, m_mpiInfo, distribution,
+                                   partition);
     }
 #else
-#pragma omp parallel for
-    for (index_t i = 0; i < myNumVertices; ++i)
-        partition[i] = myRank;
+    partitionAlongHilbertCurve(m_nodes, m_mpiInfo, distribution, partition);
 #endif // ESYS_HAVE_PARMETIS
 
     // create a new distribution and labeling of the DOF
@@ -19,12 +19,605 @@
 
 #include <escript/index.h>
 
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
 using escript::IOError;
 
 namespace dudley {
 
 #define MAX_numNodes_gmsh 20
 
+namespace {
+
+// Binary MSH files are read in parallel. Rank 0 runs a quick index pass over
+// the section headers which only seeks over the record data. Every rank then
+// reads its own contiguous range of node and element records directly from
+// the file and prepare() takes care of the redistribution.
+
+/// a contiguous run of fixed-size node or element records in a binary file
+struct GmshBlock {
+    int64_t offset;      // byte offset of the first record (node tags in 4.1)
+    int64_t coordOffset; // byte offset of the node coordinates (4.1 only)
+    int64_t first;       // global index of the first record
+    int64_t count;       // number of records
+    int64_t gmshType;    // gmsh element type (elements only)
+    int64_t tag;         // entity tag (4.1) or number of tags (2.2)
+};
+
+/// layout of a binary MSH file as found by the index pass
+struct GmshIndex {
+    double version;
+    int sizeT;
+    int64_t numNodes;
+    int64_t numElements;
+    std::vector<GmshBlock> nodeBlocks;
+    std::vector<GmshBlock> elementBlocks;
+    std::vector<std::pair<int, std::string> > names;
+};
+
+/// maps gmsh element type `gmsh_type` to the dudley element type, its
+/// dimension and number of nodes. Returns false for unsupported types.
+bool getElementType(int gmsh_type, ElementTypeId& type, int& dim,
+                    int& numNodes)
+{
+    switch (gmsh_type) {
+        case 1: // line order 1
+            type = Dudley_Line2;
+            dim = 1;
+            numNodes = 2;
+            break;
+        case 2: // triangle order 1
+            type = Dudley_Tri3;
+            dim = 2;
+            numNodes = 3;
+            break;
+        case 4: // tetrahedron order 1
+            type = Dudley_Tet4;
+            dim = 3;
+            numNodes = 4;
+            break;
+        case 15: // point
+            type = Dudley_Point1;
+            dim = 0;
+            numNodes = 1;
+            break;
+        default:
+            type = Dudley_NoRef;
+            dim = -1;
+            numNodes = 0;
+            return false;
+    }
+    return true;
+}
+
+/// returns true if the file looks like a gmsh file in binary format
+bool isBinaryGmsh(const std::string& filename)
+{
+    std::ifstream f(filename.c_str(), std::ios::binary);
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 11, "$MeshFormat") == 0) {
+            double version = 0.;
+            int format = 0;
+            return std::getline(f, line) && sscanf(line.c_str(), "%lf %d",
+                                                   &version, &format) == 2
+                   && format == 1;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+inline T readBinaryValue(std::ifstream& f)
+{
+    T value;
+    f.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!f)
+        throw IOError("readGmsh: early EOF while scanning");
+    return value;
+}
+
+/// reads an unsigned integer of `size` bytes (gmsh's size_t)
+inline int64_t readBinarySize(std::ifstream& f, int size)
+{
+    if (size == 4)
+        return readBinaryValue<uint32_t>(f);
+    return static_cast<int64_t>(readBinaryValue<uint64_t>(f));
+}
+
+/// decodes an integer of `size` bytes from a record buffer
+inline int64_t decodeInt(const char* p, int size)
+{
+    if (size == 4) {
+        int32_t value;
+        memcpy(&value, p, 4);
+        return value;
+    }
+    int64_t value;
+    memcpy(&value, p, 8);
+    return value;
+}
+
+/// skips the binary $Entities section of a MSH 4.1 file
+void skipEntities(std::ifstream& f, int sizeT)
+{
+    int64_t num[4];
+    for (int i = 0; i < 4; i++)
+        num[i] = readBinarySize(f, sizeT);
+    for (int i = 0; i < 4; i++) {
+        for (int64_t j = 0; j < num[i]; j++) {
+            // tag, bounding box (or point coordinates)
+            f.seekg(sizeof(int32_t) + (i == 0 ? 3 : 6) * sizeof(double),
+                    std::ios::cur);
+            const int64_t numPhysicals = readBinarySize(f, sizeT);
+            f.seekg(numPhysicals * sizeof(int32_t), std::ios::cur);
+            if (i > 0) {
+                const int64_t numBounding = readBinarySize(f, sizeT);
+                f.seekg(numBounding * sizeof(int32_t), std::ios::cur);
+            }
+        }
+    }
+}
+
+inline std::string unexpectedType(int gmsh_type, const std::string& filename)
+{
+    std::stringstream ss;
+    ss << "readGmsh: Unexpected gmsh element type " << gmsh_type
+        << " in mesh file " << filename;
+    return ss.str();
+}
+
+/// scans the section headers of binary gmsh file `filename` without reading
+/// the node and element records
+void indexGmsh(const std::string& filename, GmshIndex& index)
+{
+    std::ifstream f(filename.c_str(), std::ios::binary);
+    if (!f) {
+        std::stringstream ss;
+        ss << "readGmsh: opening file " << filename << " for reading failed.";
+        throw IOError(ss.str());
+    }
+    index.version = 0.;
+    index.sizeT = 0;
+    index.numNodes = -1;
+    index.numElements = -1;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] != '$' || line.compare(0, 4, "$End") == 0)
+            continue;
+
+        if (line.compare(0, 11, "$MeshFormat") == 0) {
+            int format = 0, size = 0;
+            if (!std::getline(f, line) || sscanf(line.c_str(), "%lf %d %d",
+                        &index.version, &format, &size) != 3)
+                throw IOError("readGmsh: malformed mesh file ($MeshFormat)");
+            if (index.version >= 4.1) {
+                if (size != 4 && size != 8)
+                    throw IOError("readGmsh: unsupported data size in binary mesh file");
+                index.sizeT = size;
+            } else if (index.version < 2. || index.version >= 3.) {
+                throw IOError("readGmsh: binary mesh files are only supported "
+                              "for format versions 2.2 and 4.1");
+            } else if (size != sizeof(double)) {
+                throw IOError("readGmsh: unsupported data size in binary mesh file");
+            }
+            if (readBinaryValue<int32_t>(f) != 1)
+                throw IOError("readGmsh: binary mesh file was written with a "
+                              "different byte order");
+        } else if (line.compare(0, 6, "$Nodes") == 0) {
+            int64_t numBlocks = 1;
+            if (index.version >= 4.1) {
+                numBlocks = readBinarySize(f, index.sizeT);
+                index.numNodes = readBinarySize(f, index.sizeT);
+                readBinarySize(f, index.sizeT); // min node tag
+                readBinarySize(f, index.sizeT); // max node tag
+            } else {
+                if (!std::getline(f, line))
+                    throw IOError("readGmsh: early EOF while scanning");
+                index.numNodes = std::stoll(line);
+            }
+            int64_t first = 0;
+            for (int64_t b = 0; b < numBlocks; b++) {
+                GmshBlock block = {0, 0, first, index.numNodes, 0, 0};
+                if (index.version >= 4.1) {
+                    readBinaryValue<int32_t>(f); // entity dimension
+                    block.tag = readBinaryValue<int32_t>(f);
+                    if (readBinaryValue<int32_t>(f) != 0)
+                        throw DudleyException("reading gmsh msh4 files using parametric coordinates is not supported yet.");
+                    block.count = readBinarySize(f, index.sizeT);
+                    block.offset = f.tellg();
+                    block.coordOffset = block.offset + block.count*index.sizeT;
+                    f.seekg(block.coordOffset + block.count*3*sizeof(double));
+                } else {
+                    block.offset = f.tellg();
+                    f.seekg(block.offset + block.count*(sizeof(int32_t)
+                                + 3*sizeof(double)));
+                }
+                index.nodeBlocks.push_back(block);
+                first += block.count;
+            }
+            if (first != index.numNodes)
+                throw IOError("readGmsh: malformed meshfile (broken node section)!");
+        } else if (line.compare(0, 9, "$Elements") == 0) {
+            int64_t numBlocks = -1;
+            if (index.version >= 4.1) {
+                numBlocks = readBinarySize(f, index.sizeT);
+                index.numElements = readBinarySize(f, index.sizeT);
+                readBinarySize(f, index.sizeT); // min element tag
+                readBinarySize(f, index.sizeT); // max element tag
+            } else {
+                if (!std::getline(f, line))
+                    throw IOError("readGmsh: early EOF while scanning");
+                index.numElements = std::stoll(line);
+            }
+            // in 2.2 files the number of blocks is implied by the element
+            // counts of the block headers
+            int64_t first = 0;
+            for (int64_t b = 0; b != numBlocks && first < index.numElements; b++) {
+                GmshBlock block = {0, 0, first, 0, 0, 0};
+                int64_t recordSize;
+                ElementTypeId type;
+                int dim, numNodes;
+                if (index.version >= 4.1) {
+                    readBinaryValue<int32_t>(f); // entity dimension
+                    block.tag = readBinaryValue<int32_t>(f);
+                    block.gmshType = readBinaryValue<int32_t>(f);
+                    block.count = readBinarySize(f, index.sizeT);
+                    if (!getElementType(block.gmshType, type, dim, numNodes))
+                        throw IOError(unexpectedType(block.gmshType, filename));
+                    recordSize = (1 + numNodes) * index.sizeT;
+                } else {
+                    block.gmshType = readBinaryValue<int32_t>(f);
+                    block.count = readBinaryValue<int32_t>(f);
+                    block.tag = readBinaryValue<int32_t>(f);
+                    if (!getElementType(block.gmshType, type, dim, numNodes))
+                        throw IOError(unexpectedType(block.gmshType, filename));
+                    recordSize = (1 + block.tag + numNodes) * sizeof(int32_t);
+                }
+                block.offset = f.tellg();
+                f.seekg(block.offset + block.count*recordSize);
+                index.elementBlocks.push_back(block);
+                first += block.count;
+            }
+            if (first != index.numElements)
+                throw IOError("readGmsh: malformed mesh file ($Elements section contains incorrect header information)");
+        } else if (line.compare(0, 14, "$PhysicalNames") == 0) {
+            if (!std::getline(f, line))
+                throw IOError("readGmsh: early EOF while scanning");
+            const int numNames = std::stoi(line);
+            for (int i = 0; i < numNames; i++) {
+                int dim, tag;
+                if (!std::getline(f, line)
+                        || sscanf(line.c_str(), "%d %d", &dim, &tag) != 2)
+                    throw IOError("readGmsh: malformed mesh file ($PhysicalNames)");
+                const size_t start = line.find('"');
+                const size_t end = line.rfind('"');
+                if (start == std::string::npos || end <= start)
+                    throw IOError("readGmsh: illegal tagname (\" missing?)");
+                index.names.push_back(std::make_pair(tag,
+                                    line.substr(start+1, end-start-1)));
+            }
+        } else if (line.compare(0, 9, "$Entities") == 0 && index.version >= 4.1) {
+            skipEntities(f, index.sizeT);
+        }
+
+        // search for end of the section
+        while (std::getline(f, line) && line.compare(0, 4, "$End") != 0);
+        if (!f)
+            throw IOError("readGmsh: early EOF while scanning");
+    }
+    if (index.numNodes < 0)
+        throw IOError("EOF before nodes section found");
+    if (index.numElements < 0)
+        throw IOError("EOF before elements section found");
+}
+
+/// runs the index pass on rank 0 and shares the result with all ranks
+void broadcastGmshIndex(escript::JMPI& mpiInfo, const std::string& filename,
+                        GmshIndex& index)
+{
+    std::string errorMsg;
+    if (mpiInfo->rank == 0) {
+        try {
+            indexGmsh(filename, index);
+        } catch (std::exception& e) {
+            errorMsg = e.what();
+        }
+    }
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1) {
+        // pack everything into a vector of 64-bit integers and a string
+        std::vector<int64_t> header(7);
+        std::string names;
+        if (mpiInfo->rank == 0) {
+            header[0] = errorMsg.size();
+            header[1] = index.sizeT;
+            header[2] = index.nodeBlocks.size();
+            header[3] = index.elementBlocks.size();
+            std::stringstream ss;
+            for (size_t i = 0; i < index.names.size(); i++)
+                ss << index.names[i].first << " " << index.names[i].second << "\n";
+            names = errorMsg + ss.str();
+            header[4] = names.size();
+            header[5] = index.numNodes;
+            header[6] = index.numElements;
+        }
+        MPI_Bcast(&header[0], 7, MPI_INT64_T, 0, mpiInfo->comm);
+        names.resize(header[4]);
+        if (header[4] > 0)
+            MPI_Bcast(&names[0], header[4], MPI_CHAR, 0, mpiInfo->comm);
+        if (header[0] > 0)
+            throw IOError(names.substr(0, header[0]));
+
+        const int blockSize = sizeof(GmshBlock)/sizeof(int64_t);
+        MPI_Bcast(&index.version, 1, MPI_DOUBLE, 0, mpiInfo->comm);
+        index.sizeT = header[1];
+        index.numNodes = header[5];
+        index.numElements = header[6];
+        index.nodeBlocks.resize(header[2]);
+        index.elementBlocks.resize(header[3]);
+        if (header[2] > 0)
+            MPI_Bcast(&index.nodeBlocks[0], header[2]*blockSize, MPI_INT64_T,
+                      0, mpiInfo->comm);
+        if (header[3] > 0)
+            MPI_Bcast(&index.elementBlocks[0], header[3]*blockSize,
+                      MPI_INT64_T, 0, mpiInfo->comm);
+        if (mpiInfo->rank > 0) {
+            std::stringstream ss(names);
+            int tag;
+            while (ss >> tag) {
+                std::string name;
+                ss.get();
+                std::getline(ss, name);
+                index.names.push_back(std::make_pair(tag, name));
+            }
+        }
+        return;
+    }
+#endif
+    if (!errorMsg.empty())
+        throw IOError(errorMsg);
+}
+
+/// reads `count` bytes at `offset` into buffer
+void readGmshBytes(std::ifstream& f, int64_t offset, int64_t count,
+                   std::vector<char>& buffer)
+{
+    buffer.resize(count);
+    if (count == 0)
+        return;
+    f.seekg(offset);
+    f.read(&buffer[0], count);
+    if (!f)
+        throw IOError("readGmsh: early EOF while reading file");
+}
+
+DudleyDomain* readGmshBinary(escript::JMPI& mpiInfo,
+                             const std::string& filename, int numDim)
+{
+    GmshIndex index;
+    broadcastGmshIndex(mpiInfo, filename, index);
+
+    // the element types follow from the block headers
+    ElementTypeId finalElementType = Dudley_NoRef;
+    ElementTypeId finalFaceElementType = Dudley_NoRef;
+    for (size_t b = 0; b < index.elementBlocks.size(); b++) {
+        ElementTypeId type;
+        int dim, numNodes;
+        if (!getElementType(index.elementBlocks[b].gmshType, type, dim, numNodes))
+            throw IOError(unexpectedType(index.elementBlocks[b].gmshType, filename));
+        if (index.elementBlocks[b].count == 0)
+            continue;
+        if (dim == numDim) {
+            if (finalElementType == Dudley_NoRef) {
+                finalElementType = type;
+            } else if (finalElementType != type) {
+                throw IOError("Dudley can handle a single type of internal "
+                              "elements only.");
+            }
+        } else if (dim == numDim - 1) {
+            if (finalFaceElementType == Dudley_NoRef) {
+                finalFaceElementType = type;
+            } else if (finalFaceElementType != type) {
+                throw IOError("Dudley can handle a single type of face "
+                              "elements only.");
+            }
+        }
+    }
+    if (finalElementType == Dudley_NoRef) {
+        if (numDim == 1) {
+            finalElementType = Dudley_Line2;
+        } else if (numDim == 2) {
+            finalElementType = Dudley_Tri3;
+        } else if (numDim == 3) {
+            finalElementType = Dudley_Tet4;
+        }
+    }
+    if (finalFaceElementType == Dudley_NoRef) {
+        if (numDim == 1) {
+            finalFaceElementType = Dudley_Point1;
+        } else if (numDim == 2) {
+            finalFaceElementType = Dudley_Line2;
+        } else if (numDim == 3) {
+            finalFaceElementType = Dudley_Tri3;
+        }
+    }
+
+    // every rank reads a contiguous range of nodes and elements
+    const int rank = mpiInfo->rank;
+    const int size = mpiInfo->size;
+    const int64_t firstNode = index.numNodes * rank / size;
+    const int64_t lastNode = index.numNodes * (rank+1) / size;
+    const int64_t firstElement = index.numElements * rank / size;
+    const int64_t lastElement = index.numElements * (rank+1) / size;
+    const bool msh4 = (index.version >= 4.1);
+    const int intSize = (msh4 ? index.sizeT : sizeof(int32_t));
+
+    std::vector<index_t> nodeIds(lastNode - firstNode);
+    std::vector<double> coords(3*(lastNode - firstNode));
+    std::vector<index_t> elementIds, faceIds;
+    std::vector<int> elementTags, faceTags;
+    std::vector<index_t> elementNodes, faceNodes;
+    int errorFlag = 0;
+    std::string errorMsg;
+
+    try {
+        std::ifstream f(filename.c_str(), std::ios::binary);
+        if (!f) {
+            std::stringstream ss;
+            ss << "Opening gmsh file " << filename << " for reading failed.";
+            throw IOError(ss.str());
+        }
+        std::vector<char> buffer, coordBuffer;
+        for (size_t b = 0; b < index.nodeBlocks.size(); b++) {
+            const GmshBlock& block = index.nodeBlocks[b];
+            const int64_t start = std::max(firstNode, block.first);
+            const int64_t end = std::min(lastNode, block.first + block.count);
+            if (start >= end)
+                continue;
+            const int64_t n = end - start;
+            const int64_t k0 = start - firstNode;
+            if (msh4) {
+                readGmshBytes(f, block.offset + (start-block.first)*intSize,
+                              n*intSize, buffer);
+                readGmshBytes(f, block.coordOffset + (start-block.first)*3*sizeof(double),
+                              n*3*sizeof(double), coordBuffer);
+                memcpy(&coords[3*k0], &coordBuffer[0], n*3*sizeof(double));
+#pragma omp parallel for
+                for (index_t i = 0; i < n; i++)
+                    nodeIds[k0+i] = decodeInt(&buffer[i*intSize], intSize);
+            } else {
+                const int recordSize = sizeof(int32_t) + 3*sizeof(double);
+                readGmshBytes(f, block.offset + (start-block.first)*recordSize,
+                              n*recordSize, buffer);
+#pragma omp parallel for
+                for (index_t i = 0; i < n; i++) {
+                    const char* record = &buffer[i*recordSize];
+                    nodeIds[k0+i] = decodeInt(record, sizeof(int32_t));
+                    memcpy(&coords[3*(k0+i)], record+sizeof(int32_t),
+                           3*sizeof(double));
+                }
+            }
+        }
+
+        for (size_t b = 0; b < index.elementBlocks.size(); b++) {
+            const GmshBlock& block = index.elementBlocks[b];
+            const int64_t start = std::max(firstElement, block.first);
+            const int64_t end = std::min(lastElement, block.first + block.count);
+            if (start >= end)
+                continue;
+            ElementTypeId type;
+            int dim, numNodes;
+            getElementType(block.gmshType, type, dim, numNodes);
+            std::vector<index_t>* ids = NULL;
+            std::vector<int>* tags = NULL;
+            std::vector<index_t>* nodes = NULL;
+            if (dim == numDim) {
+                ids = &elementIds;
+                tags = &elementTags;
+                nodes = &elementNodes;
+            } else if (dim == numDim - 1) {
+                ids = &faceIds;
+                tags = &faceTags;
+                nodes = &faceNodes;
+            } else {
+                continue;
+            }
+            const int numTags = (msh4 ? 0 : block.tag);
+            const int recordSize = (1 + numTags + numNodes) * intSize;
+            readGmshBytes(f, block.offset + (start-block.first)*recordSize,
+                          (end-start)*recordSize, buffer);
+            for (int64_t e = start; e < end; e++) {
+                const char* record = &buffer[(e-start)*recordSize];
+                // like the ASCII reader use the elementary tag if present
+                int tag = (msh4 ? block.tag : 1);
+                if (numTags > 0)
+                    tag = decodeInt(record + (numTags > 1 ? 2 : 1)*intSize, intSize);
+                const char* vertices = record + (1+numTags)*intSize;
+                ids->push_back(decodeInt(record, intSize));
+                tags->push_back(tag);
+                for (int j = 0; j < numNodes; j++)
+                    nodes->push_back(decodeInt(vertices+j*intSize, intSize));
+            }
+        }
+    } catch (std::exception& e) {
+        errorFlag = 1;
+        errorMsg = e.what();
+    }
+
+#ifdef ESYS_MPI
+    if (size > 1) {
+        int globalError;
+        MPI_Allreduce(&errorFlag, &globalError, 1, MPI_INT, MPI_MAX,
+                      mpiInfo->comm);
+        if (globalError && !errorFlag)
+            errorMsg = "readGmsh: reading the mesh file failed on another rank";
+        errorFlag = globalError;
+    }
+#endif
+    if (errorFlag)
+        throw IOError(errorMsg);
+
+    DudleyDomain* domain = new DudleyDomain(filename, numDim, mpiInfo);
+    for (size_t i = 0; i < index.names.size(); i++)
+        domain->setTagMap(index.names[i].second, index.names[i].first);
+
+    const dim_t numNodes = nodeIds.size();
+    NodeFile* nodeFile = domain->getNodes();
+    nodeFile->allocTable(numNodes);
+#pragma omp parallel for
+    for (index_t i = 0; i < numNodes; i++) {
+        nodeFile->Id[i] = nodeIds[i];
+        nodeFile->globalDegreesOfFreedom[i] = nodeIds[i];
+        nodeFile->Tag[i] = 0;
+        for (int j = 0; j < numDim; j++)
+            nodeFile->Coordinates[INDEX2(j, i, numDim)] = coords[3*i+j];
+    }
+
+    ElementFile* elements = new ElementFile(finalElementType, mpiInfo);
+    domain->setElements(elements);
+    ElementFile* faces = new ElementFile(finalFaceElementType, mpiInfo);
+    domain->setFaceElements(faces);
+    ElementFile* points = new ElementFile(Dudley_Point1, mpiInfo);
+    domain->setPoints(points);
+    const dim_t numElements = elementIds.size();
+    const dim_t numFaceElements = faceIds.size();
+    elements->allocTable(numElements);
+    faces->allocTable(numFaceElements);
+    points->allocTable(0);
+    elements->minColor = 0;
+    elements->maxColor = numElements - 1;
+    faces->minColor = 0;
+    faces->maxColor = numFaceElements - 1;
+    points->minColor = 0;
+    points->maxColor = 0;
+#pragma omp parallel for
+    for (index_t e = 0; e < numElements; e++) {
+        elements->Id[e] = elementIds[e];
+        elements->Tag[e] = elementTags[e];
+        elements->Color[e] = e;
+        elements->Owner[e] = rank;
+        for (int j = 0; j < elements->numNodes; ++j)
+            elements->Nodes[INDEX2(j, e, elements->numNodes)] =
+                                    elementNodes[e*elements->numNodes+j];
+    }
+#pragma omp parallel for
+    for (index_t e = 0; e < numFaceElements; e++) {
+        faces->Id[e] = faceIds[e];
+        faces->Tag[e] = faceTags[e];
+        faces->Color[e] = e;
+        faces->Owner[e] = rank;
+        for (int j = 0; j < faces->numNodes; ++j)
+            faces->Nodes[INDEX2(j, e, faces->numNodes)] =
+                                    faceNodes[e*faces->numNodes+j];
+    }
+    return domain;
+}
+
+} // anonymous namespace
+
 /// reads a mesh from a gmsh file of name filename
 escript::Domain_ptr DudleyDomain::readGmsh(escript::JMPI mpiInfo,
                                            const std::string& filename,
@@ -40,8 +633,23 @@ escript::Domain_ptr DudleyDomain::readGmsh(escript::JMPI mpiInfo,
     int* tag = NULL;
     std::string line;
 
+    // binary files are read in parallel by all ranks
+    int binary = 0;
+    if (mpiInfo->rank == 0)
+        binary = isBinaryGmsh(filename);
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1)
+        MPI_Bcast(&binary, 1, MPI_INT, 0, mpiInfo->comm);
+#endif
+    if (binary) {
+        DudleyDomain* domain = readGmshBinary(mpiInfo, filename, numDim);
+        domain->resolveNodeIds();
+        domain->prepare(optimize);
+        return domain->getPtr();
+    }
+
     if (mpiInfo->size > 1)
-        throw DudleyException("reading gmsh with MPI is not supported yet.");
+        throw DudleyException("reading ASCII gmsh files with MPI is not supported yet.");
 
     // allocate domain
     DudleyDomain* domain = new DudleyDomain(filename, numDim, mpiInfo);
@@ -71,6 +71,13 @@ IndexPair getFlaggedMinMaxInt(dim_t N, const index_t* values, index_t ignore);
 /// those entries
 std::vector<index_t> packMask(const std::vector<short>& mask);
 
+/// returns the position of the point x along a Hilbert curve through the
+/// box starting at `lo`. `scale` maps the box onto the integer grid with
+/// 2^bits points in each direction that is used by the curve, numDim*bits
+/// must not exceed 64.
+uint64_t hilbertKey(const double* x, int numDim, const double* lo,
+                    const double* scale, int bits);
+
 void setValuesInUse(const int* values, dim_t numValues,
                     std::vector<int>& valuesInUse, escript::JMPI mpiInfo);
 
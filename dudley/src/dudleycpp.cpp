@@ -80,6 +80,9 @@ BOOST_PYTHON_MODULE(dudleycpp)
 ":param full:\n:type full: ``bool``")
       .def("dump", &dudley::DudleyDomain::dump, args("fileName")
 ,"dumps the mesh to a file with the given name.")
+      .def("dumpBinary", &dudley::DudleyDomain::dumpBinary, args("fileName")
+,"writes the mesh to a single binary checkpoint file which can be loaded\n"
+"with `LoadMesh` on any number of ranks.")
       .def("getDescription", &dudley::DudleyDomain::getDescription,
 ":return: a description for this domain\n:rtype: ``string``")
       .def("getDim", &dudley::DudleyDomain::getDim,":rtype: ``int``")
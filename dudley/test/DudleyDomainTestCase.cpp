@@ -20,10 +20,15 @@
 #include "DudleyDomainTestCase.h"
 
 #include <dudley/DomainFactory.h>
+#include <dudley/DudleyDomain.h>
+
+#include <escript/EscriptParams.h>
 
 #include <cppunit/TestCaller.h>
 #include <boost/scoped_ptr.hpp>
 
+#include <map>
+
 using namespace escript;
 using namespace dudley;
 using namespace CppUnit;
@@ -35,12 +40,62 @@ void DudleyDomainTestCase::testAll()
     CPPUNIT_ASSERT(dom->getDim() == 3);
 }
 
+// checks that all elements have a colour and that no two elements of the
+// same colour share a degree of freedom
+static void checkColoring(const ElementFile* elements, const NodeFile* nodes)
+{
+    const int NN = elements->numNodes;
+    // element of each colour touching a DOF
+    std::map<std::pair<index_t, index_t>, index_t> owner;
+    for (index_t e = 0; e < elements->numElements; e++) {
+        const index_t color = elements->Color[e];
+        CPPUNIT_ASSERT(color >= elements->minColor);
+        CPPUNIT_ASSERT(color <= elements->maxColor);
+        for (int i = 0; i < NN; i++) {
+            const index_t dof = nodes->globalDegreesOfFreedom[
+                                        elements->Nodes[INDEX2(i, e, NN)]];
+            const std::pair<index_t, index_t> key(dof, color);
+            std::map<std::pair<index_t, index_t>, index_t>::const_iterator it
+                = owner.find(key);
+            if (it == owner.end())
+                owner[key] = e;
+            else
+                CPPUNIT_ASSERT(it->second == e);
+        }
+    }
+}
+
+static void checkDomainColoring(Domain_ptr dom)
+{
+    const DudleyDomain* dd = dynamic_cast<const DudleyDomain*>(dom.get());
+    CPPUNIT_ASSERT(dd);
+    checkColoring(dd->getElements(), dd->getNodes());
+    checkColoring(dd->getFaceElements(), dd->getNodes());
+    checkColoring(dd->getPoints(), dd->getNodes());
+}
+
+void DudleyDomainTestCase::testColoring()
+{
+    JMPI info = makeInfo(MPI_COMM_WORLD);
+    const int balanced = getEscriptParamInt("BALANCED_COLORING");
+    for (int b = 0; b <= 1; b++) {
+        setEscriptParamInt("BALANCED_COLORING", b);
+        checkDomainColoring(rectangle(info, 9, 7));
+        checkDomainColoring(rectangle(info, 12, 5, 1, 2., 1.));
+        checkDomainColoring(brick(info, 5, 4, 3));
+        checkDomainColoring(brick(info, 3, 6, 4, 1, 1., 2., 1.));
+    }
+    setEscriptParamInt("BALANCED_COLORING", balanced);
+}
+
 TestSuite* DudleyDomainTestCase::suite()
 {
     TestSuite *testSuite = new TestSuite("DudleyDomainTestCase");
 
     testSuite->addTest(new TestCaller<DudleyDomainTestCase>(
                 "testAll", &DudleyDomainTestCase::testAll));
+    testSuite->addTest(new TestCaller<DudleyDomainTestCase>(
+                "testColoring", &DudleyDomainTestCase::testColoring));
     return testSuite;
 }
 
@@ -101,6 +101,42 @@ class Test_InputOutputOnDudley(unittest.TestCase):
         mydomain2 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True)
         self.domainsEqual(mydomain1, mydomain2)
 
+     # Does the Hilbert curve ordering change Brick?
+     def test_Brick_hilbert_ordering(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=False)
+        setEscriptParamInt("HILBERT_ORDERING", 1)
+        try:
+            mydomain2 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=False)
+        finally:
+            setEscriptParamInt("HILBERT_ORDERING", 0)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     # Does the built-in partitioner change Brick?
+     def test_Brick_builtin_partitioner(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=False)
+        setEscriptParamInt("BUILTIN_PARTITIONER", 1)
+        try:
+            mydomain2 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True)
+        finally:
+            setEscriptParamInt("BUILTIN_PARTITIONER", 0)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     # Does the built-in partitioner give every rank the same number of DOFs?
+     @unittest.skipIf(getMPISizeWorld()<2, "less than 2 MPI ranks")
+     def test_builtin_partitioner_balance(self):
+        setEscriptParamInt("BUILTIN_PARTITIONER", 1)
+        try:
+            domains = [Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True),
+                       Rectangle(n0=NE0, n1=NE1, order=1, l0=1., l1=1., optimize=True)]
+        finally:
+            setEscriptParamInt("BUILTIN_PARTITIONER", 0)
+        for dom in domains:
+            numDOF = Scalar(0., Solution(dom)).getNumberOfDataPoints()
+            maxDOF = getMPIWorldMax(numDOF)
+            minDOF = -getMPIWorldMax(-numDOF)
+            self.assertTrue(minDOF > 0, "a rank has no DOFs")
+            self.assertTrue(maxDOF - minDOF <= 1, "partitions are not balanced: %d to %d DOFs" % (minDOF, maxDOF))
+
      @unittest.skipIf(not loadIsConfigured(), "loading not configured")
      def test_data_dump_to_NetCDF_rectangle(self):
         mydomain1 = Rectangle(n0=NE0, n1=NE1, order=1, l0=1., l1=1., optimize=False)
@@ -139,6 +175,43 @@ class Test_InputOutputOnDudley(unittest.TestCase):
         self.assertEqual(dom.getTag('tag3'),3,'error with tag3')
         self.assertRaises(ValueError, dom.getTag, 'tag4')
 
+     def test_readgmsh_binary(self):
+        mydomain1 = ReadGmsh(os.path.join(DUDLEY_TEST_MESH_PATH, "testcube_binary.2.2.msh"), numDim=3)
+        mydomain2 = ReadGmsh(os.path.join(DUDLEY_TEST_MESH_PATH, "testcube_binary.4.1.msh"), numDim=3)
+        self.domainsEqual(mydomain1, mydomain2)
+        self.assertEqual(mydomain1.getTag('test Surface A'), 13, 'error with tag')
+
+     def test_mesh_dump_binary_brick(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True)
+        dumpfile=os.path.join(DUDLEY_WORKDIR, "tempfile.mesh.ckpt")
+        mydomain1.dumpBinary(dumpfile)
+        mydomain2=LoadMesh(dumpfile)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     def test_mesh_dump_binary_gmsh(self):
+        mydomain1 = ReadGmsh(os.path.join(DUDLEY_TEST_MESH_PATH, "testcube_binary.2.2.msh"), numDim=3)
+        dumpfile=os.path.join(DUDLEY_WORKDIR, "tempfile.gmsh.ckpt")
+        mydomain1.dumpBinary(dumpfile)
+        mydomain2=LoadMesh(dumpfile)
+        self.domainsEqual(mydomain1, mydomain2)
+        self.assertEqual(mydomain2.getTag('test Surface A'), 13, 'error with tag')
+
+     # the reference checkpoints were written on 1 and on 3 ranks so at
+     # least one of them is always loaded on a different number of ranks
+     @unittest.skipIf(hasFeature("longindex"), "checkpoints were written with 32-bit indices")
+     def test_mesh_load_binary_rectangle_other_ranks(self):
+        mydomain1 = Rectangle(n0=8, n1=10, order=1, l0=1., l1=1., optimize=False)
+        for ranks in ("1rank", "3ranks"):
+            mydomain2=LoadMesh(os.path.join(DUDLEY_TEST_MESH_PATH, "rect_8x10_%s.ckpt"%ranks))
+            self.domainsEqual(mydomain1, mydomain2)
+
+     @unittest.skipIf(hasFeature("longindex"), "checkpoints were written with 32-bit indices")
+     def test_mesh_load_binary_brick_other_ranks(self):
+        mydomain1 = Brick(n0=4, n1=4, n2=4, order=1, l0=1., l1=1., l2=1., optimize=False)
+        for ranks in ("1rank", "3ranks"):
+            mydomain2=LoadMesh(os.path.join(DUDLEY_TEST_MESH_PATH, "brick_4x4x4_%s.ckpt"%ranks))
+            self.domainsEqual(mydomain1, mydomain2)
+
      def test_flyTags(self):
         dom=ReadMesh(os.path.join(DUDLEY_TEST_MESH_PATH, "tagtest2.fly"))
         tags=sorted(dom.showTagNames().split(', '))
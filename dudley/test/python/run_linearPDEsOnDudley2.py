@@ -42,7 +42,10 @@ from esys.escriptcore.testing import *
 from test_linearPDEs import Test_LinearPDE, Test_TransportPDE
 from test_assemblage import Test_assemblage_2Do1, Test_assemblage_3Do1
 from test_pdetools import Test_pdetools
-from esys.dudley import ReadMesh
+from esys.escript import *
+from esys.escript.linearPDEs import LinearPDE
+from esys.dudley import Rectangle, Brick, ReadMesh
+import numpy as np
 
 try:
      DUDLEY_TEST_DATA=os.environ['DUDLEY_TEST_DATA']
@@ -51,6 +54,8 @@ except KeyError:
 
 DUDLEY_TEST_MESH_PATH=os.path.join(DUDLEY_TEST_DATA,"data_meshes")
 
+NE=8 # number of element in each spatial direction (must be even)
+
 class Test_LinearPDEOnDudleyTet2D(Test_LinearPDE):
    RES_TOL=1.e-7
    ABS_TOL=1.e-8
@@ -123,6 +128,51 @@ class Test_TransportPDEOnDudleyTet3D(Test_TransportPDE):
    def tearDown(self):
         del self.domain
 
+class Test_BalancedColoringOnDudley(unittest.TestCase):
+   RES_TOL=1.e-12
+   # applies the operator and returns the right hand side of a PDE with
+   # variable coefficients on a mesh which was created with or without
+   # balanced element colouring
+   def assemble(self, makeDomain, numEqu, balanced):
+        oldBalanced = getEscriptParamInt("BALANCED_COLORING")
+        setEscriptParamInt("BALANCED_COLORING", balanced)
+        try:
+            domain = makeDomain()
+        finally:
+            setEscriptParamInt("BALANCED_COLORING", oldBalanced)
+        dim = domain.getDim()
+        x = Function(domain).getX()
+        pde = LinearPDE(domain, numEquations=numEqu)
+        if numEqu == 1:
+            pde.setValue(A=kronecker(dim)*(1.+x[0]), B=0.1*x, C=-x*x[1],
+                         D=1.+x[1]**2, X=x*x[0], Y=sin(x[0]))
+            y = Solution(domain).getX()
+            u = y[0]**2 - y[1]
+        else:
+            pde.setValue(A=identityTensor4(Function(domain))*(1.+x[0]),
+                         D=kronecker(dim)*(1.+x[1]**2), X=kronecker(dim)*x[0],
+                         Y=x)
+            y = Solution(domain).getX()
+            u = y*(1.+y[0]) - y[1]**2
+        return convertToNumpy(pde.getOperator().of(u)), convertToNumpy(pde.getRightHandSide())
+
+   def check(self, makeDomain, numEqu):
+        Au0, rhs0 = self.assemble(makeDomain, numEqu, 0)
+        Au1, rhs1 = self.assemble(makeDomain, numEqu, 1)
+        self.assertLessEqual(np.max(abs(Au1-Au0)), self.RES_TOL*np.max(abs(Au0)), "operators differ")
+        self.assertLessEqual(np.max(abs(rhs1-rhs0)), self.RES_TOL*np.max(abs(rhs0)), "right hand sides differ")
+
+   def test_Rectangle(self):
+        self.check(lambda: Rectangle(NE, NE), 1)
+
+   def test_Rectangle_system(self):
+        self.check(lambda: Rectangle(NE, NE), 2)
+
+   def test_Brick(self):
+        self.check(lambda: Brick(NE//2, NE//2, NE//2), 1)
+
+   def test_Brick_system(self):
+        self.check(lambda: Brick(NE//2, NE//2, NE//2), 3)
 
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
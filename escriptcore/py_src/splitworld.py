@@ -42,12 +42,23 @@ class SplitWorld(object):
   boost::python::raw_functions into members of a class.
   """
   
-  def __init__(self, count):
+  def __init__(self, count, dynamic=False, batched=False):
     """
     :var count: How many equally sized subworlds should our compute resources be partitioned into?
     :type count: `int`
+    :var dynamic: If True, jobs added with addJob() are handed out to subworlds as they become
+                  free (most expensive first, see addJob()). Otherwise they are distributed
+                  evenly before any of them run.
+    :type dynamic: `bool`
+    :var batched: If True, variables which every subworld exported to in a runJobs() call
+                  are reduced together using one non-blocking collective per reduction
+                  operation, overlapping with the cleanup of the jobs. This only applies
+                  to scalar reductions other than SET and to sums of `Data`.
+    :type batched: `bool`
     """
     self.cpp_obj=escore.Internal_SplitWorld(count)
+    self.cpp_obj.setDynamicScheduling(dynamic)
+    self.cpp_obj.setBatchedReductions(batched)
     
   def buildDomains(self, fn, *vec, **kwargs):
     """
@@ -70,6 +81,9 @@ class SplitWorld(object):
     :type jobctr: `callable`
     
     The remaining parameters are for the arguments of the function.
+    The optional keyword argument ``jobcost`` is not passed on. It gives the
+    relative cost of the job (default 1) which is used to run expensive jobs
+    first and to balance the cost of the jobs between subworlds.
     """
     escore.internal_addJob(self.cpp_obj, jobctr, *vec, **kwargs)
     
@@ -157,6 +171,23 @@ class SplitWorld(object):
     """
     return self.cpp_obj.getLocalObjectVariable(vname)
     
+  def getJobStats(self):
+    """
+    Returns a list with one dict per subworld containing the number of jobs
+    it ran (``jobs``), the time spent in their work() methods (``busy``) and
+    the time spent in runJobs() (``elapsed``) since the SplitWorld was
+    created or resetJobStats() was called. The difference between elapsed
+    and busy time is mostly time spent waiting for other subworlds.
+    This must be called on all processes.
+    """
+    return [dict(jobs=j, busy=b, elapsed=e) for j,b,e in self.cpp_obj.getJobStats()]
+
+  def resetJobStats(self):
+    """
+    Resets the statistics returned by getJobStats().
+    """
+    self.cpp_obj.resetJobStats()
+
   def getSubWorldCount(self):
     """
     Return the number of subworlds in this splitworld
@@ -205,6 +205,78 @@ def saveDataCSV(filename, append=False, refid=False, sep=", ", csep="_", **data)
                raise ValueError("saveDataCSV: unknown non-data argument type for %s"%(str(n)))
     escore._saveDataCSV(filename, new_data, sep, csep, refid, append)
 
+def saveDataBinary(filename, refid=False, **data):
+    """
+    Writes `Data` objects to a binary file with one column per component.
+    Arguments are handled as in `saveDataCSV`, in particular a scalar `Data`
+    object named ``mask`` selects the rows to be written.
+
+    The file starts with a text header which lists the number of rows and
+    the name, type (``float64``, ``complex128`` or ``int64``) and byte
+    offset of each column, terminated by a line ``end``. The columns follow
+    as raw values in the byte order given in the header, aligned to 64 bytes.
+    Use `loadDataBinary` to access the columns without reading the file.
+
+    :param filename: file to save data to.
+    :type filename: ``string``
+    :param refid: If ``True``, then the reference ids are written as first
+                  column ``Ref_ID``
+    :type refid: ``bool``
+    """
+    fs = None
+    for n,d in sorted(data.items(), key=lambda x: x[0]):
+        if isinstance(d, Data): fs=d.getFunctionSpace()
+    if fs is None:
+        raise ValueError("saveDataBinary: there must be at least one Data object in the argument list.")
+
+    new_data={}
+    for n,d in sorted(data.items(), key=lambda x: x[0]):
+        if isinstance(d, Data):
+            new_data[n]=d
+        else:
+            try:
+               new_data[n]=Data(d,fs)
+            except:
+               raise ValueError("saveDataBinary: unknown non-data argument type for %s"%(str(n)))
+    escore._saveDataBinary(filename, new_data, refid)
+
+def loadDataBinary(filename):
+    """
+    Returns the columns of a file written by `saveDataBinary` as a dictionary
+    of read-only memory-mapped numpy arrays keyed by the column names.
+
+    :param filename: file to read
+    :type filename: ``string``
+    :rtype: ``dict``
+    """
+    columns={}
+    with open(filename, 'rb') as f:
+        if f.readline().strip() != b"#escript-columns 1":
+            raise ValueError("loadDataBinary: %s is not a binary data file."%filename)
+        byteorder='<'
+        rows=0
+        while True:
+            line=f.readline()
+            if not line:
+                raise ValueError("loadDataBinary: unexpected end of header in %s."%filename)
+            words=line.decode().split()
+            if words[0] == "end":
+                break
+            elif words[0] == "byteorder":
+                byteorder = '<' if words[1] == "little" else '>'
+            elif words[0] == "rows":
+                rows=int(words[1])
+            elif words[0] == "column":
+                columns[words[1]]=(words[2], int(words[3]))
+    types={"float64":"f8", "complex128":"c16", "int64":"i8"}
+    result={}
+    for n,(t,offset) in columns.items():
+        if rows == 0:
+            result[n]=numpy.zeros((0,), dtype=byteorder+types[t])
+        else:
+            result[n]=numpy.memmap(filename, dtype=byteorder+types[t], mode='r', offset=offset, shape=(rows,))
+    return result
+
 def getNumpy(**data):
     """
     Writes `Data` objects to a numpy array.
@@ -289,6 +361,27 @@ def convertToNumpy(data):
     return escore._convertToNumpy(Data(data,data.getFunctionSpace()))
 
 
+def convertToNumpyView(data):
+    """
+    Returns a read-only numpy array which refers to the values of `data`
+    without copying them.
+
+    The array has shape (number of samples, data points per sample) + the
+    data point shape of `data`. Constant data is presented with zero strides
+    so every data point refers to the same values, tagged and lazy data are
+    expanded first. The array stays valid and unchanged if `data` is modified
+    later as the values are copied before they are overwritten.
+
+    Example usage:
+
+    v=Vector(1.,Function(dom))
+    a=convertToNumpyView(v)
+    a.shape == (v.getNumberOfDataPoints()//v.getNumDataPointsPerSample(),
+                v.getNumDataPointsPerSample(), dom.getDim())
+    """
+    return escore._convertToNumpyView(data)
+
+
 def saveESD(datasetName, dataDir=".", domain=None, timeStep=0, deltaT=1, dynamicMesh=0, timeStepFormat="%04d", **data):
     """
     Saves `Data` objects to files and creates an `escript dataset` (ESD) file
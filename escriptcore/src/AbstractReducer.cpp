@@ -46,5 +46,20 @@ bool AbstractReducer::canClash()
     return false;
 }
 
+bool AbstractReducer::getBatchInfo(MPI_Op& op, size_t& count)
+{
+    return false;
+}
+
+void AbstractReducer::packBatch(double* buf)
+{
+    throw SplitWorldException("This reducer does not support batched reductions.");
+}
+
+void AbstractReducer::unpackBatch(const double* buf)
+{
+    throw SplitWorldException("This reducer does not support batched reductions.");
+}
+
 } // namespace escript
 
@@ -108,6 +108,16 @@ public:
 
     virtual void copyValueFrom(boost::shared_ptr<AbstractReducer>& src)=0;
 
+    // Batched remote reductions: the values of several variables are packed
+    // into one buffer and reduced with a single collective.
+    // Returns false if the value can't be batched, otherwise sets op to the
+    // operation to apply and count to the number of doubles contributed.
+    virtual bool getBatchInfo(MPI_Op& op, size_t& count);
+
+    // copy the current value into / replace it from a batch buffer
+    virtual void packBatch(double* buf);
+    virtual void unpackBatch(const double* buf);
+
 protected:
     bool valueadded;
     bool had_an_export_this_round;
@@ -0,0 +1,622 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+
+/****************************************************************************
+
+  Escript: chunked Data files
+
+  A chunked Data file is a single file in native byte order which is written
+  collectively by all ranks. It consists of
+
+    - a fixed size header (magic, version, function space type, shape, ...)
+    - the chunk index, i.e. offset, stored size and number of samples of
+      every chunk
+    - the chunks. Chunk c holds the samples with reference IDs in
+      [minId + c*samplesPerChunk, minId + (c+1)*samplesPerChunk) sorted by
+      ID: first the number of samples, then their IDs, then their values.
+      Chunks may be zlib compressed individually.
+
+  Samples present on more than one rank are stored once. Since the chunk of
+  an ID is known from the header a reader only needs the chunks covering
+  its own IDs regardless of how many ranks wrote the file.
+
+*****************************************************************************/
+
+#include "DataChunkedFile.h"
+#include "DataException.h"
+#include "FileWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <stdint.h>
+
+#ifdef ESYS_HAVE_BOOST_IO
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#endif
+
+namespace escript {
+
+namespace {
+
+const char CHUNKED_MAGIC[8] = { 'E','S','Y','S','D','A','T','A' };
+const int CHUNKED_VERSION = 1;
+/// largest number of bytes moved by a single MPI-IO call
+const size_t CHUNKED_MAX_IO = size_t(1) << 30;
+
+struct ChunkedHeader
+{
+    char magic[8];
+    int32_t version;
+    int32_t functionSpaceType;
+    int32_t rank;
+    int32_t shape[4];
+    int32_t isComplex;
+    int32_t compressed;
+    int32_t numDataPointsPerSample;
+    int64_t minId;
+    int64_t samplesPerChunk;
+    int64_t numChunks;
+    int64_t numSamples;
+};
+
+/// position of a chunk in the file
+struct ChunkEntry
+{
+    int64_t offset;
+    int64_t storedSize;
+    int64_t numSamples;
+};
+
+/// first chunk assembled by each rank, chunks are dealt out in contiguous
+/// blocks so every rank writes one contiguous range of the file
+std::vector<int64_t> chunkDistribution(int64_t numChunks, int mpiSize)
+{
+    std::vector<int64_t> first(mpiSize+1);
+    for (int r = 0; r <= mpiSize; r++)
+        first[r] = numChunks*r/mpiSize;
+    return first;
+}
+
+size_t rawChunkSize(int64_t numSamples, size_t valueBytes)
+{
+    return sizeof(int64_t) + numSamples*(sizeof(int64_t) + valueBytes);
+}
+
+void compressChunk(const std::vector<char>& raw, std::vector<char>& out)
+{
+#ifdef ESYS_HAVE_BOOST_IO
+    boost::iostreams::filtering_ostream os;
+    os.push(boost::iostreams::zlib_compressor());
+    os.push(boost::iostreams::back_inserter(out));
+    os.write(&raw[0], raw.size());
+#endif
+}
+
+void decompressChunk(const char* stored, size_t storedSize,
+                     std::vector<char>& raw)
+{
+#ifdef ESYS_HAVE_BOOST_IO
+    boost::iostreams::filtering_istream is;
+    is.push(boost::iostreams::zlib_decompressor());
+    is.push(boost::iostreams::array_source(stored, storedSize));
+    is.read(&raw[0], raw.size());
+    if (is.gcount() != (std::streamsize)raw.size())
+        throw IOError("loadChunked: corrupt compressed chunk.");
+#else
+    throw IOError("loadChunked: file is compressed but escript was compiled "
+                  "without boost iostreams.");
+#endif
+}
+
+/// collectively writes the header (rank 0 only) and the chunks of all ranks
+void writeChunkedBytes(JMPI mpiInfo, const std::string& fileName,
+                       const std::vector<char>& header,
+                       const std::vector<char>& chunks, int64_t chunkOffset)
+{
+    // the header is only non-empty on rank 0 whose chunks directly follow it
+    std::vector<char> data;
+    const std::vector<char>* buffer = &chunks;
+    int64_t offset = chunkOffset;
+    if (!header.empty()) {
+        data.reserve(header.size() + chunks.size());
+        data.insert(data.end(), header.begin(), header.end());
+        data.insert(data.end(), chunks.begin(), chunks.end());
+        buffer = &data;
+        offset = 0;
+    }
+    const size_t length = buffer->size();
+
+    FileWriter fw(mpiInfo->size > 1 ? mpiInfo->comm : MPI_COMM_NULL);
+    int error = (fw.openFile(fileName, 0, true) ? 0 : 1);
+    int gError;
+    checkResult(error, gError, mpiInfo);
+    if (gError)
+        throw IOError("dumpChunked: cannot open file " + fileName);
+
+    // all ranks have to take part in the same number of collective calls
+    int64_t numPieces = (length + CHUNKED_MAX_IO - 1) / CHUNKED_MAX_IO;
+#ifdef ESYS_MPI
+    int64_t myPieces = numPieces;
+    MPI_Allreduce(&myPieces, &numPieces, 1, MPI_LONG_LONG, MPI_MAX,
+                  mpiInfo->comm);
+#endif
+    for (int64_t p = 0; p < numPieces; p++) {
+        const size_t start = std::min(p*CHUNKED_MAX_IO, length);
+        const size_t count = std::min(CHUNKED_MAX_IO, length - start);
+        if (!fw.writeAtAll(count > 0 ? &(*buffer)[start] : NULL, count,
+                           offset + start))
+            error = 1;
+    }
+    fw.close();
+    checkResult(error, gError, mpiInfo);
+    if (gError)
+        throw IOError("dumpChunked: error writing to file " + fileName);
+}
+
+/// reads the given byte ranges of the file. Collective, ranks may pass
+/// different (or no) ranges.
+void readChunkedBytes(JMPI mpiInfo, const std::string& fileName,
+                      const std::vector<int64_t>& offsets,
+                      const std::vector<size_t>& lengths,
+                      std::vector<std::vector<char> >& buffers)
+{
+    buffers.resize(offsets.size());
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1) {
+        int error = 0;
+        MPI_File fileHandle;
+        int mpiErr = MPI_File_open(mpiInfo->comm,
+                const_cast<char*>(fileName.c_str()), MPI_MODE_RDONLY,
+                MPI_INFO_NULL, &fileHandle);
+        int gError;
+        checkResult(mpiErr != MPI_SUCCESS, gError, mpiInfo);
+        if (gError)
+            throw IOError("loadChunked: cannot open file " + fileName);
+        for (size_t i = 0; i < offsets.size() && !error; i++) {
+            buffers[i].resize(lengths[i]);
+            for (size_t start = 0; start < lengths[i]; start += CHUNKED_MAX_IO) {
+                const size_t count = std::min(CHUNKED_MAX_IO, lengths[i]-start);
+                MPI_Status status;
+                if (MPI_File_read_at(fileHandle, offsets[i] + start,
+                            &buffers[i][start], count, MPI_BYTE, &status)
+                        != MPI_SUCCESS) {
+                    error = 1;
+                    break;
+                }
+            }
+        }
+        MPI_File_close(&fileHandle);
+        checkResult(error, gError, mpiInfo);
+        if (gError)
+            throw IOError("loadChunked: error reading from file " + fileName);
+        return;
+    }
+#endif
+    std::ifstream f(fileName.c_str(), std::ifstream::binary);
+    if (f.fail())
+        throw IOError("loadChunked: cannot open file " + fileName);
+    for (size_t i = 0; i < offsets.size(); i++) {
+        buffers[i].resize(lengths[i]);
+        f.seekg(offsets[i]);
+        f.read(buffers[i].data(), lengths[i]);
+        if (f.fail())
+            throw IOError("loadChunked: error reading from file " + fileName);
+    }
+}
+
+} // anonymous namespace
+
+bool isChunkedDataFile(const std::string& fileName, JMPI mpiInfo)
+{
+    int found = 0;
+    if (mpiInfo->rank == 0) {
+        char magic[sizeof(CHUNKED_MAGIC)];
+        std::ifstream f(fileName.c_str(), std::ifstream::binary);
+        if (f.good() && f.read(magic, sizeof(magic)) &&
+                memcmp(magic, CHUNKED_MAGIC, sizeof(magic)) == 0)
+            found = 1;
+    }
+#ifdef ESYS_MPI
+    MPI_Bcast(&found, 1, MPI_INT, 0, mpiInfo->comm);
+#endif
+    return found;
+}
+
+void dumpChunked(const Data& data, const std::string& fileName,
+                 int samplesPerChunk, bool compress)
+{
+    if (data.isEmpty())
+        throw DataException("dumpChunked: cannot dump empty Data.");
+    if (samplesPerChunk < 1)
+        throw ValueError("dumpChunked: samplesPerChunk must be positive.");
+#ifndef ESYS_HAVE_BOOST_IO
+    if (compress)
+        throw ValueError("dumpChunked: compression requires escript to be "
+                         "compiled with boost iostreams.");
+#endif
+
+    Data d(data);
+    if (d.isLazy())
+        d.resolve();
+    if (!d.isExpanded())
+        d.expand();
+
+    const FunctionSpace& fs = d.getFunctionSpace();
+    JMPI mpiInfo(fs.getDomain()->getMPI());
+    const int mpiSize = mpiInfo->size;
+    const DataTypes::dim_t numSamples = d.getNumSamples();
+    const DataTypes::dim_t* ids = fs.borrowSampleReferenceIDs();
+    const bool cplx = d.isComplex();
+    const size_t valueBytes = d.getNumDataPointsPerSample() *
+        d.getDataPointSize() *
+        (cplx ? sizeof(DataTypes::cplx_t) : sizeof(DataTypes::real_t));
+    const size_t recordSize = sizeof(int64_t) + valueBytes;
+
+    // reference ID range
+    int64_t range[2] = { std::numeric_limits<int64_t>::max(),
+                         std::numeric_limits<int64_t>::max() };
+    for (DataTypes::dim_t i = 0; i < numSamples; i++) {
+        range[0] = std::min<int64_t>(range[0], ids[i]);
+        range[1] = std::min<int64_t>(range[1], -ids[i]);
+    }
+#ifdef ESYS_MPI
+    int64_t myRange[2] = { range[0], range[1] };
+    MPI_Allreduce(myRange, range, 2, MPI_LONG_LONG, MPI_MIN, mpiInfo->comm);
+#endif
+    int64_t minId = 0, numChunks = 0;
+    if (range[0] != std::numeric_limits<int64_t>::max()) {
+        minId = range[0];
+        numChunks = (-range[1] - minId)/samplesPerChunk + 1;
+    }
+    const std::vector<int64_t> first(chunkDistribution(numChunks, mpiSize));
+
+    // send every sample to the rank assembling its chunk
+    std::vector<int> sendCount(mpiSize, 0), dest(numSamples);
+    for (DataTypes::dim_t i = 0; i < numSamples; i++) {
+        const int64_t c = (ids[i] - minId)/samplesPerChunk;
+        dest[i] = std::upper_bound(first.begin(), first.end(), c)
+                  - first.begin() - 1;
+        sendCount[dest[i]]++;
+    }
+    std::vector<int> sendOffset(mpiSize+1, 0);
+    for (int r = 0; r < mpiSize; r++)
+        sendOffset[r+1] = sendOffset[r] + sendCount[r];
+    std::vector<char> sendBuffer(sendOffset[mpiSize]*recordSize);
+    {
+        std::vector<int> pos(sendOffset.begin(), sendOffset.end()-1);
+        for (DataTypes::dim_t i = 0; i < numSamples; i++) {
+            char* rec = &sendBuffer[(pos[dest[i]]++)*recordSize];
+            const int64_t id = ids[i];
+            memcpy(rec, &id, sizeof(int64_t));
+            const void* values = (cplx ?
+                    (const void*)d.getSampleDataRO(i, DataTypes::cplx_t(0)) :
+                    (const void*)d.getSampleDataRO(i));
+            memcpy(rec + sizeof(int64_t), values, valueBytes);
+        }
+    }
+
+    std::vector<char> recvBuffer;
+    int64_t numRecords;
+#ifdef ESYS_MPI
+    if (mpiSize > 1) {
+        std::vector<int> recvCount(mpiSize), recvOffset(mpiSize+1, 0);
+        MPI_Alltoall(&sendCount[0], 1, MPI_INT, &recvCount[0], 1, MPI_INT,
+                     mpiInfo->comm);
+        for (int r = 0; r < mpiSize; r++)
+            recvOffset[r+1] = recvOffset[r] + recvCount[r];
+        recvBuffer.resize(std::max<size_t>(recvOffset[mpiSize]*recordSize, 1));
+        sendBuffer.resize(std::max<size_t>(sendBuffer.size(), 1));
+        MPI_Datatype recordType;
+        MPI_Type_contiguous(recordSize, MPI_BYTE, &recordType);
+        MPI_Type_commit(&recordType);
+        MPI_Alltoallv(&sendBuffer[0], &sendCount[0], &sendOffset[0],
+                      recordType, &recvBuffer[0], &recvCount[0],
+                      &recvOffset[0], recordType, mpiInfo->comm);
+        MPI_Type_free(&recordType);
+        numRecords = recvOffset[mpiSize];
+    } else
+#endif
+    {
+        recvBuffer.swap(sendBuffer);
+        numRecords = numSamples;
+    }
+    sendBuffer.clear();
+
+    // sort by ID, duplicates come from overlapping ranks and the copy of the
+    // lowest rank is kept
+    std::vector<int64_t> recId(numRecords), order(numRecords);
+    for (int64_t i = 0; i < numRecords; i++) {
+        memcpy(&recId[i], &recvBuffer[i*recordSize], sizeof(int64_t));
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+            [&recId](int64_t a, int64_t b) { return recId[a] < recId[b]; });
+    order.erase(std::unique(order.begin(), order.end(),
+            [&recId](int64_t a, int64_t b) { return recId[a] == recId[b]; }),
+            order.end());
+
+    // assemble my chunks
+    const int64_t myFirst = first[mpiInfo->rank];
+    const int64_t myNumChunks = first[mpiInfo->rank+1] - myFirst;
+    std::vector<ChunkEntry> entries(myNumChunks);
+    std::vector<char> chunks;
+    size_t next = 0;
+    for (int64_t c = 0; c < myNumChunks; c++) {
+        const int64_t idEnd = minId + (myFirst+c+1)*samplesPerChunk;
+        size_t end = next;
+        while (end < order.size() && recId[order[end]] < idEnd)
+            end++;
+        const int64_t n = end - next;
+        std::vector<char> raw(rawChunkSize(n, valueBytes));
+        char* p = &raw[0];
+        memcpy(p, &n, sizeof(int64_t));
+        p += sizeof(int64_t);
+        for (size_t i = next; i < end; i++, p += sizeof(int64_t))
+            memcpy(p, &recId[order[i]], sizeof(int64_t));
+        for (size_t i = next; i < end; i++, p += valueBytes)
+            memcpy(p, &recvBuffer[order[i]*recordSize + sizeof(int64_t)],
+                   valueBytes);
+        entries[c].offset = chunks.size();
+        entries[c].numSamples = n;
+        if (compress) {
+            compressChunk(raw, chunks);
+        } else {
+            chunks.insert(chunks.end(), raw.begin(), raw.end());
+        }
+        entries[c].storedSize = chunks.size() - entries[c].offset;
+        next = end;
+    }
+    recvBuffer.clear();
+
+    // place my chunks behind header, index and the chunks of lower ranks
+    const int64_t dataStart = sizeof(ChunkedHeader) +
+                              numChunks*sizeof(ChunkEntry);
+    int64_t myOffset = 0;
+#ifdef ESYS_MPI
+    int64_t mySize = chunks.size();
+    MPI_Exscan(&mySize, &myOffset, 1, MPI_LONG_LONG, MPI_SUM, mpiInfo->comm);
+    if (mpiInfo->rank == 0)
+        myOffset = 0;
+#endif
+    myOffset += dataStart;
+    for (int64_t c = 0; c < myNumChunks; c++)
+        entries[c].offset += myOffset;
+
+    std::vector<ChunkEntry> index;
+    if (mpiInfo->rank == 0)
+        index.resize(numChunks);
+#ifdef ESYS_MPI
+    if (mpiSize > 1) {
+        const int numValues = sizeof(ChunkEntry)/sizeof(int64_t);
+        std::vector<int> counts(mpiSize), displs(mpiSize);
+        for (int r = 0; r < mpiSize; r++) {
+            counts[r] = (first[r+1]-first[r])*numValues;
+            displs[r] = first[r]*numValues;
+        }
+        MPI_Gatherv(entries.data(), myNumChunks*numValues, MPI_LONG_LONG,
+                    index.data(), &counts[0], &displs[0], MPI_LONG_LONG, 0,
+                    mpiInfo->comm);
+    } else
+#endif
+    {
+        index = entries;
+    }
+
+    std::vector<char> header;
+    if (mpiInfo->rank == 0) {
+        ChunkedHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, CHUNKED_MAGIC, sizeof(CHUNKED_MAGIC));
+        h.version = CHUNKED_VERSION;
+        h.functionSpaceType = fs.getTypeCode();
+        const DataTypes::ShapeType& shape = d.getDataPointShape();
+        h.rank = shape.size();
+        for (size_t i = 0; i < shape.size(); i++)
+            h.shape[i] = shape[i];
+        h.isComplex = cplx;
+        h.compressed = compress;
+        h.numDataPointsPerSample = d.getNumDataPointsPerSample();
+        h.minId = minId;
+        h.samplesPerChunk = samplesPerChunk;
+        h.numChunks = numChunks;
+        h.numSamples = 0;
+        for (int64_t c = 0; c < numChunks; c++)
+            h.numSamples += index[c].numSamples;
+        header.resize(dataStart);
+        memcpy(&header[0], &h, sizeof(h));
+        if (numChunks > 0)
+            memcpy(&header[sizeof(h)], index.data(),
+                   numChunks*sizeof(ChunkEntry));
+    }
+    writeChunkedBytes(mpiInfo, fileName, header, chunks, myOffset);
+}
+
+Data loadChunked(const std::string& fileName, const AbstractDomain& domain)
+{
+    JMPI mpiInfo(domain.getMPI());
+
+    // header and index are read by rank 0 and broadcast
+    ChunkedHeader h;
+    std::vector<ChunkEntry> index;
+    int error = 0;
+    std::string msg;
+    if (mpiInfo->rank == 0) {
+        std::ifstream f(fileName.c_str(), std::ifstream::binary);
+        if (f.fail()) {
+            error = 1;
+            msg = "loadChunked: cannot open file " + fileName;
+        } else if (!f.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+                memcmp(h.magic, CHUNKED_MAGIC, sizeof(CHUNKED_MAGIC)) != 0) {
+            error = 1;
+            msg = "loadChunked: " + fileName + " is not a chunked Data file.";
+        } else if (h.version != CHUNKED_VERSION) {
+            error = 1;
+            msg = "loadChunked: unsupported file version.";
+        } else {
+            index.resize(h.numChunks);
+            if (h.numChunks > 0 && !f.read(reinterpret_cast<char*>(&index[0]),
+                        h.numChunks*sizeof(ChunkEntry))) {
+                error = 1;
+                msg = "loadChunked: " + fileName + " is truncated.";
+            }
+        }
+    }
+    int gError;
+    checkResult(error, gError, mpiInfo);
+    if (gError) {
+#ifdef ESYS_MPI
+        char* gmsg;
+        shipString(msg.c_str(), &gmsg, mpiInfo->comm);
+        msg = gmsg;
+        delete[] gmsg;
+#endif
+        throw IOError(msg);
+    }
+#ifdef ESYS_MPI
+    MPI_Bcast(&h, sizeof(h), MPI_BYTE, 0, mpiInfo->comm);
+    index.resize(h.numChunks);
+    if (h.numChunks > 0)
+        MPI_Bcast(&index[0], h.numChunks*sizeof(ChunkEntry), MPI_BYTE, 0,
+                  mpiInfo->comm);
+#endif
+
+    if (!domain.isValidFunctionSpaceType(h.functionSpaceType))
+        throw DataException("loadChunked: function space type code in file "
+                            "is invalid for given domain.");
+    if (h.rank < 0 || h.rank > DataTypes::maxRank)
+        throw DataException("loadChunked: invalid rank in file.");
+    FunctionSpace fs(domain.getPtr(), h.functionSpaceType);
+    if (h.numDataPointsPerSample != fs.getNumDataPointsPerSample())
+        throw DataException("loadChunked: number of data points per sample in"
+                            " file does not match the function space.");
+    DataTypes::ShapeType shape(h.shape, h.shape + h.rank);
+
+    Data out(0, shape, fs, true);
+    if (h.isComplex)
+        out.complicate();
+    out.requireWrite();
+    const bool cplx = h.isComplex;
+    const DataTypes::dim_t numSamples = out.getNumSamples();
+    const DataTypes::dim_t* ids = fs.borrowSampleReferenceIDs();
+    const size_t valueBytes = h.numDataPointsPerSample * out.getDataPointSize()
+        * (cplx ? sizeof(DataTypes::cplx_t) : sizeof(DataTypes::real_t));
+
+    // chunks holding my samples, consecutive chunks are read in one go
+    std::vector<int64_t> sampleChunk(numSamples);
+    std::vector<char> needed(h.numChunks, 0);
+    for (DataTypes::dim_t i = 0; i < numSamples; i++) {
+        const int64_t c = (ids[i] < h.minId ? -1 :
+                           (ids[i] - h.minId)/h.samplesPerChunk);
+        if (c < 0 || c >= h.numChunks) {
+            error = 1;
+            sampleChunk[i] = -1;
+        } else {
+            needed[c] = 1;
+            sampleChunk[i] = c;
+        }
+    }
+    std::vector<int64_t> runFirst, offsets;
+    std::vector<size_t> lengths;
+    for (int64_t c = 0; c < h.numChunks; c++) {
+        if (!needed[c])
+            continue;
+        if (!runFirst.empty() && needed[c-1]) {
+            lengths.back() += index[c].storedSize;
+        } else {
+            runFirst.push_back(c);
+            offsets.push_back(index[c].offset);
+            lengths.push_back(index[c].storedSize);
+        }
+    }
+    std::vector<std::vector<char> > buffers;
+    readChunkedBytes(mpiInfo, fileName, offsets, lengths, buffers);
+
+    // decode my chunks
+    std::vector<std::vector<char> > raw(h.numChunks);
+    try {
+        for (size_t r = 0; r < runFirst.size(); r++) {
+            const char* p = buffers[r].data();
+            for (int64_t c = runFirst[r]; c < h.numChunks && needed[c]; c++) {
+                raw[c].resize(rawChunkSize(index[c].numSamples, valueBytes));
+                if (h.compressed) {
+                    decompressChunk(p, index[c].storedSize, raw[c]);
+                } else if ((size_t)index[c].storedSize != raw[c].size()) {
+                    throw IOError("loadChunked: chunk size mismatch.");
+                } else {
+                    memcpy(&raw[c][0], p, raw[c].size());
+                }
+                p += index[c].storedSize;
+            }
+            std::vector<char>().swap(buffers[r]);
+        }
+    } catch (const EsysException& e) {
+        error = 2;
+        msg = e.what();
+    }
+
+    // copy the values of my samples
+    if (!error) {
+#pragma omp parallel for
+        for (DataTypes::dim_t i = 0; i < numSamples; i++) {
+            const std::vector<char>& chunk = raw[sampleChunk[i]];
+            const int64_t* chunkIds =
+                    reinterpret_cast<const int64_t*>(&chunk[sizeof(int64_t)]);
+            const int64_t n = chunkIds[-1];
+            const int64_t* pos = std::lower_bound(chunkIds, chunkIds+n,
+                                                  (int64_t)ids[i]);
+            if (pos == chunkIds+n || *pos != ids[i]) {
+#pragma omp critical
+                error = 1;
+                continue;
+            }
+            const char* values = &chunk[sizeof(int64_t) + n*sizeof(int64_t)
+                                        + (pos-chunkIds)*valueBytes];
+            void* dest = (cplx ?
+                    (void*)out.getSampleDataRW(i, DataTypes::cplx_t(0)) :
+                    (void*)out.getSampleDataRW(i));
+            memcpy(dest, values, valueBytes);
+        }
+    }
+    // 1 = samples missing from the file, 2 = file corrupt
+    if (error == 1)
+        msg = "loadChunked: file does not contain all samples of the domain.";
+    checkResult(error, gError, mpiInfo);
+    if (gError) {
+#ifdef ESYS_MPI
+        if (error != gError)
+            msg.clear();
+        char* gmsg;
+        shipString(msg.c_str(), &gmsg, mpiInfo->comm);
+        msg = gmsg;
+        delete[] gmsg;
+#endif
+        if (gError == 2)
+            throw IOError(msg);
+        throw DataException(msg);
+    }
+    return out;
+}
+
+} // namespace escript
+
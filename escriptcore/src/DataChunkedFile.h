@@ -0,0 +1,67 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+#ifndef __ESCRIPT_DATACHUNKEDFILE_H__
+#define __ESCRIPT_DATACHUNKEDFILE_H__
+
+#include "system_dep.h"
+#include "Data.h"
+
+#include <string>
+
+namespace escript {
+
+/**
+   \brief
+   writes Data into a single file which can be loaded on any number of
+   ranks.
+
+   The samples are sorted by their reference ID and grouped into chunks
+   covering `samplesPerChunk` consecutive IDs each. Every rank assembles and
+   writes a contiguous range of chunks using collective MPI-IO, an index at
+   the start of the file gives the position of each chunk. Non-expanded
+   Data is expanded before writing.
+
+   \param data the Data object to write
+   \param fileName name of the file
+   \param samplesPerChunk width of the reference ID range of a chunk
+   \param compress if true each chunk is zlib compressed
+*/
+ESCRIPT_DLL_API void
+dumpChunked(const Data& data, const std::string& fileName,
+            int samplesPerChunk=16384, bool compress=false);
+
+/**
+   \brief
+   reads Data written by dumpChunked() on domain. Each rank only reads
+   the chunks holding the reference IDs of its samples.
+*/
+ESCRIPT_DLL_API Data
+loadChunked(const std::string& fileName, const AbstractDomain& domain);
+
+/**
+   \brief
+   returns true if fileName was written by dumpChunked(). Collective on
+   the communicator of mpiInfo.
+*/
+ESCRIPT_DLL_API bool
+isChunkedDataFile(const std::string& fileName, JMPI mpiInfo);
+
+} // namespace escript
+
+#endif // __ESCRIPT_DATACHUNKEDFILE_H__
+
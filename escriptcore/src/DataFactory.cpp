@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "DataFactory.h"
+#include "DataChunkedFile.h"
 
 #include <boost/python/extract.hpp>
 #include <boost/scoped_array.hpp>
@@ -452,6 +453,8 @@ Data ComplexData(boost::python::object o, const FunctionSpace& what, bool expand
 
 Data load(const std::string fileName, const AbstractDomain& domain)
 {
+    if (isChunkedDataFile(fileName, domain.getMPI()))
+        return loadChunked(fileName, domain);
 #ifdef ESYS_HAVE_NETCDF
     JMPI mpiInfo(domain.getMPI());
     const std::string newFileName(mpiInfo->appendRankToFileName(fileName));
@@ -707,6 +710,8 @@ Data load(const std::string fileName, const AbstractDomain& domain)
 
 Data load(const std::string fileName, const AbstractDomain& domain)
 {
+    if (isChunkedDataFile(fileName, domain.getMPI()))
+        return loadChunked(fileName, domain);
 #ifdef ESYS_HAVE_NETCDF
     NcAtt *type_att, *rank_att, *function_space_type_att;
     // netCDF error handler
@@ -228,7 +228,8 @@ ComplexData(boost::python::object o,
 
 /**
    \brief
-   reads Data on domain from file in netCDF format
+   reads Data on domain from file in netCDF format or from a file written
+   by dumpChunked()
 */
 ESCRIPT_DLL_API Data
 load(const std::string fileName,
@@ -0,0 +1,73 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+#include "ElementTiling.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace escript {
+
+using DataTypes::dim_t;
+
+ElementTiling::ElementTiling(const dim_t* NE, const dim_t* tileSize)
+{
+    bool automatic[3];
+    for (int i = 0; i < 3; i++) {
+        m_NE[i] = std::max(NE[i], (dim_t)0);
+        automatic[i] = (tileSize[i] <= 0);
+        m_tileSize[i] = std::max((dim_t)1,
+                          automatic[i] ? m_NE[i] : std::min(tileSize[i], m_NE[i]));
+    }
+
+    // Shrink automatic tile extents until each colour has a few tiles per
+    // thread. Elements along x are kept contiguous as long as possible since
+    // that is the fastest running index of the sample data.
+    int numThreads = 1;
+#ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+#endif
+    const dim_t target = 2*numThreads;
+    while (numThreads > 1) {
+        dim_t tilesPerColour = 1;
+        for (int i = 0; i < 3; i++)
+            tilesPerColour *= ((m_NE[i]+m_tileSize[i]-1)/m_tileSize[i]+1)/2;
+        if (tilesPerColour >= target)
+            break;
+        int split = -1;
+        for (int i = 2; i > 0; i--) {
+            if (automatic[i] && m_tileSize[i] > 1 &&
+                    (split < 0 || m_tileSize[i] > m_tileSize[split]))
+                split = i;
+        }
+        if (split < 0 && automatic[0] && m_tileSize[0] > 1)
+            split = 0;
+        if (split < 0)
+            break;
+        m_tileSize[split] = (m_tileSize[split]+1)/2;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        const dim_t numTiles = (m_NE[i]+m_tileSize[i]-1)/m_tileSize[i];
+        m_numColourTiles[i][0] = (numTiles+1)/2;
+        m_numColourTiles[i][1] = numTiles/2;
+    }
+}
+
+} // end of namespace escript
+
@@ -0,0 +1,99 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+#ifndef __ESCRIPT_ELEMENTTILING_H__
+#define __ESCRIPT_ELEMENTTILING_H__
+
+#include "system_dep.h"
+#include "DataTypes.h"
+
+#include <algorithm>
+
+namespace escript {
+
+/**
+   \brief
+   Splits the local elements of a structured 3D grid into tiles of
+   tileSize[0] x tileSize[1] x tileSize[2] elements and colours the tiles
+   by the parity of their tile coordinates. This gives 8 colours and tiles
+   of the same colour do not share any nodes, so they can be assembled
+   concurrently without locking. Used by the ripley and speckley Brick
+   assemblers.
+
+   A tile size of (NE0, NE1, 1) reproduces the classic two-colour z-slab
+   scheme while smaller tiles expose parallelism in all three directions.
+*/
+class ESCRIPT_DLL_API ElementTiling
+{
+public:
+    /**
+       \brief
+       Constructor.
+       \param NE number of local elements in each dimension
+       \param tileSize requested tile extent in each dimension. Values <= 0
+              select the extent automatically based on the number of threads
+    */
+    ElementTiling(const DataTypes::dim_t* NE,
+                  const DataTypes::dim_t* tileSize);
+
+    /// returns the number of tile colours
+    inline int getNumColours() const { return 8; }
+
+    /// returns the number of tiles with colour `colour`
+    inline DataTypes::dim_t getNumTiles(int colour) const
+    {
+        return m_numColourTiles[0][colour&1]
+                * m_numColourTiles[1][(colour>>1)&1]
+                * m_numColourTiles[2][(colour>>2)&1];
+    }
+
+    /**
+       \brief
+       returns the element index ranges [first[i], last[i]) of tile number
+       `tile` of colour `colour`
+    */
+    inline void getTileRange(int colour, DataTypes::dim_t tile,
+                             DataTypes::index_t* first,
+                             DataTypes::index_t* last) const
+    {
+        for (int i = 0; i < 3; i++) {
+            const int parity = (colour>>i) & 1;
+            const DataTypes::dim_t n = m_numColourTiles[i][parity];
+            const DataTypes::index_t t = 2*(tile % n) + parity;
+            tile /= n;
+            first[i] = t*m_tileSize[i];
+            last[i] = std::min(first[i]+m_tileSize[i], m_NE[i]);
+        }
+    }
+
+    /// returns the tile extent used in dimension `dim`
+    inline DataTypes::dim_t getTileSize(int dim) const
+    {
+        return m_tileSize[dim];
+    }
+
+private:
+    DataTypes::dim_t m_NE[3];
+    DataTypes::dim_t m_tileSize[3];
+    /// number of tiles with even/odd tile coordinate in each dimension
+    DataTypes::dim_t m_numColourTiles[3][2];
+};
+
+} // end of namespace escript
+
+#endif // __ESCRIPT_ELEMENTTILING_H__
+
@@ -49,6 +49,10 @@ EscriptParams::EscriptParams()
 #endif
     tooManyLevels = 9;	// this is fairly arbitrary
     tooManyLines = 80;
+    balancedColoring = 0;
+    builtinPartitioner = 0;
+    cacheElementIntegrals = 0;
+    hilbertOrdering = 0;
 
     // now populate feature set
 #ifdef ESYS_HAVE_CUDA
@@ -123,6 +127,14 @@ int EscriptParams::getInt(const std::string& name, int sentinel) const
 {
     if (name == "AUTOLAZY")
         return autoLazy;
+    else if (name == "BALANCED_COLORING")
+        return balancedColoring;
+    else if (name == "BUILTIN_PARTITIONER")
+        return builtinPartitioner;
+    else if (name == "CACHE_ELEMENT_INTEGRALS")
+        return cacheElementIntegrals;
+    else if (name == "HILBERT_ORDERING")
+        return hilbertOrdering;
     else if (name == "LAZY_STR_FMT")
         return lazyStrFmt;
     else if (name == "LAZY_VERBOSE")
@@ -142,6 +154,14 @@ EscriptParams::setInt(const std::string& name, int value)
 {
     if (name == "AUTOLAZY")
         autoLazy = value;
+    else if (name == "BALANCED_COLORING")
+        balancedColoring = value;
+    else if (name == "BUILTIN_PARTITIONER")
+        builtinPartitioner = value;
+    else if (name == "CACHE_ELEMENT_INTEGRALS")
+        cacheElementIntegrals = value;
+    else if (name == "HILBERT_ORDERING")
+        hilbertOrdering = value;
     else if (name == "LAZY_STR_FMT")
         lazyStrFmt = value;
     else if (name == "LAZY_VERBOSE")
@@ -160,6 +180,10 @@ bp::list EscriptParams::listEscriptParams() const
 {
    bp::list l;
    l.append(bp::make_tuple("AUTOLAZY", autoLazy, "{0,1} Operations involving Expanded Data will create lazy results."));
+   l.append(bp::make_tuple("BALANCED_COLORING", balancedColoring, "{0,1} Balance the sizes of the element colour classes in finley/dudley for better OpenMP load balance."));
+   l.append(bp::make_tuple("BUILTIN_PARTITIONER", builtinPartitioner, "{0,1} Use the built-in Hilbert curve partitioner for finley/dudley meshes even if ParMETIS is available (it is always used without ParMETIS)."));
+   l.append(bp::make_tuple("CACHE_ELEMENT_INTEGRALS", cacheElementIntegrals, "Memory in MB per rank that finley may use to keep the element integrals of shape function products between assemblies with constant coefficients, 0 to switch off."));
+   l.append(bp::make_tuple("HILBERT_ORDERING", hilbertOrdering, "{0,1} Renumber the nodes, degrees of freedom and elements of finley/dudley meshes along a Hilbert curve for better memory locality."));
    l.append(bp::make_tuple("LAZY_STR_FMT", lazyStrFmt, "{0,1,2}(TESTING ONLY) change output format for lazy expressions."));
    l.append(bp::make_tuple("LAZY_VERBOSE", lazyVerbose, "{0,1} Print a warning when expressions are resolved because they are too large."));
    l.append(bp::make_tuple("RESOLVE_COLLECTIVE", resolveCollective, "(TESTING ONLY) {0.1} Collective operations will resolve their data."));
@@ -38,6 +38,10 @@ public:
     boost::python::list listEscriptParams() const;
 
     inline int getAutoLazy() const { return autoLazy; }
+    inline int getBalancedColoring() const { return balancedColoring; }
+    inline int getBuiltinPartitioner() const { return builtinPartitioner; }
+    inline int getCacheElementIntegrals() const { return cacheElementIntegrals; }
+    inline int getHilbertOrdering() const { return hilbertOrdering; }
     inline int getLazyStrFmt() const { return lazyStrFmt; }
     inline int getLazyVerbose() const { return lazyVerbose; }
     inline int getResolveCollective() const { return resolveCollective; }
@@ -57,6 +61,10 @@ private:
     int resolveCollective;
     int tooManyLevels;
     int tooManyLines;
+    int balancedColoring;
+    int builtinPartitioner;
+    int cacheElementIntegrals;
+    int hilbertOrdering;
 };
 
 
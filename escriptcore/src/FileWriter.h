@@ -196,6 +196,30 @@ public:
         return success;
     }
 
+    /// writes `length` bytes from `data` at `offset`. With more than one
+    /// rank this is a collective call, ranks without data pass length 0.
+    bool writeAtAll(const char* data, size_t length, long offset)
+    {
+        if (!m_open)
+            return false;
+
+        bool success=false;
+        if (mpiSize>1) {
+#ifdef ESYS_MPI
+            MPI_Status mpiStatus;
+            int mpiErr = MPI_File_write_at_all(
+                fileHandle, offset, const_cast<char*>(data),
+                length, MPI_CHAR, &mpiStatus);
+            success=(mpiErr==0);
+#endif
+        } else {
+            ofs.seekp(offset);
+            ofs.write(data, length);
+            success=!ofs.fail();
+        }
+        return success;
+    }
+
     void close()
     {
         if (!m_open)
@@ -17,6 +17,7 @@
 #include "MPIDataReducer.h"
 #include "SplitWorldException.h"
 
+#include <algorithm>
 #include <limits>
 #include <sstream>
 #include <boost/python/extract.hpp>
@@ -594,5 +595,77 @@ bool MPIDataReducer::canClash()
     return (reduceop==MPI_OP_NULL);
 }
 
+// Only sums of expanded values can be batched. Complex values are
+// contributed as pairs of doubles which is fine for a sum.
+// Values on the same FunctionSpace have the same number of local samples
+// on corresponding ranks so the buffers line up.
+bool MPIDataReducer::getBatchInfo(MPI_Op& op, size_t& count)
+{
+    if (reduceop!=MPI_SUM || !valueadded)
+    {
+        return false;
+    }
+    if (value.isLazy())
+    {
+        value.resolve();
+    }
+    if (!value.isExpanded())
+    {
+        return false;
+    }
+    op=reduceop;
+    count=value.getLength()*(value.isComplex() ? 2 : 1);
+    return true;
+}
+
+void MPIDataReducer::packBatch(double* buf)
+{
+    if (value.isComplex())
+    {
+        DataTypes::cplx_t dummy=0;
+        const DataTypes::cplx_t* vect=value.getDataRO(dummy);
+        if (vect!=0)
+        {
+            const double* src=reinterpret_cast<const double*>(vect);
+            std::copy(src, src+2*value.getLength(), buf);
+        }
+    }
+    else
+    {
+        DataTypes::real_t dummy=0;
+        const DataTypes::real_t* vect=value.getDataRO(dummy);
+        if (vect!=0)
+        {
+            std::copy(vect, vect+value.getLength(), buf);
+        }
+    }
+}
+
+void MPIDataReducer::unpackBatch(const double* buf)
+{
+    // value may still share its storage with data held by jobs
+    Data result(0, value.getDataPointShape(), value.getFunctionSpace(), true);
+    if (value.isComplex())
+    {
+        result.complicate();
+        DataTypes::CplxVectorType& rr=result.getExpandedVectorReference(DataTypes::cplx_t(0));
+        if (rr.size()>0)
+        {
+            const DataTypes::cplx_t* src=reinterpret_cast<const DataTypes::cplx_t*>(buf);
+            std::copy(src, src+rr.size(), &rr[0]);
+        }
+    }
+    else
+    {
+        DataTypes::RealVectorType& rr=result.getExpandedVectorReference();
+        if (rr.size()>0)
+        {
+            std::copy(buf, buf+rr.size(), &rr[0]);
+        }
+    }
+    value=result;
+    valueadded=true;
+}
+
 } // namespace escript
 
@@ -68,6 +68,11 @@ public:
 
     void newRunJobs();
     void copyValueFrom(boost::shared_ptr<AbstractReducer>& src);
+
+    bool getBatchInfo(MPI_Op& op, size_t& count);
+    void packBatch(double* buf);
+    void unpackBatch(const double* buf);
+
 private:    
     escript::Data value;
     escript::const_Domain_ptr dom;
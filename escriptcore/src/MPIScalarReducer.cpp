@@ -312,3 +312,24 @@ bool MPIScalarReducer::canClash()
     return (reduceop==MPI_OP_NULL);
 }
 
+bool MPIScalarReducer::getBatchInfo(MPI_Op& op, size_t& count)
+{
+    if (reduceop==MPI_OP_NULL)
+    {
+        return false;   // SET clashes need to be detected individually
+    }
+    op=reduceop;
+    count=1;
+    return true;
+}
+
+void MPIScalarReducer::packBatch(double* buf)
+{
+    buf[0]=value;
+}
+
+void MPIScalarReducer::unpackBatch(const double* buf)
+{
+    value=buf[0];
+    valueadded=true;
+}
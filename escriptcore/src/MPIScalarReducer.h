@@ -70,7 +70,11 @@ public:
     void copyValueFrom(boost::shared_ptr<AbstractReducer>& src);    
     
     void newRunJobs();
-    
+
+    bool getBatchInfo(MPI_Op& op, size_t& count);
+    void packBatch(double* buf);
+    void unpackBatch(const double* buf);
+
 private:    
     double value;
     MPI_Op reduceop;
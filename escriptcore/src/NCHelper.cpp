@@ -20,6 +20,13 @@
 #include <cstring>
 #ifdef NETCDF4
   #include "NCHelper.h"
+  #ifdef ESYS_MPI
+    #include <netcdf_meta.h>
+    #if NC_HAS_PARALLEL
+      #include <netcdf_par.h>
+      #define ESYS_HAVE_NETCDF_PAR
+    #endif
+  #endif
 #endif
 
 
@@ -90,7 +97,38 @@ bool openNcFile(netCDF::NcFile& ncf, const std::string& name)
     return true;
 }
 
-
+bool readNcHyperslabParallel(MPI_Comm comm, const std::string& filename,
+                             const std::string& varname,
+                             const std::vector<size_t>& start,
+                             const std::vector<size_t>& count,
+                             double* values)
+{
+#ifdef ESYS_HAVE_NETCDF_PAR
+    int ncid, varid;
+    int ok = (nc_open_par(filename.c_str(), NC_NOWRITE, comm, MPI_INFO_NULL,
+                          &ncid) == NC_NOERR);
+    int allOk = 0;
+    MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, comm);
+    if (!allOk) {
+        if (ok)
+            nc_close(ncid);
+        return false;
+    }
+    ok = (nc_inq_varid(ncid, varname.c_str(), &varid) == NC_NOERR &&
+            nc_var_par_access(ncid, varid, NC_COLLECTIVE) == NC_NOERR);
+    MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, comm);
+    if (allOk) {
+        double dummy;
+        ok = (nc_get_vara_double(ncid, varid, &start[0], &count[0],
+                                 values ? values : &dummy) == NC_NOERR);
+        MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, comm);
+    }
+    nc_close(ncid);
+    return allOk;
+#else
+    return false;
+#endif
+}
 
 #endif
 }
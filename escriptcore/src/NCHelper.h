@@ -25,10 +25,23 @@ char NcFType(const std::string& name);
 }
 
 #ifdef NETCDF4
+#include <escript/EsysMPI.h>
 #include <ncFile.h>
+#include <vector>
 namespace escript
 {
 bool openNcFile(netCDF::NcFile& f, const std::string& name);
+
+/// reads the hyperslab [start, start+count) of variable 'varname' in
+/// 'filename' using collective parallel netCDF access. All ranks of 'comm'
+/// must call this function, ranks without data pass zero counts.
+/// Returns false on all ranks if parallel access is not available for this
+/// build or file, in which case the caller has to fall back to serial reads.
+bool readNcHyperslabParallel(MPI_Comm comm, const std::string& filename,
+                             const std::string& varname,
+                             const std::vector<size_t>& start,
+                             const std::vector<size_t>& count,
+                             double* values);
 }
 #endif
 
@@ -20,6 +20,7 @@
 #include "SplitWorldException.h"
 #include "pyerr.h"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace boost::python;
@@ -42,8 +43,14 @@ boost::python::object SplitWorld::getLocalObjectVariable(const std::string& name
 
 SplitWorld::SplitWorld(unsigned int numgroups, MPI_Comm global)
     : localworld((SubWorld*)0), swcount(numgroups > 0 ? numgroups : 1),
-      jobcounter(1), manualimport(false)
+      jobcounter(1), manualimport(false), costhints(false),
+      dynamicscheduling(false), dynamicrounds(0)
 {
+    resetJobStats();
+#ifdef ESYS_MPI
+    jobcounterwin=MPI_WIN_NULL;
+    jobcounters[0]=jobcounters[1]=0;
+#endif
     globalcom = makeInfo(global);
     
     int grank=0;
@@ -91,6 +98,14 @@ SplitWorld::SplitWorld(unsigned int numgroups, MPI_Comm global)
 SplitWorld::~SplitWorld()
 {
     // communicator cleanup handled by the MPI_Info
+#ifdef ESYS_MPI
+    int mpifinalized=0;
+    MPI_Finalized(&mpifinalized);
+    if (jobcounterwin!=MPI_WIN_NULL && !mpifinalized)
+    {
+        MPI_Win_free(&jobcounterwin);
+    }
+#endif
 }
 
 
@@ -124,11 +139,15 @@ object SplitWorld::buildDomains(tuple t, dict kwargs)
 void SplitWorld::runJobs()
 {
     NoCOMM_WORLD ncw;	// it's destructor will unset the flag
+    const double starttime=gettime();
     localworld->resetInterest();  
     localworld->newRunJobs();
     try 
     {
-	distributeJobs();
+	if (!dynamicscheduling)
+	{
+	    distributeJobs();
+	}
 	int mres=0;
 	std::string err;
 	do	// only here so I can "break" to the end
@@ -154,24 +173,30 @@ void SplitWorld::runJobs()
 	    {
 	        // now we actually need to run the jobs
 	        // everybody will be executing their localworld's jobs
+	        const double t0=gettime();
 	        mres=localworld->runJobs(err);	
-
-                if (mres<2)
-	        {
-                    if (!localworld->localTransport(err))
-		    {
-		        mres=4;		// both running jobs and local reduction are local ops
-		    }
-	        }
+	        statbusy+=gettime()-t0;
+	        statjobs+=localworld->getNumJobs();
 	    }
 	} while (false);
+	if (dynamicscheduling)
+	{
+	    // this has to be called on all worlds, even failed ones
+	    runDynamicJobs(mres, err);
+	}
+	if (mres<2)
+	{
+	    if (!localworld->localTransport(err))
+	    {
+		mres=4;		// both running jobs and local reduction are local ops
+	    }
+	}
         int res=mres;
         // now we find out about the other worlds
         if (!checkResult(res, mres, globalcom))
         {
 	    throw SplitWorldException("MPI appears to have failed.");
         }
-	localworld->clearJobs();
 	  // at this point, the remote world has all the reductions done
 	  // now we need to do the global merges
 	if (!localworld->checkRemoteCompatibility(err))
@@ -179,6 +204,24 @@ void SplitWorld::runJobs()
 	    mres=4;
 	    err=std::string("Error in checkRemoteCompatibility. ")+err;
 	}
+	  // the merges of values which are new everywhere can be started now
+	  // and run while the jobs are torn down
+	bool batched=(mres==0 && localworld->getBatchedReductions());
+	if (batched && !localworld->startBatchedReductions(err))
+	{
+	    mres=4;
+	}
+	localworld->clearJobs();
+	if (dynamicscheduling)
+	{
+	    jobcounter+=create.size();
+	    clearPendingJobs();
+	}
+	if (batched && !localworld->finishBatchedReductions(err))
+	{
+	    mres=4;
+	}
+	statelapsed+=gettime()-starttime;
 	if (mres==0)	
 	{  	
 	    return;
@@ -223,6 +266,19 @@ void SplitWorld::runJobs()
 */
 void SplitWorld::addJob(boost::python::object creator, boost::python::tuple tup, boost::python::dict kw)
 {
+    // the cost hint is for the scheduler only and not passed to the job
+    double cost=1.;
+    if (kw.has_key("jobcost"))
+    {
+	extract<double> ex(kw.attr("pop")("jobcost"));
+	if (!ex.check() || ex()<0)
+	{
+	    throw SplitWorldException("jobcost must be a non-negative number.");
+	}
+	cost=ex();
+	costhints=true;
+    }
+    jobcosts.push_back(cost);
     create.push_back(creator);
     tupargs.push_back(tup);
     kwargs.push_back(kw);  
@@ -356,6 +412,135 @@ void SplitWorld::clearPendingJobs()
     create.clear();
     tupargs.clear();
     kwargs.clear();
+    jobcosts.clear();
+    costhints=false;
+}
+
+// Creates the pending job with index i on this world
+object SplitWorld::createJob(unsigned int i)
+{
+    // we need to add some things to the kw map
+    kwargs[i]["domain"]=localworld->getDomain();
+    kwargs[i]["jobid"]=object(jobcounter+i);
+    kwargs[i]["swcount"]=object(swcount);
+    kwargs[i]["swid"]=object(localid);    
+    return create[i](*(tupargs[i]), **(kwargs[i]));
+}
+
+// Returns the indices of the pending jobs, most expensive first.
+// Jobs of equal cost keep the order in which they were added.
+std::vector<unsigned int> SplitWorld::getJobOrder()
+{
+    std::vector<std::pair<double, unsigned int> > costs(create.size());
+    for (unsigned int i=0;i<create.size();++i)
+    {
+	costs[i]=std::make_pair(-jobcosts[i], i);
+    }
+    std::sort(costs.begin(), costs.end());
+    std::vector<unsigned int> order(create.size());
+    for (unsigned int i=0;i<create.size();++i)
+    {
+	order[i]=costs[i].second;
+    }
+    return order;
+}
+
+// Returns the position of the next job to run on this world (in the order
+// given by getJobOrder()). With more than one world, the leader of each
+// world increments a counter on global rank 0 and shares the result with
+// the rest of its world.
+unsigned int SplitWorld::fetchNextJob(int slot, unsigned int& localnext)
+{
+#ifdef ESYS_MPI
+    if (swcount>1)
+    {
+	int next=0;
+	if (localworld->amLeader())
+	{
+	    const int one=1;
+	    MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, jobcounterwin);
+	    MPI_Fetch_and_op(&one, &next, MPI_INT, 0, slot, MPI_SUM, jobcounterwin);
+	    MPI_Win_unlock(0, jobcounterwin);
+	}
+	if (MPI_Bcast(&next, 1, MPI_INT, 0, localworld->getMPI()->comm)!=MPI_SUCCESS)
+	{
+	    throw SplitWorldException("MPI appears to have failed.");
+	}
+	return next;
+    }
+#endif
+    return localnext++;
+}
+
+// Hands the pending jobs to the worlds as they become free.
+// Every world takes part, even if it has already failed, because the job
+// counters alternate between two slots: slot (round%2) is used for this
+// round while rank 0 resets the other one. The checkResult at the end of
+// runJobs guarantees that nobody is still using a slot when it is reset.
+void SplitWorld::runDynamicJobs(int& mres, std::string& err)
+{
+    if (create.empty())
+    {
+	return;
+    }
+    std::vector<unsigned int> order=getJobOrder();
+    const int slot=dynamicrounds%2;
+    dynamicrounds++;
+#ifdef ESYS_MPI
+    if (swcount>1)
+    {
+	if (jobcounterwin==MPI_WIN_NULL)
+	{
+	    MPI_Win_create(jobcounters, (globalcom->rank==0 ? 2*sizeof(int) : 0),
+			   sizeof(int), MPI_INFO_NULL, globalcom->comm,
+			   &jobcounterwin);
+	}
+	if (globalcom->rank==0)
+	{
+	    const int zero=0;
+	    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, jobcounterwin);
+	    MPI_Put(&zero, 1, MPI_INT, 0, 1-slot, 1, MPI_INT, jobcounterwin);
+	    MPI_Win_unlock(0, jobcounterwin);
+	}
+    }
+#endif
+    unsigned int localnext=0;
+    while (true)
+    {
+	// all processes in this world need to agree on whether to continue
+	int failed=(mres>1 ? 1 : 0);
+	int anyfailed=0;
+	if (!checkResult(failed, anyfailed, localworld->getMPI()))
+	{
+	    throw SplitWorldException("MPI appears to have failed.");
+	}
+	if (anyfailed)
+	{
+	    break;
+	}
+	unsigned int k=fetchNextJob(slot, localnext);
+	if (k>=order.size())
+	{
+	    break;
+	}
+	object job;
+	try
+	{
+	    job=createJob(order[k]);
+	}
+	catch (boost::python::error_already_set& e)
+	{
+	    getStringFromPyException(e, err);
+	    err=std::string("(During Job creation/distribution) ")+err;
+	    mres=3;
+	    continue;
+	}
+	const double t0=gettime();
+	char res=localworld->addAndRunJob(job, err);
+	statbusy+=gettime()-t0;
+	statjobs++;
+	mres=(res>1 ? res : std::max(mres, int(res)));
+    }
 }
 
 // All the job params are known on all the ranks.
@@ -363,31 +548,49 @@ void SplitWorld::clearPendingJobs()
 void SplitWorld::distributeJobs()
 {
     std::string errmsg;
-    unsigned int numjobs=create.size()/swcount;
-    unsigned int start=create.size()/swcount*localid;
-    if (localid<create.size()%swcount)
+    std::vector<unsigned int> myjobs;
+    if (costhints)
     {
-	numjobs++;
-	start+=localid;
+	// longest processing time first: each job goes to the world with the
+	// lowest total cost so far
+	std::vector<unsigned int> order=getJobOrder();
+	std::vector<double> load(swcount, 0.);
+	for (unsigned int k=0;k<order.size();++k)
+	{
+	    unsigned int w=std::min_element(load.begin(), load.end())-load.begin();
+	    load[w]+=jobcosts[order[k]];
+	    if (w==localid)
+	    {
+		myjobs.push_back(order[k]);
+	    }
+	}
     }
     else
     {
-	start+=create.size()%swcount;
+	unsigned int numjobs=create.size()/swcount;
+	unsigned int start=create.size()/swcount*localid;
+	if (localid<create.size()%swcount)
+	{
+	    numjobs++;
+	    start+=localid;
+	}
+	else
+	{
+	    start+=create.size()%swcount;
+	}
+	for (unsigned int i=start;i<start+numjobs;++i)
+	{
+	    myjobs.push_back(i);
+	}
     }
     int errstat=0;
     try
     {
-	// No other subworld will be looking at this portion of the array
+	// No other subworld will be looking at these entries of the array
 	// so jobs will only be created on one subworld
-	for (unsigned int i=start;i<start+numjobs;++i)
+	for (unsigned int k=0;k<myjobs.size();++k)
 	{
-	    // we need to add some things to the kw map
-	    kwargs[i]["domain"]=localworld->getDomain();
-	    kwargs[i]["jobid"]=object(jobcounter+i);
-	    kwargs[i]["swcount"]=object(swcount);
-	    kwargs[i]["swid"]=object(localid);    
-	    object job=create[i](*(tupargs[i]), **(kwargs[i]));
-	    localworld->addJob(job);
+	    localworld->addJob(createJob(myjobs[k]));
 	}
     }
     catch (boost::python::error_already_set& e)
@@ -425,6 +628,45 @@ void SplitWorld::distributeJobs()
     }
 }
 
+void SplitWorld::setDynamicScheduling(bool dynamic)
+{
+    dynamicscheduling=dynamic;
+}
+
+void SplitWorld::setBatchedReductions(bool batched)
+{
+    localworld->setBatchedReductions(batched);
+}
+
+void SplitWorld::resetJobStats()
+{
+    statjobs=0;
+    statbusy=0.;
+    statelapsed=0.;
+}
+
+// Collective: gathers the job statistics of all worlds
+boost::python::object SplitWorld::getJobStats()
+{
+    double mine[3]={double(statjobs), statbusy, statelapsed};
+    std::vector<double> all(3*swcount);
+#ifdef ESYS_MPI
+    if (MPI_Allgather(mine, 3, MPI_DOUBLE, &all[0], 3, MPI_DOUBLE,
+		      localworld->getCorrMPI()->comm)!=MPI_SUCCESS)
+    {
+	throw SplitWorldException("MPI appears to have failed.");
+    }
+#else
+    std::copy(mine, mine+3, all.begin());
+#endif
+    boost::python::list l;
+    for (unsigned int w=0;w<swcount;++w)
+    {
+	l.append(boost::python::make_tuple(int(all[3*w]), all[3*w+1], all[3*w+2]));
+    }
+    return std::move(l);
+}
+
 int SplitWorld::getSubWorldCount()
 {
     return swcount;
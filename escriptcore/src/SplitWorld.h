@@ -65,6 +65,13 @@ public:
 
     void copyVariable(const std::string& src, const std::string& dest);     
     
+    // if true, jobs are handed to worlds as they become free
+    void setDynamicScheduling(bool dynamic);
+    // if true, reductions after runJobs are packed together and overlap
+    // with the cleanup of the jobs
+    void setBatchedReductions(bool batched);
+    boost::python::object getJobStats();
+    void resetJobStats();
     
 private:    
     JMPI globalcom;	// communicator linking all procs used in this splitworld
@@ -77,11 +84,29 @@ private:
     std::vector<boost::python::object> create;
     std::vector<boost::python::tuple> tupargs;
     std::vector<boost::python::dict> kwargs;
+    std::vector<double> jobcosts;	// cost hints, 1 if not given
     
     unsigned int jobcounter;		// note that the id of the first job is 1 not 0.
     bool manualimport;		// if false, all reduced vars will be shipped to all subworlds    
+    bool costhints;		// true if at least one pending job has a cost hint
+    bool dynamicscheduling;
+    unsigned int dynamicrounds;	// number of runJobs calls with dynamic jobs
+
+    // per world statistics
+    unsigned int statjobs;	// number of jobs run
+    double statbusy;		// time spent in work() of jobs
+    double statelapsed;		// time spent in runJobs
+#ifdef ESYS_MPI
+    int jobcounters[2];		// only used on global rank 0
+    MPI_Win jobcounterwin;
+#endif
+
     void clearPendingJobs();
     void distributeJobs();
+    boost::python::object createJob(unsigned int i);
+    std::vector<unsigned int> getJobOrder();
+    unsigned int fetchNextJob(int slot, unsigned int& localnext);
+    void runDynamicJobs(int& mres, std::string& err);
 
 };
 
@@ -25,6 +25,7 @@
 #include <boost/python/import.hpp>
 #include <boost/python/dict.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace escript;
@@ -37,7 +38,8 @@ SubWorld::SubWorld(JMPI& global, JMPI& comm, JMPI& corr,
                    unsigned int subworldcount, unsigned int local_id,
                    bool manualimport)
     : everyone(global), swmpi(comm), corrmpi(corr), domain((AbstractDomain*)0),
-    swcount(subworldcount), localid(local_id), manualimports(manualimport)
+    swcount(subworldcount), localid(local_id), manualimports(manualimport),
+    batchreductions(false)
 #ifdef ESYS_MPI
     ,globalinfoinvalid(true)
 #endif
@@ -161,23 +163,53 @@ bool SubWorld::deliverImports(std::string& errmsg)
 {
     for (size_t i=0;i<jobvec.size();++i)
     {
-        if (manualimports)
+        if (!deliverImports(jobvec[i], errmsg))
         {
-            bp::list wanted=bp::extract<bp::list>(jobvec[i].attr("wantedvalues"))();
-            for (size_t j=0;j<len(wanted);++j)
+            return false;
+        }
+    }
+    return true;
+}
+
+// give the imported values to one job
+bool SubWorld::deliverImports(bp::object& job, std::string& errmsg)
+{
+    if (manualimports)
+    {
+        bp::list wanted=bp::extract<bp::list>(job.attr("wantedvalues"))();
+        for (size_t j=0;j<len(wanted);++j)
+        {
+            bp::extract<std::string> exs(wanted[j]);        // must have been checked by now
+            std::string n=exs();
+              // now we need to check to see if this value is known
+            str2reduce::iterator it=reducemap.find(n);
+            if (it==reducemap.end())
+            {
+                errmsg="Attempt to import variable \""+n+"\". SplitWorld was not told about this variable.";
+                return false;
+            }
+            try
+            {
+                job.attr("setImportValue")(it->first, reducemap[it->first]->getPyObj());
+            }
+            catch (bp::error_already_set& e)
+            {
+                getStringFromPyException(e, errmsg);
+                return false;
+            }
+        }
+    }
+    else
+    {
+          // For automatic imports, we want to import "Everything" into every job.
+          // However, we don't want to import things with no value yet
+        for (str2reduce::iterator it=reducemap.begin();it!=reducemap.end();++it)
+        {
+            if (it->second->hasValue())
             {
-                bp::extract<std::string> exs(wanted[j]);        // must have been checked by now
-                std::string n=exs();
-                  // now we need to check to see if this value is known
-                str2reduce::iterator it=reducemap.find(n);
-                if (it==reducemap.end())
-                {
-                    errmsg="Attempt to import variable \""+n+"\". SplitWorld was not told about this variable.";
-                    return false;
-                }
                 try
                 {
-                    jobvec[i].attr("setImportValue")(it->first, reducemap[it->first]->getPyObj());
+                    job.attr("setImportValue")(it->first, it->second->getPyObj());
                 }
                 catch (bp::error_already_set& e)
                 {
@@ -186,26 +218,6 @@ bool SubWorld::deliverImports(std::string& errmsg)
                 }
             }
         }
-        else
-        {
-              // For automatic imports, we want to import "Everything" into every job.
-              // However, we don't want to import things with no value yet
-            for (str2reduce::iterator it=reducemap.begin();it!=reducemap.end();++it)
-            {
-                if (it->second->hasValue())
-                {
-                    try
-                    {
-                        jobvec[i].attr("setImportValue")(it->first, it->second->getPyObj());
-                    }
-                    catch (bp::error_already_set& e)
-                    {
-                        getStringFromPyException(e, errmsg);
-                        return false;
-                    }
-                }
-            }
-        }
     }
     return true;
 }
@@ -796,6 +808,122 @@ bool SubWorld::synchVariableValues(std::string& err)
     return true;
 }
 
+// Starts the reduction of all variables which have a new value in every
+// world and can be batched. Their values are packed into one buffer per
+// operation and reduced with a non-blocking collective so the caller can
+// do other work before calling finishBatchedReductions().
+// All processes in all worlds must call this after a successful runJobs.
+bool SubWorld::startBatchedReductions(std::string& err)
+{
+#ifdef ESYS_MPI
+    batches.clear();
+    if (swcount==1 || getNumVars()==0)
+    {
+        return true;
+    }
+      // find out which variables are new in all worlds and that everyone
+      // agrees on their size: [min size][-max size] per variable
+    const size_t nvars=getNumVars();
+    std::vector<long> sizes(2*nvars), gsizes(2*nvars);
+    std::vector<MPI_Op> ops(nvars, MPI_OP_NULL);
+    size_t vnum=0;
+    for (str2reduce::iterator it=reducemap.begin();it!=reducemap.end();++it, ++vnum)
+    {
+        long n=-1;
+        size_t count;
+        if (varstate[it->first]==rs::NEW && it->second->getBatchInfo(ops[vnum], count))
+        {
+            n=static_cast<long>(count);
+        }
+        sizes[vnum]=n;
+        sizes[nvars+vnum]=-n;
+    }
+    if (MPI_Allreduce(&sizes[0], &gsizes[0], 2*nvars, MPI_LONG, MPI_MIN, corrmpi->comm)!=MPI_SUCCESS)
+    {
+        err="MPI failure while preparing batched reductions.";
+        return false;
+    }
+    vnum=0;
+    for (str2reduce::iterator it=reducemap.begin();it!=reducemap.end();++it, ++vnum)
+    {
+            // a variable without any local samples still takes part
+        if (gsizes[vnum]<0 || gsizes[vnum]!=-gsizes[nvars+vnum])
+        {
+            continue;
+        }
+        size_t b=0;
+        while (b<batches.size() && batches[b].op!=ops[vnum])
+        {
+            ++b;
+        }
+        if (b==batches.size())
+        {
+            batches.push_back(ReductionBatch());
+            batches[b].op=ops[vnum];
+        }
+        ReductionBatch& batch=batches[b];
+        batch.vars.push_back(it->first);
+        batch.offsets.push_back(batch.sendbuf.size());
+        batch.sendbuf.resize(batch.sendbuf.size()+gsizes[vnum]);
+        if (gsizes[vnum]>0)
+        {
+            it->second->packBatch(&batch.sendbuf[batch.offsets.back()]);
+        }
+    }
+    for (size_t b=0;b<batches.size();++b)
+    {
+        ReductionBatch& batch=batches[b];
+        batch.recvbuf.resize(batch.sendbuf.size());
+        batch.request=MPI_REQUEST_NULL;
+        if (batch.sendbuf.empty())
+        {
+            continue;
+        }
+        if (MPI_Iallreduce(&batch.sendbuf[0], &batch.recvbuf[0], batch.sendbuf.size(),
+                    MPI_DOUBLE, batch.op, corrmpi->comm, &batch.request)!=MPI_SUCCESS)
+        {
+            err="MPI failure while starting batched reductions.";
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+// Completes the reductions started by startBatchedReductions() and stores
+// the results. The reduced variables are then treated as if they had been
+// merged by synchVariableValues().
+bool SubWorld::finishBatchedReductions(std::string& err)
+{
+#ifdef ESYS_MPI
+    bool ok=true;
+    for (size_t b=0;b<batches.size();++b)
+    {
+        ReductionBatch& batch=batches[b];
+        if (MPI_Wait(&batch.request, MPI_STATUS_IGNORE)!=MPI_SUCCESS)
+        {
+            err="MPI failure in batched reductions.";
+            ok=false;
+            continue;
+        }
+        for (size_t i=0;i<batch.vars.size();++i)
+        {
+            const size_t end=(i+1<batch.vars.size() ? batch.offsets[i+1] : batch.recvbuf.size());
+            if (end>batch.offsets[i])
+            {
+                reducemap[batch.vars[i]]->unpackBatch(&batch.recvbuf[batch.offsets[i]]);
+            }
+              // every world has the merged value now
+            setAllVarsState(batch.vars[i], rs::OLD);
+        }
+    }
+    batches.clear();
+    return ok;
+#else
+    return true;
+#endif
+}
+
 bool SubWorld::amLeader()
 {
     return swmpi->rank==0;
@@ -955,23 +1083,34 @@ bool SubWorld::synchVariableInfo(std::string& err)
 char SubWorld::runJobs(std::string& errormsg)
 {
     errormsg.clear();
-    int ret=0;
-    try
+    char ret=0;
+    for (size_t i=0;i<jobvec.size();++i)
     {
-        for (size_t i=0;i<jobvec.size();++i)
+        char res=runJob(jobvec[i], errormsg);
+        if (res>1)
         {
-            bp::object result=jobvec[i].attr("work")();
-            bp::extract<bool> ex(result);
-            if (!ex.check() || (result.is_none()))
-            {
-                return 2;       
-            }
-            // check to see if we need to keep running
-            if (!ex())
-            {
-                ret=1;
-            }
+            return res;
+        }
+        ret=std::max(ret, res);
+    }
+    return ret;
+}
 
+// same return values as runJobs but for a single job
+char SubWorld::runJob(bp::object& job, std::string& errormsg)
+{
+    try
+    {
+        bp::object result=job.attr("work")();
+        bp::extract<bool> ex(result);
+        if (!ex.check() || (result.is_none()))
+        {
+            return 2;       
+        }
+        // check to see if we need to keep running
+        if (!ex())
+        {
+            return 1;
         }
     }
     catch (bp::error_already_set& e)
@@ -979,7 +1118,20 @@ char SubWorld::runJobs(std::string& errormsg)
         getStringFromPyException(e, errormsg);
         return 3;
     }
-    return ret;
+    return 0;
+}
+
+// Adds a job to the current batch after the imports have been delivered and
+// runs it immediately. Returns the same values as runJobs, or 4 if the
+// imports could not be delivered.
+char SubWorld::addAndRunJob(bp::object j, std::string& errmsg)
+{
+    jobvec.push_back(j);
+    if (!deliverImports(jobvec.back(), errmsg))
+    {
+        return 4;
+    }
+    return runJob(jobvec.back(), errmsg);
 }
 
 size_t SubWorld::getNumVars()
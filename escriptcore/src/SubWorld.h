@@ -60,7 +60,10 @@ public:
     JMPI& getCorrMPI();
     void addJob(boost::python::object j);       // add a Job to the current batch
     char runJobs(std::string& errmsg);          // run all jobs in the current batch
+    char addAndRunJob(boost::python::object j, std::string& errmsg); // add a Job
+                                                // to the batch and run it now
     void clearJobs();                           // remove all jobs in the current batch
+    size_t getNumJobs() { return jobvec.size(); } // number of jobs in the batch
 
     void addVariable(std::string&, Reducer_ptr& red);
     void removeVariable(std::string& name);  
@@ -90,8 +93,18 @@ public:
     void copyVariable(const std::string& src, const std::string& dest);
     
     void newRunJobs();
-    
+
+    // if true, variables with new values in every world are reduced
+    // together right after runJobs
+    void setBatchedReductions(bool batched) { batchreductions=batched; }
+    bool getBatchedReductions() { return batchreductions; }
+    bool startBatchedReductions(std::string& err); // pack and start reductions
+    bool finishBatchedReductions(std::string& err); // wait and unpack
+
 private:
+    bool deliverImports(boost::python::object& job, std::string& errmsg);
+    char runJob(boost::python::object& job, std::string& errmsg);
+
     JMPI everyone;   // communicator linking all procs in all subworlds
     JMPI swmpi;      // communicator linking all procs in this subworld
     JMPI corrmpi;    // communicator linking corresponding procs in all subworlds
@@ -111,8 +124,22 @@ private:
     str2char varstate;          // using the state values from AbstractReducer.h
 
     bool manualimports;
+    bool batchreductions;
     
 #ifdef ESYS_MPI    
+    // one packed buffer and request per reduction operation
+    struct ReductionBatch
+    {
+        MPI_Op op;
+        std::vector<std::string> vars;
+        std::vector<size_t> offsets;
+        std::vector<double> sendbuf;
+        std::vector<double> recvbuf;
+        MPI_Request request;
+    };
+    std::vector<ReductionBatch> batches;  // batches in flight
+
+
     std::vector<unsigned char> globalvarinfo;   // info about which worlds want which vars
                                   // [vars on process0][vars on process 1][vars on ...]
     typedef std::map<unsigned char, int> countmap;
@@ -22,6 +22,7 @@
 
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <unistd.h>
 
 #include <boost/python.hpp>
@@ -385,29 +386,33 @@ void MPIBarrierWorld()
 #endif
 }
 
-void saveDataCSV(const std::string& filename, bp::dict arg,
-                 const std::string& sep, const std::string& csep, bool refid, bool append)
+/// extracts the Data objects and the optional mask from the keyword
+/// arguments of the save functions and interpolates them to a common
+/// function space which is returned. Names are sorted.
+static FunctionSpace prepareDataForSaving(const std::string& caller,
+                                          bp::dict arg,
+                                          std::vector<std::string>& names,
+                                          std::vector<Data>& data,
+                                          Data& mask, bool& hasmask)
 {
     bp::list keys = arg.keys();
     int numdata = bp::extract<int>(arg.attr("__len__")());
 
-    bool hasmask = arg.has_key("mask");
-    Data mask;
+    hasmask = arg.has_key("mask");
     if (hasmask) {
         mask = bp::extract<escript::Data>(arg["mask"]);
         if (mask.getDataPointRank() != 0) {
-            throw DataException("saveDataCSV: mask must be scalar.");
+            throw DataException(caller+": mask must be scalar.");
         }
         keys.remove("mask");
         numdata--;
     }
     if (numdata < 1) {
-        throw DataException("saveDataCSV: no data to save specified.");
+        throw DataException(caller+": no data to save specified.");
     }
 
-    std::vector<int> step(numdata);
-    std::vector<std::string> names(numdata);
-    std::vector<Data> data(numdata);
+    names.resize(numdata);
+    data.resize(numdata);
     std::vector<int> fstypes(numdata+int(hasmask)); // FunctionSpace types for each data for interpolation
 
     keys.sort(); // to get some predictable order to things
@@ -418,30 +423,25 @@ void saveDataCSV(const std::string& filename, bp::dict arg,
         names[i] = bp::extract<std::string>(keys[i]);
         data[i] = bp::extract<escript::Data>(arg[keys[i]]);
         fstypes[i] = data[i].getFunctionSpace().getTypeCode();
-        step[i] = (data[i].actsExpanded() ? DataTypes::noValues(data[i].getDataPointShape()) : 0);
 
         if (i > 0) {
             if (data[i].getDomain()!=data[i-1].getDomain()) {
-                throw DataException("saveDataCSV: all data must be on the same domain.");
+                throw DataException(caller+": all data must be on the same domain.");
             }
         }
-        if (data[i].isComplex()) {
-            throw DataException("saveDataCSV: complex values must be separated into components before calling this.");
-        }
     }
 
     if (hasmask) {
         if (mask.getDomain() != data[0].getDomain())
-            throw DataException("saveDataCSV: mask domain must be the same as the data domain.");
+            throw DataException(caller+": mask domain must be the same as the data domain.");
         fstypes[numdata] = mask.getFunctionSpace().getTypeCode();
     }
 
     int bestfnspace = 0;
     if (!data[0].getDomain()->commonFunctionSpace(fstypes, bestfnspace)) {
-        throw DataException("saveDataCSV: FunctionSpaces of data are incompatible");
+        throw DataException(caller+": FunctionSpaces of data are incompatible");
     }
 
-
     // now we interpolate all data to the same type
     FunctionSpace best(data[0].getDomain(), bestfnspace);
     for (int i=0; i<numdata; ++i) {
@@ -449,6 +449,27 @@ void saveDataCSV(const std::string& filename, bp::dict arg,
     }
     if (hasmask)
         mask = mask.interpolate(best);
+    return best;
+}
+
+void saveDataCSV(const std::string& filename, bp::dict arg,
+                 const std::string& sep, const std::string& csep, bool refid, bool append)
+{
+    std::vector<std::string> names;
+    std::vector<Data> data;
+    Data mask;
+    bool hasmask;
+    FunctionSpace best(prepareDataForSaving("saveDataCSV", arg, names, data,
+                                            mask, hasmask));
+    const int numdata = data.size();
+
+    std::vector<int> step(numdata);
+    for (int i=0; i<numdata; ++i) {
+        step[i] = (data[i].actsExpanded() ? DataTypes::noValues(data[i].getDataPointShape()) : 0);
+        if (data[i].isComplex()) {
+            throw DataException("saveDataCSV: complex values must be separated into components before calling this.");
+        }
+    }
 
     // these must be the same for all data
     int numsamples = data[0].getNumSamples();
@@ -660,6 +681,181 @@ void saveDataCSV(const std::string& filename, bp::dict arg,
         throw DataException("saveDataCSV: Error writing to file");
 }
 
+void saveDataBinary(const std::string& filename, bp::dict arg, bool refid)
+{
+    std::vector<std::string> names;
+    std::vector<Data> data;
+    Data mask;
+    bool hasmask;
+    FunctionSpace best(prepareDataForSaving("saveDataBinary", arg, names,
+                                            data, mask, hasmask));
+    const int numdata = data.size();
+    // samples are read from several threads below
+    for (int i=0; i<numdata; ++i)
+        data[i].resolve();
+    if (hasmask)
+        mask.resolve();
+
+    const int numsamples = data[0].getNumSamples();
+    const int dpps = data[0].getNumDataPointsPerSample();
+    const DataTypes::real_t onlyreal = 0;
+    const DataTypes::cplx_t onlycomplex = 0;
+
+    // select the rows (sample, data point) to be written by this rank
+    std::vector<std::pair<int,int> > rows;
+    const bool expandedmask = (hasmask && mask.actsExpanded());
+    for (int i=0; i<numsamples; ++i) {
+        if (!best.ownSample(i))
+            continue;
+        const DataTypes::real_t* masksample = NULL;
+        if (hasmask) {
+            masksample = mask.getSampleDataRO(i, onlyreal);
+            if (!expandedmask && masksample[0] <= 0)
+                continue;
+        }
+        for (int j=0; j<dpps; ++j) {
+            if (expandedmask && masksample[j] <= 0)
+                continue;
+            rows.push_back(std::make_pair(i, j));
+        }
+    }
+
+    // position of this rank's block within each column
+    long myNumRows = rows.size();
+    long numRows = myNumRows;
+    long firstRow = 0;
+    const int mpiRank = data[0].getDomain()->getMPIRank();
+#ifdef ESYS_MPI
+    MPI_Comm com = data[0].getDomain()->getMPIComm();
+    MPI_Allreduce(&myNumRows, &numRows, 1, MPI_LONG, MPI_SUM, com);
+    MPI_Exscan(&myNumRows, &firstRow, 1, MPI_LONG, MPI_SUM, com);
+    if (mpiRank == 0)
+        firstRow = 0;
+#else
+    MPI_Comm com = MPI_COMM_NULL;
+#endif
+
+    // The file starts with a text header describing the columns followed by
+    // the raw values of each column. Columns are aligned to 64 bytes so the
+    // file can be memory-mapped. Offsets are printed with fixed width so the
+    // header size is known before the offsets are.
+    const long alignment = 64;
+    std::vector<std::string> columnNames;
+    std::vector<const char*> columnTypes;
+    std::vector<long> columnSizes;
+    if (refid) {
+        columnNames.push_back("Ref_ID");
+        columnTypes.push_back("int64");
+        columnSizes.push_back(sizeof(int64_t));
+    }
+    for (int d=0; d<numdata; ++d) {
+        const DataTypes::ShapeType& shape = data[d].getDataPointShape();
+        const int numComps = DataTypes::noValues(shape);
+        // components are numbered in storage order, i.e. with the first
+        // index running fastest
+        for (int c=0; c<numComps; ++c) {
+            std::ostringstream name;
+            name << names[d];
+            int rem = c;
+            for (size_t k=0; k<shape.size(); ++k) {
+                name << "_" << rem % shape[k];
+                rem /= shape[k];
+            }
+            columnNames.push_back(name.str());
+            if (data[d].isComplex()) {
+                columnTypes.push_back("complex128");
+                columnSizes.push_back(sizeof(DataTypes::cplx_t));
+            } else {
+                columnTypes.push_back("float64");
+                columnSizes.push_back(sizeof(DataTypes::real_t));
+            }
+        }
+    }
+    const int numColumns = columnNames.size();
+    long headerSize = 0;
+    std::ostringstream header;
+    for (int pass=0; pass<2; ++pass) {
+        header.str(std::string());
+        const int one = 1;
+        header << "#escript-columns 1\n"
+               << "byteorder " << (*reinterpret_cast<const char*>(&one) ? "little" : "big") << "\n"
+               << "rows " << numRows << "\n"
+               << "columns " << numColumns << "\n";
+        long offset = headerSize;
+        for (int c=0; c<numColumns; ++c) {
+            header << "column " << columnNames[c] << " " << columnTypes[c]
+                   << " " << std::setw(20) << std::setfill('0') << offset
+                   << "\n";
+            offset += ((numRows*columnSizes[c] + alignment - 1) / alignment) * alignment;
+        }
+        header << "end\n";
+        headerSize = ((long(header.str().size()) + alignment - 1) / alignment) * alignment;
+    }
+    std::string headerString = header.str();
+    headerString.resize(headerSize, ' ');
+    long fileSize = headerSize;
+    std::vector<long> columnOffsets(numColumns);
+    for (int c=0; c<numColumns; ++c) {
+        columnOffsets[c] = fileSize;
+        fileSize += ((numRows*columnSizes[c] + alignment - 1) / alignment) * alignment;
+    }
+
+    FileWriter fw(com);
+    if (!fw.openFile(filename, fileSize, true, false)) {
+        throw DataException("saveDataBinary: unable to open file for writing");
+    }
+    bool success = fw.writeAtAll(headerString.c_str(),
+                                 mpiRank == 0 ? headerString.size() : 0, 0);
+
+    // now the columns, one at a time
+    std::vector<char> buffer;
+    int c = 0;
+    if (refid) {
+        buffer.resize(myNumRows * sizeof(int64_t));
+        int64_t* out = reinterpret_cast<int64_t*>(buffer.data());
+#pragma omp parallel for
+        for (long r=0; r<myNumRows; ++r)
+            out[r] = best.getReferenceIDOfSample(rows[r].first);
+        success = fw.writeAtAll(buffer.data(), buffer.size(),
+                columnOffsets[c] + firstRow * sizeof(int64_t)) && success;
+        c++;
+    }
+    for (int d=0; d<numdata; ++d) {
+        const int numComps = DataTypes::noValues(data[d].getDataPointShape());
+        const int step = (data[d].actsExpanded() ? numComps : 0);
+        for (int comp=0; comp<numComps; ++comp, ++c) {
+            buffer.resize(myNumRows * columnSizes[c]);
+            if (data[d].isComplex()) {
+                DataTypes::cplx_t* out = reinterpret_cast<DataTypes::cplx_t*>(buffer.data());
+#pragma omp parallel for
+                for (long r=0; r<myNumRows; ++r) {
+                    const DataTypes::cplx_t* sample = data[d].getSampleDataRO(rows[r].first, onlycomplex);
+                    out[r] = sample[rows[r].second * step + comp];
+                }
+            } else {
+                DataTypes::real_t* out = reinterpret_cast<DataTypes::real_t*>(buffer.data());
+#pragma omp parallel for
+                for (long r=0; r<myNumRows; ++r) {
+                    const DataTypes::real_t* sample = data[d].getSampleDataRO(rows[r].first, onlyreal);
+                    out[r] = sample[rows[r].second * step + comp];
+                }
+            }
+            success = fw.writeAtAll(buffer.data(), buffer.size(),
+                    columnOffsets[c] + firstRow * columnSizes[c]) && success;
+        }
+    }
+    fw.close();
+
+    int error = !success;
+#ifdef ESYS_MPI
+    int rerror = 0;
+    MPI_Allreduce(&error, &rerror, 1, MPI_INT, MPI_MAX, com);
+    error = rerror;
+#endif
+    if (error)
+        throw DataException("saveDataBinary: Error writing to file");
+}
+
 #ifdef ESYS_HAVE_BOOST_NUMPY
 boost::python::list getNumpy(boost::python::dict arg)
 {
@@ -929,58 +1125,132 @@ boost::python::numpy::ndarray convertToNumpy(escript::Data data)
     // Py_Initialize();
     boost::python::numpy::initialize();
 
+    if (data.isEmpty())
+        throw DataException("convertToNumpy: Data object is empty.");
+    if (data.isLazy())
+        data.resolve();
+
     // Check to see if we have complex data
     bool have_complex = data.isComplex();
 
     // Work out how many data points there are
-    int numDataPoints = data.getNumSamples();
-    int dpps = data.getNumDataPointsPerSample();
-
-    // Work out the data point shape
-    std::vector<int> shape = data.getDataPointShape();
-    if(shape.size() == 0){ // If we have scalar data, the shape will be ()
-        shape.push_back(1);
-    }
+    const int numSamples = data.getNumSamples();
+    const int dpps = data.getNumDataPointsPerSample();
+    const long numDataPoints = static_cast<long>(numSamples) * dpps;
 
     // Work out the shape
-    int dimensions = data.getShapeProduct();
-
-    // Initialise the ndarray
-    boost::python::tuple arrayshape = boost::python::make_tuple(dimensions, dpps * numDataPoints);
+    const int dimensions = data.getShapeProduct();
+    // constant and tagged data store a single data point per sample which
+    // all data points of that sample share
+    const int pointStride = (data.isExpanded() ? dimensions : 0);
+
+    // Initialise the ndarray. One row per component, one column per data
+    // point.
+    boost::python::tuple arrayshape = boost::python::make_tuple(dimensions, numDataPoints);
     boost::python::numpy::dtype datatype = boost::python::numpy::dtype::get_builtin<double>();
     if (have_complex) {
         datatype = boost::python::numpy::dtype::get_builtin<std::complex<double>>();
     }
-    boost::python::numpy::ndarray dataArray = boost::python::numpy::zeros(arrayshape, datatype);
-
-    // Initialise variables
-    std::string localmsg;
-    std::vector<const DataTypes::real_t*> samplesR(1);
-
-    // This is needed below in getSampleDataRO
-    const DataTypes::real_t onlyreal = 0;
-    const DataTypes::cplx_t onlycomplex = 0;
+    boost::python::numpy::ndarray dataArray = boost::python::numpy::empty(arrayshape, datatype);
 
-// #pragma omp parallel for
-    for (int i = 0; i < numDataPoints; ++i) {
-        for (int j = 0; j < shape[0]; j++) {
-            if(have_complex){
-                dataArray[j][i] = *(data.getSampleDataRO(i, onlycomplex)+j);
-            } else {
-                dataArray[j][i] = *(data.getSampleDataRO(i, onlyreal)+j);
+    // the array is freshly allocated and therefore C-contiguous so the
+    // values can be written directly without going through python
+    if (have_complex) {
+        const DataTypes::cplx_t onlycomplex = 0;
+        DataTypes::cplx_t* out = reinterpret_cast<DataTypes::cplx_t*>(dataArray.get_data());
+#pragma omp parallel for
+        for (int i = 0; i < numSamples; ++i) {
+            const DataTypes::cplx_t* in = data.getSampleDataRO(i, onlycomplex);
+            for (int k = 0; k < dpps; ++k) {
+                const long col = static_cast<long>(i) * dpps + k;
+                for (int j = 0; j < dimensions; j++) {
+                    out[j * numDataPoints + col] = in[k * pointStride + j];
+                }
+            }
+        }
+    } else {
+        const DataTypes::real_t onlyreal = 0;
+        DataTypes::real_t* out = reinterpret_cast<DataTypes::real_t*>(dataArray.get_data());
+#pragma omp parallel for
+        for (int i = 0; i < numSamples; ++i) {
+            const DataTypes::real_t* in = data.getSampleDataRO(i, onlyreal);
+            for (int k = 0; k < dpps; ++k) {
+                const long col = static_cast<long>(i) * dpps + k;
+                for (int j = 0; j < dimensions; j++) {
+                    out[j * numDataPoints + col] = in[k * pointStride + j];
+                }
             }
         }
     }
 
-    // Print out the ndarray to the console - used during debugging
-    // std::cout << "Finished array:\n" << bp::extract<char const *>(bp::str(dataArray)) << std::endl;
-
     return dataArray;
 }
+
+boost::python::numpy::ndarray convertToNumpyView(escript::Data data)
+{
+    boost::python::numpy::initialize();
+
+    if (data.isEmpty())
+        throw DataException("convertToNumpyView: Data object is empty.");
+    // only constant and expanded storage can be described by strides so
+    // anything else is turned into expanded data first. This happens on the
+    // local copy, the argument is not modified.
+    if (data.isLazy())
+        data.resolve();
+    if (data.isTagged())
+        data.expand();
+
+    const bool have_complex = data.isComplex();
+    const DataTypes::ShapeType& shape = data.getDataPointShape();
+    const long itemsize = (have_complex ? sizeof(DataTypes::cplx_t) : sizeof(DataTypes::real_t));
+    const long pointsize = data.getDataPointSize() * itemsize;
+    const int dpps = data.getNumDataPointsPerSample();
+
+    std::vector<Py_intptr_t> arrayshape;
+    std::vector<Py_intptr_t> strides;
+    arrayshape.push_back(data.getNumSamples());
+    arrayshape.push_back(dpps);
+    if (data.isConstant()) {
+        // a single data point is stored which all samples share
+        strides.push_back(0);
+        strides.push_back(0);
+    } else {
+        strides.push_back(dpps * pointsize);
+        strides.push_back(pointsize);
+    }
+    // data point values are stored with the first index running fastest
+    long stride = itemsize;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        arrayshape.push_back(shape[i]);
+        strides.push_back(stride);
+        stride *= shape[i];
+    }
+
+    boost::python::numpy::dtype datatype = boost::python::numpy::dtype::get_builtin<double>();
+    const void* values;
+    if (have_complex) {
+        datatype = boost::python::numpy::dtype::get_builtin<std::complex<double>>();
+        values = data.getDataRO(DataTypes::cplx_t(0));
+    } else {
+        values = data.getDataRO();
+    }
+
+    // The array keeps a reference to a copy of the Data object as its owner.
+    // Since the storage is then shared, any later modification of the
+    // original object copies the values first so the view never changes
+    // under the user. The view is read-only for the same reason.
+    boost::python::object owner(data);
+    return boost::python::numpy::from_data(values, datatype, arrayshape,
+                                           strides, owner);
+}
 #else
 void convertToNumpy(escript::Data data){
     throw DataException("getNumpy: Error - Please recompile escripts with the boost numpy library");
 }
+
+void convertToNumpyView(escript::Data data){
+    throw DataException("convertToNumpyView: Error - Please recompile escripts with the boost numpy library");
+}
 #endif
 
 void resolveGroup(bp::object obj)
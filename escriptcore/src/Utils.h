@@ -110,6 +110,15 @@ ESCRIPT_DLL_API void saveDataCSV(const std::string& filename,
                                  bool refid=false,
                                  bool append=false);
 
+/**
+    \brief
+    writes Data objects to a binary file with one column per component.
+    A text header lists the columns with their type and file offset.
+*/
+ESCRIPT_DLL_API void saveDataBinary(const std::string& filename,
+                                    boost::python::dict arg,
+                                    bool refid=false);
+
 #ifdef ESYS_HAVE_BOOST_NUMPY
 ESCRIPT_DLL_API boost::python::list getNumpy(boost::python::dict arg);
 #else
@@ -122,6 +131,18 @@ ESCRIPT_DLL_API boost::python::numpy::ndarray convertToNumpy(escript::Data data)
 ESCRIPT_DLL_API void convertToNumpy(escript::Data data);
 #endif
 
+/**
+    \brief
+    returns a read-only numpy array of shape (samples, dpps, shape...) which
+    refers to the storage of `data` without copying. Constant data is
+    exposed through zero strides, tagged and lazy data are expanded first.
+*/
+#ifdef ESYS_HAVE_BOOST_NUMPY
+ESCRIPT_DLL_API boost::python::numpy::ndarray convertToNumpyView(escript::Data data);
+#else
+ESCRIPT_DLL_API void convertToNumpyView(escript::Data data);
+#endif
+
 
 /**
     \brief
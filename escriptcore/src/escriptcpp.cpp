@@ -20,6 +20,7 @@
 #include "AbstractSystemMatrix.h"
 #include "AbstractTransportProblem.h"
 #include "Data.h"
+#include "DataChunkedFile.h"
 #include "DataFactory.h"
 #include "DataVector.h"
 #include "EscriptParams.h"
@@ -155,7 +156,11 @@ BOOST_PYTHON_MODULE(escriptcpp)
     .def("getLocalObjectVariable", &escript::SplitWorld::getLocalObjectVariable, "Returns python object for a variable which is not shared between worlds")
     .def("getSubWorldCount",&escript::SplitWorld::getSubWorldCount)
     .def("getSubWorldID", &escript::SplitWorld::getSubWorldID)
-    .def("copyVariable", &escript::SplitWorld::copyVariable, args("source","destination"), "Copy the contents of one variable to another");
+    .def("copyVariable", &escript::SplitWorld::copyVariable, args("source","destination"), "Copy the contents of one variable to another")
+    .def("setDynamicScheduling", &escript::SplitWorld::setDynamicScheduling, arg("dynamic"), "If True, jobs are handed to subworlds as they become free instead of being distributed in advance")
+    .def("setBatchedReductions", &escript::SplitWorld::setBatchedReductions, arg("batched"), "If True, variables exported by every subworld are reduced together at the end of runJobs")
+    .def("getJobStats", &escript::SplitWorld::getJobStats, "Returns a (jobs, busy time, elapsed time) tuple for each subworld. Must be called on all processes.")
+    .def("resetJobStats", &escript::SplitWorld::resetJobStats, "Resets the job statistics of this process");
 
   // This class has no methods. This is deliberate - at this stage, I would like this to be an opaque type
   class_ <escript::SubWorld, escript::SubWorld_ptr, boost::noncopyable>("SubWorld", "Information about a group of workers.", no_init);
@@ -205,6 +210,18 @@ BOOST_PYTHON_MODULE(escriptcpp)
         ":param append: If True, write to the end of ``filename``\n"
         ":type append: ``string``\n"
         "");
+  def("_saveDataBinary",escript::saveDataBinary, (args("filename","arg"), arg("refid")=false),
+        "Saves data objects passed in a python dictionary to a binary file with one column per component.\n"
+        "The data objects must be over the same domain and be able to be interpolated to the same FunctionSpace.\n"
+        "If one of the dictionary keys is named ``mask``, then only samples where ``mask`` has a positive\n"
+        "value will be written to the file.\n\n"
+        ":param filename:\n"
+        ":type filename: ``string``\n"
+        ":param arg: dictionary of named `Data` objects. If one is called ``mask`` it must be scalar data.\n"
+        ":type arg: ``dict``\n"
+        ":param refid: If True, a column with the reference ids of the samples is written first\n"
+        ":type refid: ``bool``\n"
+        "");
   def("_getNumpy",escript::getNumpy, arg("arg"),
         "Takes in a data object (or objects) and returns a numpy array\n"
         ":param arg: Data object\n"
@@ -215,6 +232,12 @@ BOOST_PYTHON_MODULE(escriptcpp)
         ":param arg: Data object\n"
         ":rtype: numpy ndarray\n"
         "");
+  def("_convertToNumpyView",escript::convertToNumpyView, arg("arg"),
+        "Returns a read-only numpy array of shape (samples, dpps, shape...) "
+        "which refers to the values of a Data object without copying them\n"
+        ":param arg: Data object\n"
+        ":rtype: numpy ndarray\n"
+        "");
   def("canInterpolate", &escript::canInterpolate, args("src", "dest"),":param src: Source FunctionSpace\n"
         ":param dest: Destination FunctionSpace\n"
         ":return: True if src can be interpolated to dest\n"
@@ -497,6 +520,15 @@ args("arg"), "assigns new location to the domain\n\n"
     .def("dump",&escript::Data::dump,args("fileName"),"Save the data as a netCDF file\n\n"
         ":param fileName: \n"
         ":type fileName: ``string``")
+    .def("dumpChunked",&escript::dumpChunked,(arg("fileName"), arg("samplesPerChunk")=16384, arg("compress")=false),
+        "Save the data into a single file which can be loaded with `load` on any number of processes.\n"
+        "The samples are stored by reference ID in chunks which are written in parallel.\n\n"
+        ":param fileName: \n"
+        ":type fileName: ``string``\n"
+        ":param samplesPerChunk: number of consecutive reference IDs per chunk\n"
+        ":type samplesPerChunk: ``int``\n"
+        ":param compress: if True, chunks are compressed with zlib\n"
+        ":type compress: ``bool``")
     .def("toListOfTuples",&escript::Data::toListOfTuples, (arg("scalarastuple")=false),
         "Return the datapoints of this object in a list. Each datapoint is stored as a tuple.\n\n"
         ":param scalarastuple: if True, scalar data will be wrapped as a tuple."
@@ -812,7 +844,7 @@ args("arg"), "assigns new location to the domain\n\n"
   //
   // Factory methods for Data
   //
-  def("load",escript::load, args("fileName","domain"), "reads Data on domain from file in netCDF format\n\n"
+  def("load",escript::load, args("fileName","domain"), "reads Data on domain from file in netCDF format or from a file written by `Data.dumpChunked`\n\n"
         ":param fileName:\n"
         ":type fileName: ``string``\n"
         ":param domain:\n"
@@ -291,6 +291,47 @@ class Test_saveCSV(unittest.TestCase):
             MPIBarrierWorld()
             if getMPIRankWorld()==0: os.unlink(fname)
 
+   @unittest.skipIf(HAVE_NUMPY is False, "Numpy is not installed")
+   def test_saveDataBinary_functionspaces(self):
+        for i in range(len(self.functionspaces)):
+            FS=self.functionspaces[i]
+            X=FS(self.domain).getX()
+            X0=X[0]
+            fname=os.path.join(self.workdir, "test_save3.bin")
+            T2=Tensor(7, X.getFunctionSpace())
+            saveDataBinary(fname, refid=True, C=X, D=X0, T=T2)
+            MPIBarrierWorld()
+            cols=loadDataBinary(fname)
+            dim=self.domain.getDim()
+            names=['Ref_ID','D']+['C_%d'%j for j in range(dim)]+['T_%d_%d'%(j,k) for j in range(dim) for k in range(dim)]
+            self.assertEqual(sorted(cols.keys()), sorted(names))
+            for n in names:
+                self.assertEqual(len(cols[n]), self.linecounts[i])
+            self.assertTrue((cols['T_1_0']==7.).all())
+            self.assertTrue((cols['D']==cols['C_0']).all())
+            # compare with the CSV output
+            csvname=os.path.join(self.workdir, "test_save3.csv")
+            saveDataCSV(csvname, refid=True, U=X, V=X0, mask=X0)
+            saveDataBinary(fname, refid=True, U=X, V=X0, mask=X0)
+            MPIBarrierWorld()
+            cols=loadDataBinary(fname)
+            f=open(csvname, 'r')
+            f.readline() # skip header
+            rows=[[float(elt) for elt in line.split(',')] for line in f]
+            f.close()
+            self.assertEqual(len(rows), len(cols['V']))
+            self.assertEqual(len(rows)+1, self.linecounts_masked[i])
+            for r in range(len(rows)):
+                self.assertEqual(rows[r][0], cols['Ref_ID'][r])
+                for j in range(dim):
+                    self.assertAlmostEqual(rows[r][1+j], cols['U_%d'%j][r])
+                self.assertAlmostEqual(rows[r][1+dim], cols['V'][r])
+            del cols
+            MPIBarrierWorld()
+            if getMPIRankWorld()==0:
+                os.unlink(fname)
+                os.unlink(csvname)
+
 
 class Test_Domain(unittest.TestCase):
 
@@ -505,6 +546,63 @@ class Test_Domain(unittest.TestCase):
          for i in range(0,tups.__len__()):
             for x in range(0, self.domain.getDim()):
                self.assertEqual(float(tups[i][x]),float(numps[x][i]))
+
+   @unittest.skipIf(HAVE_NUMPY is False, "Numpy is not installed")
+   def test_convertToNumpy(self):
+      if hasFeature("boostnumpy"):
+         fs=Function(self.domain)
+         x=fs.getX()
+         c=Vector(3., fs)
+         t=Scalar(1., fs)
+         t.setTaggedValue(1, 5.)
+         t2=Tensor(-1., fs)
+         t2.setTaggedValue(1, kronecker(self.domain))
+         e=outer(x, x+1.)
+         # constant, tagged and expanded data with several data points per
+         # sample. Components are stored with the first index running fastest.
+         for d in (c, t, t2, e):
+            tups=d.toListOfTuples()
+            numps=convertToNumpy(d)
+            ref=numpy.array(tups).reshape((len(tups),)+d.getShape())
+            ref=ref.transpose(tuple(range(ref.ndim-1,0,-1))+(0,))
+            ref=ref.reshape(-1, len(tups))
+            self.assertEqual(numps.shape, ref.shape)
+            self.assertTrue((numps==ref).all())
+         z=Scalar(1.+2.j, fs)
+         numps=convertToNumpy(z)
+         self.assertEqual(numps.shape, (1, z.getNumberOfDataPoints()))
+         self.assertTrue((numps==1.+2.j).all())
+
+   @unittest.skipIf(HAVE_NUMPY is False, "Numpy is not installed")
+   def test_convertToNumpyView(self):
+      if hasFeature("boostnumpy"):
+         fs=Function(self.domain)
+         dim=self.domain.getDim()
+         d=outer(fs.getX(), fs.getX()+1.)
+         view=convertToNumpyView(d)
+         self.assertFalse(view.flags.writeable)
+         self.assertEqual(view.shape[2:], (dim,dim))
+         self.assertEqual(view.shape[0]*view.shape[1], d.getNumberOfDataPoints())
+         tups=d.toListOfTuples()
+         flat=view.reshape((-1,dim,dim))
+         for p in range(len(tups)):
+            for i in range(dim):
+               for j in range(dim):
+                  self.assertEqual(float(tups[p][i][j]), float(flat[p,i,j]))
+         # the view must not change when the Data object is modified
+         old=flat.copy()
+         d*=2.
+         self.assertTrue((flat==old).all())
+         # constant data is presented through zero strides
+         c=Vector(3., fs)
+         cview=convertToNumpyView(c)
+         self.assertEqual(cview.shape[2:], (dim,))
+         self.assertEqual(cview.strides[:2], (0,0))
+         self.assertTrue((cview==3.).all())
+         # complex data
+         z=Scalar(1.+2.j, fs)
+         z.expand()
+         self.assertTrue((convertToNumpyView(z)==1.+2.j).all())
    #===========================================================================
 
 class Test_SetDataPointValue(unittest.TestCase):
@@ -664,6 +762,45 @@ class Test_Dump(unittest.TestCase):
                 d.setTaggedValue(100,self.args[rank]*4)
                 self._diffDataObjects(d,filename)
 
+class Test_DumpChunked(unittest.TestCase):
+   """
+   dumpChunked() files can be loaded on any sample ordering, so the domain
+   with a different ordering is used for loading on any number of ranks.
+   """
+   def _diffDataObjects(self, d_ref, filename, **kwargs):
+       d_ref.dumpChunked(filename, **kwargs)
+       d=load(filename, d_ref.getDomain())
+       self.assertEqual(d_ref.getShape(), d.getShape(), "different shape %s."%filename)
+       self.assertEqual(d_ref.getFunctionSpace(), d.getFunctionSpace(), "wrong function space in %s."%filename)
+       self.assertEqual(d_ref.isComplex(), d.isComplex(), "wrong type in %s."%filename)
+       self.assertTrue(Lsup(d_ref-d)<=0., "different entries %s."%filename)
+
+   def test_DumpChunked(self):
+        for functionspace, spacename in [
+                (Solution, "solution"),
+                (ContinuousFunction, "continuous_function"),
+                (Function, "function"),
+                (FunctionOnBoundary, "function_on_boundary")
+            ]:
+            filename=os.path.join(self.filename_base,
+                    "chunked_{0}.esd".format(spacename))
+            x=functionspace(self.domain).getX()
+            d=x[0]*x[1]+Data(1.5, (2,), functionspace(self.domain))
+            self._diffDataObjects(d*(1.-2j), filename)
+            self._diffDataObjects(d, filename, samplesPerChunk=5)
+            if hasFeature('unzip'):
+                self._diffDataObjects(d, filename, samplesPerChunk=3, compress=True)
+            self.assertRaises(RuntimeError, load, filename,
+                    self.domain_with_different_number_of_data_points_per_sample)
+            x=functionspace(self.domain_with_different_sample_ordering).getX()
+            d2=load(filename, self.domain_with_different_sample_ordering)
+            self.assertTrue(Lsup(d2-(x[0]*x[1]+1.5))<=1e-14, "reordering failed for %s."%filename)
+
+   def test_DumpChunked_Constant(self):
+        filename=os.path.join(self.filename_base, "chunked_constant.esd")
+        d=Data(numpy.array([[1.5, -2.], [0.25, 7.]]), Function(self.domain))
+        self._diffDataObjects(d, filename)
+
 class Test_Lazy(unittest.TestCase):
   def makeLazyObj(self):
         d=delay(Data(1,self.mainfs,True))
@@ -93,6 +93,9 @@ def sum_check(self, **args):
         raise RuntimeError("Data total is not as expected")
 
         
+def id_work(self, **args):
+    self.exportValue("v_scalar", self.jobid)
+
 def var_setup(self, **kwargs):
     z=1
     x=Data(1, Function(self.domain))
@@ -135,8 +138,8 @@ class sw_testmany(unittest.TestCase):
         mypde.setValue(f=1+self.swid,q=gammaD)
         u = mypde.getSolution()
         return True
-    def create_many_subworlds(self):
-        sw=SplitWorld(getMPISizeWorld())
+    def create_many_subworlds(self, batched=False):
+        sw=SplitWorld(getMPISizeWorld(), batched=batched)
         sw.buildDomains(self.domain_ctr, *self.domain_vec, **self.domain_dict)
         return sw
         
@@ -276,6 +279,13 @@ class sw_testmany(unittest.TestCase):
         self.sum_vars_tester(sw) 
         
         
+    @unittest.skipIf(mpisize<3, "test is redundant on fewer than three processes")        
+    def testmanyworld_sum_vars_batched(self):
+        sw=self.create_many_subworlds(batched=True)
+        self.sum_vars_tester(sw) 
+        sw=self.create_many_subworlds(batched=True)
+        self.copy_vars_tester(sw)
+
     @unittest.skipIf(mpisize<3, "test is redundant on fewer than three processes")        
     def testmanyworld_copy_vars(self):
         sw=self.create_many_subworlds()
@@ -570,6 +580,32 @@ class Test_SplitWorld(unittest.TestCase):
       sw.runJobs()
       self.assertEqual(sw.getFloatVariable('boolean'),m)      
       
+  def test_job_scheduling(self):
+      """
+      jobs with cost hints run exactly once with static and dynamic scheduling
+      """
+      for dynamic in (False, True):
+        sw=SplitWorld(getMPISizeWorld(), dynamic=dynamic)
+        sw.buildDomains(*self.domainpars)
+        sw.addVariable("v_scalar", "float", "SUM")
+        n=3*getMPISizeWorld()+1
+        first=1
+        for r in range(3):
+          sw.clearVariable("v_scalar")
+          for i in range(n):
+            sw.addJob(FunctionJob, id_work, jobcost=(i*7)%5)
+          sw.runJobs()
+          # job ids are consecutive over all rounds
+          self.assertEqual(sw.getFloatVariable("v_scalar"), sum(range(first, first+n)))
+          first+=n
+        stats=sw.getJobStats()
+        self.assertEqual(len(stats), getMPISizeWorld())
+        self.assertEqual(sum([s['jobs'] for s in stats]), 3*n)
+        for s in stats:
+          self.assertTrue(s['busy']<=s['elapsed'])
+        sw.resetJobStats()
+        self.assertEqual(sw.getJobStats()[sw.getSubWorldID()]['jobs'], 0)
+
   def test_split_simple_solve(self):
     """
     Solve a single equation
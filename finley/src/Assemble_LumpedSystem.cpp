@@ -90,19 +90,20 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
     double* lumpedMat_p = lumpedMat.getSampleDataRW(0);
 
     if (funcspace==FINLEY_POINTS) {
+        const index_t* colorOffsets = elements->borrowColorOffsets();
+        const index_t* coloredElements = elements->borrowColoredElements();
 #pragma omp parallel
         {
             for (int color=elements->minColor; color<=elements->maxColor; color++) {
-                // loop over all elements
+                // loop over the elements of this colour
 #pragma omp for
-                for (index_t e=0; e<elements->numElements; e++) {
-                    if (elements->Color[e]==color) {
-                        const double* D_p = D.getSampleDataRO(e);
-                        util::addScatter(1,
-                                &p.row_DOF[elements->Nodes[INDEX2(0,e,p.NN)]],
-                                p.numEqu, D_p, lumpedMat_p,
-                                p.row_DOF_UpperBound);
-                    } // end color check
+                for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                    const index_t e = coloredElements[k];
+                    const double* D_p = D.getSampleDataRO(e);
+                    util::addScatter(1,
+                            &p.row_DOF[elements->Nodes[INDEX2(0,e,p.NN)]],
+                            p.numEqu, D_p, lumpedMat_p,
+                            p.row_DOF_UpperBound);
                 } // end element loop
             } // end color loop
         } // end parallel region
@@ -110,6 +111,8 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
         bool expandedD = D.actsExpanded();
         const std::vector<double>& S(p.row_jac->BasisFunctions->S);
 
+        const index_t* colorOffsets = elements->borrowColorOffsets();
+        const index_t* coloredElements = elements->borrowColoredElements();
 #pragma omp parallel
         {
             std::vector<double> EM_lumpedMat(p.row_numShapesTotal * p.numEqu);
@@ -117,105 +120,103 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
             if (p.numEqu == 1) { // single equation
                 if (expandedD) { // with expanded D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                for (int isub = 0; isub < p.numSub; isub++) {
-                                    const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e, p.numQuadSub,p.numSub)];
-                                    const double* D_p = D.getSampleDataRO(e);
-                                    if (useHRZ) {
-                                        double m_t = 0; // mass of the element
-                                        double diagS = 0; // diagonal sum
-                                        double rtmp;
-                                        #pragma ivdep
-                                        for (int q = 0; q < p.numQuadSub; q++)
-                                            m_t += Vol[q] * D_p[INDEX2(q, isub, p.numQuadSub) ];
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            for (int isub = 0; isub < p.numSub; isub++) {
+                                const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e, p.numQuadSub,p.numSub)];
+                                const double* D_p = D.getSampleDataRO(e);
+                                if (useHRZ) {
+                                    double m_t = 0; // mass of the element
+                                    double diagS = 0; // diagonal sum
+                                    double rtmp;
+                                    #pragma ivdep
+                                    for (int q = 0; q < p.numQuadSub; q++)
+                                        m_t += Vol[q] * D_p[INDEX2(q, isub, p.numQuadSub) ];
 
-                                        for (int s = 0; s < p.row_numShapes; s++) {
-                                            rtmp = 0.;
-                                            #pragma ivdep
-                                            for (int q = 0; q < p.numQuadSub; q++) {
-                                                const double Sq = S[INDEX2(s,q,p.row_numShapes)];
-                                                rtmp += Vol[q]*D_p[INDEX2(q, isub,p.numQuadSub)] * Sq * Sq;
-                                            }
-                                            EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
-                                            diagS += rtmp;
-                                        }
-                                        // rescale diagonals by m_t/diagS to
-                                        // ensure consistent mass over element
-                                        rtmp = m_t/diagS;
+                                    for (int s = 0; s < p.row_numShapes; s++) {
+                                        rtmp = 0.;
                                         #pragma ivdep
-                                        for (int s = 0; s < p.row_numShapes; s++)
-                                            EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
-                                    } else { // row-sum lumping
-                                        for (int s = 0; s < p.row_numShapes; s++) {
-                                            double rtmp = 0.;
-                                            #pragma ivdep
-                                            for (int q = 0; q < p.numQuadSub; q++)
-                                                rtmp += Vol[q]*S[INDEX2(s,q,p.row_numShapes)] * D_p[INDEX2(q, isub,p.numQuadSub)];
-                                            EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
+                                        for (int q = 0; q < p.numQuadSub; q++) {
+                                            const double Sq = S[INDEX2(s,q,p.row_numShapes)];
+                                            rtmp += Vol[q]*D_p[INDEX2(q, isub,p.numQuadSub)] * Sq * Sq;
                                         }
+                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
+                                        diagS += rtmp;
+                                    }
+                                    // rescale diagonals by m_t/diagS to
+                                    // ensure consistent mass over element
+                                    rtmp = m_t/diagS;
+                                    #pragma ivdep
+                                    for (int s = 0; s < p.row_numShapes; s++)
+                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
+                                } else { // row-sum lumping
+                                    for (int s = 0; s < p.row_numShapes; s++) {
+                                        double rtmp = 0.;
+                                        #pragma ivdep
+                                        for (int q = 0; q < p.numQuadSub; q++)
+                                            rtmp += Vol[q]*S[INDEX2(s,q,p.row_numShapes)] * D_p[INDEX2(q, isub,p.numQuadSub)];
+                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
                                     }
-                                    for (int q = 0; q < p.row_numShapesTotal; q++)
-                                        row_index[q] = p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
-                                    util::addScatter(p.row_numShapesTotal,
-                                                &row_index[0], p.numEqu,
-                                                &EM_lumpedMat[0], lumpedMat_p,
-                                                p.row_DOF_UpperBound);
-                                } // end of isub loop
-                            } // end color check
+                                }
+                                for (int q = 0; q < p.row_numShapesTotal; q++)
+                                    row_index[q] = p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
+                                util::addScatter(p.row_numShapesTotal,
+                                            &row_index[0], p.numEqu,
+                                            &EM_lumpedMat[0], lumpedMat_p,
+                                            p.row_DOF_UpperBound);
+                            } // end of isub loop
                         } // end element loop
                     } // end color loop
                 } else { // with constant D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                for (int isub = 0; isub < p.numSub; isub++) {
-                                    const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e, p.numQuadSub,p.numSub)];
-                                    const double* D_p = D.getSampleDataRO(e);
-                                    if (useHRZ) { // HRZ lumping
-                                        double m_t = 0; // mass of the element
-                                        double diagS = 0; // diagonal sum
-                                        double rtmp;
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            for (int isub = 0; isub < p.numSub; isub++) {
+                                const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e, p.numQuadSub,p.numSub)];
+                                const double* D_p = D.getSampleDataRO(e);
+                                if (useHRZ) { // HRZ lumping
+                                    double m_t = 0; // mass of the element
+                                    double diagS = 0; // diagonal sum
+                                    double rtmp;
+                                    #pragma ivdep
+                                    for (int q = 0; q < p.numQuadSub; q++)
+                                        m_t += Vol[q];
+                                    for (int s = 0; s < p.row_numShapes; s++) {
+                                        rtmp = 0.;
                                         #pragma ivdep
-                                        for (int q = 0; q < p.numQuadSub; q++)
-                                            m_t += Vol[q];
-                                        for (int s = 0; s < p.row_numShapes; s++) {
-                                            rtmp = 0.;
-                                            #pragma ivdep
-                                            for (int q = 0; q < p.numQuadSub; q++) {
-                                                const double Sq = S[INDEX2(s,q,p.row_numShapes)];
-                                                rtmp += Vol[q] * Sq * Sq;
-                                            }
-                                            EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
-                                            diagS += rtmp;
+                                        for (int q = 0; q < p.numQuadSub; q++) {
+                                            const double Sq = S[INDEX2(s,q,p.row_numShapes)];
+                                            rtmp += Vol[q] * Sq * Sq;
                                         }
-                                        // rescale diagonals by m_t/diagS to
-                                        // ensure consistent mass over element
-                                        rtmp = m_t / diagS * D_p[0];
+                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] = rtmp;
+                                        diagS += rtmp;
+                                    }
+                                    // rescale diagonals by m_t/diagS to
+                                    // ensure consistent mass over element
+                                    rtmp = m_t / diagS * D_p[0];
+                                    #pragma ivdep
+                                    for (int s = 0; s < p.row_numShapes; s++)
+                                        EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
+                                } else { // row-sum lumping
+                                    for (int s = 0; s < p.row_numShapes; s++) {
+                                        double rtmp = 0.;
                                         #pragma ivdep
-                                        for (int s = 0; s < p.row_numShapes; s++)
-                                            EM_lumpedMat[INDEX2(0, s, p.numEqu)] *= rtmp;
-                                    } else { // row-sum lumping
-                                        for (int s = 0; s < p.row_numShapes; s++) {
-                                            double rtmp = 0.;
-                                            #pragma ivdep
-                                            for (int q = 0; q < p.numQuadSub; q++)
-                                                rtmp += Vol[q] * S[INDEX2(s,q,p.row_numShapes)];
-                                            EM_lumpedMat[INDEX2(0,s,p.numEqu)] = rtmp * D_p[0];
-                                        }
+                                        for (int q = 0; q < p.numQuadSub; q++)
+                                            rtmp += Vol[q] * S[INDEX2(s,q,p.row_numShapes)];
+                                        EM_lumpedMat[INDEX2(0,s,p.numEqu)] = rtmp * D_p[0];
                                     }
-                                    for (int q = 0; q < p.row_numShapesTotal; q++)
-                                        row_index[q] = p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
-                                    util::addScatter(p.row_numShapesTotal,
-                                                &row_index[0], p.numEqu,
-                                                &EM_lumpedMat[0], lumpedMat_p,
-                                                p.row_DOF_UpperBound);
-                                } // end of isub loop
-                            } // end color check
+                                }
+                                for (int q = 0; q < p.row_numShapesTotal; q++)
+                                    row_index[q] = p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
+                                util::addScatter(p.row_numShapesTotal,
+                                            &row_index[0], p.numEqu,
+                                            &EM_lumpedMat[0], lumpedMat_p,
+                                            p.row_DOF_UpperBound);
+                            } // end of isub loop
                         } // end element loop
                     } // end color loop
                 }
@@ -223,118 +224,116 @@ void Assemble_LumpedSystem(const NodeFile* nodes, const ElementFile* elements,
             } else { // system of equations
                 if (expandedD) { // with expanded D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                for (int isub = 0; isub < p.numSub; isub++) {
-                                    const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e,p.numQuadSub,p.numSub)];
-                                    const double* D_p = D.getSampleDataRO(e);
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            for (int isub = 0; isub < p.numSub; isub++) {
+                                const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e,p.numQuadSub,p.numSub)];
+                                const double* D_p = D.getSampleDataRO(e);
 
-                                    if (useHRZ) { // HRZ lumping
-                                        for (int k=0; k<p.numEqu; k++) {
-                                            double m_t=0.; // mass of element
-                                            double diagS=0; // diagonal sum
-                                            double rtmp;
-                                            #pragma ivdep
-                                            for (int q=0; q<p.numQuadSub; q++)
-                                                m_t+=Vol[q]*D_p[INDEX3(k,q,isub,p.numEqu,p.numQuadSub)];
+                                if (useHRZ) { // HRZ lumping
+                                    for (int k=0; k<p.numEqu; k++) {
+                                        double m_t=0.; // mass of element
+                                        double diagS=0; // diagonal sum
+                                        double rtmp;
+                                        #pragma ivdep
+                                        for (int q=0; q<p.numQuadSub; q++)
+                                            m_t+=Vol[q]*D_p[INDEX3(k,q,isub,p.numEqu,p.numQuadSub)];
 
-                                            for (int s=0; s<p.row_numShapes; s++) {
-                                                rtmp=0;
-                                                #pragma ivdep
-                                                for (int q=0; q<p.numQuadSub; q++) {
-                                                    const double Sq=S[INDEX2(s,q,p.row_numShapes)];
-                                                    rtmp+=Vol[q]*D_p[INDEX3(k,q,isub,p.numEqu,p.numQuadSub)]*Sq*Sq;
-                                                }
-                                                EM_lumpedMat[INDEX2(k,s,p.numEqu)]=rtmp;
-                                                diagS+=rtmp;
-                                            }
-                                            // rescale diagonals by m_t/diagS
-                                            // to ensure consistent mass over
-                                            // element
-                                            rtmp=m_t/diagS;
-                                            #pragma ivdep
-                                            for (int s=0; s<p.row_numShapes; s++)
-                                                EM_lumpedMat[INDEX2(k,s,p.numEqu)]*=rtmp;
-                                        }
-                                    } else { // row-sum lumping
                                         for (int s=0; s<p.row_numShapes; s++) {
-                                            for (int k=0; k<p.numEqu; k++) {
-                                                double rtmp=0.;
-                                                #pragma ivdep
-                                                for (int q=0; q<p.numQuadSub; q++)
-                                                    rtmp+=Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*D_p[INDEX3(k,q,isub,p.numEqu,p.numQuadSub)];
-                                                EM_lumpedMat[INDEX2(k,s,p.numEqu)]=rtmp;
+                                            rtmp=0;
+                                            #pragma ivdep
+                                            for (int q=0; q<p.numQuadSub; q++) {
+                                                const double Sq=S[INDEX2(s,q,p.row_numShapes)];
+                                                rtmp+=Vol[q]*D_p[INDEX3(k,q,isub,p.numEqu,p.numQuadSub)]*Sq*Sq;
                                             }
+                                            EM_lumpedMat[INDEX2(k,s,p.numEqu)]=rtmp;
+                                            diagS+=rtmp;
+                                        }
+                                        // rescale diagonals by m_t/diagS
+                                        // to ensure consistent mass over
+                                        // element
+                                        rtmp=m_t/diagS;
+                                        #pragma ivdep
+                                        for (int s=0; s<p.row_numShapes; s++)
+                                            EM_lumpedMat[INDEX2(k,s,p.numEqu)]*=rtmp;
+                                    }
+                                } else { // row-sum lumping
+                                    for (int s=0; s<p.row_numShapes; s++) {
+                                        for (int k=0; k<p.numEqu; k++) {
+                                            double rtmp=0.;
+                                            #pragma ivdep
+                                            for (int q=0; q<p.numQuadSub; q++)
+                                                rtmp+=Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*D_p[INDEX3(k,q,isub,p.numEqu,p.numQuadSub)];
+                                            EM_lumpedMat[INDEX2(k,s,p.numEqu)]=rtmp;
                                         }
                                     }
-                                    for (int q=0; q<p.row_numShapesTotal; q++)
-                                        row_index[q]=p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
-                                    util::addScatter(p.row_numShapesTotal,
-                                                &row_index[0], p.numEqu,
-                                                &EM_lumpedMat[0], lumpedMat_p,
-                                                p.row_DOF_UpperBound);
-                                } // end of isub loop
-                            } // end color check
+                                }
+                                for (int q=0; q<p.row_numShapesTotal; q++)
+                                    row_index[q]=p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
+                                util::addScatter(p.row_numShapesTotal,
+                                            &row_index[0], p.numEqu,
+                                            &EM_lumpedMat[0], lumpedMat_p,
+                                            p.row_DOF_UpperBound);
+                            } // end of isub loop
                         } // end element loop
                     } // end color loop
                 } else { // with constant D
                     for (int color = elements->minColor; color <= elements->maxColor; color++) {
-                        // loop over all elements
+                        // loop over the elements of this colour
 #pragma omp for
-                        for (index_t e = 0; e < elements->numElements; e++) {
-                            if (elements->Color[e] == color) {
-                                for (int isub = 0; isub < p.numSub; isub++) {
-                                    const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e, p.numQuadSub,p.numSub)];
-                                    const double* D_p = D.getSampleDataRO(e);
+                        for (index_t k = colorOffsets[color-elements->minColor]; k < colorOffsets[color-elements->minColor+1]; k++) {
+                            const index_t e = coloredElements[k];
+                            for (int isub = 0; isub < p.numSub; isub++) {
+                                const double* Vol = &p.row_jac->volume[INDEX3(0,isub,e, p.numQuadSub,p.numSub)];
+                                const double* D_p = D.getSampleDataRO(e);
 
-                                    if (useHRZ) { // HRZ lumping
-                                        double m_t = 0.; // mass of the element
-                                        double diagS = 0; // diagonal sum
-                                        double rtmp;
+                                if (useHRZ) { // HRZ lumping
+                                    double m_t = 0.; // mass of the element
+                                    double diagS = 0; // diagonal sum
+                                    double rtmp;
+                                    #pragma ivdep
+                                    for (int q = 0; q < p.numQuadSub; q++)
+                                        m_t += Vol[q];
+                                    for (int s = 0; s < p.row_numShapes; s++) {
+                                        rtmp = 0.;
                                         #pragma ivdep
-                                        for (int q = 0; q < p.numQuadSub; q++)
-                                            m_t += Vol[q];
-                                        for (int s = 0; s < p.row_numShapes; s++) {
-                                            rtmp = 0.;
-                                            #pragma ivdep
-                                            for (int q = 0; q < p.numQuadSub; q++) {
-                                                const double Sq = S[INDEX2(s, q, p.row_numShapes)];
-                                                rtmp += Vol[q] * Sq * Sq;
-                                            }
-                                            #pragma ivdep
-                                            for (int k = 0; k < p.numEqu; k++)
-                                                EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
-                                            diagS += rtmp;
+                                        for (int q = 0; q < p.numQuadSub; q++) {
+                                            const double Sq = S[INDEX2(s, q, p.row_numShapes)];
+                                            rtmp += Vol[q] * Sq * Sq;
                                         }
+                                        #pragma ivdep
+                                        for (int k = 0; k < p.numEqu; k++)
+                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp;
+                                        diagS += rtmp;
+                                    }
 
-                                        // rescale diagonals by m_t/diagS to
-                                        // ensure consistent mass over element
-                                        rtmp = m_t / diagS;
-                                        for (int s = 0; s < p.row_numShapes; s++)
+                                    // rescale diagonals by m_t/diagS to
+                                    // ensure consistent mass over element
+                                    rtmp = m_t / diagS;
+                                    for (int s = 0; s < p.row_numShapes; s++)
+                                        #pragma ivdep
+                                        for (int k = 0; k < p.numEqu; k++)
+                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] *= rtmp * D_p[k];
+                                } else { // row-sum lumping
+                                    for (int s = 0; s < p.row_numShapes; s++) {
+                                        for (int k = 0; k < p.numEqu; k++) {
+                                            double rtmp = 0.;
                                             #pragma ivdep
-                                            for (int k = 0; k < p.numEqu; k++)
-                                                EM_lumpedMat[INDEX2(k, s, p.numEqu)] *= rtmp * D_p[k];
-                                    } else { // row-sum lumping
-                                        for (int s = 0; s < p.row_numShapes; s++) {
-                                            for (int k = 0; k < p.numEqu; k++) {
-                                                double rtmp = 0.;
-                                                #pragma ivdep
-                                                for (int q = 0; q < p.numQuadSub; q++)
-                                                    rtmp += Vol[q] * S[INDEX2(s, q, p.row_numShapes)];
-                                                EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp * D_p[k];
-                                            }
+                                            for (int q = 0; q < p.numQuadSub; q++)
+                                                rtmp += Vol[q] * S[INDEX2(s, q, p.row_numShapes)];
+                                            EM_lumpedMat[INDEX2(k, s, p.numEqu)] = rtmp * D_p[k];
                                         }
                                     }
-                                    for (int q = 0; q < p.row_numShapesTotal; q++)
-                                        row_index[q] = p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
-                                    util::addScatter(p.row_numShapesTotal,
-                                                &row_index[0], p.numEqu,
-                                                &EM_lumpedMat[0], lumpedMat_p,
-                                                p.row_DOF_UpperBound);
-                                } // end of isub loop
-                            } // end color check
+                                }
+                                for (int q = 0; q < p.row_numShapesTotal; q++)
+                                    row_index[q] = p.row_DOF[elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
+                                util::addScatter(p.row_numShapesTotal,
+                                            &row_index[0], p.numEqu,
+                                            &EM_lumpedMat[0], lumpedMat_p,
+                                            p.row_DOF_UpperBound);
+                            } // end of isub loop
                         } // end element loop
                     } // end color loop
                 }
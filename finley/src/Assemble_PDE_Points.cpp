@@ -52,26 +52,27 @@ void Assemble_PDE_Points(const AssembleParameters& p,
         F_p = p.F.getSampleDataRW(0, zero);
     }
 
+    const index_t* colorOffsets = p.elements->borrowColorOffsets();
+    const index_t* coloredElements = p.elements->borrowColoredElements();
 #pragma omp parallel
     {
         for (index_t color = p.elements->minColor; color <= p.elements->maxColor; color++) {
-            // loop over all elements
+            // loop over the elements of this colour
 #pragma omp for
-            for (index_t e = 0; e < p.elements->numElements; e++) {
-                if (p.elements->Color[e] == color) {
-                    index_t rowIndex = p.row_DOF[p.elements->Nodes[INDEX2(0,e,p.NN)]];
-                    if (!y_dirac.isEmpty()) {
-                        const Scalar* y_dirac_p = y_dirac.getSampleDataRO(e, zero);
-                        util::addScatter(1, &rowIndex, p.numEqu,
-                                         y_dirac_p, F_p, p.row_DOF_UpperBound);
-                    }
+            for (index_t k = colorOffsets[color-p.elements->minColor]; k < colorOffsets[color-p.elements->minColor+1]; k++) {
+                const index_t e = coloredElements[k];
+                index_t rowIndex = p.row_DOF[p.elements->Nodes[INDEX2(0,e,p.NN)]];
+                if (!y_dirac.isEmpty()) {
+                    const Scalar* y_dirac_p = y_dirac.getSampleDataRO(e, zero);
+                    util::addScatter(1, &rowIndex, p.numEqu,
+                                     y_dirac_p, F_p, p.row_DOF_UpperBound);
+                }
                    
-                    if (!d_dirac.isEmpty()) {
-                        const Scalar* d_dirac_p = d_dirac.getSampleDataRO(e, zero);
-                        Assemble_addToSystemMatrix(p.S, 1, &rowIndex,
-                                p.numEqu, 1, &rowIndex, p.numComp, d_dirac_p);
-                    }
-                } // end color check
+                if (!d_dirac.isEmpty()) {
+                    const Scalar* d_dirac_p = d_dirac.getSampleDataRO(e, zero);
+                    Assemble_addToSystemMatrix(p.S, 1, &rowIndex,
+                            p.numEqu, 1, &rowIndex, p.numComp, d_dirac_p);
+                }
             } // end element loop
         } // end color loop
     } // end parallel region
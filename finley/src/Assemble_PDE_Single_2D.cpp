@@ -65,6 +65,14 @@ void Assemble_PDE_Single_2D(const AssembleParameters& p,
     const int len_EM_S = p.row_numShapesTotal*p.col_numShapesTotal;
     const int len_EM_F = p.row_numShapesTotal;
 
+    // the integrals of shape function products needed for constant
+    // coefficients are kept between calls if caching is switched on
+    p.row_jac->updateIntegrals(!A.isEmpty() && !expandedA,
+            (!B.isEmpty() && !expandedB) || (!C.isEmpty() && !expandedC),
+            !D.isEmpty() && !expandedD);
+
+    const index_t* colorOffsets = p.elements->borrowColorOffsets();
+    const index_t* coloredElements = p.elements->borrowColoredElements();
 #pragma omp parallel
     {
         std::vector<Scalar> EM_S(len_EM_S);
@@ -72,38 +80,52 @@ void Assemble_PDE_Single_2D(const AssembleParameters& p,
         IndexVector row_index(len_EM_F);
 
         for (index_t color = p.elements->minColor; color <= p.elements->maxColor; color++) {
-            // loop over all elements
+            // loop over the elements of this colour
 #pragma omp for
-            for (index_t e = 0; e < p.elements->numElements; e++) {
-                if (p.elements->Color[e] == color) {
-                    for (int isub = 0; isub < p.numSub; isub++) {
-                        const double* Vol = &(p.row_jac->volume[INDEX3(0,isub,e,p.numQuadSub,p.numSub)]);
-                        const double* DSDX = &(p.row_jac->DSDX[INDEX5(0,0,0,isub,e, p.row_numShapesTotal,DIM,p.numQuadSub,p.numSub)]);
-                        std::fill(EM_S.begin(), EM_S.end(), zero);
-                        std::fill(EM_F.begin(), EM_F.end(), zero);
-                        bool add_EM_F = false;
-                        bool add_EM_S = false;
-                        ///////////////
-                        // process A //
-                        ///////////////
-                        if (!A.isEmpty()) {
-                            const Scalar* A_p = A.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedA) {
-                                const Scalar* A_q = &A_p[INDEX4(0,0,0,isub,DIM,DIM,p.numQuadSub)];
+            for (index_t k = colorOffsets[color-p.elements->minColor]; k < colorOffsets[color-p.elements->minColor+1]; k++) {
+                const index_t e = coloredElements[k];
+                for (int isub = 0; isub < p.numSub; isub++) {
+                    const double* Vol = &(p.row_jac->volume[INDEX3(0,isub,e,p.numQuadSub,p.numSub)]);
+                    const double* DSDX = &(p.row_jac->DSDX[INDEX5(0,0,0,isub,e, p.row_numShapesTotal,DIM,p.numQuadSub,p.numSub)]);
+                    std::fill(EM_S.begin(), EM_S.end(), zero);
+                    std::fill(EM_F.begin(), EM_F.end(), zero);
+                    bool add_EM_F = false;
+                    bool add_EM_S = false;
+                    ///////////////
+                    // process A //
+                    ///////////////
+                    if (!A.isEmpty()) {
+                        const Scalar* A_p = A.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedA) {
+                            const Scalar* A_q = &A_p[INDEX4(0,0,0,isub,DIM,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    Scalar f = zero;
+                                    for (int q = 0; q < p.numQuadSub; q++) {
+                                        f += Vol[q]*(DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(0,0,q,DIM,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                            + DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(0,1,q,DIM,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
+                                            + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(1,0,q,DIM,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                            + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(1,1,q,DIM,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]);
+                                    }
+                                    EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                }
+                            }
+                        } else { // constant A
+                            const double* DD = p.row_jac->getCachedIntegralsDD(e, isub);
+                            if (DD) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
-                                        Scalar f = zero;
-                                        for (int q = 0; q < p.numQuadSub; q++) {
-                                            f += Vol[q]*(DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(0,0,q,DIM,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                + DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(0,1,q,DIM,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
-                                                + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(1,0,q,DIM,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX3(1,1,q,DIM,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]);
+                                        const double* f = &DD[INDEX4(0,0,s,r,DIM,DIM,p.row_numShapes)];
+                                        Scalar EM = zero;
+                                        for (int i = 0; i < DIM; i++) {
+                                            for (int j = 0; j < DIM; j++)
+                                                EM += f[INDEX2(i,j,DIM)] * A_p[INDEX2(i,j,DIM)];
                                         }
-                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += EM;
                                     }
                                 }
-                            } else { // constant A
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f00 = zero;
@@ -127,25 +149,39 @@ void Assemble_PDE_Single_2D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process B //
-                        ///////////////
-                        if (!B.isEmpty()) {
-                            const Scalar* B_p = B.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedB) {
-                                const Scalar* B_q = &B_p[INDEX3(0,0,isub,DIM,p.numQuadSub)];
+                    }
+                    ///////////////
+                    // process B //
+                    ///////////////
+                    if (!B.isEmpty()) {
+                        const Scalar* B_p = B.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedB) {
+                            const Scalar* B_q = &B_p[INDEX3(0,0,isub,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    Scalar f = zero;
+                                    for (int q = 0; q < p.numQuadSub; q++) {
+                                        f += Vol[q]*S[INDEX2(r,q,p.row_numShapes)]*(DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*B_q[INDEX2(0,q,DIM)]
+                                                + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*B_q[INDEX2(1,q,DIM)]);
+                                    }
+                                    EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                }
+                            }
+                        } else { // constant B
+                            const double* DS = p.row_jac->getCachedIntegralsDS(e, isub);
+                            if (DS) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
-                                        Scalar f = zero;
-                                        for (int q = 0; q < p.numQuadSub; q++) {
-                                            f += Vol[q]*S[INDEX2(r,q,p.row_numShapes)]*(DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*B_q[INDEX2(0,q,DIM)]
-                                                    + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*B_q[INDEX2(1,q,DIM)]);
+                                        const double* f = &DS[INDEX3(0,s,r,DIM,p.row_numShapes)];
+                                        Scalar EM = zero;
+                                        for (int i = 0; i < DIM; i++) {
+                                            EM += f[i] * B_p[i];
                                         }
-                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += EM;
                                     }
                                 }
-                            } else { // constant B
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f0 = zero;
@@ -160,25 +196,39 @@ void Assemble_PDE_Single_2D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process C //
-                        ///////////////
-                        if (!C.isEmpty()) {
-                            const Scalar* C_p = C.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedC) {
-                                const Scalar* C_q = &C_p[INDEX3(0,0,isub,DIM,p.numQuadSub)];
+                    }
+                    ///////////////
+                    // process C //
+                    ///////////////
+                    if (!C.isEmpty()) {
+                        const Scalar* C_p = C.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedC) {
+                            const Scalar* C_q = &C_p[INDEX3(0,0,isub,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    Scalar f = zero;
+                                    for (int q = 0; q < p.numQuadSub; q++) {
+                                        f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*(C_q[INDEX2(0,q,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                                + C_q[INDEX2(1,q,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]);
+                                    }
+                                    EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                }
+                            }
+                        } else { // constant C
+                            const double* DS = p.row_jac->getCachedIntegralsDS(e, isub);
+                            if (DS) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
-                                        Scalar f = zero;
-                                        for (int q = 0; q < p.numQuadSub; q++) {
-                                            f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*(C_q[INDEX2(0,q,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                    + C_q[INDEX2(1,q,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]);
+                                        const double* f = &DS[INDEX3(0,r,s,DIM,p.row_numShapes)];
+                                        Scalar EM = zero;
+                                        for (int i = 0; i < DIM; i++) {
+                                            EM += f[i] * C_p[i];
                                         }
-                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += EM;
                                     }
                                 }
-                            } else { // constant C
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f0 = zero;
@@ -193,24 +243,34 @@ void Assemble_PDE_Single_2D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process D //
-                        ///////////////
-                        if (!D.isEmpty()) {
-                            const Scalar* D_p = D.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedD) {
-                                const Scalar* D_q = &D_p[INDEX2(0, isub, p.numQuadSub)];
+                    }
+                    ///////////////
+                    // process D //
+                    ///////////////
+                    if (!D.isEmpty()) {
+                        const Scalar* D_p = D.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedD) {
+                            const Scalar* D_q = &D_p[INDEX2(0, isub, p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    Scalar f = zero;
+                                    for (int q = 0; q < p.numQuadSub; q++) {
+                                        f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*D_q[q]*S[INDEX2(r,q,p.row_numShapes)];
+                                    }
+                                    EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                }
+                            }
+                        } else { // constant D
+                            const double* SS = p.row_jac->getCachedIntegralsSS(e, isub);
+                            if (SS) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
-                                        Scalar f = zero;
-                                        for (int q = 0; q < p.numQuadSub; q++) {
-                                            f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*D_q[q]*S[INDEX2(r,q,p.row_numShapes)];
-                                        }
-                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        const double f = SS[INDEX2(s,r,p.row_numShapes)];
+                                        EM_S[INDEX4(0,0,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += f*D_p[0];
                                     }
                                 }
-                            } else { // constant D
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f = zero;
@@ -222,76 +282,76 @@ void Assemble_PDE_Single_2D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process X //
-                        ///////////////
-                        if (!X.isEmpty()) {
-                            const Scalar* X_p = X.getSampleDataRO(e, zero);
-                            add_EM_F = true;
-                            if (expandedX) {
-                                const Scalar* X_q = &X_p[INDEX3(0,0,isub,DIM,p.numQuadSub)];
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    Scalar f = zero;
-                                    for (int q = 0; q < p.numQuadSub; q++) {
-                                        f += Vol[q]*(DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*X_q[INDEX2(0,q,DIM)]
-                                                 + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*X_q[INDEX2(1,q,DIM)]);
-                                    }
-                                    EM_F[INDEX2(0,s,p.numEqu)] += f;
+                    }
+                    ///////////////
+                    // process X //
+                    ///////////////
+                    if (!X.isEmpty()) {
+                        const Scalar* X_p = X.getSampleDataRO(e, zero);
+                        add_EM_F = true;
+                        if (expandedX) {
+                            const Scalar* X_q = &X_p[INDEX3(0,0,isub,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                Scalar f = zero;
+                                for (int q = 0; q < p.numQuadSub; q++) {
+                                    f += Vol[q]*(DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*X_q[INDEX2(0,q,DIM)]
+                                             + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*X_q[INDEX2(1,q,DIM)]);
                                 }
-                            } else { // constant X
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    Scalar f0 = zero;
-                                    Scalar f1 = zero;
-                                    for (int q = 0; q < p.numQuadSub; q++) {
-                                        f0 += Vol[q]*DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)];
-                                        f1 += Vol[q]*DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)];
-                                    }
-                                    EM_F[INDEX2(0,s,p.numEqu)] += f0*X_p[0] + f1*X_p[1];
+                                EM_F[INDEX2(0,s,p.numEqu)] += f;
+                            }
+                        } else { // constant X
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                Scalar f0 = zero;
+                                Scalar f1 = zero;
+                                for (int q = 0; q < p.numQuadSub; q++) {
+                                    f0 += Vol[q]*DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)];
+                                    f1 += Vol[q]*DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)];
                                 }
+                                EM_F[INDEX2(0,s,p.numEqu)] += f0*X_p[0] + f1*X_p[1];
                             }
                         }
-                        ///////////////
-                        // process Y //
-                        ///////////////
-                        if (!Y.isEmpty()) {
-                            const Scalar* Y_p = Y.getSampleDataRO(e, zero);
-                            add_EM_F = true;
-                            if (expandedY) {
-                                const Scalar* Y_q = &Y_p[INDEX2(0,isub,p.numQuadSub)];
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    Scalar f = zero;
-                                    for (int q = 0; q < p.numQuadSub; q++) {
-                                        f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*Y_q[q];
-                                    }
-                                    EM_F[INDEX2(0,s,p.numEqu)] += f;
+                    }
+                    ///////////////
+                    // process Y //
+                    ///////////////
+                    if (!Y.isEmpty()) {
+                        const Scalar* Y_p = Y.getSampleDataRO(e, zero);
+                        add_EM_F = true;
+                        if (expandedY) {
+                            const Scalar* Y_q = &Y_p[INDEX2(0,isub,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                Scalar f = zero;
+                                for (int q = 0; q < p.numQuadSub; q++) {
+                                    f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*Y_q[q];
                                 }
-                            } else { // constant Y
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    Scalar f = zero;
-                                    for (int q = 0; q < p.numQuadSub; q++) {
-                                        f += Vol[q] * S[INDEX2(s,q,p.row_numShapes)];
-                                    }
-                                    EM_F[INDEX2(0,s,p.numEqu)] += f * Y_p[0];
+                                EM_F[INDEX2(0,s,p.numEqu)] += f;
+                            }
+                        } else { // constant Y
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                Scalar f = zero;
+                                for (int q = 0; q < p.numQuadSub; q++) {
+                                    f += Vol[q] * S[INDEX2(s,q,p.row_numShapes)];
                                 }
+                                EM_F[INDEX2(0,s,p.numEqu)] += f * Y_p[0];
                             }
                         }
-                        // add the element matrices onto the matrix and
-                        // right hand side
-                        for (int q = 0; q < p.row_numShapesTotal; q++) {
-                            row_index[q] = p.row_DOF[p.elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
-                        }
-                        if (add_EM_F) {
-                            util::addScatter(p.row_numShapesTotal,
-                                    &row_index[0], p.numEqu, &EM_F[0], F_p,
-                                    p.row_DOF_UpperBound);
-                        }
-                        if (add_EM_S)
-                            Assemble_addToSystemMatrix(p.S,
-                                    p.row_numShapesTotal, &row_index[0],
-                                    p.numEqu, p.col_numShapesTotal,
-                                    &row_index[0], p.numComp, &EM_S[0]);
-                    } // end of isub
-                } // end color check
+                    }
+                    // add the element matrices onto the matrix and
+                    // right hand side
+                    for (int q = 0; q < p.row_numShapesTotal; q++) {
+                        row_index[q] = p.row_DOF[p.elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
+                    }
+                    if (add_EM_F) {
+                        util::addScatter(p.row_numShapesTotal,
+                                &row_index[0], p.numEqu, &EM_F[0], F_p,
+                                p.row_DOF_UpperBound);
+                    }
+                    if (add_EM_S)
+                        Assemble_addToSystemMatrix(p.S,
+                                p.row_numShapesTotal, &row_index[0],
+                                p.numEqu, p.col_numShapesTotal,
+                                &row_index[0], p.numComp, &EM_S[0]);
+                } // end of isub
             } // end element loop
         } // end color loop
     } // end parallel region
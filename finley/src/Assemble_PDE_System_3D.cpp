@@ -68,6 +68,14 @@ void Assemble_PDE_System_3D(const AssembleParameters& p,
     const size_t len_EM_S = p.row_numShapesTotal*p.col_numShapesTotal*p.numEqu*p.numComp;
     const size_t len_EM_F = p.row_numShapesTotal*p.numEqu;
 
+    // the integrals of shape function products needed for constant
+    // coefficients are kept between calls if caching is switched on
+    p.row_jac->updateIntegrals(!A.isEmpty() && !expandedA,
+            (!B.isEmpty() && !expandedB) || (!C.isEmpty() && !expandedC),
+            !D.isEmpty() && !expandedD);
+
+    const index_t* colorOffsets = p.elements->borrowColorOffsets();
+    const index_t* coloredElements = p.elements->borrowColoredElements();
 #pragma omp parallel
     {
         std::vector<Scalar> EM_S(len_EM_S);
@@ -75,48 +83,66 @@ void Assemble_PDE_System_3D(const AssembleParameters& p,
         IndexVector row_index(p.row_numShapesTotal);
 
         for (index_t color = p.elements->minColor; color <= p.elements->maxColor; color++) {
-            // loop over all elements
+            // loop over the elements of this colour
 #pragma omp for
-            for (index_t e = 0; e < p.elements->numElements; e++) {
-                if (p.elements->Color[e] == color) {
-                    for (int isub = 0; isub < p.numSub; isub++) {
-                        const double* Vol = &(p.row_jac->volume[INDEX3(0,isub,e,p.numQuadSub,p.numSub)]);
-                        const double* DSDX = &(p.row_jac->DSDX[INDEX5(0,0,0,isub,e, p.row_numShapesTotal,DIM,p.numQuadSub,p.numSub)]);
-                        std::fill(EM_S.begin(), EM_S.end(), zero);
-                        std::fill(EM_F.begin(), EM_F.end(), zero);
-                        bool add_EM_F = false;
-                        bool add_EM_S = false;
-                        ///////////////
-                        // process A //
-                        ///////////////
-                        if (!A.isEmpty()) {
-                            const Scalar* A_p = A.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedA) {
-                                const Scalar* A_q = &A_p[INDEX6(0,0,0,0,0,isub,p.numEqu,DIM,p.numComp,DIM,p.numQuadSub)];
+            for (index_t k = colorOffsets[color-p.elements->minColor]; k < colorOffsets[color-p.elements->minColor+1]; k++) {
+                const index_t e = coloredElements[k];
+                for (int isub = 0; isub < p.numSub; isub++) {
+                    const double* Vol = &(p.row_jac->volume[INDEX3(0,isub,e,p.numQuadSub,p.numSub)]);
+                    const double* DSDX = &(p.row_jac->DSDX[INDEX5(0,0,0,isub,e, p.row_numShapesTotal,DIM,p.numQuadSub,p.numSub)]);
+                    std::fill(EM_S.begin(), EM_S.end(), zero);
+                    std::fill(EM_F.begin(), EM_F.end(), zero);
+                    bool add_EM_F = false;
+                    bool add_EM_S = false;
+                    ///////////////
+                    // process A //
+                    ///////////////
+                    if (!A.isEmpty()) {
+                        const Scalar* A_p = A.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedA) {
+                            const Scalar* A_q = &A_p[INDEX6(0,0,0,0,0,isub,p.numEqu,DIM,p.numComp,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    for (int k = 0; k < p.numEqu; k++) {
+                                        for (int m = 0; m < p.numComp; m++) {
+                                            Scalar f = zero;
+                                            for (int q = 0; q < p.numQuadSub; q++) {
+                                                f += Vol[q]*(
+                                                        DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,0,m,0,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,0,m,1,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,0,m,2,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,1,m,0,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,1,m,1,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,1,m,2,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,2,m,0,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,2,m,1,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
+                                                      + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,2,m,2,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]);
+                                            }
+                                            EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        }
+                                    }
+                                }
+                            }
+                        } else { // constant A
+                            const double* DD = p.row_jac->getCachedIntegralsDD(e, isub);
+                            if (DD) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
+                                        const double* f = &DD[INDEX4(0,0,s,r,DIM,DIM,p.row_numShapes)];
                                         for (int k = 0; k < p.numEqu; k++) {
                                             for (int m = 0; m < p.numComp; m++) {
-                                                Scalar f = zero;
-                                                for (int q = 0; q < p.numQuadSub; q++) {
-                                                    f += Vol[q]*(
-                                                            DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,0,m,0,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,0,m,1,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,0,m,2,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,1,m,0,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,1,m,1,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,1,m,2,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,2,m,0,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,2,m,1,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
-                                                          + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*A_q[INDEX5(k,2,m,2,q,p.numEqu,DIM,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]);
+                                                Scalar EM = zero;
+                                                for (int i = 0; i < DIM; i++) {
+                                                    for (int j = 0; j < DIM; j++)
+                                                        EM += f[INDEX2(i,j,DIM)] * A_p[INDEX4(k,i,m,j,p.numEqu,DIM,p.numComp)];
                                                 }
-                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += EM;
                                             }
                                         }
                                     }
                                 }
-                            } else { // constant A
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f00 = zero;
@@ -162,31 +188,49 @@ void Assemble_PDE_System_3D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process B //
-                        ///////////////
-                        if (!B.isEmpty()) {
-                            const Scalar* B_p = B.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedB) {
-                                const Scalar* B_q = &B_p[INDEX5(0,0,0,0,isub,p.numEqu,DIM,p.numComp,p.numQuadSub)];
+                    }
+                    ///////////////
+                    // process B //
+                    ///////////////
+                    if (!B.isEmpty()) {
+                        const Scalar* B_p = B.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedB) {
+                            const Scalar* B_q = &B_p[INDEX5(0,0,0,0,isub,p.numEqu,DIM,p.numComp,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    for (int k = 0; k < p.numEqu; k++) {
+                                        for (int m = 0; m < p.numComp; m++) {
+                                            Scalar f = zero;
+                                            for (int q = 0; q < p.numQuadSub; q++) {
+                                                f += Vol[q]*S[INDEX2(r,q,p.row_numShapes)]*(
+                                                        DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*B_q[INDEX4(k,0,m,q,p.numEqu,DIM,p.numComp)]
+                                                      + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*B_q[INDEX4(k,1,m,q,p.numEqu,DIM,p.numComp)]
+                                                      + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*B_q[INDEX4(k,2,m,q,p.numEqu,DIM,p.numComp)]);
+                                            }
+                                            EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        }
+                                    }
+                                }
+                            }
+                        } else { // constant B
+                            const double* DS = p.row_jac->getCachedIntegralsDS(e, isub);
+                            if (DS) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
+                                        const double* f = &DS[INDEX3(0,s,r,DIM,p.row_numShapes)];
                                         for (int k = 0; k < p.numEqu; k++) {
                                             for (int m = 0; m < p.numComp; m++) {
-                                                Scalar f = zero;
-                                                for (int q = 0; q < p.numQuadSub; q++) {
-                                                    f += Vol[q]*S[INDEX2(r,q,p.row_numShapes)]*(
-                                                            DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*B_q[INDEX4(k,0,m,q,p.numEqu,DIM,p.numComp)]
-                                                          + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*B_q[INDEX4(k,1,m,q,p.numEqu,DIM,p.numComp)]
-                                                          + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*B_q[INDEX4(k,2,m,q,p.numEqu,DIM,p.numComp)]);
+                                                Scalar EM = zero;
+                                                for (int i = 0; i < DIM; i++) {
+                                                    EM += f[i] * B_p[INDEX3(k,i,m,p.numEqu,DIM)];
                                                 }
-                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += EM;
                                             }
                                         }
                                     }
                                 }
-                            } else { // constant B
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f0 = zero;
@@ -210,31 +254,49 @@ void Assemble_PDE_System_3D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process C //
-                        ///////////////
-                        if (!C.isEmpty()) {
-                            const Scalar* C_p = C.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedC) {
-                                const Scalar* C_q = &C_p[INDEX5(0,0,0,0,isub,p.numEqu,p.numComp,DIM,p.numQuadSub)];
+                    }
+                    ///////////////
+                    // process C //
+                    ///////////////
+                    if (!C.isEmpty()) {
+                        const Scalar* C_p = C.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedC) {
+                            const Scalar* C_q = &C_p[INDEX5(0,0,0,0,isub,p.numEqu,p.numComp,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    for (int k = 0; k < p.numEqu; k++) {
+                                        for (int m = 0; m < p.numComp; m++) {
+                                            Scalar f = zero;
+                                            for (int q = 0; q < p.numQuadSub; q++) {
+                                                f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*(
+                                                        C_q[INDEX4(k,m,0,q,p.numEqu,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
+                                                      + C_q[INDEX4(k,m,1,q,p.numEqu,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
+                                                      + C_q[INDEX4(k,m,2,q,p.numEqu,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]);
+                                            }
+                                            EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        }
+                                    }
+                                }
+                            }
+                        } else { // constant C
+                            const double* DS = p.row_jac->getCachedIntegralsDS(e, isub);
+                            if (DS) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
+                                        const double* f = &DS[INDEX3(0,r,s,DIM,p.row_numShapes)];
                                         for (int k = 0; k < p.numEqu; k++) {
                                             for (int m = 0; m < p.numComp; m++) {
-                                                Scalar f = zero;
-                                                for (int q = 0; q < p.numQuadSub; q++) {
-                                                    f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*(
-                                                            C_q[INDEX4(k,m,0,q,p.numEqu,p.numComp,DIM)]*DSDX[INDEX3(r,0,q,p.row_numShapesTotal,DIM)]
-                                                          + C_q[INDEX4(k,m,1,q,p.numEqu,p.numComp,DIM)]*DSDX[INDEX3(r,1,q,p.row_numShapesTotal,DIM)]
-                                                          + C_q[INDEX4(k,m,2,q,p.numEqu,p.numComp,DIM)]*DSDX[INDEX3(r,2,q,p.row_numShapesTotal,DIM)]);
+                                                Scalar EM = zero;
+                                                for (int i = 0; i < DIM; i++) {
+                                                    EM += f[i] * C_p[INDEX3(k,m,i,p.numEqu,p.numComp)];
                                                 }
-                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += EM;
                                             }
                                         }
                                     }
                                 }
-                            } else { // constant C
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f0 = zero;
@@ -258,28 +320,42 @@ void Assemble_PDE_System_3D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process D //
-                        ///////////////
-                        if (!D.isEmpty()) {
-                            const Scalar* D_p = D.getSampleDataRO(e, zero);
-                            add_EM_S = true;
-                            if (expandedD) {
-                                const Scalar* D_q = &D_p[INDEX4(0,0,0,isub,p.numEqu,p.numComp,p.numQuadSub)];
+                    }
+                    ///////////////
+                    // process D //
+                    ///////////////
+                    if (!D.isEmpty()) {
+                        const Scalar* D_p = D.getSampleDataRO(e, zero);
+                        add_EM_S = true;
+                        if (expandedD) {
+                            const Scalar* D_q = &D_p[INDEX4(0,0,0,isub,p.numEqu,p.numComp,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int r = 0; r < p.col_numShapes; r++) {
+                                    for (int k = 0; k < p.numEqu; k++) {
+                                        for (int m = 0; m < p.numComp; m++) {
+                                            Scalar f = zero;
+                                            for (int q = 0; q < p.numQuadSub; q++) {
+                                                f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*D_q[INDEX3(k,m,q,p.numEqu,p.numComp)]*S[INDEX2(r,q,p.row_numShapes)];
+                                            }
+                                            EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                        }
+                                    }
+                                }
+                            }
+                        } else { // constant D
+                            const double* SS = p.row_jac->getCachedIntegralsSS(e, isub);
+                            if (SS) {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
+                                        const double f = SS[INDEX2(s,r,p.row_numShapes)];
                                         for (int k = 0; k < p.numEqu; k++) {
                                             for (int m = 0; m < p.numComp; m++) {
-                                                Scalar f = zero;
-                                                for (int q = 0; q < p.numQuadSub; q++) {
-                                                    f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*D_q[INDEX3(k,m,q,p.numEqu,p.numComp)]*S[INDEX2(r,q,p.row_numShapes)];
-                                                }
-                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)]+=f;
+                                                EM_S[INDEX4(k,m,s,r,p.numEqu,p.numComp,p.row_numShapesTotal)] += f*D_p[INDEX2(k,m,p.numEqu)];
                                             }
                                         }
                                     }
                                 }
-                            } else { // constant D
+                            } else {
                                 for (int s = 0; s < p.row_numShapes; s++) {
                                     for (int r = 0; r < p.col_numShapes; r++) {
                                         Scalar f = zero;
@@ -295,90 +371,90 @@ void Assemble_PDE_System_3D(const AssembleParameters& p,
                                 }
                             }
                         }
-                        ///////////////
-                        // process X //
-                        ///////////////
-                        if (!X.isEmpty()) {
-                            const Scalar* X_p = X.getSampleDataRO(e, zero);
-                            add_EM_F = true;
-                            if (expandedX) {
-                                const Scalar* X_q = &X_p[INDEX4(0,0,0,isub,p.numEqu,DIM,p.numQuadSub)];
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    for (int k = 0; k < p.numEqu; k++) {
-                                        Scalar f = zero;
-                                        for (int q = 0; q < p.numQuadSub; q++) {
-                                            f += Vol[q]*(
-                                                    DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*X_q[INDEX3(k,0,q,p.numEqu,DIM)]
-                                                  + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*X_q[INDEX3(k,1,q,p.numEqu,DIM)]
-                                                  + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*X_q[INDEX3(k,2,q,p.numEqu,DIM)]);
-                                        }
-                                        EM_F[INDEX2(k,s,p.numEqu)] += f;
-                                    }
-                                }
-                            } else { // constant X
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    Scalar f0 = zero;
-                                    Scalar f1 = zero;
-                                    Scalar f2 = zero;
+                    }
+                    ///////////////
+                    // process X //
+                    ///////////////
+                    if (!X.isEmpty()) {
+                        const Scalar* X_p = X.getSampleDataRO(e, zero);
+                        add_EM_F = true;
+                        if (expandedX) {
+                            const Scalar* X_q = &X_p[INDEX4(0,0,0,isub,p.numEqu,DIM,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int k = 0; k < p.numEqu; k++) {
+                                    Scalar f = zero;
                                     for (int q = 0; q < p.numQuadSub; q++) {
-                                        f0 += Vol[q]*DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)];
-                                        f1 += Vol[q]*DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)];
-                                        f2 += Vol[q]*DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)];
-                                    }
-                                    for (int k = 0; k < p.numEqu; k++) {
-                                        EM_F[INDEX2(k,s,p.numEqu)] +=
-                                            f0 * X_p[INDEX2(k,0,p.numEqu)]
-                                          + f1 * X_p[INDEX2(k,1,p.numEqu)]
-                                          + f2 * X_p[INDEX2(k,2,p.numEqu)];
+                                        f += Vol[q]*(
+                                                DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)]*X_q[INDEX3(k,0,q,p.numEqu,DIM)]
+                                              + DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)]*X_q[INDEX3(k,1,q,p.numEqu,DIM)]
+                                              + DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)]*X_q[INDEX3(k,2,q,p.numEqu,DIM)]);
                                     }
+                                    EM_F[INDEX2(k,s,p.numEqu)] += f;
                                 }
                             }
-                        }
-                        ///////////////
-                        // process Y //
-                        ///////////////
-                        if (!Y.isEmpty()) {
-                            const Scalar* Y_p = Y.getSampleDataRO(e, zero);
-                            add_EM_F = true;
-                            if (expandedY) {
-                                const Scalar* Y_q = &Y_p[INDEX3(0,0,isub,p.numEqu,p.numQuadSub)];
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    for (int k = 0; k < p.numEqu; k++) {
-                                        Scalar f = zero;
-                                        for (int q = 0; q < p.numQuadSub; q++)
-                                            f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*Y_q[INDEX2(k,q,p.numEqu)];
-                                        EM_F[INDEX2(k,s,p.numEqu)]+=f;
-                                    }
+                        } else { // constant X
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                Scalar f0 = zero;
+                                Scalar f1 = zero;
+                                Scalar f2 = zero;
+                                for (int q = 0; q < p.numQuadSub; q++) {
+                                    f0 += Vol[q]*DSDX[INDEX3(s,0,q,p.row_numShapesTotal,DIM)];
+                                    f1 += Vol[q]*DSDX[INDEX3(s,1,q,p.row_numShapesTotal,DIM)];
+                                    f2 += Vol[q]*DSDX[INDEX3(s,2,q,p.row_numShapesTotal,DIM)];
                                 }
-                            } else { // constant Y
-                                for (int s = 0; s < p.row_numShapes; s++) {
-                                    Scalar f = zero;
-                                    for (int q = 0; q < p.numQuadSub; q++) {
-                                        f += Vol[q] * S[INDEX2(s,q,p.row_numShapes)];
-                                    }
-                                    for (int k = 0; k < p.numEqu; k++)
-                                        EM_F[INDEX2(k,s,p.numEqu)] += f * Y_p[k];
+                                for (int k = 0; k < p.numEqu; k++) {
+                                    EM_F[INDEX2(k,s,p.numEqu)] +=
+                                        f0 * X_p[INDEX2(k,0,p.numEqu)]
+                                      + f1 * X_p[INDEX2(k,1,p.numEqu)]
+                                      + f2 * X_p[INDEX2(k,2,p.numEqu)];
                                 }
                             }
                         }
-                        // add the element matrices onto the matrix and
-                        // right hand side
-                        for (int q = 0; q < p.row_numShapesTotal; q++) {
-                            row_index[q] = p.row_DOF[p.elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
-                        }
-                        if (add_EM_F) {
-                            util::addScatter(p.row_numShapesTotal,
-                                    &row_index[0], p.numEqu, &EM_F[0], F_p,
-                                    p.row_DOF_UpperBound);
-                        }
-                        if (add_EM_S) {
-                            Assemble_addToSystemMatrix(p.S,
-                                    p.row_numShapesTotal, &row_index[0],
-                                    p.numEqu, p.col_numShapesTotal,
-                                    &row_index[0], p.numComp, &EM_S[0]);
+                    }
+                    ///////////////
+                    // process Y //
+                    ///////////////
+                    if (!Y.isEmpty()) {
+                        const Scalar* Y_p = Y.getSampleDataRO(e, zero);
+                        add_EM_F = true;
+                        if (expandedY) {
+                            const Scalar* Y_q = &Y_p[INDEX3(0,0,isub,p.numEqu,p.numQuadSub)];
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                for (int k = 0; k < p.numEqu; k++) {
+                                    Scalar f = zero;
+                                    for (int q = 0; q < p.numQuadSub; q++)
+                                        f += Vol[q]*S[INDEX2(s,q,p.row_numShapes)]*Y_q[INDEX2(k,q,p.numEqu)];
+                                    EM_F[INDEX2(k,s,p.numEqu)]+=f;
+                                }
+                            }
+                        } else { // constant Y
+                            for (int s = 0; s < p.row_numShapes; s++) {
+                                Scalar f = zero;
+                                for (int q = 0; q < p.numQuadSub; q++) {
+                                    f += Vol[q] * S[INDEX2(s,q,p.row_numShapes)];
+                                }
+                                for (int k = 0; k < p.numEqu; k++)
+                                    EM_F[INDEX2(k,s,p.numEqu)] += f * Y_p[k];
+                            }
                         }
-                    } // end of isub
-                } // end color check
+                    }
+                    // add the element matrices onto the matrix and
+                    // right hand side
+                    for (int q = 0; q < p.row_numShapesTotal; q++) {
+                        row_index[q] = p.row_DOF[p.elements->Nodes[INDEX2(p.row_node[INDEX2(q,isub,p.row_numShapesTotal)],e,p.NN)]];
+                    }
+                    if (add_EM_F) {
+                        util::addScatter(p.row_numShapesTotal,
+                                &row_index[0], p.numEqu, &EM_F[0], F_p,
+                                p.row_DOF_UpperBound);
+                    }
+                    if (add_EM_S) {
+                        Assemble_addToSystemMatrix(p.S,
+                                p.row_numShapesTotal, &row_index[0],
+                                p.numEqu, p.col_numShapesTotal,
+                                &row_index[0], p.numComp, &EM_S[0]);
+                    }
+                } // end of isub
             } // end element loop
         } // end color loop
     } // end parallel region
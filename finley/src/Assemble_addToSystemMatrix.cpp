@@ -21,6 +21,8 @@
 #include <paso/SystemMatrix.h>
 #endif
 
+#include <algorithm>
+
 #ifdef ESYS_HAVE_TRILINOS
 #include <trilinoswrap/TrilinosMatrixAdapter.h>
 
@@ -33,6 +35,18 @@ using escript::DataTypes::real_t;
 using escript::DataTypes::cplx_t;
 
 #ifdef ESYS_HAVE_PASO
+/// returns the position of `idx` in the index range [begin, end) of a paso
+/// pattern or -1 if the entry is not in the pattern. paso::Pattern keeps the
+/// indices of each row sorted so a binary search can be used which is much
+/// faster than a linear scan for higher order elements and systems.
+static inline index_t findInPattern(const index_t* index, index_t begin,
+                                    index_t end, index_t idx)
+{
+    const index_t* last = index + end;
+    const index_t* p = std::lower_bound(index + begin, last, idx);
+    return (p != last && *p == idx ? p - index : -1);
+}
+
 static void addToSystemMatrixPasoCSC(paso::SystemMatrix* S, int NN_Equa,
                                      const index_t* Nodes_Equa, int num_Equa,
                                      int NN_Sol, const index_t* Nodes_Sol,
@@ -137,21 +151,20 @@ void addToSystemMatrixPasoCSC(paso::SystemMatrix* in, int NN_Equa,
                     for (int l_row = 0; l_row < num_subblocks_Equa; ++l_row) {
                         const index_t i_row = j_Equa*num_subblocks_Equa+index_offset+l_row;
                         if (i_row < numMyRows + index_offset ) {
-                            for (index_t k = mainBlock_ptr[i_col]-index_offset;
-                                 k < mainBlock_ptr[i_col + 1]-index_offset; ++k) {
-                                if (mainBlock_index[k] == i_row) {
-                                    // Entry array(k_Equa, j_Sol) is a block
-                                    // (col_block_size x col_block_size)
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir + row_block_size * l_row;
-                                            mainBlock_val[k*block_size + ir + row_block_size*ic] +=
-                                                array[INDEX4
-                                                  (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
-                                        }
+                            const index_t k = findInPattern(mainBlock_index,
+                                    mainBlock_ptr[i_col]-index_offset,
+                                    mainBlock_ptr[i_col + 1]-index_offset, i_row);
+                            if (k >= 0) {
+                                // Entry array(k_Equa, j_Sol) is a block
+                                // (col_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        mainBlock_val[k*block_size + ir + row_block_size*ic] +=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
                                     }
-                                    break;
                                 }
                             }
                         } else {
@@ -180,19 +193,18 @@ void addToSystemMatrixPasoCSC(paso::SystemMatrix* in, int NN_Equa,
                     for (int l_row = 0; l_row < num_subblocks_Equa; ++l_row) {
                         const index_t i_row = j_Equa * num_subblocks_Equa + index_offset + l_row;
                         if (i_row < numMyRows + index_offset) {
-                            for (index_t k = col_coupleBlock_ptr[i_col-numMyCols]-index_offset;
-                                 k < col_coupleBlock_ptr[i_col - numMyCols + 1] - index_offset; ++k) {
-                                if (col_coupleBlock_index[k] == i_row) {
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir + row_block_size * l_row;
-                                            col_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
-                                                array[INDEX4
-                                                  (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
-                                        }
+                            const index_t k = findInPattern(col_coupleBlock_index,
+                                    col_coupleBlock_ptr[i_col-numMyCols]-index_offset,
+                                    col_coupleBlock_ptr[i_col - numMyCols + 1] - index_offset, i_row);
+                            if (k >= 0) {
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        col_coupleBlock_val[k*block_size + ir + row_block_size*ic] +=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
                                     }
-                                    break;
                                 }
                             }
                         }
@@ -241,39 +253,37 @@ void addToSystemMatrixPasoCSR(paso::SystemMatrix* in, int NN_Equa,
                         // only look at the matrix rows stored on this processor
                         const index_t i_col = j_Sol * num_subblocks_Sol + index_offset + l_col;
                         if (i_col < numMyCols + index_offset) {
-                            for (index_t k = mainBlock_ptr[i_row] - index_offset;
-                                 k < mainBlock_ptr[i_row + 1] - index_offset; ++k) {
-                                if (mainBlock_index[k] == i_col) {
-                                    // Entry array(k_Sol, j_Equa) is a block
-                                    // (row_block_size x col_block_size)
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir + row_block_size * l_row;
-                                            mainBlock_val[k*block_size + ir + row_block_size*ic]+=
-                                                  array[INDEX4
-                                                    (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
-                                        }
+                            const index_t k = findInPattern(mainBlock_index,
+                                    mainBlock_ptr[i_row] - index_offset,
+                                    mainBlock_ptr[i_row + 1] - index_offset, i_col);
+                            if (k >= 0) {
+                                // Entry array(k_Sol, j_Equa) is a block
+                                // (row_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        mainBlock_val[k*block_size + ir + row_block_size*ic]+=
+                                              array[INDEX4
+                                                (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
                                     }
-                                    break;
                                 }
                             }
                         } else {
-                            for (index_t k = col_coupleBlock_ptr[i_row] - index_offset;
-                                 k < col_coupleBlock_ptr[i_row + 1] - index_offset; ++k) {
-                                if (col_coupleBlock_index[k] == i_col - numMyCols) {
-                                    // Entry array(k_Sol, j_Equa) is a block
-                                    // (row_block_size x col_block_size)
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir+row_block_size*l_row;
-                                            col_coupleBlock_val[k*block_size + ir + row_block_size*ic]+=
-                                                  array[INDEX4
-                                                    (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
-                                        }
+                            const index_t k = findInPattern(col_coupleBlock_index,
+                                    col_coupleBlock_ptr[i_row] - index_offset,
+                                    col_coupleBlock_ptr[i_row + 1] - index_offset, i_col - numMyCols);
+                            if (k >= 0) {
+                                // Entry array(k_Sol, j_Equa) is a block
+                                // (row_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir+row_block_size*l_row;
+                                        col_coupleBlock_val[k*block_size + ir + row_block_size*ic]+=
+                                              array[INDEX4
+                                                (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
                                     }
-                                    break;
                                 }
                             }
                         }
@@ -286,21 +296,20 @@ void addToSystemMatrixPasoCSR(paso::SystemMatrix* in, int NN_Equa,
                     for (int l_col = 0; l_col < num_subblocks_Sol; ++l_col) {
                         const index_t i_col = j_Sol * num_subblocks_Sol + index_offset + l_col;
                         if (i_col < numMyCols + index_offset) {
-                            for (index_t k = row_coupleBlock_ptr[i_row - numMyRows] - index_offset;
-                                 k < row_coupleBlock_ptr[i_row - numMyRows + 1] - index_offset; ++k) {
-                                if (row_coupleBlock_index[k] == i_col) {
-                                    // Entry array(k_Sol, j_Equa) is a block
-                                    // (row_block_size x col_block_size)
-                                    for (int ic = 0; ic < col_block_size; ++ic) {
-                                        const int i_Sol = ic + col_block_size * l_col;
-                                        for (int ir = 0; ir < row_block_size; ++ir) {
-                                            const int i_Eq = ir + row_block_size * l_row;
-                                            row_coupleBlock_val[k*block_size + ir + row_block_size*ic]+=
-                                                array[INDEX4
-                                                  (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
-                                        }
+                            const index_t k = findInPattern(row_coupleBlock_index,
+                                    row_coupleBlock_ptr[i_row - numMyRows] - index_offset,
+                                    row_coupleBlock_ptr[i_row - numMyRows + 1] - index_offset, i_col);
+                            if (k >= 0) {
+                                // Entry array(k_Sol, j_Equa) is a block
+                                // (row_block_size x col_block_size)
+                                for (int ic = 0; ic < col_block_size; ++ic) {
+                                    const int i_Sol = ic + col_block_size * l_col;
+                                    for (int ir = 0; ir < row_block_size; ++ir) {
+                                        const int i_Eq = ir + row_block_size * l_row;
+                                        row_coupleBlock_val[k*block_size + ir + row_block_size*ic]+=
+                                            array[INDEX4
+                                              (i_Eq, i_Sol, k_Equa, k_Sol, num_Equa, num_Sol, NN_Equa)];
                                     }
-                                    break;
                                 }
                             }
                         }
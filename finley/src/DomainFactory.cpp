@@ -99,8 +99,10 @@ inline void cleanupAndThrow(FinleyDomain* dom, string msg)
 
 Domain_ptr FinleyDomain::load(const string& fileName)
 {
-#ifdef ESYS_HAVE_NETCDF
     JMPI mpiInfo = makeInfo(MPI_COMM_WORLD);
+    if (isCheckpointFile(fileName, mpiInfo))
+        return loadBinary(fileName);
+#ifdef ESYS_HAVE_NETCDF
     const string fName(mpiInfo->appendRankToFileName(fileName));
 
     // Open NetCDF file for reading
@@ -490,8 +492,10 @@ Domain_ptr FinleyDomain::load(const string& fileName)
 
 Domain_ptr FinleyDomain::load(const string& fileName)
 {
-#ifdef ESYS_HAVE_NETCDF
     JMPI mpiInfo = makeInfo(MPI_COMM_WORLD);
+    if (isCheckpointFile(fileName, mpiInfo))
+        return loadBinary(fileName);
+#ifdef ESYS_HAVE_NETCDF
     const string fName(mpiInfo->appendRankToFileName(fileName));
 
     // Open NetCDF file for reading
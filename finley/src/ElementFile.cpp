@@ -18,9 +18,11 @@
 #include "ElementFile.h"
 
 #include <escript/Data.h>
+#include <escript/EscriptParams.h>
 #include <escript/index.h>
 
 #include <algorithm> // std::swap
+#include <cstdint>
 
 namespace finley {
 
@@ -28,6 +30,7 @@ namespace finley {
 /// use ElementFile::allocTable to allocate the element table
 ElementFile::ElementFile(const_ReferenceElementSet_ptr refSet,
                          escript::JMPI mpiInfo) :
+    colorOrderingValid(false),
     MPIInfo(mpiInfo),
     referenceElementSet(refSet),
     numElements(0),
@@ -68,6 +71,7 @@ void ElementFile::allocTable(dim_t NE)
         freeTable();
 
     numElements = NE;
+    colorOrderingValid = false;
     Owner = new int[numElements];
     Id = new index_t[numElements];
     Nodes = new index_t[numElements * numNodes];
@@ -97,6 +101,7 @@ void ElementFile::freeTable()
     delete[] Color;
     tagsInUse.clear();
     numElements = 0;
+    colorOrderingValid = false;
     maxColor = -1;
     minColor = 0;
 }
@@ -137,6 +142,7 @@ void ElementFile::gather(const index_t* index, const ElementFile* in)
     }
     minColor = std::min(minColor, in->minColor+maxColor+1);
     maxColor = std::max(maxColor, in->maxColor+maxColor+1);
+    colorOrderingValid = false;
 }
 
 /// scatters the ElementFile in into this ElementFile.
@@ -156,6 +162,7 @@ void ElementFile::scatter(index_t* index, const ElementFile* in)
     }
     minColor = std::min(minColor, in->minColor+maxColor+1);
     maxColor = std::max(maxColor, in->maxColor+maxColor+1);
+    colorOrderingValid = false;
 }
 
 void ElementFile::swapTable(ElementFile* other)
@@ -168,6 +175,8 @@ void ElementFile::swapTable(ElementFile* other)
     std::swap(Color, other->Color);
     std::swap(minColor, other->minColor);
     std::swap(maxColor, other->maxColor);
+    colorOrderingValid = false;
+    other->colorOrderingValid = false;
     std::swap(tagsInUse, other->tagsInUse);
 }
 
@@ -196,6 +205,7 @@ void ElementFile::optimizeOrdering()
 
     out->gather(index, this);
     swapTable(out);
+    updateColorOrdering();
     delete out;
     delete[] index;
 }
@@ -245,7 +255,18 @@ void ElementFile::setTags(int newTag, const escript::Data& mask)
     updateTagList();
 }
 
-/// Tries to reduce the number of colours used to colour the elements
+/// pseudo-random but reproducible priority of element e used by the
+/// colouring (splitmix64 finaliser)
+static inline uint64_t colorPriority(index_t e)
+{
+    uint64_t z = static_cast<uint64_t>(e) + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/// Colours the elements such that elements of the same colour do not share
+/// a degree of freedom, trying to keep the number of colours small
 void ElementFile::createColoring(const IndexVector& dofMap)
 {
     if (numElements < 1)
@@ -254,52 +275,140 @@ void ElementFile::createColoring(const IndexVector& dofMap)
     const int NN = numNodes;
     const std::pair<index_t,index_t> idRange(util::getMinMaxInt(
                                             1, dofMap.size(), &dofMap[0]));
-    const index_t len = idRange.second-idRange.first+1;
+    const dim_t len = idRange.second - idRange.first + 1;
 
-    // reset color vector
+    // build the lists of elements touching each DOF
+    IndexVector dofElementPtr(len + 1, 0);
+    IndexVector dofElements(numElements * NN);
 #pragma omp parallel for
-    for (index_t e = 0; e < numElements; e++)
-        Color[e] = -1;
+    for (index_t e = 0; e < numElements; e++) {
+        for (int i = 0; i < NN; i++) {
+#ifdef BOUNDS_CHECK
+            ESYS_ASSERT(Nodes[INDEX2(i, e, NN)] >= 0, "BOUNDS_CHECK");
+            ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first < len, "BOUNDS_CHECK");
+            ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first >= 0, "BOUNDS_CHECK");
+#endif
+            const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+#pragma omp atomic
+            dofElementPtr[dof + 1]++;
+        }
+    }
+    for (index_t n = 0; n < len; n++)
+        dofElementPtr[n + 1] += dofElementPtr[n];
+    {
+        IndexVector pos(dofElementPtr.begin(), dofElementPtr.end() - 1);
+#pragma omp parallel for
+        for (index_t e = 0; e < numElements; e++) {
+            for (int i = 0; i < NN; i++) {
+                const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+                index_t k;
+#pragma omp atomic capture
+                k = pos[dof]++;
+                dofElements[k] = e;
+            }
+        }
+    }
 
-    index_t numUncoloredElements = numElements;
+    // Jones-Plassmann colouring: in every round the uncoloured elements
+    // with a higher priority than all their uncoloured neighbours form an
+    // independent set and are coloured concurrently. The priorities only
+    // depend on the element index so the result does not depend on the
+    // number of threads.
+    const bool balanced = (escript::getEscriptParamInt("BALANCED_COLORING") > 0);
+    IndexVector uncolored(numElements);
+    std::vector<char> selected(numElements, 0);
+#pragma omp parallel for
+    for (index_t e = 0; e < numElements; e++) {
+        Color[e] = -1;
+        uncolored[e] = e;
+    }
+    std::vector<dim_t> colorCount;
     minColor = 0;
     maxColor = -1;
-    while (numUncoloredElements>0) {
-        // initialize the mask marking nodes used by a color
-        std::vector<index_t> maskDOF(len, -1);
-        numUncoloredElements=0;
 
-        // TODO: OMP
-        for (index_t e=0; e<numElements; e++) {
-            if (Color[e] < 0) {
-                // find out if element e is independent from the elements
-                // already coloured:
-                bool independent = true; 
-                for (int i=0; i<NN; i++) {
-#ifdef BOUNDS_CHECK
-                    ESYS_ASSERT(Nodes[INDEX2(i, e, NN)] >= 0, "BOUNDS_CHECK");
-                    ESYS_ASSERT(Nodes[INDEX2(i, e, NN)] < dofMap.size(), "BOUNDS_CHECK");
-                    ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first < len, "BOUNDS_CHECK");
-                    ESYS_ASSERT(dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first >= 0, "BOUNDS_CHECK");
-#endif
-                    if (maskDOF[dofMap[Nodes[INDEX2(i,e,NN)]]-idRange.first]>0) {
-                        independent=false;
-                        break;
+    while (!uncolored.empty()) {
+        const dim_t numUncolored = uncolored.size();
+#pragma omp parallel for
+        for (index_t k = 0; k < numUncolored; k++) {
+            const index_t e = uncolored[k];
+            const uint64_t prio = colorPriority(e);
+            bool isMax = true;
+            for (int i = 0; i < NN && isMax; i++) {
+                const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+                for (index_t j = dofElementPtr[dof]; j < dofElementPtr[dof + 1]; j++) {
+                    const index_t f = dofElements[j];
+                    if (f != e && Color[f] < 0) {
+                        const uint64_t fprio = colorPriority(f);
+                        if (fprio > prio || (fprio == prio && f > e)) {
+                            isMax = false;
+                            break;
+                        }
                     }
                 }
-                // if e is independent a new color is assigned and the nodes
-                // are marked as being used
-                if (independent) {
-                    for (int i=0; i<NN; i++)
-                        maskDOF[dofMap[Nodes[INDEX2(i,e,NN)]]-idRange.first] = 1;
-                    Color[e]=maxColor+1;
-                } else {
-                    numUncoloredElements++;
+            }
+            selected[e] = isMax;
+        }
+
+        // the selected elements are not neighbours of each other so their
+        // colours can be chosen independently
+        const dim_t numColors = maxColor + 1;
+#pragma omp parallel
+        {
+            // forbidden[c]==e marks colour c as used by a neighbour of e
+            IndexVector forbidden(numColors + 1, -1);
+#pragma omp for
+            for (index_t k = 0; k < numUncolored; k++) {
+                const index_t e = uncolored[k];
+                if (!selected[e])
+                    continue;
+                for (int i = 0; i < NN; i++) {
+                    const index_t dof = dofMap[Nodes[INDEX2(i, e, NN)]] - idRange.first;
+                    for (index_t j = dofElementPtr[dof]; j < dofElementPtr[dof + 1]; j++) {
+                        const index_t c = Color[dofElements[j]];
+                        if (c >= 0) {
+                            if (c >= static_cast<index_t>(forbidden.size()))
+                                forbidden.resize(c + 1, -1);
+                            forbidden[c] = e;
+                        }
+                    }
+                }
+                index_t color = -1;
+                if (balanced) {
+                    // pick the least used colour that is still available
+                    for (index_t c = 0; c < numColors; c++) {
+                        if (forbidden[c] != e && (color < 0 ||
+                                    colorCount[c] < colorCount[color]))
+                            color = c;
+                    }
+                }
+                if (color < 0) {
+                    color = 0;
+                    while (color < static_cast<index_t>(forbidden.size()) &&
+                        forbidden[color] == e)
+                        color++;
+                }
+                Color[e] = color;
+            }
+        }
+
+        // remove the coloured elements from the list
+        IndexVector remaining;
+        for (index_t k = 0; k < numUncolored; k++) {
+            const index_t e = uncolored[k];
+            if (selected[e]) {
+                const index_t c = Color[e];
+                if (c > maxColor) {
+                    maxColor = c;
+                    colorCount.resize(c + 1, 0);
                 }
-            } // if no colour yet
-        } // for all elements
-        maxColor++;
-    } // end of while loop
+                colorCount[c]++;
+            } else {
+                remaining.push_back(e);
+            }
+        }
+        uncolored.swap(remaining);
+    }
+    updateColorOrdering();
 }
 
 void ElementFile::markNodes(std::vector<short>& mask, int offset, bool useLinear)
@@ -482,5 +591,28 @@ void ElementFile::distributeByRankOfDOF(const std::vector<int>& mpiRankOfDOF, in
     }
 }
 
+void ElementFile::updateColorOrdering() const
+{
+    const dim_t numColors = std::max(maxColor-minColor+1, index_t(0));
+    colorOffsets.assign(numColors+1, 0);
+    // counting sort by colour, elements without a valid colour are skipped
+    // as they are by the colour loops
+    for (index_t e = 0; e < numElements; e++) {
+        const index_t c = Color[e]-minColor;
+        if (c >= 0 && c < numColors)
+            colorOffsets[c+1]++;
+    }
+    for (index_t c = 0; c < numColors; c++)
+        colorOffsets[c+1] += colorOffsets[c];
+    coloredElements.resize(colorOffsets[numColors]);
+    IndexVector pos(colorOffsets.begin(), colorOffsets.end()-1);
+    for (index_t e = 0; e < numElements; e++) {
+        const index_t c = Color[e]-minColor;
+        if (c >= 0 && c < numColors)
+            coloredElements[pos[c]++] = e;
+    }
+    colorOrderingValid = true;
+}
+
 } // namespace finley
 
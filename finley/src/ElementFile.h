@@ -57,6 +57,53 @@ struct ElementFile_Jacobians
     /// derivatives of shape functions in global coordinates at quadrature
     /// points
     double* DSDX;
+
+    /// builds the tables of element integrals requested by the flags if
+    /// the CACHE_ELEMENT_INTEGRALS escript parameter is set and the tables
+    /// of all element files fit into the memory limit it gives (in MB per
+    /// rank). Stale tables are released.
+    void updateIntegrals(bool needDD, bool needDS, bool needSS);
+
+    /// returns the cached integrals of the products of shape function
+    /// derivatives over sub-element isub of element e,
+    /// DD[INDEX4(i,j,s,r,numDim,numDim,numShapes)] =
+    /// sum_q volume[q]*dS_s/dx_i*dS_r/dx_j, or NULL if they are not cached
+    inline const double* getCachedIntegralsDD(index_t e, int isub) const
+    {
+        const int numShapes = BasisFunctions->Type->numShapes;
+        return (integralsDD ? &integralsDD[INDEX2(isub, e, numSub)
+                    * numDim * numDim * numShapes * numShapes] : NULL);
+    }
+
+    /// returns DS[INDEX3(i,s,r,numDim,numShapes)] =
+    /// sum_q volume[q]*dS_s/dx_i*S_r or NULL, see getCachedIntegralsDD
+    inline const double* getCachedIntegralsDS(index_t e, int isub) const
+    {
+        const int numShapes = BasisFunctions->Type->numShapes;
+        return (integralsDS ? &integralsDS[INDEX2(isub, e, numSub)
+                    * numDim * numShapes * numShapes] : NULL);
+    }
+
+    /// returns SS[INDEX2(s,r,numShapes)] = sum_q volume[q]*S_s*S_r or NULL,
+    /// see getCachedIntegralsDD
+    inline const double* getCachedIntegralsSS(index_t e, int isub) const
+    {
+        const int numShapes = BasisFunctions->Type->numShapes;
+        return (integralsSS ? &integralsSS[INDEX2(isub, e, numSub)
+                    * numShapes * numShapes] : NULL);
+    }
+
+    /// releases the cached integrals
+    void freeIntegrals();
+
+    /// status of the mesh when the cached integrals were built
+    int integralsStatus;
+    /// cached integrals (or NULL), see getCachedIntegralsDD etc.
+    double* integralsDD;
+    double* integralsDS;
+    double* integralsSS;
+    /// number of values in the cached integrals
+    size_t integralsSize;
 };
 
 class ElementFile
@@ -110,9 +157,33 @@ public:
     /// ranks.
     inline void updateTagList();
 
+    /// sorts the elements by colour into a contiguous list so assembly
+    /// loops only visit the elements of the current colour. This is called
+    /// by createColoring() and optimizeOrdering() and otherwise happens on
+    /// first use after the element table has been changed. Code that
+    /// modifies Color directly after that has to call this method again.
+    void updateColorOrdering() const;
+
+    /// returns the offsets of the colours into borrowColoredElements(), the
+    /// elements of colour c are at positions
+    /// offsets[c-minColor] to offsets[c-minColor+1]-1.
+    /// Must not be called from within a parallel region.
+    inline const index_t* borrowColorOffsets() const;
+
+    /// returns the element indices sorted by colour (see borrowColorOffsets).
+    /// Must not be called from within a parallel region.
+    inline const index_t* borrowColoredElements() const;
+
 private:
     void swapTable(ElementFile* other);
 
+    /// element indices sorted by colour
+    mutable IndexVector coloredElements;
+    /// offsets of the colours in coloredElements
+    mutable IndexVector colorOffsets;
+    /// true if coloredElements and colorOffsets match Color
+    mutable bool colorOrderingValid;
+
 public:
     escript::JMPI MPIInfo;
 
@@ -181,6 +252,20 @@ inline void ElementFile::updateTagList()
     util::setValuesInUse(Tag, numElements, tagsInUse, MPIInfo);
 }
 
+inline const index_t* ElementFile::borrowColorOffsets() const
+{
+    if (!colorOrderingValid)
+        updateColorOrdering();
+    return &colorOffsets[0];
+}
+
+inline const index_t* ElementFile::borrowColoredElements() const
+{
+    if (!colorOrderingValid)
+        updateColorOrdering();
+    return coloredElements.empty() ? NULL : &coloredElements[0];
+}
+
 } // namespace finley
 
 #endif // __FINLEY_ELEMENTFILE_H__
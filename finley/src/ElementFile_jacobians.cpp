@@ -18,6 +18,10 @@
 #include "ElementFile.h"
 #include "Assemble.h"
 
+#include <escript/EscriptParams.h>
+
+#include <algorithm>
+
 namespace finley {
 
 ElementFile_Jacobians::ElementFile_Jacobians(const_ShapeFunction_ptr basis) :
@@ -27,7 +31,12 @@ ElementFile_Jacobians::ElementFile_Jacobians(const_ShapeFunction_ptr basis) :
     numQuadTotal(0),
     numElements(0),
     volume(NULL),
-    DSDX(NULL)
+    DSDX(NULL),
+    integralsStatus(FINLEY_INITIAL_STATUS-1),
+    integralsDD(NULL),
+    integralsDS(NULL),
+    integralsSS(NULL),
+    integralsSize(0)
 {
 }
 
@@ -35,6 +44,134 @@ ElementFile_Jacobians::~ElementFile_Jacobians()
 {
     delete[] volume;
     delete[] DSDX;
+    freeIntegrals();
+}
+
+/// number of values held in the element integral tables of all element
+/// files, checked against the CACHE_ELEMENT_INTEGRALS limit
+static size_t totalIntegralsSize = 0;
+
+// The sums over the quadrature points are carried out in the same order as
+// in the constant coefficient branches of the Assemble_PDE_* kernels without
+// caching so results do not change.
+static void integrateDD(int numDim, int numShapes, int numShapesTotal,
+                        int numQuad, const double* Vol, const double* DSDX,
+                        double* DD)
+{
+    for (int s = 0; s < numShapes; s++) {
+        for (int r = 0; r < numShapes; r++) {
+            double* f = &DD[INDEX4(0,0,s,r,numDim,numDim,numShapes)];
+            for (int i = 0; i < numDim*numDim; i++)
+                f[i] = 0.;
+            for (int q = 0; q < numQuad; q++) {
+                for (int i = 0; i < numDim; i++) {
+                    const double fi = Vol[q]*DSDX[INDEX3(s,i,q,numShapesTotal,numDim)];
+                    for (int j = 0; j < numDim; j++)
+                        f[INDEX2(i,j,numDim)] += fi*DSDX[INDEX3(r,j,q,numShapesTotal,numDim)];
+                }
+            }
+        }
+    }
+}
+
+static void integrateDS(int numDim, int numShapes, int numShapesTotal,
+                        int numQuad, const double* Vol, const double* DSDX,
+                        const double* S, double* DS)
+{
+    for (int s = 0; s < numShapes; s++) {
+        for (int r = 0; r < numShapes; r++) {
+            double* f = &DS[INDEX3(0,s,r,numDim,numShapes)];
+            for (int i = 0; i < numDim; i++)
+                f[i] = 0.;
+            for (int q = 0; q < numQuad; q++) {
+                const double fq = Vol[q]*S[INDEX2(r,q,numShapes)];
+                for (int i = 0; i < numDim; i++)
+                    f[i] += fq*DSDX[INDEX3(s,i,q,numShapesTotal,numDim)];
+            }
+        }
+    }
+}
+
+static void integrateSS(int numShapes, int numQuad, const double* Vol,
+                        const double* S, double* SS)
+{
+    for (int s = 0; s < numShapes; s++) {
+        for (int r = 0; r < numShapes; r++) {
+            double f = 0.;
+            for (int q = 0; q < numQuad; q++)
+                f += Vol[q]*S[INDEX2(s,q,numShapes)]*S[INDEX2(r,q,numShapes)];
+            SS[INDEX2(s,r,numShapes)] = f;
+        }
+    }
+}
+
+void ElementFile_Jacobians::freeIntegrals()
+{
+    delete[] integralsDD;
+    delete[] integralsDS;
+    delete[] integralsSS;
+    integralsDD = integralsDS = integralsSS = NULL;
+    totalIntegralsSize -= integralsSize;
+    integralsSize = 0;
+}
+
+void ElementFile_Jacobians::updateIntegrals(bool needDD, bool needDS,
+                                            bool needSS)
+{
+    const size_t limit = std::max(0,
+            escript::escriptParams.getCacheElementIntegrals())
+            * size_t(1024*1024) / sizeof(double);
+    if (integralsStatus < status || limit == 0) {
+        freeIntegrals();
+        integralsStatus = status;
+    }
+    if (limit == 0)
+        return;
+
+    const int numShapes = BasisFunctions->Type->numShapes;
+    const int numQuad = numQuadTotal / numSub;
+    const double* S = &BasisFunctions->S[0];
+    const dim_t numBlocks = numElements * numSub;
+    const size_t lenDD = numDim*numDim*numShapes*numShapes;
+    const size_t lenDS = numDim*numShapes*numShapes;
+    const size_t lenSS = numShapes*numShapes;
+    // tables that would exceed the limit are not built, the assemblers
+    // then integrate per element as without caching
+    if (needDD && integralsDD == NULL
+            && totalIntegralsSize + numBlocks*lenDD <= limit) {
+        integralsDD = new double[numBlocks*lenDD];
+        integralsSize += numBlocks*lenDD;
+        totalIntegralsSize += numBlocks*lenDD;
+#pragma omp parallel for
+        for (index_t b = 0; b < numBlocks; b++) {
+            integrateDD(numDim, numShapes, numShapesTotal, numQuad,
+                        &volume[b*numQuad], &DSDX[b*numShapesTotal*numDim*numQuad],
+                        &integralsDD[b*lenDD]);
+        }
+    }
+    if (needDS && integralsDS == NULL
+            && totalIntegralsSize + numBlocks*lenDS <= limit) {
+        integralsDS = new double[numBlocks*lenDS];
+        integralsSize += numBlocks*lenDS;
+        totalIntegralsSize += numBlocks*lenDS;
+#pragma omp parallel for
+        for (index_t b = 0; b < numBlocks; b++) {
+            integrateDS(numDim, numShapes, numShapesTotal, numQuad,
+                        &volume[b*numQuad], &DSDX[b*numShapesTotal*numDim*numQuad],
+                        S, &integralsDS[b*lenDS]);
+        }
+    }
+    if (needSS && integralsSS == NULL
+            && totalIntegralsSize + numBlocks*lenSS <= limit) {
+        integralsSS = new double[numBlocks*lenSS];
+        integralsSize += numBlocks*lenSS;
+        totalIntegralsSize += numBlocks*lenSS;
+#pragma omp parallel for
+        for (index_t b = 0; b < numBlocks; b++) {
+            integrateSS(numShapes, numQuad, &volume[b*numQuad], S,
+                        &integralsSS[b*lenSS]);
+        }
+    }
 }
 
 
@@ -68,6 +205,13 @@ ElementFile_Jacobians* ElementFile::borrowJacobians(const NodeFile* nodefile,
         out->numQuadTotal=shape->numQuadNodes; 
         out->numSides=refElement->Type->numSides;
         out->numShapesTotal=basis->Type->numShapes * out->numSides; 
+        if (out->numElements != numElements) {
+            // the element table has changed size, e.g. after rebalancing
+            delete[] out->volume;
+            delete[] out->DSDX;
+            out->volume = NULL;
+            out->DSDX = NULL;
+        }
         out->numElements=numElements;
         const double *dBdv;
 
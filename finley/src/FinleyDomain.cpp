@@ -23,6 +23,7 @@
 
 #include <escript/Data.h>
 #include <escript/DataFactory.h>
+#include <escript/EscriptParams.h>
 #include <escript/Random.h>
 #include <escript/SolverOptions.h>
 
@@ -2807,6 +2808,22 @@ void FinleyDomain::prepare(bool optimize)
         optimizeDOFDistribution(distribution);
         distributeByRankOfDOF(distribution);
     }
+    createLabelingsAndMappings(distribution, optimize);
+
+    updateTagList();
+}
+
+/// renumbers the nodes, DOFs and elements of the distributed mesh and
+/// creates the global node labeling, the reduced labelings and the mappings
+void FinleyDomain::createLabelingsAndMappings(const IndexVector& distribution,
+                                              bool optimize)
+{
+    // nodes and DOFs can be renumbered along a space-filling curve for
+    // better memory locality. The elements follow the nodes in
+    // optimizeElementOrdering() below.
+    if (escript::escriptParams.getHilbertOrdering()) {
+        optimizeNodeOrdering(distribution);
+    }
     // the local labelling of the degrees of freedom is optimized
     if (optimize) {
         optimizeDOFLabeling(distribution);
@@ -2829,8 +2846,6 @@ void FinleyDomain::prepare(bool optimize)
     m_nodes->createDenseReducedLabeling(maskReducedNodes, true);
     // create the missing mappings
     m_nodes->createNodeMappings(indexReducedNodes, distribution, nodeDistribution);
-
-    updateTagList();
 }
 
 /// redistributes the Nodes and Elements including overlap
@@ -96,11 +96,23 @@ class FinleyDomain : public escript::AbstractContinuousDomain
 public:
     /**
      \brief
-     recovers domain from a dump file
+     recovers domain from a dump file. Binary checkpoint files written by
+     dumpBinary() are detected and passed on to loadBinary().
      \param filename the name of the file
     */
     static escript::Domain_ptr load(const std::string& filename);
 
+    /**
+     \brief
+     recovers domain from a binary checkpoint file written by dumpBinary().
+     If the number of ranks matches the number used for writing, the
+     distribution, DOF labelling and element colouring are restored as they
+     were. Otherwise the domain is repartitioned along the DOF labelling of
+     the checkpoint without running the optimizer.
+     \param filename the name of the file
+    */
+    static escript::Domain_ptr loadBinary(const std::string& filename);
+
     /**
      \brief
      reads a mesh from a fly file. For MPI parallel runs fans out the mesh
@@ -385,6 +397,30 @@ public:
     */
     void dump(const std::string& fileName) const;
 
+    /**
+     \brief
+     writes the mesh to a single binary checkpoint file which can be
+     restored on any number of ranks. All ranks write their part
+     collectively.
+     \param fileName Input - The name of the file
+    */
+    void dumpBinary(const std::string& fileName) const;
+
+    /**
+     \brief
+     returns a copy of this domain whose nodes and elements are
+     redistributed so that the cost of the ranks is balanced. Each rank
+     passes its own cost, e.g. the time it spent in assembly and solve
+     since the last call, which is spread evenly over the degrees of
+     freedom it owns. The Data objects in `data` are copied to the new
+     domain. This domain and all Data objects on it remain valid.
+     \param cost Input - the cost of this rank, must be positive
+     \param data Input - list of Data objects on this domain to copy
+     \return a tuple of the new domain and the list of copied Data objects
+    */
+    boost::python::tuple rebalance(double cost,
+                                   const boost::python::list& data) const;
+
     /**
      \brief
      Return the tag key for the given sample number.
@@ -838,8 +874,16 @@ public:
     static FinleyDomain* merge(const std::vector<const FinleyDomain*>& meshes);
 
 private:
+    /// returns true if fileName starts with the checkpoint magic written by
+    /// dumpBinary(). The test is done on rank 0 and broadcast.
+    static bool isCheckpointFile(const std::string& fileName,
+                                 escript::JMPI mpiInfo);
+
     void prepare(bool optimize);
 
+    void createLabelingsAndMappings(const IndexVector& distribution,
+                                    bool optimize);
+
     void setOrders();
 
     /// Initially the element nodes refer to the numbering defined by the
@@ -869,8 +913,12 @@ private:
     void createColoring(const IndexVector& dofMap);
     void distributeByRankOfDOF(const IndexVector& distribution);
     void markNodes(std::vector<short>& mask, index_t offset, bool useLinear) const;
-    void optimizeDOFDistribution(IndexVector& distribution);
+    void optimizeDOFDistribution(IndexVector& distribution,
+                const std::vector<double>& weights = std::vector<double>());
     void optimizeDOFLabeling(const IndexVector& distribution);
+    /// renumbers the local nodes and the DOFs of this rank along a Hilbert
+    /// curve through the node coordinates
+    void optimizeNodeOrdering(const IndexVector& distribution);
     void optimizeElementOrdering();
     void findMatchingFaces(double safetyFactor, double tolerance, int* numPairs,
                            int* elem0, int* elem1, int* matchingNodes) const;
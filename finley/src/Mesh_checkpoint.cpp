@@ -0,0 +1,568 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+
+/****************************************************************************
+
+  Finley: binary checkpoint files
+
+  A checkpoint is a single file in native byte order which is written
+  collectively by all ranks. It consists of
+
+    - a fixed size header (magic, version, sizes, element type ids, ...)
+    - the offsets of the per-rank chunks, the DOF and node distributions,
+      the mesh name and the tag map
+    - one chunk per writing rank holding its node table (including overlap)
+      and its four element tables with local node references, colouring
+      and owners.
+
+  When the file is loaded on the same number of ranks every rank picks up
+  its own chunk and the mesh is restored exactly, i.e. without
+  redistribution, DOF optimization or recolouring. Otherwise the chunks are
+  dealt out to the new ranks in contiguous blocks and the mesh is
+  repartitioned along the DOF labelling found in the file.
+
+*****************************************************************************/
+
+#include "FinleyDomain.h"
+
+#include <escript/index.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <stdint.h>
+
+using escript::IOError;
+
+namespace finley {
+
+static const char CHECKPOINT_MAGIC[8] = { 'F','I','N','L','E','Y','C','K' };
+static const int CHECKPOINT_VERSION = 1;
+/// largest number of bytes moved by a single MPI-IO call
+static const size_t CHECKPOINT_MAX_IO = size_t(1) << 30;
+
+struct CheckpointHeader
+{
+    char magic[8];
+    int32_t version;
+    int32_t indexSize;
+    int32_t numDim;
+    int32_t order;
+    int32_t reducedOrder;
+    int32_t mpiSize;
+    int32_t typeId[4];
+    int64_t numTags;
+    int64_t nameLength;
+};
+
+/// element table of one chunk as found in the file
+struct ElementChunk
+{
+    dim_t numElements;
+    int numNodes;
+    index_t minColor;
+    index_t maxColor;
+    IndexVector Id;
+    std::vector<int> Tag;
+    std::vector<int> Owner;
+    IndexVector Color;
+    IndexVector Nodes;
+};
+
+/// node table and element tables of one chunk as found in the file
+struct CheckpointChunk
+{
+    dim_t numNodes;
+    IndexVector Id;
+    std::vector<int> Tag;
+    IndexVector globalDegreesOfFreedom;
+    IndexVector globalNodesIndex;
+    IndexVector globalReducedDOFIndex;
+    IndexVector globalReducedNodesIndex;
+    std::vector<double> Coordinates;
+    ElementChunk elements[4];
+};
+
+template<typename T>
+static void pack(std::vector<char>& buffer, const T* values, size_t n)
+{
+    if (n > 0) {
+        const char* p = reinterpret_cast<const char*>(values);
+        buffer.insert(buffer.end(), p, p + n*sizeof(T));
+    }
+}
+
+template<typename T>
+static const char* unpack(const char* pos, const char* end, T* values,
+                          size_t n)
+{
+    if (pos + n*sizeof(T) > end)
+        throw IOError("loadBinary: checkpoint file is truncated.");
+    if (n > 0)
+        memcpy(values, pos, n*sizeof(T));
+    return pos + n*sizeof(T);
+}
+
+template<typename T>
+static const char* unpack(const char* pos, const char* end,
+                          std::vector<T>& values, size_t n)
+{
+    values.resize(n);
+    return unpack(pos, end, n > 0 ? &values[0] : (T*)NULL, n);
+}
+
+static void packElements(std::vector<char>& buffer, const ElementFile* e)
+{
+    const int64_t info[4] = { e->numElements, e->numNodes, e->minColor,
+                              e->maxColor };
+    pack(buffer, info, 4);
+    pack(buffer, e->Id, e->numElements);
+    pack(buffer, e->Tag, e->numElements);
+    pack(buffer, e->Owner, e->numElements);
+    pack(buffer, e->Color, e->numElements);
+    pack(buffer, e->Nodes, e->numElements*e->numNodes);
+}
+
+static const char* unpackElements(const char* pos, const char* end,
+                                  ElementChunk& e)
+{
+    int64_t info[4];
+    pos = unpack(pos, end, info, 4);
+    e.numElements = info[0];
+    e.numNodes = info[1];
+    e.minColor = info[2];
+    e.maxColor = info[3];
+    pos = unpack(pos, end, e.Id, e.numElements);
+    pos = unpack(pos, end, e.Tag, e.numElements);
+    pos = unpack(pos, end, e.Owner, e.numElements);
+    pos = unpack(pos, end, e.Color, e.numElements);
+    return unpack(pos, end, e.Nodes, e.numElements*e.numNodes);
+}
+
+static const char* unpackChunk(const char* pos, const char* end, int numDim,
+                               CheckpointChunk& c)
+{
+    int64_t numNodes;
+    pos = unpack(pos, end, &numNodes, 1);
+    c.numNodes = numNodes;
+    pos = unpack(pos, end, c.Id, c.numNodes);
+    pos = unpack(pos, end, c.Tag, c.numNodes);
+    pos = unpack(pos, end, c.globalDegreesOfFreedom, c.numNodes);
+    pos = unpack(pos, end, c.globalNodesIndex, c.numNodes);
+    pos = unpack(pos, end, c.globalReducedDOFIndex, c.numNodes);
+    pos = unpack(pos, end, c.globalReducedNodesIndex, c.numNodes);
+    pos = unpack(pos, end, c.Coordinates, c.numNodes*numDim);
+    for (int i = 0; i < 4; i++)
+        pos = unpackElements(pos, end, c.elements[i]);
+    return pos;
+}
+
+/// collectively reads `length` bytes starting at `offset` on every rank
+static void readCheckpointBytes(escript::JMPI mpiInfo,
+                                const std::string& fileName, int64_t offset,
+                                size_t length, char* buffer)
+{
+#ifdef ESYS_MPI
+    MPI_File fileHandle;
+    int mpiErr = MPI_File_open(mpiInfo->comm,
+            const_cast<char*>(fileName.c_str()), MPI_MODE_RDONLY,
+            MPI_INFO_NULL, &fileHandle);
+    if (mpiErr != MPI_SUCCESS)
+        throw IOError("loadBinary: cannot open file " + fileName);
+
+    // all ranks have to take part in the same number of collective calls
+    int64_t myPieces = (length + CHECKPOINT_MAX_IO - 1) / CHECKPOINT_MAX_IO;
+    int64_t numPieces;
+    MPI_Allreduce(&myPieces, &numPieces, 1, MPI_LONG_LONG, MPI_MAX,
+                  mpiInfo->comm);
+    int error = 0;
+    for (int64_t p = 0; p < numPieces; p++) {
+        const size_t start = std::min(p*CHECKPOINT_MAX_IO, length);
+        const size_t count = std::min(CHECKPOINT_MAX_IO, length - start);
+        MPI_Status status;
+        if (MPI_File_read_at_all(fileHandle, offset + start, buffer + start,
+                    count, MPI_BYTE, &status) != MPI_SUCCESS)
+            error = 1;
+    }
+    MPI_File_close(&fileHandle);
+    int gError;
+    MPI_Allreduce(&error, &gError, 1, MPI_INT, MPI_MAX, mpiInfo->comm);
+    if (gError)
+        throw IOError("loadBinary: error reading from file " + fileName);
+#else
+    std::ifstream f(fileName.c_str(), std::ifstream::binary);
+    if (f.fail())
+        throw IOError("loadBinary: cannot open file " + fileName);
+    f.seekg(offset);
+    f.read(buffer, length);
+    if (f.fail())
+        throw IOError("loadBinary: error reading from file " + fileName);
+#endif
+}
+
+/// collectively writes the header (rank 0 only) and the chunks of all ranks
+static void writeCheckpointBytes(escript::JMPI mpiInfo,
+                                 const std::string& fileName,
+                                 const std::vector<char>& header,
+                                 const std::vector<char>& chunk,
+                                 int64_t chunkOffset)
+{
+#ifdef ESYS_MPI
+    // remove a previous file first so no stale bytes survive
+    int error = 0;
+    if (mpiInfo->rank == 0) {
+        std::ifstream f(fileName.c_str());
+        if (f.good()) {
+            f.close();
+            if (std::remove(fileName.c_str()))
+                error = 1;
+        }
+    }
+    int gError;
+    MPI_Allreduce(&error, &gError, 1, MPI_INT, MPI_MAX, mpiInfo->comm);
+    if (gError)
+        throw IOError("dumpBinary: error removing " + fileName);
+
+    MPI_File fileHandle;
+    int mpiErr = MPI_File_open(mpiInfo->comm,
+            const_cast<char*>(fileName.c_str()),
+            MPI_MODE_CREATE|MPI_MODE_WRONLY|MPI_MODE_UNIQUE_OPEN,
+            MPI_INFO_NULL, &fileHandle);
+    if (mpiErr != MPI_SUCCESS)
+        throw IOError("dumpBinary: cannot open file " + fileName);
+
+    const size_t length = header.size() + chunk.size();
+    int64_t myPieces = (length + CHECKPOINT_MAX_IO - 1) / CHECKPOINT_MAX_IO;
+    int64_t numPieces;
+    MPI_Allreduce(&myPieces, &numPieces, 1, MPI_LONG_LONG, MPI_MAX,
+                  mpiInfo->comm);
+    // header and chunk are written as one logical range per rank. The header
+    // is only non-empty on rank 0 whose chunk directly follows it.
+    std::vector<char> data;
+    const char* buffer;
+    int64_t offset;
+    if (header.empty()) {
+        buffer = chunk.empty() ? NULL : &chunk[0];
+        offset = chunkOffset;
+    } else {
+        data.reserve(length);
+        data.insert(data.end(), header.begin(), header.end());
+        data.insert(data.end(), chunk.begin(), chunk.end());
+        buffer = &data[0];
+        offset = 0;
+    }
+    for (int64_t p = 0; p < numPieces; p++) {
+        const size_t start = std::min(p*CHECKPOINT_MAX_IO, length);
+        const size_t count = std::min(CHECKPOINT_MAX_IO, length - start);
+        MPI_Status status;
+        if (MPI_File_write_at_all(fileHandle, offset + start,
+                    const_cast<char*>(buffer) + start, count, MPI_BYTE,
+                    &status) != MPI_SUCCESS)
+            error = 1;
+    }
+    MPI_File_close(&fileHandle);
+    MPI_Allreduce(&error, &gError, 1, MPI_INT, MPI_MAX, mpiInfo->comm);
+    if (gError)
+        throw IOError("dumpBinary: error writing to file " + fileName);
+#else
+    std::ofstream f(fileName.c_str(), std::ofstream::binary);
+    if (f.fail())
+        throw IOError("dumpBinary: cannot open file " + fileName);
+    f.write(&header[0], header.size());
+    if (!chunk.empty())
+        f.write(&chunk[0], chunk.size());
+    if (f.fail())
+        throw IOError("dumpBinary: error writing to file " + fileName);
+#endif
+}
+
+bool FinleyDomain::isCheckpointFile(const std::string& fileName,
+                                    escript::JMPI mpiInfo)
+{
+    int found = 0;
+    if (mpiInfo->rank == 0) {
+        char magic[sizeof(CHECKPOINT_MAGIC)];
+        std::ifstream f(fileName.c_str(), std::ifstream::binary);
+        if (f.good() && f.read(magic, sizeof(magic)) &&
+                memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0)
+            found = 1;
+    }
+#ifdef ESYS_MPI
+    MPI_Bcast(&found, 1, MPI_INT, 0, mpiInfo->comm);
+#endif
+    return found;
+}
+
+void FinleyDomain::dumpBinary(const std::string& fileName) const
+{
+    const int mpiSize = m_mpiInfo->size;
+    const int numDim = getDim();
+    const ElementFile* files[4] = { m_elements, m_faceElements,
+                                    m_contactElements, m_points };
+
+    // my chunk: node table followed by the four element tables
+    std::vector<char> chunk;
+    const int64_t numNodes = m_nodes->getNumNodes();
+    pack(chunk, &numNodes, 1);
+    pack(chunk, m_nodes->Id, numNodes);
+    pack(chunk, m_nodes->Tag, numNodes);
+    pack(chunk, m_nodes->globalDegreesOfFreedom, numNodes);
+    pack(chunk, m_nodes->globalNodesIndex, numNodes);
+    pack(chunk, m_nodes->globalReducedDOFIndex, numNodes);
+    pack(chunk, m_nodes->globalReducedNodesIndex, numNodes);
+    pack(chunk, m_nodes->Coordinates, numNodes*numDim);
+    for (int i = 0; i < 4; i++)
+        packElements(chunk, files[i]);
+
+    // the header is identical on all ranks, its size determines the offsets
+    CheckpointHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.indexSize = sizeof(index_t);
+    h.numDim = numDim;
+    h.order = integrationOrder;
+    h.reducedOrder = reducedIntegrationOrder;
+    h.mpiSize = mpiSize;
+    for (int i = 0; i < 4; i++)
+        h.typeId[i] = files[i]->referenceElementSet->referenceElement->Type->TypeId;
+    h.numTags = m_tagMap.size();
+    h.nameLength = m_name.length();
+
+    std::vector<char> tags;
+    for (TagMap::const_iterator it = m_tagMap.begin(); it != m_tagMap.end(); it++) {
+        const int32_t keyLen[2] = { it->second, (int32_t)it->first.length() };
+        pack(tags, keyLen, 2);
+        pack(tags, it->first.c_str(), it->first.length());
+    }
+    const int64_t headerSize = sizeof(h) + (mpiSize+1)*sizeof(int64_t)
+                        + 2*(mpiSize+1)*sizeof(index_t) + h.nameLength
+                        + tags.size();
+
+    std::vector<int64_t> chunkOffsets(mpiSize+1);
+    int64_t myChunkSize = chunk.size();
+#ifdef ESYS_MPI
+    MPI_Allgather(&myChunkSize, 1, MPI_LONG_LONG, &chunkOffsets[1], 1,
+                  MPI_LONG_LONG, m_mpiInfo->comm);
+#else
+    chunkOffsets[1] = myChunkSize;
+#endif
+    chunkOffsets[0] = headerSize;
+    for (int p = 0; p < mpiSize; p++)
+        chunkOffsets[p+1] += chunkOffsets[p];
+
+    std::vector<char> header;
+    if (m_mpiInfo->rank == 0) {
+        pack(header, &h, 1);
+        pack(header, &chunkOffsets[0], mpiSize+1);
+        pack(header, &m_nodes->degreesOfFreedomDistribution->first_component[0], mpiSize+1);
+        pack(header, &m_nodes->nodesDistribution->first_component[0], mpiSize+1);
+        pack(header, m_name.c_str(), m_name.length());
+        header.insert(header.end(), tags.begin(), tags.end());
+    }
+    writeCheckpointBytes(m_mpiInfo, fileName, header, chunk,
+                         chunkOffsets[m_mpiInfo->rank]);
+}
+
+escript::Domain_ptr FinleyDomain::loadBinary(const std::string& fileName)
+{
+    escript::JMPI mpiInfo = escript::makeInfo(MPI_COMM_WORLD);
+
+    CheckpointHeader h;
+    readCheckpointBytes(mpiInfo, fileName, 0, sizeof(h),
+                        reinterpret_cast<char*>(&h));
+    if (memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0)
+        throw IOError("loadBinary: " + fileName + " is not a finley checkpoint file.");
+    if (h.version != CHECKPOINT_VERSION)
+        throw IOError("loadBinary: unsupported checkpoint version.");
+    if (h.indexSize != sizeof(index_t))
+        throw IOError("loadBinary: size of index types at runtime differ from checkpoint file");
+
+    // read the rest of the header. The first chunk offset directly follows
+    // the fixed part and equals the total header size.
+    const int writerSize = h.mpiSize;
+    int64_t headerSize;
+    readCheckpointBytes(mpiInfo, fileName, sizeof(h), sizeof(int64_t),
+                        reinterpret_cast<char*>(&headerSize));
+    std::vector<char> header(headerSize);
+    readCheckpointBytes(mpiInfo, fileName, 0, headerSize, &header[0]);
+    const char* pos = &header[sizeof(h)];
+    const char* end = &header[0] + headerSize;
+    std::vector<int64_t> chunkOffsets;
+    IndexVector dofDistribution, nodeDistribution;
+    std::string name(h.nameLength, ' ');
+    pos = unpack(pos, end, chunkOffsets, writerSize+1);
+    pos = unpack(pos, end, dofDistribution, writerSize+1);
+    pos = unpack(pos, end, nodeDistribution, writerSize+1);
+    pos = unpack(pos, end, &name[0], h.nameLength);
+
+    FinleyDomain* dom = new FinleyDomain(name, h.numDim, mpiInfo);
+    try {
+        for (int64_t t = 0; t < h.numTags; t++) {
+            int32_t keyLen[2];
+            pos = unpack(pos, end, keyLen, 2);
+            std::string tagName(keyLen[1], ' ');
+            pos = unpack(pos, end, &tagName[0], keyLen[1]);
+            dom->setTagMap(tagName, keyLen[0]);
+        }
+
+        // rank r restores the chunks of writers firstChunk..lastChunk-1
+        const bool sameLayout = (writerSize == mpiInfo->size);
+        const int firstChunk = (int64_t)mpiInfo->rank * writerSize / mpiInfo->size;
+        const int lastChunk = (int64_t)(mpiInfo->rank+1) * writerSize / mpiInfo->size;
+        const int64_t chunkStart = chunkOffsets[firstChunk];
+        std::vector<char> buffer(chunkOffsets[lastChunk] - chunkStart);
+        readCheckpointBytes(mpiInfo, fileName, chunkStart, buffer.size(),
+                            buffer.empty() ? NULL : &buffer[0]);
+
+        ElementFile* files[4];
+        for (int i = 0; i < 4; i++) {
+            const_ReferenceElementSet_ptr refSet(new ReferenceElementSet(
+                        (ElementTypeId)h.typeId[i], h.order, h.reducedOrder));
+            files[i] = new ElementFile(refSet, mpiInfo);
+        }
+        dom->setElements(files[0]);
+        dom->setFaceElements(files[1]);
+        dom->setContactElements(files[2]);
+        dom->setPoints(files[3]);
+
+        NodeFile* nodes = dom->getNodes();
+        const int numDim = h.numDim;
+        if (sameLayout) {
+            CheckpointChunk c;
+            unpackChunk(buffer.empty() ? NULL : &buffer[0],
+                        buffer.empty() ? NULL : &buffer[0] + buffer.size(),
+                        numDim, c);
+            nodes->allocTable(c.numNodes);
+#pragma omp parallel for
+            for (index_t n = 0; n < c.numNodes; n++) {
+                nodes->Id[n] = c.Id[n];
+                nodes->Tag[n] = c.Tag[n];
+                nodes->globalDegreesOfFreedom[n] = c.globalDegreesOfFreedom[n];
+                nodes->globalNodesIndex[n] = c.globalNodesIndex[n];
+                nodes->globalReducedDOFIndex[n] = c.globalReducedDOFIndex[n];
+                nodes->globalReducedNodesIndex[n] = c.globalReducedNodesIndex[n];
+                for (int i = 0; i < numDim; i++)
+                    nodes->Coordinates[INDEX2(i,n,numDim)] =
+                                        c.Coordinates[INDEX2(i,n,numDim)];
+            }
+            for (int f = 0; f < 4; f++) {
+                ElementFile* out = files[f];
+                const ElementChunk& in = c.elements[f];
+                if (in.numNodes != out->numNodes)
+                    throw IOError("loadBinary: element type does not match number of nodes in checkpoint file.");
+                const int NN = in.numNodes;
+                out->allocTable(in.numElements);
+                out->minColor = in.minColor;
+                out->maxColor = in.maxColor;
+#pragma omp parallel for
+                for (index_t e = 0; e < in.numElements; e++) {
+                    out->Id[e] = in.Id[e];
+                    out->Tag[e] = in.Tag[e];
+                    out->Owner[e] = in.Owner[e];
+                    out->Color[e] = in.Color[e];
+                    for (int j = 0; j < NN; j++)
+                        out->Nodes[INDEX2(j,e,NN)] = in.Nodes[INDEX2(j,e,NN)];
+                }
+            }
+        } else {
+            // keep the nodes and elements owned by each writer once and
+            // refer to nodes by their Id so resolveNodeIds() can pull in the
+            // overlap
+            std::vector<CheckpointChunk> chunks(lastChunk - firstChunk);
+            dim_t numNodes = 0;
+            dim_t numElements[4] = { 0, 0, 0, 0 };
+            for (int w = firstChunk; w < lastChunk; w++) {
+                CheckpointChunk& c = chunks[w-firstChunk];
+                const char* cpos = &buffer[chunkOffsets[w] - chunkStart];
+                const char* cend = &buffer[0] + (chunkOffsets[w+1] - chunkStart);
+                unpackChunk(cpos, cend, numDim, c);
+                for (index_t n = 0; n < c.numNodes; n++) {
+                    if (c.globalDegreesOfFreedom[n] >= dofDistribution[w] &&
+                            c.globalDegreesOfFreedom[n] < dofDistribution[w+1])
+                        numNodes++;
+                }
+                for (int f = 0; f < 4; f++) {
+                    if (c.elements[f].numNodes != files[f]->numNodes)
+                        throw IOError("loadBinary: element type does not match number of nodes in checkpoint file.");
+                    for (index_t e = 0; e < c.elements[f].numElements; e++) {
+                        if (c.elements[f].Owner[e] == w)
+                            numElements[f]++;
+                    }
+                }
+            }
+            nodes->allocTable(numNodes);
+            for (int f = 0; f < 4; f++)
+                files[f]->allocTable(numElements[f]);
+            numNodes = 0;
+            for (int f = 0; f < 4; f++)
+                numElements[f] = 0;
+            for (int w = firstChunk; w < lastChunk; w++) {
+                const CheckpointChunk& c = chunks[w-firstChunk];
+                for (index_t n = 0; n < c.numNodes; n++) {
+                    if (c.globalDegreesOfFreedom[n] >= dofDistribution[w] &&
+                            c.globalDegreesOfFreedom[n] < dofDistribution[w+1]) {
+                        nodes->Id[numNodes] = c.Id[n];
+                        nodes->Tag[numNodes] = c.Tag[n];
+                        nodes->globalDegreesOfFreedom[numNodes] = c.globalDegreesOfFreedom[n];
+                        for (int i = 0; i < numDim; i++)
+                            nodes->Coordinates[INDEX2(i,numNodes,numDim)] =
+                                            c.Coordinates[INDEX2(i,n,numDim)];
+                        numNodes++;
+                    }
+                }
+                for (int f = 0; f < 4; f++) {
+                    ElementFile* out = files[f];
+                    const ElementChunk& in = c.elements[f];
+                    const int NN = in.numNodes;
+                    for (index_t e = 0; e < in.numElements; e++) {
+                        if (in.Owner[e] != w)
+                            continue;
+                        const index_t k = numElements[f]++;
+                        out->Id[k] = in.Id[e];
+                        out->Tag[k] = in.Tag[e];
+                        out->Owner[k] = mpiInfo->rank;
+                        for (int j = 0; j < NN; j++)
+                            out->Nodes[INDEX2(j,k,NN)] =
+                                            c.Id[in.Nodes[INDEX2(j,e,NN)]];
+                    }
+                }
+            }
+        }
+        nodes->updateTagList();
+        for (int f = 0; f < 4; f++)
+            files[f]->updateTagList();
+
+        if (sameLayout) {
+            dom->setOrders();
+            dom->createMappings(dofDistribution, nodeDistribution);
+            dom->updateTagList();
+        } else {
+            dom->resolveNodeIds();
+            dom->prepare(false);
+        }
+    } catch (...) {
+        delete dom;
+        throw;
+    }
+    return dom->getPtr();
+}
+
+} // namespace finley
+
@@ -22,6 +22,11 @@
 
   searches for faces in the mesh which are matching.
 
+  The face centres are put into a uniform grid of cells which is stored as a
+  hash table. Two faces can only match if their centres are within the
+  tolerance so it is sufficient to compare a centre with the centres in the
+  neighbouring cells of its own cell.
+
 *****************************************************************************/
 
 #include "FinleyDomain.h"
@@ -29,33 +34,12 @@
 
 #include <escript/index.h>
 
+#include <cmath>
+
 //#define Finley_TRACE
 
 namespace finley {
 
-static double lockingGridSize = 0.;
-
-// this structure is used for matching surface elements
-struct FaceCenter
-{
-   int refId;
-   std::vector<double> x;
-};
-
-/// comparison function for findMatchingFaces
-bool FaceCenterCompare(const FaceCenter& e1, const FaceCenter& e2)
-{
-    for (int i = 0; i < e1.x.size(); i++) {
-        bool l = (e1.x[i] < e2.x[i]+lockingGridSize);
-        bool g = (e2.x[i] < e1.x[i]+lockingGridSize);
-        if (! (l && g)) {
-            if (l) return true;
-            if (g) return false;
-        }
-    }
-    return e1.refId < e2.refId; // strict order to e1==e2 is false
-}
-
 inline double getDist(int e0, int i0, int e1, int i1, int numDim, int NN,
                       const double* X)
 {
@@ -67,6 +51,16 @@ inline double getDist(int e0, int i0, int e1, int i1, int numDim, int NN,
     return dist;
 }
 
+/// returns the hash table bucket of grid cell `cell`
+inline dim_t getBucket(const int64_t* cell, int numDim, dim_t numBuckets)
+{
+    static const uint64_t primes[3] = { 73856093, 19349663, 83492791 };
+    uint64_t key = 0;
+    for (int i = 0; i < numDim; i++)
+        key ^= static_cast<uint64_t>(cell[i]) * primes[i];
+    return static_cast<dim_t>(key % static_cast<uint64_t>(numBuckets));
+}
+
 void FinleyDomain::findMatchingFaces(double safety_factor, double tolerance,
                                      int* numPairs, int* elem0, int* elem1,
                                      int* matching_nodes_in_elem1) const
@@ -75,6 +69,7 @@ void FinleyDomain::findMatchingFaces(double safety_factor, double tolerance,
                                             borrowReferenceElement(false));
     const int numDim = m_nodes->numDim;
     const int NN = m_faceElements->numNodes;
+    const dim_t numElements = m_faceElements->numElements;
     const int numNodesOnFace = refElement->Type->numNodesOnFace;
     const int* faceNodes = refElement->Type->faceNodes;
     const int* shiftNodes = refElement->Type->shiftNodes;
@@ -86,53 +81,121 @@ void FinleyDomain::findMatchingFaces(double safety_factor, double tolerance,
             "face elements of type " << refElement->Type->Name;
         throw escript::ValueError(ss.str());
     }
-    double* X = new double[NN * numDim * m_faceElements->numElements];
-    std::vector<FaceCenter> center(m_faceElements->numElements);
+    double* X = new double[NN * numDim * numElements];
+    std::vector<double> center(numDim * numElements, 0.);
     int* a1 = new int[NN];
     int* a2 = new int[NN];
     double h = std::numeric_limits<double>::max();
 
-    // TODO: OMP
-    for (index_t e = 0; e < m_faceElements->numElements; e++) {
-        // get the coordinates of the nodes
-        util::gather(NN, &(m_faceElements->Nodes[INDEX2(0,e,NN)]), numDim,
-                     m_nodes->Coordinates, &X[INDEX3(0,0,e,numDim,NN)]);
-        // get the element center
-        center[e].refId = e;
-        center[e].x.assign(numDim, 0);
-        for (int i0 = 0; i0 < numNodesOnFace; i0++) {
+#pragma omp parallel
+    {
+        double h_local = std::numeric_limits<double>::max();
+#pragma omp for
+        for (index_t e = 0; e < numElements; e++) {
+            // get the coordinates of the nodes
+            util::gather(NN, &(m_faceElements->Nodes[INDEX2(0,e,NN)]), numDim,
+                         m_nodes->Coordinates, &X[INDEX3(0,0,e,numDim,NN)]);
+            // get the element center
+            double* x = &center[INDEX2(0,e,numDim)];
+            for (int i0 = 0; i0 < numNodesOnFace; i0++) {
+                for (int i = 0; i < numDim; i++)
+                    x[i] += X[INDEX3(i,faceNodes[i0],e,numDim,NN)];
+            }
             for (int i = 0; i < numDim; i++)
-                center[e].x[i] += X[INDEX3(i,faceNodes[i0],e,numDim,NN)];
-        }
-        for (int i = 0; i < numDim; i++)
-            center[e].x[i] /= numNodesOnFace;
-        // get the minimum distance between nodes in the element
-        for (int i0 = 0; i0 < numNodesOnFace; i0++) {
-            for (int i1 = i0+1; i1 < numNodesOnFace; i1++) {
-                double h_local = getDist(e, faceNodes[i0], e, faceNodes[i1], numDim, NN, X);
-                h = std::min(h, h_local);
+                x[i] /= numNodesOnFace;
+            // get the minimum distance between nodes in the element
+            for (int i0 = 0; i0 < numNodesOnFace; i0++) {
+                for (int i1 = i0+1; i1 < numNodesOnFace; i1++) {
+                    h_local = std::min(h_local, getDist(e, faceNodes[i0], e,
+                                faceNodes[i1], numDim, NN, X));
+                }
             }
         }
+#pragma omp critical
+        h = std::min(h, h_local);
     }
-    lockingGridSize = h*std::max(safety_factor, 0.);
+    const double tol = h * tolerance;
+    // the cells must not be smaller than the tolerance so matching centres
+    // are in the same or in neighbouring cells. safety_factor gives the cell
+    // size relative to the smallest node distance.
+    const double cellSize = h * std::max(safety_factor, tolerance);
 #ifdef Finley_TRACE
-    std::cout << "locking grid size is " << lockingGridSize << std::endl;
-    std::cout << "absolute tolerance is " << h * tolerance << std::endl;
-    std::cout << "number of face elements is " << m_faceElements->numElements << std::endl;
+    std::cout << "cell size is " << cellSize << std::endl;
+    std::cout << "absolute tolerance is " << tol << std::endl;
+    std::cout << "number of face elements is " << numElements << std::endl;
 #endif
-    // sort the elements by center coordinates (lexicographical)
-    std::sort(center.begin(), center.end(), FaceCenterCompare);
+
+    // put the centres into the buckets of the hash table (CSR storage)
+    const dim_t numBuckets = std::max(2*numElements, (dim_t)1);
+    std::vector<int64_t> cells(numDim * numElements);
+    std::vector<dim_t> bucketOfElement(numElements);
+    IndexVector bucketPtr(numBuckets + 1, 0);
+    IndexVector bucketElements(numElements);
+    if (cellSize > 0.) {
+#pragma omp parallel for
+        for (index_t e = 0; e < numElements; e++) {
+            for (int i = 0; i < numDim; i++)
+                cells[INDEX2(i,e,numDim)] = static_cast<int64_t>(
+                        std::floor(center[INDEX2(i,e,numDim)] / cellSize));
+            bucketOfElement[e] = getBucket(&cells[INDEX2(0,e,numDim)],
+                                           numDim, numBuckets);
+        }
+        for (index_t e = 0; e < numElements; e++)
+            bucketPtr[bucketOfElement[e] + 1]++;
+        for (dim_t b = 0; b < numBuckets; b++)
+            bucketPtr[b + 1] += bucketPtr[b];
+        IndexVector fill(bucketPtr.begin(), bucketPtr.end() - 1);
+        for (index_t e = 0; e < numElements; e++)
+            bucketElements[fill[bucketOfElement[e]]++] = e;
+    }
+
+    // find the closest face with matching centre for each face. Ties are
+    // resolved by the smaller element index so the result does not depend
+    // on the order of the faces in a bucket.
+    IndexVector partner(numElements, -1);
+    int numNeighbourCells = 1;
+    for (int i = 0; i < numDim; i++)
+        numNeighbourCells *= 3;
+    if (cellSize > 0. && tol > 0.) {
+#pragma omp parallel for
+        for (index_t e = 0; e < numElements; e++) {
+            const double* x = &center[INDEX2(0,e,numDim)];
+            double bestDist = tol;
+            index_t best = -1;
+            int64_t cell[3];
+            for (int n = 0; n < numNeighbourCells; n++) {
+                int m = n;
+                for (int i = 0; i < numDim; i++) {
+                    cell[i] = cells[INDEX2(i,e,numDim)] + (m % 3) - 1;
+                    m /= 3;
+                }
+                const dim_t b = getBucket(cell, numDim, numBuckets);
+                for (index_t k = bucketPtr[b]; k < bucketPtr[b + 1]; k++) {
+                    const index_t f = bucketElements[k];
+                    if (f == e)
+                        continue;
+                    double dist = 0.;
+                    for (int i = 0; i < numDim; i++)
+                        dist = std::max(dist, std::abs(x[i] -
+                                                center[INDEX2(i,f,numDim)]));
+                    if (dist < bestDist || (dist == bestDist && f < best)) {
+                        bestDist = dist;
+                        best = f;
+                    }
+                }
+            }
+            partner[e] = best;
+        }
+    }
+
     // find elements with matching center
     *numPairs = 0;
-
-    // TODO: OMP
-    for (index_t e = 0; e < m_faceElements->numElements-1; e++) {
-        double dist = 0.;
-        for (int i = 0; i < numDim; i++)
-            dist = std::max(dist, std::abs(center[e].x[i]-center[e+1].x[i]));
-        if (dist < h * tolerance) {
-            const int e_0 = center[e].refId;
-            const int e_1 = center[e+1].refId;
+    for (index_t e = 0; e < numElements; e++) {
+        const index_t f = partner[e];
+        if (f > e && partner[f] == e) {
+            const int e_0 = e;
+            const int e_1 = f;
+            double dist;
             elem0[*numPairs] = e_0;
             elem1[*numPairs] = e_1;
             // now the element e_1 is rotated such that the first node in
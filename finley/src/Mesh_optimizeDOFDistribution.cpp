@@ -17,6 +17,9 @@
 
 #include "FinleyDomain.h"
 #include "IndexList.h"
+#include "Util.h"
+
+#include <escript/EscriptParams.h>
 
 #include <escript/index.h>
 
@@ -28,6 +31,7 @@ typedef float real_t;
 #endif
 
 #include <iostream>
+#include <algorithm>
 #include <boost/scoped_array.hpp>
 
 namespace finley {
@@ -60,10 +64,132 @@ static bool allRanksHaveNodes(escript::JMPI mpiInfo,
 }
 #endif
 
-/// optimizes the distribution of DOFs across processors using ParMETIS.
+/// partitions the vertices by cutting a Hilbert curve through their
+/// coordinates into mpiSize pieces with (almost) the same total weight.
+/// If `weights` is empty all vertices have weight one.
+/// Pieces of a space-filling curve are compact so the number of vertices
+/// shared with other ranks stays small.
+static void partitionAlongHilbertCurve(const NodeFile* nodes,
+                                       escript::JMPI mpiInfo,
+                                       const IndexVector& distribution,
+                                       const std::vector<double>& weights,
+                                       index_t* partition)
+{
+    const int mpiSize = mpiInfo->size;
+    const int myRank = mpiInfo->rank;
+    const index_t myFirstVertex = distribution[myRank];
+    const dim_t myNumVertices = distribution[myRank + 1] - myFirstVertex;
+    const dim_t numNodes = nodes->getNumNodes();
+    const int dim = nodes->numDim;
+    const int bits = (dim == 1 ? 32 : 63 / dim);
+
+    // get the coordinates of the vertices
+    std::vector<double> xyz(myNumVertices * dim);
+#pragma omp parallel for
+    for (index_t i = 0; i < numNodes; ++i) {
+        const index_t k = nodes->globalDegreesOfFreedom[i] - myFirstVertex;
+        if (k >= 0 && k < myNumVertices) {
+            for (int j = 0; j < dim; ++j)
+                xyz[INDEX2(j, k, dim)] = nodes->Coordinates[INDEX2(j, i, dim)];
+        }
+    }
+
+    // get the global bounding box
+    double lo[3], hi[3], scale[3];
+    for (int j = 0; j < dim; ++j) {
+        lo[j] = std::numeric_limits<double>::max();
+        hi[j] = -std::numeric_limits<double>::max();
+    }
+    for (index_t k = 0; k < myNumVertices; ++k) {
+        for (int j = 0; j < dim; ++j) {
+            lo[j] = std::min(lo[j], xyz[INDEX2(j, k, dim)]);
+            hi[j] = std::max(hi[j], xyz[INDEX2(j, k, dim)]);
+        }
+    }
+#ifdef ESYS_MPI
+    double lo_local[3], hi_local[3];
+    std::copy(lo, lo + dim, lo_local);
+    std::copy(hi, hi + dim, hi_local);
+    MPI_Allreduce(lo_local, lo, dim, MPI_DOUBLE, MPI_MIN, mpiInfo->comm);
+    MPI_Allreduce(hi_local, hi, dim, MPI_DOUBLE, MPI_MAX, mpiInfo->comm);
+#endif
+    const double maxGrid = static_cast<double>((uint64_t(1) << bits) - 1);
+    for (int j = 0; j < dim; ++j)
+        scale[j] = (hi[j] > lo[j] ? maxGrid / (hi[j] - lo[j]) : 0.);
+
+    std::vector<uint64_t> key(myNumVertices);
+#pragma omp parallel for
+    for (index_t k = 0; k < myNumVertices; ++k)
+        key[k] = util::hilbertKey(&xyz[INDEX2(0, k, dim)], dim, lo, scale, bits);
+    std::vector<std::pair<uint64_t, double> > curve(myNumVertices);
+#pragma omp parallel for
+    for (index_t k = 0; k < myNumVertices; ++k) {
+        curve[k].first = key[k];
+        curve[k].second = (weights.empty() ? 1. : weights[k]);
+    }
+    std::sort(curve.begin(), curve.end());
+    // sortedKey[k] is the k-th key along the curve and weightInFront[k] the
+    // total weight of the vertices before it
+    std::vector<uint64_t> sortedKey(myNumVertices);
+    std::vector<double> weightInFront(myNumVertices + 1, 0.);
+    for (index_t k = 0; k < myNumVertices; ++k) {
+        sortedKey[k] = curve[k].first;
+        weightInFront[k + 1] = weightInFront[k] + curve[k].second;
+    }
+    double totalWeight = weightInFront[myNumVertices];
+#ifdef ESYS_MPI
+    double myWeight = totalWeight;
+    MPI_Allreduce(&myWeight, &totalWeight, 1, MPI_DOUBLE, MPI_SUM,
+                  mpiInfo->comm);
+#endif
+
+    // the curve is cut before the smallest key which has at least the
+    // weight p*totalWeight/mpiSize in front of it, p=1,...,mpiSize-1.
+    // The cuts are found by bisection over the keys using one reduction per
+    // bit of the key.
+    std::vector<uint64_t> cut(mpiSize - 1, 0);
+    if (mpiSize > 1) {
+        std::vector<uint64_t> cutHi(mpiSize - 1, uint64_t(1) << (dim * bits));
+        std::vector<double> front(mpiSize - 1);
+        std::vector<double> globalFront(mpiSize - 1);
+        for (int b = 0; b <= dim * bits; ++b) {
+            for (int p = 0; p < mpiSize - 1; ++p) {
+                const uint64_t mid = cut[p] + (cutHi[p] - cut[p]) / 2;
+                front[p] = weightInFront[std::lower_bound(sortedKey.begin(),
+                                    sortedKey.end(), mid) - sortedKey.begin()];
+            }
+#ifdef ESYS_MPI
+            MPI_Allreduce(&front[0], &globalFront[0], mpiSize - 1, MPI_DOUBLE,
+                          MPI_SUM, mpiInfo->comm);
+#else
+            globalFront = front;
+#endif
+            for (int p = 0; p < mpiSize - 1; ++p) {
+                const uint64_t mid = cut[p] + (cutHi[p] - cut[p]) / 2;
+                if (globalFront[p] >= totalWeight * (p + 1) / mpiSize) {
+                    cutHi[p] = mid;
+                } else {
+                    cut[p] = mid + 1;
+                }
+            }
+        }
+    }
+
+#pragma omp parallel for
+    for (index_t k = 0; k < myNumVertices; ++k) {
+        partition[k] = std::upper_bound(cut.begin(), cut.end(), key[k])
+                            - cut.begin();
+    }
+}
+
+/// optimizes the distribution of DOFs across processors using ParMETIS or,
+/// if it is not available or the BUILTIN_PARTITIONER escript parameter is
+/// set, by cutting a Hilbert curve through the DOF coordinates.
+/// `weights` holds the weights of the DOFs of this rank or is empty.
 /// On return a new distribution is given and the globalDOF are relabeled
 /// accordingly but the mesh has not been redistributed yet
-void FinleyDomain::optimizeDOFDistribution(IndexVector& distribution)
+void FinleyDomain::optimizeDOFDistribution(IndexVector& distribution,
+                                           const std::vector<double>& weights)
 {
     int mpiSize = m_mpiInfo->size;
     const int myRank = m_mpiInfo->rank;
@@ -80,7 +206,8 @@ void FinleyDomain::optimizeDOFDistribution(IndexVector& distribution)
     index_t* partition = new index_t[len];
 
 #ifdef ESYS_HAVE_PARMETIS
-    if (mpiSize > 1 && allRanksHaveNodes(m_mpiInfo, distribution)) {
+    if (!escript::escriptParams.getBuiltinPartitioner() && mpiSize > 1
+            && allRanksHaveNodes(m_mpiInfo, distribution)) {
         boost::scoped_array<IndexList> index_list(new IndexList[myNumVertices]);
         int dim = m_nodes->numDim;
 
@@ -148,7 +275,23 @@ void FinleyDomain::optimizeDOFDistribution(IndexVector& distribution)
         index_t options[3] = { 1, 0, 0 };
         std::vector<real_t> tpwgts(ncon * mpiSize, 1.f / mpiSize);
         std::vector<real_t> ubvec(ncon, 1.05f);
-        ParMETIS_V3_PartGeomKway(&distribution[0], ptr, index, NULL, NULL,
+        // ParMETIS needs positive integer vertex weights so the weights are
+        // scaled to an average of 100
+        std::vector<index_t> vwgt;
+        if (!weights.empty()) {
+            double sum = 0., globalSum;
+            for (index_t i = 0; i < myNumVertices; ++i)
+                sum += weights[i];
+            MPI_Allreduce(&sum, &globalSum, 1, MPI_DOUBLE, MPI_SUM,
+                          m_mpiInfo->comm);
+            const double f = (globalSum > 0. ? 100. * globalNumVertices / globalSum : 0.);
+            vwgt.resize(myNumVertices);
+            for (index_t i = 0; i < myNumVertices; ++i)
+                vwgt[i] = std::max(index_t(1), static_cast<index_t>(f * weights[i] + .5));
+            wgtflag = 2;
+        }
+        ParMETIS_V3_PartGeomKway(&distribution[0], ptr, index,
+                                 vwgt.empty() ? NULL : &vwgt[0], NULL,
                                  &wgtflag, &numflag, &idim, xyz, &ncon,
                                  &impiSize, &tpwgts[0], &ubvec[0], options,
                                  &edgecut, partition, &m_mpiInfo->comm);
@@ -156,13 +299,12 @@ void FinleyDomain::optimizeDOFDistribution(IndexVector& distribution)
         delete[] index;
         delete[] ptr;
     } else {
-        for (index_t i = 0; i < myNumVertices; ++i)
-            partition[i] = 0; // CPU 0 owns all
+        partitionAlongHilbertCurve(m_nodes, m_mpiInfo, distribution, weights,
+                                   partition);
     }
 #else
-#pragma omp parallel for
-    for (index_t i = 0; i < myNumVertices; ++i)
-        partition[i] = myRank; // CPU myRank owns all
+    partitionAlongHilbertCurve(m_nodes, m_mpiInfo, distribution, weights,
+                               partition);
 #endif // ESYS_HAVE_PARMETIS
 
     // create a new distribution and labeling of the DOF
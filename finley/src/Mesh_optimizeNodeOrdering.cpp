@@ -0,0 +1,154 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+
+/****************************************************************************
+
+  Finley: Domain
+
+  renumbers the nodes and degrees of freedom on each rank along a Hilbert
+  curve through the node coordinates so that nodes which are close in space
+  are close in memory.
+
+*****************************************************************************/
+
+#include "FinleyDomain.h"
+#include "Util.h"
+
+#include <escript/index.h>
+
+#include <algorithm>
+
+namespace finley {
+
+void FinleyDomain::optimizeNodeOrdering(const IndexVector& distribution)
+{
+    const int myRank = getMPIRank();
+    const int mpiSize = getMPISize();
+    const int numDim = m_nodes->numDim;
+    const dim_t numNodes = m_nodes->getNumNodes();
+    const double* X = m_nodes->Coordinates;
+    const int bits = (numDim == 1 ? 32 : 63 / numDim);
+
+    // get the bounding box of the local nodes
+    double lo[3], hi[3], scale[3];
+    for (int i = 0; i < numDim; i++) {
+        lo[i] = std::numeric_limits<double>::max();
+        hi[i] = -std::numeric_limits<double>::max();
+    }
+#pragma omp parallel
+    {
+        double lo_local[3], hi_local[3];
+        for (int i = 0; i < numDim; i++) {
+            lo_local[i] = std::numeric_limits<double>::max();
+            hi_local[i] = -std::numeric_limits<double>::max();
+        }
+#pragma omp for
+        for (index_t n = 0; n < numNodes; n++) {
+            for (int i = 0; i < numDim; i++) {
+                lo_local[i] = std::min(lo_local[i], X[INDEX2(i,n,numDim)]);
+                hi_local[i] = std::max(hi_local[i], X[INDEX2(i,n,numDim)]);
+            }
+        }
+#pragma omp critical
+        for (int i = 0; i < numDim; i++) {
+            lo[i] = std::min(lo[i], lo_local[i]);
+            hi[i] = std::max(hi[i], hi_local[i]);
+        }
+    }
+    // the largest grid coordinate along the curve is 2^bits-1
+    const double maxGrid = static_cast<double>((uint64_t(1) << bits) - 1);
+    for (int i = 0; i < numDim; i++)
+        scale[i] = (hi[i] > lo[i] ? maxGrid / (hi[i] - lo[i]) : 0.);
+
+    // sort the nodes along the curve. The node index is used to resolve
+    // ties so the result is deterministic.
+    std::vector<std::pair<uint64_t, index_t> > curve(numNodes);
+#pragma omp parallel for
+    for (index_t n = 0; n < numNodes; n++) {
+        curve[n].first = util::hilbertKey(&X[INDEX2(0,n,numDim)], numDim,
+                                          lo, scale, bits);
+        curve[n].second = n;
+    }
+    std::sort(curve.begin(), curve.end());
+
+    // the DOFs of this rank are labelled in the order in which their nodes
+    // are visited by the curve
+    const index_t myFirstVertex = distribution[myRank];
+    const index_t myLastVertex = distribution[myRank+1];
+    dim_t len = 1;
+    for (int p = 0; p < mpiSize; ++p)
+        len = std::max(len, distribution[p+1]-distribution[p]);
+    IndexVector newGlobalDOFID(len, -1);
+    index_t nextDOF = myFirstVertex;
+    for (index_t i = 0; i < numNodes; i++) {
+        const index_t k = m_nodes->globalDegreesOfFreedom[curve[i].second];
+        if (myFirstVertex <= k && k < myLastVertex
+                && newGlobalDOFID[k-myFirstVertex] < 0) {
+            newGlobalDOFID[k-myFirstVertex] = nextDOF++;
+        }
+    }
+
+    // distribute new labeling to other processors
+#ifdef ESYS_MPI
+    const int dest = m_mpiInfo->mod_rank(myRank + 1);
+    const int source = m_mpiInfo->mod_rank(myRank - 1);
+#endif
+    int current_rank = myRank;
+    for (int p = 0; p < mpiSize; ++p) {
+        const index_t firstVertex = distribution[current_rank];
+        const index_t lastVertex = distribution[current_rank + 1];
+#pragma omp parallel for
+        for (index_t i = 0; i < numNodes; ++i) {
+            const index_t k = m_nodes->globalDegreesOfFreedom[i];
+            if (firstVertex <= k && k < lastVertex) {
+                m_nodes->globalDegreesOfFreedom[i] = newGlobalDOFID[k-firstVertex];
+            }
+        }
+
+        if (p < mpiSize - 1) { // the final send can be skipped
+#ifdef ESYS_MPI
+            MPI_Status status;
+            MPI_Sendrecv_replace(&newGlobalDOFID[0], len, MPI_DIM_T,
+                                 dest, m_mpiInfo->counter(), source,
+                                 m_mpiInfo->counter(), m_mpiInfo->comm, &status);
+            m_mpiInfo->incCounter();
+#endif
+            current_rank = m_mpiInfo->mod_rank(current_rank - 1);
+        }
+    }
+
+    // finally the node table is reordered along the curve and the elements
+    // are relabelled accordingly
+    IndexVector index(numNodes);
+    IndexVector newLocalLabel(numNodes);
+#pragma omp parallel for
+    for (index_t i = 0; i < numNodes; i++) {
+        index[i] = curve[i].second;
+        newLocalLabel[curve[i].second] = i;
+    }
+    if (numNodes > 0) {
+        NodeFile sortedNodes(numDim, m_mpiInfo);
+        sortedNodes.allocTable(numNodes);
+        sortedNodes.gather(&index[0], m_nodes);
+        m_nodes->copyTable(0, 0, 0, &sortedNodes);
+        relabelElementNodes(newLocalLabel, 0);
+    }
+}
+
+} // namespace finley
+
@@ -21,6 +21,10 @@
 #include <escript/index.h>
 
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+#include <unordered_map>
 
 //can't return because the flag need to be shared across all nodes
 #define SSCANF_CHECK(scan_ret) { if (scan_ret == EOF) { errorFlag = 1;} }
@@ -89,111 +93,122 @@ inline char* next_space(char** position, int count)
     return *position;
 }
 
-int getSingleElement(FILE* f, int dim, double version, struct ElementInfo& e,
-        std::string& errorMsg, const std::string& filename,
-        bool useMacroElements)
+/// maps gmsh element type `gmsh_type` to the finley element type, its
+/// dimension and number of nodes. Returns false for unsupported types.
+bool getElementType(int gmsh_type, bool useMacroElements, ElementTypeId& type,
+                    int& dim, int& numNodes)
 {
-    int gmsh_type = -1;
-
-    std::vector<char> line;
-    if (!get_line(line, f))
-        return EARLY_EOF;
-    char *position = &line[0];
-    if (sscanf(position, "%d %d", &e.id, &gmsh_type) != 2) {
-        errorMsg = "malformed mesh file";
-        return THROW_ERROR;
-    }
-    if (next_space(&position, 2) == NULL)
-        return EARLY_EOF;
-
-    int numNodesPerElement = 0;
     switch (gmsh_type) {
         case 1:  /* line order 1 */
-            e.type = Line2;
-            e.dim = 1;
-            numNodesPerElement = 2;
+            type = Line2;
+            dim = 1;
+            numNodes = 2;
             break;
         case 2:  /* triangle order 1 */
-            e.type=Tri3;
-            numNodesPerElement= 3;
-            e.dim=2;
+            type = Tri3;
+            numNodes = 3;
+            dim = 2;
             break;
         case 3:  /* quadrilateral order 1 */
-            e.type=Rec4;
-            numNodesPerElement= 4;
-            e.dim=2;
+            type = Rec4;
+            numNodes = 4;
+            dim = 2;
             break;
         case 4:  /* tetrahedron order 1 */
-            e.type=Tet4;
-            numNodesPerElement= 4;
-            e.dim=3;
+            type = Tet4;
+            numNodes = 4;
+            dim = 3;
             break;
         case 5:  /* hexahedron order 1 */
-            e.type=Hex8;
-            numNodesPerElement= 8;
-            e.dim=3;
+            type = Hex8;
+            numNodes = 8;
+            dim = 3;
             break;
         case 8:  /* line order 2 */
             if (useMacroElements) {
-                e.type=Line3Macro;
+                type = Line3Macro;
             } else {
-                e.type=Line3;
+                type = Line3;
             }
-            numNodesPerElement= 3;
-            e.dim=1;
+            numNodes = 3;
+            dim = 1;
             break;
         case 9:  /* triangle order 2 */
             if (useMacroElements) {
-                 e.type=Tri6Macro;
+                type = Tri6Macro;
             } else {
-                 e.type=Tri6;
+                type = Tri6;
             }
-            numNodesPerElement= 6;
-            e.dim=2;
+            numNodes = 6;
+            dim = 2;
             break;
         case 10:  /* quadrilateral order 2 */
             if (useMacroElements) {
-                e.type=Rec9Macro;
+                type = Rec9Macro;
             } else {
-                e.type=Rec9;
+                type = Rec9;
             }
-            numNodesPerElement= 9;
-            e.dim=2;
+            numNodes = 9;
+            dim = 2;
             break;
         case 11:  /* tetrahedron order 2 */
             if (useMacroElements) {
-                e.type=Tet10Macro;
+                type = Tet10Macro;
             } else {
-                e.type=Tet10;
+                type = Tet10;
             }
-            numNodesPerElement= 10;
-            e.dim=3;
+            numNodes = 10;
+            dim = 3;
             break;
         case 16:  /* rectangular order 2 */
-            e.type=Rec8;
-            numNodesPerElement= 8;
-            e.dim=2;
+            type = Rec8;
+            numNodes = 8;
+            dim = 2;
             break;
         case 17:  /* hexahedron order 2 */
-            e.type=Hex20;
-            numNodesPerElement= 20;
-            e.dim=3;
+            type = Hex20;
+            numNodes = 20;
+            dim = 3;
             break;
-        case 15 :  /* point */
-            e.type=Point1;
-            numNodesPerElement= 1;
-            e.dim=0;
+        case 15:  /* point */
+            type = Point1;
+            numNodes = 1;
+            dim = 0;
             break;
         default:
-            {
-                e.type=NoRef;
-                e.dim=-1;
-                std::stringstream ss;
-                ss << "readGmsh: Unexpected gmsh element type "
-                    << gmsh_type << " in mesh file " << filename;
-                errorMsg = ss.str();
-                return THROW_ERROR;
-            }
+            type = NoRef;
+            dim = -1;
+            numNodes = 0;
+            return false;
+    }
+    return true;
+}
+
+int getSingleElement(FILE* f, int dim, double version, struct ElementInfo& e,
+        std::string& errorMsg, const std::string& filename,
+        bool useMacroElements)
+{
+    int gmsh_type = -1;
+
+    std::vector<char> line;
+    if (!get_line(line, f))
+        return EARLY_EOF;
+    char *position = &line[0];
+    if (sscanf(position, "%d %d", &e.id, &gmsh_type) != 2) {
+        errorMsg = "malformed mesh file";
+        return THROW_ERROR;
+    }
+    if (next_space(&position, 2) == NULL)
+        return EARLY_EOF;
+
+    int numNodesPerElement = 0;
+    if (!getElementType(gmsh_type, useMacroElements, e.type, e.dim,
+                        numNodesPerElement)) {
+        std::stringstream ss;
+        ss << "readGmsh: Unexpected gmsh element type "
+            << gmsh_type << " in mesh file " << filename;
+        errorMsg = ss.str();
+        return THROW_ERROR;
     }
     if (version <= 1.0) {
         int tmp = 0;
@@ -233,93 +248,13 @@ int getSingleElementMSH4(FILE* f, int dim, double version, struct ElementInfo& e
         bool useMacroElements, int gmsh_type, char *position)
 {
     int numNodesPerElement = 0;
-    switch (gmsh_type) {
-        case 1:  /* line order 1 */
-            e.type = Line2;
-            e.dim = 1;
-            numNodesPerElement = 2;
-            break;
-        case 2:  /* triangle order 1 */
-            e.type=Tri3;
-            numNodesPerElement= 3;
-            e.dim=2;
-            break;
-        case 3:  /* quadrilateral order 1 */
-            e.type=Rec4;
-            numNodesPerElement= 4;
-            e.dim=2;
-            break;
-        case 4:  /* tetrahedron order 1 */
-            e.type=Tet4;
-            numNodesPerElement= 4;
-            e.dim=3;
-            break;
-        case 5:  /* hexahedron order 1 */
-            e.type=Hex8;
-            numNodesPerElement= 8;
-            e.dim=3;
-            break;
-        case 8:  /* line order 2 */
-            if (useMacroElements) {
-                e.type=Line3Macro;
-            } else {
-                e.type=Line3;
-            }
-            numNodesPerElement= 3;
-            e.dim=1;
-            break;
-        case 9:  /* triangle order 2 */
-            if (useMacroElements) {
-                 e.type=Tri6Macro;
-            } else {
-                 e.type=Tri6;
-            }
-            numNodesPerElement= 6;
-            e.dim=2;
-            break;
-        case 10:  /* quadrilateral order 2 */
-            if (useMacroElements) {
-                e.type=Rec9Macro;
-            } else {
-                e.type=Rec9;
-            }
-            numNodesPerElement= 9;
-            e.dim=2;
-            break;
-        case 11:  /* tetrahedron order 2 */
-            if (useMacroElements) {
-                e.type=Tet10Macro;
-            } else {
-                e.type=Tet10;
-            }
-            numNodesPerElement= 10;
-            e.dim=3;
-            break;
-        case 16:  /* rectangular order 2 */
-            e.type=Rec8;
-            numNodesPerElement= 8;
-            e.dim=2;
-            break;
-        case 17:  /* hexahedron order 2 */
-            e.type=Hex20;
-            numNodesPerElement= 20;
-            e.dim=3;
-            break;
-        case 15 :  /* point */
-            e.type=Point1;
-            numNodesPerElement= 1;
-            e.dim=0;
-            break;
-        default:
-            {
-                e.type=NoRef;
-                e.dim=-1;
-                std::stringstream ss;
-                ss << "readGmsh: Unexpected gmsh element type "
-                    << gmsh_type << " in mesh file " << filename;
-                errorMsg = ss.str();
-                return THROW_ERROR;
-            }
+    if (!getElementType(gmsh_type, useMacroElements, e.type, e.dim,
+                        numNodesPerElement)) {
+        std::stringstream ss;
+        ss << "readGmsh: Unexpected gmsh element type "
+            << gmsh_type << " in mesh file " << filename;
+        errorMsg = ss.str();
+        return THROW_ERROR;
     }
 
     // char *position = &line[0];
@@ -1551,7 +1486,7 @@ FinleyDomain* readGmshSlave(escript::JMPI& mpiInfo,
                 MPI_Bcast(tagInfo, 2, MPI_INT,  0, mpiInfo->comm);
                 //strlen + 1 for null terminator
                 MPI_Bcast(&name, tagInfo[1], MPI_CHAR, 0, mpiInfo->comm);
-                dom->setTagMap(&name[1], tagInfo[0]);
+                dom->setTagMap(name, tagInfo[0]);
             }
         }
         //post logic error check
@@ -1564,6 +1499,701 @@ FinleyDomain* readGmshSlave(escript::JMPI& mpiInfo,
 #endif // ESYS_MPI
 }
 
+// binary MSH files follow. Rank 0 runs a quick index pass over the section
+// headers which only seeks over the record data. Every rank then reads its
+// own contiguous range of node and element records directly from the file
+// and prepare() takes care of the redistribution.
+
+/// a contiguous run of fixed-size node or element records in a binary file
+struct GmshBlock {
+    int64_t offset;      // byte offset of the first record (node tags in 4.1)
+    int64_t coordOffset; // byte offset of the node coordinates (4.1 only)
+    int64_t first;       // global index of the first record
+    int64_t count;       // number of records
+    int64_t gmshType;    // gmsh element type (elements only)
+    int64_t tag;         // entity tag (4.1) or number of tags (2.2)
+};
+
+/// layout of a binary MSH file as found by the index pass
+struct GmshIndex {
+    double version;
+    int sizeT;
+    int64_t numNodes;
+    int64_t numElements;
+    std::vector<GmshBlock> nodeBlocks;
+    std::vector<GmshBlock> elementBlocks;
+    std::vector<std::pair<int, std::string> > names;
+};
+
+/// returns true if the file looks like a gmsh file in binary format
+bool isBinaryGmsh(const std::string& filename)
+{
+    std::ifstream f(filename.c_str(), std::ios::binary);
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 11, "$MeshFormat") == 0) {
+            double version = 0.;
+            int format = 0;
+            return std::getline(f, line) && sscanf(line.c_str(), "%lf %d",
+                                                   &version, &format) == 2
+                   && format == 1;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+inline T readBinaryValue(std::ifstream& f)
+{
+    T value;
+    f.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!f)
+        throw IOError("readGmsh: early EOF while scanning");
+    return value;
+}
+
+/// reads an unsigned integer of `size` bytes (gmsh's size_t)
+inline int64_t readBinarySize(std::ifstream& f, int size)
+{
+    if (size == 4)
+        return readBinaryValue<uint32_t>(f);
+    return static_cast<int64_t>(readBinaryValue<uint64_t>(f));
+}
+
+/// decodes an integer of `size` bytes from a record buffer
+inline int64_t decodeInt(const char* p, int size)
+{
+    if (size == 4) {
+        int32_t value;
+        memcpy(&value, p, 4);
+        return value;
+    }
+    int64_t value;
+    memcpy(&value, p, 8);
+    return value;
+}
+
+/// skips the binary $Entities section of a MSH 4.1 file
+void skipEntities(std::ifstream& f, int sizeT)
+{
+    int64_t num[4];
+    for (int i = 0; i < 4; i++)
+        num[i] = readBinarySize(f, sizeT);
+    for (int i = 0; i < 4; i++) {
+        for (int64_t j = 0; j < num[i]; j++) {
+            // tag, bounding box (or point coordinates)
+            f.seekg(sizeof(int32_t) + (i == 0 ? 3 : 6) * sizeof(double),
+                    std::ios::cur);
+            const int64_t numPhysicals = readBinarySize(f, sizeT);
+            f.seekg(numPhysicals * sizeof(int32_t), std::ios::cur);
+            if (i > 0) {
+                const int64_t numBounding = readBinarySize(f, sizeT);
+                f.seekg(numBounding * sizeof(int32_t), std::ios::cur);
+            }
+        }
+    }
+}
+
+inline std::string unexpectedType(int gmsh_type, const std::string& filename)
+{
+    std::stringstream ss;
+    ss << "readGmsh: Unexpected gmsh element type " << gmsh_type
+        << " in mesh file " << filename;
+    return ss.str();
+}
+
+/// scans the section headers of binary gmsh file `filename` without reading
+/// the node and element records
+void indexGmsh(const std::string& filename, GmshIndex& index)
+{
+    std::ifstream f(filename.c_str(), std::ios::binary);
+    if (!f) {
+        std::stringstream ss;
+        ss << "readGmsh: opening file " << filename << " for reading failed.";
+        throw IOError(ss.str());
+    }
+    index.version = 0.;
+    index.sizeT = 0;
+    index.numNodes = -1;
+    index.numElements = -1;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] != '$' || line.compare(0, 4, "$End") == 0)
+            continue;
+
+        if (line.compare(0, 11, "$MeshFormat") == 0) {
+            int format = 0, size = 0;
+            if (!std::getline(f, line) || sscanf(line.c_str(), "%lf %d %d",
+                        &index.version, &format, &size) != 3)
+                throw IOError("readGmsh: malformed mesh file ($MeshFormat)");
+            if (index.version >= 4.1) {
+                if (size != 4 && size != 8)
+                    throw IOError("readGmsh: unsupported data size in binary mesh file");
+                index.sizeT = size;
+            } else if (index.version < 2. || index.version >= 3.) {
+                throw IOError("readGmsh: binary mesh files are only supported "
+                              "for format versions 2.2 and 4.1");
+            } else if (size != sizeof(double)) {
+                throw IOError("readGmsh: unsupported data size in binary mesh file");
+            }
+            if (readBinaryValue<int32_t>(f) != 1)
+                throw IOError("readGmsh: binary mesh file was written with a "
+                              "different byte order");
+        } else if (line.compare(0, 6, "$Nodes") == 0) {
+            int64_t numBlocks = 1;
+            if (index.version >= 4.1) {
+                numBlocks = readBinarySize(f, index.sizeT);
+                index.numNodes = readBinarySize(f, index.sizeT);
+                readBinarySize(f, index.sizeT); // min node tag
+                readBinarySize(f, index.sizeT); // max node tag
+            } else {
+                if (!std::getline(f, line))
+                    throw IOError("readGmsh: early EOF while scanning");
+                index.numNodes = std::stoll(line);
+            }
+            int64_t first = 0;
+            for (int64_t b = 0; b < numBlocks; b++) {
+                GmshBlock block = {0, 0, first, index.numNodes, 0, 0};
+                if (index.version >= 4.1) {
+                    readBinaryValue<int32_t>(f); // entity dimension
+                    block.tag = readBinaryValue<int32_t>(f);
+                    if (readBinaryValue<int32_t>(f) != 0)
+                        throw IOError("eScript does not supprot nodefiles with parametric coordinates.");
+                    block.count = readBinarySize(f, index.sizeT);
+                    block.offset = f.tellg();
+                    block.coordOffset = block.offset + block.count*index.sizeT;
+                    f.seekg(block.coordOffset + block.count*3*sizeof(double));
+                } else {
+                    block.offset = f.tellg();
+                    f.seekg(block.offset + block.count*(sizeof(int32_t)
+                                + 3*sizeof(double)));
+                }
+                index.nodeBlocks.push_back(block);
+                first += block.count;
+            }
+            if (first != index.numNodes)
+                throw IOError("readGmsh: malformed meshfile (broken node section)!");
+        } else if (line.compare(0, 9, "$Elements") == 0) {
+            int64_t numBlocks = -1;
+            if (index.version >= 4.1) {
+                numBlocks = readBinarySize(f, index.sizeT);
+                index.numElements = readBinarySize(f, index.sizeT);
+                readBinarySize(f, index.sizeT); // min element tag
+                readBinarySize(f, index.sizeT); // max element tag
+            } else {
+                if (!std::getline(f, line))
+                    throw IOError("readGmsh: early EOF while scanning");
+                index.numElements = std::stoll(line);
+            }
+            // in 2.2 files the number of blocks is implied by the element
+            // counts of the block headers
+            int64_t first = 0;
+            for (int64_t b = 0; b != numBlocks && first < index.numElements; b++) {
+                GmshBlock block = {0, 0, first, 0, 0, 0};
+                int64_t recordSize;
+                ElementTypeId type;
+                int dim, numNodes;
+                if (index.version >= 4.1) {
+                    readBinaryValue<int32_t>(f); // entity dimension
+                    block.tag = readBinaryValue<int32_t>(f);
+                    block.gmshType = readBinaryValue<int32_t>(f);
+                    block.count = readBinarySize(f, index.sizeT);
+                    if (!getElementType(block.gmshType, false, type, dim, numNodes))
+                        throw IOError(unexpectedType(block.gmshType, filename));
+                    recordSize = (1 + numNodes) * index.sizeT;
+                } else {
+                    block.gmshType = readBinaryValue<int32_t>(f);
+                    block.count = readBinaryValue<int32_t>(f);
+                    block.tag = readBinaryValue<int32_t>(f);
+                    if (!getElementType(block.gmshType, false, type, dim, numNodes))
+                        throw IOError(unexpectedType(block.gmshType, filename));
+                    recordSize = (1 + block.tag + numNodes) * sizeof(int32_t);
+                }
+                block.offset = f.tellg();
+                f.seekg(block.offset + block.count*recordSize);
+                index.elementBlocks.push_back(block);
+                first += block.count;
+            }
+            if (first != index.numElements)
+                throw IOError("readGmsh: malformed mesh file ($Elements section contains incorrect header information)");
+        } else if (line.compare(0, 14, "$PhysicalNames") == 0) {
+            if (!std::getline(f, line))
+                throw IOError("readGmsh: early EOF while scanning");
+            const int numNames = std::stoi(line);
+            for (int i = 0; i < numNames; i++) {
+                int dim, tag;
+                char name[1024] = {0};
+                if (!std::getline(f, line)
+                        || sscanf(line.c_str(), "%d %d %1023s", &dim, &tag, name) != 3)
+                    throw IOError("readGmsh: malformed mesh file ($PhysicalNames)");
+                // same name handling as the ASCII reader: the first word
+                // without its leading and trailing character (the quotes)
+                const size_t len = strlen(name);
+                if (len < 2)
+                    throw IOError("readGmsh: illegal tagname (\" missing?)");
+                index.names.push_back(std::make_pair(tag,
+                                    std::string(name+1, len-2)));
+            }
+        } else if (line.compare(0, 9, "$Entities") == 0 && index.version >= 4.1) {
+            skipEntities(f, index.sizeT);
+        }
+
+        // search for end of the section
+        while (std::getline(f, line) && line.compare(0, 4, "$End") != 0);
+        if (!f)
+            throw IOError("readGmsh: early EOF while scanning");
+    }
+    if (index.numNodes < 0)
+        throw IOError("EOF before nodes section found");
+    if (index.numElements < 0)
+        throw IOError("EOF before elements section found");
+}
+
+/// runs the index pass on rank 0 and shares the result with all ranks
+void broadcastGmshIndex(escript::JMPI& mpiInfo, const std::string& filename,
+                        GmshIndex& index)
+{
+    std::string errorMsg;
+    if (mpiInfo->rank == 0) {
+        try {
+            indexGmsh(filename, index);
+        } catch (std::exception& e) {
+            errorMsg = e.what();
+        }
+    }
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1) {
+        // pack everything into a vector of 64-bit integers and a string
+        std::vector<int64_t> header(7);
+        std::string names;
+        if (mpiInfo->rank == 0) {
+            header[0] = errorMsg.size();
+            header[1] = index.sizeT;
+            header[2] = index.nodeBlocks.size();
+            header[3] = index.elementBlocks.size();
+            std::stringstream ss;
+            for (size_t i = 0; i < index.names.size(); i++)
+                ss << index.names[i].first << " " << index.names[i].second << "\n";
+            names = errorMsg + ss.str();
+            header[4] = names.size();
+            header[5] = index.numNodes;
+            header[6] = index.numElements;
+        }
+        MPI_Bcast(&header[0], 7, MPI_INT64_T, 0, mpiInfo->comm);
+        names.resize(header[4]);
+        if (header[4] > 0)
+            MPI_Bcast(&names[0], header[4], MPI_CHAR, 0, mpiInfo->comm);
+        if (header[0] > 0)
+            throw IOError(names.substr(0, header[0]));
+
+        const int blockSize = sizeof(GmshBlock)/sizeof(int64_t);
+        MPI_Bcast(&index.version, 1, MPI_DOUBLE, 0, mpiInfo->comm);
+        index.sizeT = header[1];
+        index.numNodes = header[5];
+        index.numElements = header[6];
+        index.nodeBlocks.resize(header[2]);
+        index.elementBlocks.resize(header[3]);
+        if (header[2] > 0)
+            MPI_Bcast(&index.nodeBlocks[0], header[2]*blockSize, MPI_INT64_T,
+                      0, mpiInfo->comm);
+        if (header[3] > 0)
+            MPI_Bcast(&index.elementBlocks[0], header[3]*blockSize,
+                      MPI_INT64_T, 0, mpiInfo->comm);
+        if (mpiInfo->rank > 0) {
+            std::stringstream ss(names);
+            int tag;
+            while (ss >> tag) {
+                std::string name;
+                ss.get();
+                std::getline(ss, name);
+                index.names.push_back(std::make_pair(tag, name));
+            }
+        }
+        return;
+    }
+#endif
+    if (!errorMsg.empty())
+        throw IOError(errorMsg);
+}
+
+/// reads `count` bytes at `offset` into buffer
+void readGmshBytes(std::ifstream& f, int64_t offset, int64_t count,
+                   std::vector<char>& buffer)
+{
+    buffer.resize(count);
+    if (count == 0)
+        return;
+    f.seekg(offset);
+    f.read(&buffer[0], count);
+    if (!f)
+        throw IOError("readGmsh: early EOF while reading file");
+}
+
+/// node id -> (global position, tag) of the first tagged element using it
+typedef std::unordered_map<index_t, std::pair<int64_t, int> > NodeTagMap;
+
+#ifdef ESYS_MPI
+/// sends send[p] to rank p and returns the concatenation of the data
+/// received from all ranks in rank order
+std::vector<int64_t> exchange(escript::JMPI& mpiInfo,
+                              const std::vector<std::vector<int64_t> >& send,
+                              std::vector<int>& recvCounts)
+{
+    const int size = mpiInfo->size;
+    std::vector<int> sendCounts(size), sendOffsets(size), recvOffsets(size);
+    std::vector<int64_t> sendBuf;
+    for (int p = 0; p < size; p++) {
+        sendCounts[p] = send[p].size();
+        sendOffsets[p] = sendBuf.size();
+        sendBuf.insert(sendBuf.end(), send[p].begin(), send[p].end());
+    }
+    recvCounts.resize(size);
+    MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &recvCounts[0], 1, MPI_INT,
+                 mpiInfo->comm);
+    int total = 0;
+    for (int p = 0; p < size; p++) {
+        recvOffsets[p] = total;
+        total += recvCounts[p];
+    }
+    std::vector<int64_t> recvBuf(std::max(total, 1));
+    sendBuf.resize(std::max<size_t>(sendBuf.size(), 1));
+    MPI_Alltoallv(&sendBuf[0], &sendCounts[0], &sendOffsets[0], MPI_INT64_T,
+                  &recvBuf[0], &recvCounts[0], &recvOffsets[0], MPI_INT64_T,
+                  mpiInfo->comm);
+    recvBuf.resize(total);
+    return recvBuf;
+}
+#endif
+
+/// returns the tag of each node in `nodeIds`, i.e. the tag of the first
+/// tagged element in the file that uses the node, or -1 if there is none.
+/// The candidates of all ranks are combined on rank (id % size).
+std::vector<int> resolveNodeTags(escript::JMPI& mpiInfo,
+                                 const NodeTagMap& candidates,
+                                 const std::vector<index_t>& nodeIds)
+{
+    std::vector<int> tags(nodeIds.size(), -1);
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1) {
+        const int size = mpiInfo->size;
+        std::vector<std::vector<int64_t> > send(size);
+        std::vector<int> counts;
+        for (NodeTagMap::const_iterator it = candidates.begin();
+                it != candidates.end(); it++) {
+            std::vector<int64_t>& buf = send[it->first % size];
+            buf.push_back(it->first);
+            buf.push_back(it->second.first);
+            buf.push_back(it->second.second);
+        }
+        std::vector<int64_t> recv = exchange(mpiInfo, send, counts);
+        NodeTagMap merged;
+        for (size_t i = 0; i < recv.size(); i += 3) {
+            std::pair<NodeTagMap::iterator, bool> res = merged.insert(
+                    std::make_pair(recv[i], std::make_pair(recv[i+1], int(recv[i+2]))));
+            if (!res.second && res.first->second.first > recv[i+1])
+                res.first->second = std::make_pair(recv[i+1], int(recv[i+2]));
+        }
+
+        // ask the owners of the combined candidates for the node tags
+        for (int p = 0; p < size; p++)
+            send[p].clear();
+        for (size_t i = 0; i < nodeIds.size(); i++)
+            send[nodeIds[i] % size].push_back(nodeIds[i]);
+        recv = exchange(mpiInfo, send, counts);
+        std::vector<std::vector<int64_t> > reply(size);
+        size_t k = 0;
+        for (int p = 0; p < size; p++) {
+            for (int i = 0; i < counts[p]; i++, k++) {
+                NodeTagMap::const_iterator it = merged.find(recv[k]);
+                reply[p].push_back(it == merged.end() ? -1 : it->second.second);
+            }
+        }
+        recv = exchange(mpiInfo, reply, counts);
+        std::vector<int> pos(size, 0);
+        for (int p = 1; p < size; p++)
+            pos[p] = pos[p-1] + counts[p-1];
+        for (size_t i = 0; i < nodeIds.size(); i++)
+            tags[i] = recv[pos[nodeIds[i] % size]++];
+        return tags;
+    }
+#endif
+    for (size_t i = 0; i < nodeIds.size(); i++) {
+        NodeTagMap::const_iterator it = candidates.find(nodeIds[i]);
+        if (it != candidates.end())
+            tags[i] = it->second.second;
+    }
+    return tags;
+}
+
+FinleyDomain* readGmshBinary(escript::JMPI& mpiInfo,
+                             const std::string& filename, int numDim,
+                             int order, int reducedOrder,
+                             bool useMacroElements)
+{
+    GmshIndex index;
+    broadcastGmshIndex(mpiInfo, filename, index);
+
+    // the element types follow from the block headers
+    ElementTypeId finalElementType = NoRef;
+    ElementTypeId finalFaceElementType = NoRef;
+    ElementTypeId contactElementType = NoRef;
+    for (size_t b = 0; b < index.elementBlocks.size(); b++) {
+        ElementTypeId type;
+        int dim, numNodes;
+        getElementType(index.elementBlocks[b].gmshType, useMacroElements,
+                       type, dim, numNodes);
+        if (index.elementBlocks[b].count == 0)
+            continue;
+        if (dim == numDim) {
+            if (finalElementType == NoRef) {
+                finalElementType = type;
+            } else if (finalElementType != type) {
+                throw IOError("Finley can only handle a single type of internal elements.");
+            }
+        } else if (dim == numDim-1) {
+            if (finalFaceElementType == NoRef) {
+                finalFaceElementType = type;
+            } else if (finalFaceElementType != type) {
+                throw IOError("Finley can only handle a single type of face elements.");
+            }
+        }
+    }
+    if (finalElementType == NoRef) {
+        if (numDim == 1) {
+           finalElementType = Line2;
+        } else if (numDim == 2) {
+           finalElementType = Tri3;
+        } else if (numDim == 3) {
+           finalElementType = Tet4;
+        }
+    }
+    if (finalFaceElementType == NoRef) {
+        if (numDim == 1) {
+           finalFaceElementType = Point1;
+        } else if (numDim == 2) {
+           finalFaceElementType = Line2;
+        } else if (numDim == 3) {
+           finalFaceElementType = Tri3;
+        }
+    }
+    if (finalFaceElementType == Line2) {
+        contactElementType = Line2_Contact;
+    } else if (finalFaceElementType == Line3 || finalFaceElementType == Line3Macro) {
+        contactElementType = Line3_Contact;
+    } else if (finalFaceElementType == Tri3) {
+        contactElementType = Tri3_Contact;
+    } else if (finalFaceElementType == Tri6 || finalFaceElementType == Tri6Macro) {
+        contactElementType = Tri6_Contact;
+    } else {
+        contactElementType = Point1_Contact;
+    }
+
+    FinleyDomain* dom = new FinleyDomain(filename, numDim, mpiInfo);
+    for (size_t i = 0; i < index.names.size(); i++)
+        dom->setTagMap(index.names[i].second, index.names[i].first);
+
+    const_ReferenceElementSet_ptr refElements(new ReferenceElementSet(
+                finalElementType, order, reducedOrder));
+    const_ReferenceElementSet_ptr refFaceElements(new ReferenceElementSet(
+                finalFaceElementType, order, reducedOrder));
+    const_ReferenceElementSet_ptr refContactElements(new ReferenceElementSet(
+                contactElementType, order, reducedOrder));
+    const_ReferenceElementSet_ptr refPoints(new ReferenceElementSet(
+                Point1, order, reducedOrder));
+    ElementFile* elements = new ElementFile(refElements, mpiInfo);
+    dom->setElements(elements);
+    ElementFile* faces = new ElementFile(refFaceElements, mpiInfo);
+    dom->setFaceElements(faces);
+    ElementFile* contacts = new ElementFile(refContactElements, mpiInfo);
+    dom->setContactElements(contacts);
+    ElementFile* points = new ElementFile(refPoints, mpiInfo);
+    dom->setPoints(points);
+
+    // every rank reads a contiguous range of nodes and elements
+    const int rank = mpiInfo->rank;
+    const int size = mpiInfo->size;
+    const int64_t firstNode = index.numNodes * rank / size;
+    const int64_t lastNode = index.numNodes * (rank+1) / size;
+    const int64_t firstElement = index.numElements * rank / size;
+    const int64_t lastElement = index.numElements * (rank+1) / size;
+    const bool msh4 = (index.version >= 4.1);
+    const int intSize = (msh4 ? index.sizeT : sizeof(int32_t));
+
+    std::vector<index_t> nodeIds(lastNode - firstNode);
+    std::vector<double> coords(3*(lastNode - firstNode));
+    std::vector<index_t> elementIds, faceIds;
+    std::vector<int> elementTags, faceTags;
+    std::vector<index_t> elementNodes, faceNodes;
+    NodeTagMap nodeTagCandidates;
+    int errorFlag = 0;
+    std::string errorMsg;
+
+    try {
+        std::ifstream f(filename.c_str(), std::ios::binary);
+        if (!f) {
+            std::stringstream ss;
+            ss << "readGmsh: opening file " << filename << " for reading failed.";
+            throw IOError(ss.str());
+        }
+        std::vector<char> buffer, coordBuffer;
+        for (size_t b = 0; b < index.nodeBlocks.size(); b++) {
+            const GmshBlock& block = index.nodeBlocks[b];
+            const int64_t start = std::max(firstNode, block.first);
+            const int64_t end = std::min(lastNode, block.first + block.count);
+            if (start >= end)
+                continue;
+            const int64_t n = end - start;
+            const int64_t k0 = start - firstNode;
+            if (msh4) {
+                readGmshBytes(f, block.offset + (start-block.first)*intSize,
+                              n*intSize, buffer);
+                readGmshBytes(f, block.coordOffset + (start-block.first)*3*sizeof(double),
+                              n*3*sizeof(double), coordBuffer);
+                memcpy(&coords[3*k0], &coordBuffer[0], n*3*sizeof(double));
+#pragma omp parallel for
+                for (index_t i = 0; i < n; i++)
+                    nodeIds[k0+i] = decodeInt(&buffer[i*intSize], intSize);
+            } else {
+                const int recordSize = sizeof(int32_t) + 3*sizeof(double);
+                readGmshBytes(f, block.offset + (start-block.first)*recordSize,
+                              n*recordSize, buffer);
+#pragma omp parallel for
+                for (index_t i = 0; i < n; i++) {
+                    const char* record = &buffer[i*recordSize];
+                    nodeIds[k0+i] = decodeInt(record, sizeof(int32_t));
+                    memcpy(&coords[3*(k0+i)], record+sizeof(int32_t),
+                           3*sizeof(double));
+                }
+            }
+        }
+
+        for (size_t b = 0; b < index.elementBlocks.size(); b++) {
+            const GmshBlock& block = index.elementBlocks[b];
+            const int64_t start = std::max(firstElement, block.first);
+            const int64_t end = std::min(lastElement, block.first + block.count);
+            if (start >= end)
+                continue;
+            ElementTypeId type;
+            int dim, numNodes;
+            getElementType(block.gmshType, useMacroElements, type, dim, numNodes);
+            const int numTags = (msh4 ? 0 : block.tag);
+            const int recordSize = (1 + numTags + numNodes) * intSize;
+            readGmshBytes(f, block.offset + (start-block.first)*recordSize,
+                          (end-start)*recordSize, buffer);
+
+            std::vector<index_t>* ids = NULL;
+            std::vector<int>* tags = NULL;
+            std::vector<index_t>* nodes = NULL;
+            if (dim == numDim) {
+                ids = &elementIds;
+                tags = &elementTags;
+                nodes = &elementNodes;
+            } else if (dim == numDim-1) {
+                ids = &faceIds;
+                tags = &faceTags;
+                nodes = &faceNodes;
+            }
+            for (int64_t e = start; e < end; e++) {
+                const char* record = &buffer[(e-start)*recordSize];
+                const int tag = (msh4 ? block.tag : (numTags > 0 ?
+                            decodeInt(record+intSize, intSize) : 1));
+                const char* vertices = record + (1+numTags)*intSize;
+                if (!msh4 && tag != 0) {
+                    for (int j = 0; j < numNodes; j++)
+                        nodeTagCandidates.insert(std::make_pair(
+                            decodeInt(vertices+j*intSize, intSize),
+                            std::make_pair(e, tag)));
+                }
+                if (!ids)
+                    continue;
+                ids->push_back(decodeInt(record, intSize));
+                tags->push_back(tag);
+                for (int j = 0; j < numNodes; j++)
+                    nodes->push_back(decodeInt(vertices+j*intSize, intSize));
+                // for tet10 the last two nodes need to be swapped
+                if (type == Tet10 || type == Tet10Macro)
+                    std::swap(*(nodes->end()-1), *(nodes->end()-2));
+            }
+        }
+    } catch (std::exception& e) {
+        errorFlag = 1;
+        errorMsg = e.what();
+    }
+
+#ifdef ESYS_MPI
+    if (size > 1) {
+        int globalError;
+        MPI_Allreduce(&errorFlag, &globalError, 1, MPI_INT, MPI_MAX,
+                      mpiInfo->comm);
+        if (globalError && !errorFlag)
+            errorMsg = "readGmsh: reading the mesh file failed on another rank";
+        errorFlag = globalError;
+    }
+#endif
+    if (errorFlag) {
+        delete dom;
+        throw IOError(errorMsg);
+    }
+
+    // MSH 2.2 files get the node tags from the elements like the ASCII
+    // reader does, MSH 4.1 files don't
+    std::vector<int> nodeTags;
+    if (msh4) {
+        nodeTags.assign(nodeIds.size(), 0);
+    } else {
+        nodeTags = resolveNodeTags(mpiInfo, nodeTagCandidates, nodeIds);
+    }
+
+    const dim_t numNodes = nodeIds.size();
+    NodeFile* nodeFile = dom->getNodes();
+    nodeFile->allocTable(numNodes);
+#pragma omp parallel for
+    for (index_t i = 0; i < numNodes; i++) {
+        nodeFile->Id[i] = nodeIds[i];
+        nodeFile->globalDegreesOfFreedom[i] = nodeIds[i];
+        nodeFile->Tag[i] = (nodeTags[i] == -1 ? nodeIds[i] : nodeTags[i]);
+        for (int j = 0; j < numDim; j++)
+            nodeFile->Coordinates[INDEX2(j,i,numDim)] = coords[3*i+j];
+    }
+
+    const dim_t numElements = elementIds.size();
+    const dim_t numFaceElements = faceIds.size();
+    elements->allocTable(numElements);
+    faces->allocTable(numFaceElements);
+    contacts->allocTable(0);
+    points->allocTable(0);
+    elements->minColor = 0;
+    elements->maxColor = numElements - 1;
+    faces->minColor = 0;
+    faces->maxColor = numFaceElements - 1;
+    contacts->minColor = 0;
+    contacts->maxColor = 0;
+    points->minColor = 0;
+    points->maxColor = 0;
+
+#pragma omp parallel for
+    for (index_t e = 0; e < numElements; e++) {
+        elements->Id[e] = elementIds[e];
+        elements->Tag[e] = elementTags[e];
+        elements->Color[e] = e;
+        elements->Owner[e] = rank;
+        for (int j = 0; j < elements->numNodes; ++j)
+            elements->Nodes[INDEX2(j, e, elements->numNodes)] =
+                                    elementNodes[e*elements->numNodes+j];
+    }
+#pragma omp parallel for
+    for (index_t e = 0; e < numFaceElements; e++) {
+        faces->Id[e] = faceIds[e];
+        faces->Tag[e] = faceTags[e];
+        faces->Color[e] = e;
+        faces->Owner[e] = rank;
+        for (int j = 0; j < faces->numNodes; ++j)
+            faces->Nodes[INDEX2(j, e, faces->numNodes)] =
+                                    faceNodes[e*faces->numNodes+j];
+    }
+    return dom;
+}
+
 } // anonymous namespace
 
 
@@ -1575,7 +2205,19 @@ escript::Domain_ptr FinleyDomain::readGmsh(escript::JMPI mpiInfo,
 {
     FinleyDomain* dom;
 
-    if (mpiInfo->rank == 0) {
+    // binary files are read in parallel by all ranks
+    int binary = 0;
+    if (mpiInfo->rank == 0)
+        binary = isBinaryGmsh(filename);
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1)
+        MPI_Bcast(&binary, 1, MPI_INT, 0, mpiInfo->comm);
+#endif
+
+    if (binary) {
+        dom = readGmshBinary(mpiInfo, filename, numDim, order, reducedOrder,
+                             useMacroElements);
+    } else if (mpiInfo->rank == 0) {
         dom = readGmshMaster(mpiInfo, filename, numDim, order, reducedOrder,
                              optimize, useMacroElements);
     } else {
@@ -0,0 +1,275 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+
+/****************************************************************************
+
+  Finley: Domain
+
+  creates a copy of a prepared mesh which is distributed according to the
+  measured cost of the ranks and moves Data objects to the new mesh.
+
+*****************************************************************************/
+
+#include "FinleyDomain.h"
+
+#include <escript/Data.h>
+#include <escript/DataTagged.h>
+
+#include <algorithm>
+
+namespace bp = boost::python;
+
+using escript::Data;
+using escript::ValueError;
+
+namespace finley {
+
+/// copies the samples (ids, values) of all ranks into the samples of `out`
+/// with the same reference ids. The samples are sent around the ranks in a
+/// circle, ids and values are consumed in the process.
+static void migrateSamples(escript::JMPI mpiInfo, IndexVector& ids,
+                           std::vector<double>& values, int sampleSize,
+                           const index_t* newIds, dim_t newNumSamples,
+                           double* out)
+{
+    // sort the new samples by reference id for lookup
+    std::vector<std::pair<index_t, index_t> > lookup(newNumSamples);
+#pragma omp parallel for
+    for (index_t i = 0; i < newNumSamples; ++i) {
+        lookup[i].first = newIds[i];
+        lookup[i].second = i;
+    }
+    std::sort(lookup.begin(), lookup.end());
+    std::vector<short> found(newNumSamples, 0);
+
+#ifdef ESYS_MPI
+    const int dest = mpiInfo->mod_rank(mpiInfo->rank + 1);
+    const int source = mpiInfo->mod_rank(mpiInfo->rank - 1);
+#endif
+    for (int p = 0; p < mpiInfo->size; ++p) {
+        const dim_t numSamples = ids.size();
+#pragma omp parallel for
+        for (index_t i = 0; i < numSamples; ++i) {
+            std::vector<std::pair<index_t, index_t> >::const_iterator it =
+                std::lower_bound(lookup.begin(), lookup.end(),
+                                 std::make_pair(ids[i], index_t(0)));
+            for (; it != lookup.end() && it->first == ids[i]; ++it) {
+                std::copy(&values[i * sampleSize],
+                          &values[(i + 1) * sampleSize],
+                          &out[it->second * sampleSize]);
+                found[it->second] = 1;
+            }
+        }
+
+        if (p < mpiInfo->size - 1) { // the final send can be skipped
+#ifdef ESYS_MPI
+            MPI_Status status;
+            dim_t recvCount = 0;
+            MPI_Sendrecv(&numSamples, 1, MPI_DIM_T, dest, mpiInfo->counter(),
+                         &recvCount, 1, MPI_DIM_T, source, mpiInfo->counter(),
+                         mpiInfo->comm, &status);
+            IndexVector recvIds(recvCount);
+            std::vector<double> recvValues(recvCount * sampleSize);
+            MPI_Sendrecv(ids.empty() ? NULL : &ids[0], numSamples, MPI_DIM_T,
+                         dest, mpiInfo->counter() + 1,
+                         recvIds.empty() ? NULL : &recvIds[0], recvCount,
+                         MPI_DIM_T, source, mpiInfo->counter() + 1,
+                         mpiInfo->comm, &status);
+            MPI_Sendrecv(values.empty() ? NULL : &values[0],
+                         numSamples * sampleSize, MPI_DOUBLE, dest,
+                         mpiInfo->counter() + 2,
+                         recvValues.empty() ? NULL : &recvValues[0],
+                         recvCount * sampleSize, MPI_DOUBLE, source,
+                         mpiInfo->counter() + 2, mpiInfo->comm, &status);
+            mpiInfo->incCounter(3);
+            ids.swap(recvIds);
+            values.swap(recvValues);
+#endif
+        }
+    }
+
+    int error = 0;
+    for (index_t i = 0; i < newNumSamples; ++i) {
+        if (!found[i]) {
+            error = 1;
+            break;
+        }
+    }
+    int gerror = error;
+    escript::checkResult(error, gerror, mpiInfo);
+    if (gerror > 0)
+        throw FinleyException("rebalance: could not find all samples after "
+                              "redistribution.");
+}
+
+/// returns a copy of the constant or tagged Data object `in` on function
+/// space `fs` of another domain
+static Data copyNonExpanded(const Data& in, const escript::FunctionSpace& fs)
+{
+    const escript::DataTypes::ShapeType& shape = in.getDataPointShape();
+    Data out(0., shape, fs, false);
+    if (in.isComplex())
+        out.complicate();
+    if (in.isTagged()) {
+        out.tag();
+        const escript::DataTagged* src =
+                        dynamic_cast<const escript::DataTagged*>(in.borrowData());
+        const escript::DataTagged::DataMapType& lookup = src->getTagLookup();
+        escript::DataTagged::DataMapType::const_iterator it;
+        for (it = lookup.begin(); it != lookup.end(); ++it) {
+            if (in.isComplex()) {
+                out.setTaggedValueFromCPP(it->first, shape,
+                        src->getTypedVectorRO(escript::DataTypes::cplx_t(0)),
+                        it->second);
+            } else {
+                out.setTaggedValueFromCPP(it->first, shape,
+                                          src->getVectorRO(), it->second);
+            }
+        }
+    }
+    // the value of constant data and the default value of tagged data are
+    // stored first
+    out.requireWrite();
+    escript::DataReady_ptr dest = out.borrowReadyPtr();
+    const escript::DataReady_ptr src = in.borrowReadyPtr();
+    const dim_t n = in.getDataPointSize();
+    if (in.isComplex()) {
+        const escript::DataTypes::cplx_t zero(0);
+        std::copy(&src->getTypedVectorRO(zero)[0],
+                  &src->getTypedVectorRO(zero)[0] + n,
+                  &dest->getTypedVectorRW(zero)[0]);
+    } else {
+        std::copy(&src->getVectorRO()[0], &src->getVectorRO()[0] + n,
+                  &dest->getVectorRW()[0]);
+    }
+    return out;
+}
+
+/// returns a copy of the expanded Data object `in` on function space `fs`
+/// of another domain. The samples are matched by reference id.
+static Data copyExpanded(escript::JMPI mpiInfo, const Data& in,
+                         const escript::FunctionSpace& fs)
+{
+    const bool isComplex = in.isComplex();
+    const int sampleSize = in.getNumDataPointsPerSample()
+                            * in.getDataPointSize() * (isComplex ? 2 : 1);
+    const dim_t numSamples = in.getNumSamples();
+    const index_t* refIds = in.getFunctionSpace().borrowSampleReferenceIDs();
+    IndexVector ids(refIds, refIds + numSamples);
+    std::vector<double> values(numSamples * sampleSize);
+    if (numSamples > 0) {
+        // the samples of expanded data are stored contiguously
+        const double* src = (isComplex ?
+            reinterpret_cast<const double*>(in.getSampleDataRO(0,
+                    escript::DataTypes::cplx_t(0))) :
+            in.getSampleDataRO(0));
+        std::copy(src, src + values.size(), values.begin());
+    }
+
+    Data out(0., in.getDataPointShape(), fs, true);
+    if (isComplex)
+        out.complicate();
+    out.requireWrite();
+    const dim_t newNumSamples = out.getNumSamples();
+    double* dest = NULL;
+    if (newNumSamples > 0) {
+        dest = (isComplex ?
+            reinterpret_cast<double*>(out.getSampleDataRW(0,
+                    escript::DataTypes::cplx_t(0))) :
+            out.getSampleDataRW(0));
+    }
+    migrateSamples(mpiInfo, ids, values, sampleSize,
+                   fs.borrowSampleReferenceIDs(), newNumSamples, dest);
+    return out;
+}
+
+bp::tuple FinleyDomain::rebalance(double cost, const bp::list& data) const
+{
+    int error = (cost > 0. ? 0 : 1);
+    int gerror = error;
+    escript::checkResult(error, gerror, m_mpiInfo);
+    if (gerror > 0)
+        throw ValueError("rebalance: cost must be positive on all ranks.");
+
+    const int numData = bp::len(data);
+    for (int d = 0; d < numData; ++d) {
+        bp::extract<Data&> ex(data[d]);
+        if (!ex.check())
+            throw ValueError("rebalance: data must be a list of Data objects.");
+        const Data& in = ex();
+        if (!in.isEmpty() && in.getFunctionSpace().getDomain().get() != this)
+            throw ValueError("rebalance: Data object is not defined on this "
+                             "domain.");
+    }
+
+    // copy the mesh, the copy is redistributed and this domain is left
+    // untouched so existing Data objects remain valid
+    FinleyDomain* out = new FinleyDomain(m_name, getDim(), m_mpiInfo);
+    escript::Domain_ptr result(out);
+    out->setElements(new ElementFile(m_elements->referenceElementSet, m_mpiInfo));
+    out->setFaceElements(new ElementFile(m_faceElements->referenceElementSet, m_mpiInfo));
+    out->setContactElements(new ElementFile(m_contactElements->referenceElementSet, m_mpiInfo));
+    out->setPoints(new ElementFile(m_points->referenceElementSet, m_mpiInfo));
+    out->m_nodes->allocTable(m_nodes->getNumNodes());
+    out->m_elements->allocTable(m_elements->numElements);
+    out->m_faceElements->allocTable(m_faceElements->numElements);
+    out->m_contactElements->allocTable(m_contactElements->numElements);
+    out->m_points->allocTable(m_points->numElements);
+    out->m_nodes->copyTable(0, 0, 0, m_nodes);
+    out->m_elements->copyTable(0, 0, 0, m_elements);
+    out->m_faceElements->copyTable(0, 0, 0, m_faceElements);
+    out->m_contactElements->copyTable(0, 0, 0, m_contactElements);
+    out->m_points->copyTable(0, 0, 0, m_points);
+    out->m_tagMap = m_tagMap;
+    out->setOrders();
+
+    IndexVector distribution(
+            m_nodes->degreesOfFreedomDistribution->first_component);
+    if (m_mpiInfo->size > 1) {
+        // the cost of this rank is spread evenly over its DOFs
+        const dim_t myNumVertices = distribution[m_mpiInfo->rank + 1]
+                                        - distribution[m_mpiInfo->rank];
+        std::vector<double> weights(myNumVertices,
+                                    cost / std::max(myNumVertices, dim_t(1)));
+        out->optimizeDOFDistribution(distribution, weights);
+    }
+    out->distributeByRankOfDOF(distribution);
+    out->createLabelingsAndMappings(distribution, true);
+    out->updateTagList();
+
+    // copy the Data objects one at a time
+    bp::list newData;
+    for (int d = 0; d < numData; ++d) {
+        Data in = bp::extract<Data>(data[d]);
+        if (in.isEmpty()) {
+            newData.append(in);
+            continue;
+        }
+        if (in.isLazy())
+            in.resolve();
+        const escript::FunctionSpace fs(result,
+                                        in.getFunctionSpace().getTypeCode());
+        if (in.isExpanded())
+            newData.append(copyExpanded(m_mpiInfo, in, fs));
+        else
+            newData.append(copyNonExpanded(in, fs));
+    }
+    return bp::make_tuple(result, newData);
+}
+
+} // namespace finley
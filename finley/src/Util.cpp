@@ -307,7 +307,6 @@ IndexPair getFlaggedMinMaxInt(dim_t N, const index_t* values, index_t ignore)
     index_t vmin = escript::DataTypes::index_t_max();
     index_t vmax = escript::DataTypes::index_t_min();
     if (values && N > 0) {
-        vmin = vmax = values[0];
 #pragma omp parallel
         {
             index_t vmin_local = vmin;
@@ -340,6 +339,50 @@ std::vector<index_t> packMask(const std::vector<short>& mask)
     return index;
 }
 
+// this uses the transpose algorithm by J. Skilling, "Programming the Hilbert
+// curve", AIP Conf. Proc. 707 (2004)
+uint64_t hilbertKey(const double* x, int numDim, const double* lo,
+                    const double* scale, int bits)
+{
+    const double maxGrid = static_cast<double>((uint64_t(1) << bits) - 1);
+    uint32_t X[3];
+    for (int i = 0; i < numDim; i++)
+        X[i] = static_cast<uint32_t>(std::min((x[i] - lo[i]) * scale[i], maxGrid));
+
+    // undo excess work (inverse of the rotations and reflections)
+    const uint32_t M = 1u << (bits - 1);
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        const uint32_t P = Q - 1;
+        for (int i = 0; i < numDim; i++) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                const uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+    // Gray encode
+    for (int i = 1; i < numDim; i++)
+        X[i] ^= X[i-1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (X[numDim-1] & Q)
+            t ^= Q - 1;
+    }
+    for (int i = 0; i < numDim; i++)
+        X[i] ^= t;
+
+    // interleave the bits of the transposed index
+    uint64_t key = 0;
+    for (int b = bits - 1; b >= 0; b--) {
+        for (int i = 0; i < numDim; i++)
+            key = (key << 1) | ((X[i] >> b) & 1);
+    }
+    return key;
+}
+
 void setValuesInUse(const int* values, dim_t numValues,
                     std::vector<int>& valuesInUse, escript::JMPI mpiinfo)
 {
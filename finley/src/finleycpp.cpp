@@ -134,6 +134,19 @@ BOOST_PYTHON_MODULE(finleycpp)
 ":param full:\n:type full: ``bool``")
       .def("dump", &finley::FinleyDomain::dump, args("fileName")
 ,"dumps the mesh to a file with the given name.")
+      .def("dumpBinary", &finley::FinleyDomain::dumpBinary, args("fileName")
+,"writes the mesh to a single binary checkpoint file which can be loaded\n"
+"with `LoadMesh` on any number of ranks.")
+      .def("rebalance", &finley::FinleyDomain::rebalance,
+           (arg("cost"), arg("data")=boost::python::list()),
+"returns a copy of the mesh which is redistributed so that the cost of\n"
+"the ranks is balanced. Each rank passes its own cost, e.g. the time spent\n"
+"since the last call. The `Data` objects in ``data`` are copied to the new\n"
+"mesh, this mesh and its `Data` objects remain valid.\n\n"
+":param cost: the cost of this rank\n:type cost: positive ``float``\n"
+":param data: `Data` objects to copy\n:type data: ``list``\n"
+":return: the new domain and the list of copied `Data` objects\n"
+":rtype: ``tuple``")
       .def("getDescription", &finley::FinleyDomain::getDescription,
 ":return: a description for this domain\n:rtype: ``string``")
       .def("getDim", &finley::FinleyDomain::getDim,":rtype: ``int``")
@@ -20,10 +20,15 @@
 #include "FinleyDomainTestCase.h"
 
 #include <finley/DomainFactory.h>
+#include <finley/FinleyDomain.h>
+
+#include <escript/EscriptParams.h>
 
 #include <cppunit/TestCaller.h>
 #include <boost/scoped_ptr.hpp>
 
+#include <map>
+
 using namespace escript;
 using namespace finley;
 using namespace CppUnit;
@@ -35,12 +40,70 @@ void FinleyDomainTestCase::testAll()
     CPPUNIT_ASSERT(dom->getDim() == 3);
 }
 
+// checks that all elements have a colour and that no two elements of the
+// same colour share a degree of freedom
+static void checkColoring(const ElementFile* elements, const NodeFile* nodes)
+{
+    const int NN = elements->numNodes;
+    // element of each colour touching a DOF
+    std::map<std::pair<index_t, index_t>, index_t> owner;
+    for (index_t e = 0; e < elements->numElements; e++) {
+        const index_t color = elements->Color[e];
+        CPPUNIT_ASSERT(color >= elements->minColor);
+        CPPUNIT_ASSERT(color <= elements->maxColor);
+        for (int i = 0; i < NN; i++) {
+            const index_t dof = nodes->globalDegreesOfFreedom[
+                                        elements->Nodes[INDEX2(i, e, NN)]];
+            const std::pair<index_t, index_t> key(dof, color);
+            std::map<std::pair<index_t, index_t>, index_t>::const_iterator it
+                = owner.find(key);
+            if (it == owner.end())
+                owner[key] = e;
+            else
+                CPPUNIT_ASSERT(it->second == e);
+        }
+    }
+}
+
+static void checkDomainColoring(Domain_ptr dom)
+{
+    const FinleyDomain* fd = dynamic_cast<const FinleyDomain*>(dom.get());
+    CPPUNIT_ASSERT(fd);
+    checkColoring(fd->getElements(), fd->getNodes());
+    checkColoring(fd->getFaceElements(), fd->getNodes());
+    checkColoring(fd->getContactElements(), fd->getNodes());
+    checkColoring(fd->getPoints(), fd->getNodes());
+}
+
+void FinleyDomainTestCase::testColoring()
+{
+    JMPI info = makeInfo(MPI_COMM_WORLD);
+    const int balanced = getEscriptParamInt("BALANCED_COLORING");
+    for (int b = 0; b <= 1; b++) {
+        setEscriptParamInt("BALANCED_COLORING", b);
+        for (int order = -1; order <= 2; order++) {
+            if (order == 0)
+                continue;
+            checkDomainColoring(rectangle(info, 9, 7, order));
+            // periodic meshes, with rich face elements if supported
+            checkDomainColoring(rectangle(info, 6, 5, order, 1., 1., true,
+                                          false, -1, -1, order > 0));
+            checkDomainColoring(brick(info, 5, 4, 3, order));
+            checkDomainColoring(brick(info, 4, 3, 4, order, 1., 1., 1.,
+                                      false, true, true, -1, -1, order > 0));
+        }
+    }
+    setEscriptParamInt("BALANCED_COLORING", balanced);
+}
+
 TestSuite* FinleyDomainTestCase::suite()
 {
     TestSuite *testSuite = new TestSuite("FinleyDomainTestCase");
 
     testSuite->addTest(new TestCaller<FinleyDomainTestCase>(
                 "testAll",&FinleyDomainTestCase::testAll));
+    testSuite->addTest(new TestCaller<FinleyDomainTestCase>(
+                "testColoring",&FinleyDomainTestCase::testColoring));
     return testSuite;
 }
 
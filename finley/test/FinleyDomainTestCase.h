@@ -26,6 +26,7 @@ class FinleyDomainTestCase : public CppUnit::TestFixture
 {
 public:
     void testAll();
+    void testColoring();
     
     static CppUnit::TestSuite* suite();
 };
@@ -29,8 +29,8 @@ import esys.escriptcore.utestselect as unittest
 from esys.escriptcore.testing import *
 from esys.escript import *
 from esys.finley import Rectangle, Brick, ReadMesh, ReadGmsh
-from test_objects import Test_Dump, Test_SetDataPointValue, Test_saveCSV, \
-        Test_TableInterpolation, Test_Domain, Test_Lazy, Test_tagMap
+from test_objects import Test_Dump, Test_DumpChunked, Test_SetDataPointValue, \
+        Test_saveCSV, Test_TableInterpolation, Test_Domain, Test_Lazy, Test_tagMap
 from test_shared import Test_Shared
 
 try:
@@ -140,6 +140,18 @@ class Test_DumpOnFinley(Test_Dump):
        del self.domain_with_different_number_of_data_points_per_sample
        del self.domain_with_different_sample_ordering
 
+class Test_DumpChunkedOnFinley(Test_DumpChunked):
+   def setUp(self):
+       self.domain = Rectangle(NE, NE+1, 2)
+       self.domain_with_different_number_of_data_points_per_sample =Rectangle(2*NE,NE+1,2,integrationOrder=2)
+       self.domain_with_different_sample_ordering =Rectangle(NE,NE+1,2, optimize=True)
+       self.filename_base=FINLEY_WORKDIR
+
+   def tearDown(self):
+       del self.domain
+       del self.domain_with_different_number_of_data_points_per_sample
+       del self.domain_with_different_sample_ordering
+
 class Test_SetDataPointValueOnFinley(Test_SetDataPointValue):
    def setUp(self):
        self.domain = Rectangle(NE, NE+1, 2)
@@ -118,6 +118,99 @@ class Test_InputOutputOnFinley(unittest.TestCase):
         mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=-1, l0=1., l1=1., l2=1., optimize=False,useElementsOnFace=0)
         mydomain2 = Brick(n0=NE0, n1=NE1, n2=NE2, order=-1, l0=1., l1=1., l2=1., optimize=True,useElementsOnFace=0)
         self.domainsEqual(mydomain1, mydomain2)
+     # Does the Hilbert curve ordering change Brick for order=2?
+     def test_Brick_hilbert_ordering_order2(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=2, l0=1., l1=1., l2=1., optimize=False,useElementsOnFace=0)
+        setEscriptParamInt("HILBERT_ORDERING", 1)
+        try:
+            mydomain2 = Brick(n0=NE0, n1=NE1, n2=NE2, order=2, l0=1., l1=1., l2=1., optimize=False,useElementsOnFace=0)
+        finally:
+            setEscriptParamInt("HILBERT_ORDERING", 0)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     # Does the built-in partitioner change Brick?
+     def test_Brick_builtin_partitioner(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=False,useElementsOnFace=0)
+        setEscriptParamInt("BUILTIN_PARTITIONER", 1)
+        try:
+            mydomain2 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True,useElementsOnFace=0)
+        finally:
+            setEscriptParamInt("BUILTIN_PARTITIONER", 0)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     # Does the built-in partitioner give every rank the same number of DOFs?
+     @unittest.skipIf(mpisize<2, "less than 2 MPI ranks")
+     def test_builtin_partitioner_balance(self):
+        setEscriptParamInt("BUILTIN_PARTITIONER", 1)
+        try:
+            domains = [Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True,useElementsOnFace=0),
+                       Rectangle(n0=NE0, n1=NE1, order=1, l0=1., l1=1., optimize=True,useElementsOnFace=0),
+                       ReadMesh(os.path.join(FINLEY_TEST_MESH_PATH, "brick_8x10x12.fly"), optimize=True)]
+        finally:
+            setEscriptParamInt("BUILTIN_PARTITIONER", 0)
+        for dom in domains:
+            numDOF = Scalar(0., Solution(dom)).getNumberOfDataPoints()
+            maxDOF = getMPIWorldMax(numDOF)
+            minDOF = -getMPIWorldMax(-numDOF)
+            self.assertTrue(minDOF > 0, "a rank has no DOFs")
+            self.assertTrue(maxDOF - minDOF <= 1, "partitions are not balanced: %d to %d DOFs" % (minDOF, maxDOF))
+
+     # Does rebalance keep the domain and the values of the Data?
+     def test_Brick_rebalance(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=1, l0=1., l1=1., l2=1., optimize=True,useElementsOnFace=0)
+        x = ContinuousFunction(mydomain1).getX()
+        u = x[0]*x[1]-x[2]
+        u.expand()
+        x = Function(mydomain1).getX()
+        v = x[0]+x[1]*x[2]
+        v.expand()
+        c = Scalar(1.5, Function(mydomain1))
+        mydomain2, data = mydomain1.rebalance(getMPIRankWorld()+1., [u, v, c])
+        u2, v2, c2 = data
+        x = ContinuousFunction(mydomain2).getX()
+        self.assertLess(Lsup(u2-(x[0]*x[1]-x[2])), REL_TOL, "copied continuous data differs")
+        x = Function(mydomain2).getX()
+        self.assertLess(Lsup(v2-(x[0]+x[1]*x[2])), REL_TOL, "copied function data differs")
+        self.assertLess(Lsup(c2-1.5), REL_TOL, "constant data differs")
+        x = Function(mydomain1).getX()
+        self.assertLess(Lsup(v-(x[0]+x[1]*x[2])), REL_TOL, "original data changed")
+        self.domainsEqual(mydomain1, mydomain2)
+
+     # Does rebalance move work away from an expensive rank?
+     @unittest.skipIf(mpisize<2, "less than 2 MPI ranks")
+     def test_Brick_rebalance_ranks(self):
+        mydomain1 = Brick(n0=NE0, n1=NE1, n2=NE2, order=2, l0=1., l1=1., l2=1., optimize=True,useElementsOnFace=0)
+        rank = getMPIRankWorld()
+        x = Solution(mydomain1).getX()
+        u = x[0]-2*x[1]*x[2]
+        u.expand()
+        x = ReducedFunction(mydomain1).getX()
+        v = x[0]*x[2]+x[1]
+        v.expand()
+        c = Vector(0.25, Function(mydomain1))
+        t = Scalar(1., FunctionOnBoundary(mydomain1))
+        t.setTaggedValue("top", 4.)
+        t.setTaggedValue("front", 7.)
+        numPoints1 = Function(mydomain1).getX().getNumberOfDataPoints()
+        cost = 4. if rank == 0 else 1.
+        mydomain2, data = mydomain1.rebalance(cost, [u, v, c, t])
+        u2, v2, c2, t2 = data
+        numPoints2 = Function(mydomain2).getX().getNumberOfDataPoints()
+        if rank == 0:
+            self.assertLess(numPoints2, numPoints1, "rank 0 did not give away work")
+        x = Solution(mydomain2).getX()
+        self.assertLess(Lsup(u2-(x[0]-2*x[1]*x[2])), REL_TOL, "copied solution data differs")
+        x = ReducedFunction(mydomain2).getX()
+        self.assertLess(Lsup(v2-(x[0]*x[2]+x[1])), REL_TOL, "copied reduced function data differs")
+        self.assertLess(Lsup(c2-0.25), REL_TOL, "constant data differs")
+        self.assertTrue(t2.isTagged(), "tagged data is not tagged")
+        t3 = Scalar(1., FunctionOnBoundary(mydomain2))
+        t3.setTaggedValue("top", 4.)
+        t3.setTaggedValue("front", 7.)
+        self.assertLess(Lsup(t2-t3), REL_TOL, "tagged data differs")
+        x = Solution(mydomain1).getX()
+        self.assertLess(Lsup(u-(x[0]-2*x[1]*x[2])), REL_TOL, "original data changed")
+        self.domainsEqual(mydomain1, mydomain2)
 
      @unittest.skipIf(not loadIsConfigured(), "load not configured")
      def test_data_dump_to_NetCDF_rectangle(self):
@@ -233,5 +326,45 @@ class Test_InputOutputOnFinley(unittest.TestCase):
         mydomain2 = ReadGmsh(os.path.join(FINLEY_TEST_MESH_PATH,"testcube.4.1.msh"), numDim=3)
         self.domainsEqual(mydomain1, mydomain2)
 
+     def test_readgmsh_binary_format_2_2(self):
+        mydomain1 = ReadGmsh(os.path.join(FINLEY_TEST_MESH_PATH,"testcube.2.2.msh"), numDim=3)
+        mydomain2 = ReadGmsh(os.path.join(FINLEY_TEST_MESH_PATH,"testcube_binary.2.2.msh"), numDim=3)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     def test_readgmsh_binary_format_4_1(self):
+        mydomain1 = ReadGmsh(os.path.join(FINLEY_TEST_MESH_PATH,"testcube.2.2.msh"), numDim=3)
+        mydomain2 = ReadGmsh(os.path.join(FINLEY_TEST_MESH_PATH,"testcube_binary.4.1.msh"), numDim=3)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     def test_mesh_dump_binary_rectangle(self):
+        mydomain1 = Rectangle(n0=NE0, n1=NE1, order=2, l0=1., l1=1., optimize=True)
+        dumpfile=os.path.join(FINLEY_WORKDIR, "tempfile.mesh.ckpt")
+        mydomain1.dumpBinary(dumpfile)
+        mydomain2=LoadMesh(dumpfile)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     def test_mesh_dump_binary_gmsh(self):
+        mydomain1 = ReadGmsh(os.path.join(FINLEY_TEST_MESH_PATH,"testcube.2.2.msh"), numDim=3)
+        dumpfile=os.path.join(FINLEY_WORKDIR, "tempfile.gmsh.ckpt")
+        mydomain1.dumpBinary(dumpfile)
+        mydomain2=LoadMesh(dumpfile)
+        self.domainsEqual(mydomain1, mydomain2)
+
+     # the reference checkpoints were written on 1 and on 3 ranks so at
+     # least one of them is always loaded on a different number of ranks
+     @unittest.skipIf(hasFeature("longindex"), "checkpoints were written with 32-bit indices")
+     def test_mesh_load_binary_rectangle_other_ranks(self):
+        mydomain1 = Rectangle(n0=8, n1=10, order=2, l0=1., l1=1., optimize=False)
+        for ranks in ("1rank", "3ranks"):
+            mydomain2=LoadMesh(os.path.join(FINLEY_TEST_MESH_PATH, "rect_8x10_order2_%s.ckpt"%ranks))
+            self.domainsEqual(mydomain1, mydomain2)
+
+     @unittest.skipIf(hasFeature("longindex"), "checkpoints were written with 32-bit indices")
+     def test_mesh_load_binary_brick_other_ranks(self):
+        mydomain1 = Brick(n0=4, n1=4, n2=4, order=2, l0=1., l1=1., l2=1., optimize=False)
+        for ranks in ("1rank", "3ranks"):
+            mydomain2=LoadMesh(os.path.join(FINLEY_TEST_MESH_PATH, "brick_4x4x4_order2_%s.ckpt"%ranks))
+            self.domainsEqual(mydomain1, mydomain2)
+
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
@@ -41,7 +41,10 @@ import esys.escriptcore.utestselect as unittest
 from esys.escriptcore.testing import *
 from test_linearPDEs import Test_Helmholtz, Test_LameEquation, Test_Poisson
 from test_assemblage import Test_assemblage_2Do1_Contact, Test_assemblage_2Do2_Contact, Test_assemblage_3Do1_Contact, Test_assemblage_3Do2_Contact
-from esys.finley import Rectangle, ReadMesh
+from esys.escript import *
+from esys.escript.linearPDEs import LinearPDE
+from esys.finley import Rectangle, Brick, ReadMesh
+import numpy as np
 
 try:
      FINLEY_TEST_DATA=os.environ['FINLEY_TEST_DATA']
@@ -141,6 +144,107 @@ class Test_AssemblePDEwithFinley_3Do2_Contact_withElementsOnFace(Test_assemblage
    def tearDown(self):
         del self.domain
 
+class Test_CachedElementIntegralsOnFinley(unittest.TestCase):
+   RES_TOL=1.e-12
+   # applies the operator of a PDE with constant coefficients to a test
+   # function with caching of element integrals switched on or off
+   def applyOperator(self, domain, numEqu, cache):
+        dim = domain.getDim()
+        oldCache = getEscriptParamInt("CACHE_ELEMENT_INTEGRALS")
+        setEscriptParamInt("CACHE_ELEMENT_INTEGRALS", cache)
+        try:
+            pde = LinearPDE(domain, numEquations=numEqu)
+            if numEqu == 1:
+                A = np.eye(dim)*1.3 + np.ones((dim,dim))*0.2
+                B = np.arange(1., dim+1.)*0.1
+                C = -np.arange(1., dim+1.)*0.3
+                D = 0.7
+            else:
+                A = np.fromfunction(lambda i,j,k,l: 1.+0.1*i-0.2*j+0.3*k*l, (numEqu,dim,numEqu,dim))
+                B = np.fromfunction(lambda i,j,k: 0.2*i-0.1*j*k, (numEqu,dim,numEqu))
+                C = np.fromfunction(lambda i,j,k: -0.3*i*k+0.1*j, (numEqu,numEqu,dim))
+                D = np.eye(numEqu)*0.7 + np.ones((numEqu,numEqu))*0.1
+            pde.setValue(A=A, B=B, C=C, D=D)
+            x = Solution(domain).getX()
+            if numEqu == 1:
+                u = x[0]*x[dim-1] + sin(x[1])
+            else:
+                u = x*(1.+x[0]) - x[1]**2
+            return pde.getOperator().of(u)
+        finally:
+            setEscriptParamInt("CACHE_ELEMENT_INTEGRALS", oldCache)
+
+   def check(self, domain, numEqu):
+        ref = self.applyOperator(domain, numEqu, 0)
+        cached = self.applyOperator(domain, numEqu, 100)
+        # assembling again uses the tables built by the previous call
+        cached2 = self.applyOperator(domain, numEqu, 100)
+        uncached = self.applyOperator(domain, numEqu, 0)
+        self.assertLess(Lsup(cached-ref), self.RES_TOL*Lsup(ref), "cached integrals give a different operator")
+        self.assertLess(Lsup(cached2-ref), self.RES_TOL*Lsup(ref), "reused integrals give a different operator")
+        self.assertLess(Lsup(uncached-ref), self.RES_TOL*Lsup(ref), "operator changed after caching was switched off")
+
+   def test_Rectangle_order1_single(self):
+        self.check(Rectangle(NE, NE, 1, useElementsOnFace=0), 1)
+
+   def test_Rectangle_order2_system(self):
+        self.check(Rectangle(NE, NE, 2, useElementsOnFace=0), 2)
+
+   def test_Brick_order1_system(self):
+        self.check(Brick(NE//2, NE//2, NE//2, 1, useElementsOnFace=0), 3)
+
+   def test_Brick_order2_single(self):
+        self.check(Brick(NE//2, NE//2, NE//2, 2, useElementsOnFace=0), 1)
+
+   def test_Brick_macro_system(self):
+        self.check(Brick(NE//2, NE//2, NE//2, -1, useElementsOnFace=0), 3)
+
+class Test_BalancedColoringOnFinley(unittest.TestCase):
+   RES_TOL=1.e-12
+   # applies the operator and returns the right hand side of a PDE with
+   # variable coefficients on a mesh which was created with or without
+   # balanced element colouring
+   def assemble(self, makeDomain, numEqu, balanced):
+        oldBalanced = getEscriptParamInt("BALANCED_COLORING")
+        setEscriptParamInt("BALANCED_COLORING", balanced)
+        try:
+            domain = makeDomain()
+        finally:
+            setEscriptParamInt("BALANCED_COLORING", oldBalanced)
+        dim = domain.getDim()
+        x = Function(domain).getX()
+        pde = LinearPDE(domain, numEquations=numEqu)
+        if numEqu == 1:
+            pde.setValue(A=kronecker(dim)*(1.+x[0]), B=0.1*x, C=-x*x[1],
+                         D=1.+x[1]**2, X=x*x[0], Y=sin(x[0]))
+            y = Solution(domain).getX()
+            u = y[0]**2 - y[1]
+        else:
+            pde.setValue(A=identityTensor4(Function(domain))*(1.+x[0]),
+                         D=kronecker(dim)*(1.+x[1]**2), X=kronecker(dim)*x[0],
+                         Y=x)
+            y = Solution(domain).getX()
+            u = y*(1.+y[0]) - y[1]**2
+        return convertToNumpy(pde.getOperator().of(u)), convertToNumpy(pde.getRightHandSide())
+
+   def check(self, makeDomain, numEqu):
+        Au0, rhs0 = self.assemble(makeDomain, numEqu, 0)
+        Au1, rhs1 = self.assemble(makeDomain, numEqu, 1)
+        self.assertLessEqual(np.max(abs(Au1-Au0)), self.RES_TOL*np.max(abs(Au0)), "operators differ")
+        self.assertLessEqual(np.max(abs(rhs1-rhs0)), self.RES_TOL*np.max(abs(rhs0)), "right hand sides differ")
+
+   def test_Rectangle_order1(self):
+        self.check(lambda: Rectangle(NE, NE, 1, useElementsOnFace=0), 1)
+
+   def test_Rectangle_order2_system(self):
+        self.check(lambda: Rectangle(NE, NE, 2, useElementsOnFace=0), 2)
+
+   def test_Brick_order1_system(self):
+        self.check(lambda: Brick(NE//2, NE//2, NE//2, 1, useElementsOnFace=0), 3)
+
+   def test_Brick_order2(self):
+        self.check(lambda: Brick(NE//2, NE//2, NE//2, 2, useElementsOnFace=0), 1)
+
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
 
@@ -27,6 +27,7 @@ __url__="https://launchpad.net/escript-finley"
 Test suite for PDE solvers on finley
 """
 
+import os
 from test_simplesolve import SimpleSolveTestCase
 import esys.escriptcore.utestselect as unittest
 from esys.escriptcore.testing import *
@@ -632,6 +633,42 @@ class Test_SimpleSolveFinleyBrick_Order2_Paso_MINRES_RILU(SimpleSolveOrder2):
     def tearDown(self):
         del self.domain
 
+### halo exchange modes of the paso Couplers
+
+class CouplerModeSolve(SimpleSolveOnPaso):
+    """
+    runs the solver tests with the way values are exchanged between ranks
+    forced through the PASO_COUPLER_MODE environment variable
+    """
+    couplerMode = None
+
+    def setUp(self):
+        self.savedCouplerMode = os.environ.get("PASO_COUPLER_MODE")
+        os.environ["PASO_COUPLER_MODE"] = self.couplerMode
+        self.domain = Brick(NE0, NE1, NE2, 1, optimize=OPTIMIZE)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.PCG
+        self.preconditioner = SolverOptions.JACOBI
+
+    def tearDown(self):
+        del self.domain
+        if self.savedCouplerMode is None:
+            del os.environ["PASO_COUPLER_MODE"]
+        else:
+            os.environ["PASO_COUPLER_MODE"] = self.savedCouplerMode
+
+class Test_SimpleSolveFinleyBrick_Order1_Paso_PCG_Jacobi_CouplerP2P(CouplerModeSolve):
+    couplerMode = "p2p"
+
+class Test_SimpleSolveFinleyBrick_Order1_Paso_PCG_Jacobi_CouplerPersistent(CouplerModeSolve):
+    couplerMode = "persistent"
+
+class Test_SimpleSolveFinleyBrick_Order1_Paso_PCG_Jacobi_CouplerNeighbour(CouplerModeSolve):
+    couplerMode = "neighbour"
+
+class Test_SimpleSolveFinleyBrick_Order1_Paso_PCG_Jacobi_CouplerShared(CouplerModeSolve):
+    couplerMode = "shared"
+
 
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
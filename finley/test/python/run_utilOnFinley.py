@@ -31,8 +31,11 @@ from test_util import Test_util, Test_Util_SpatialFunctions, \
 from test_util_interpolation import Test_Util_Point_Data_Interpolation
 from test_util_NaN_funcs import Test_util_NaN_funcs
 
-from esys.escript import FunctionOnBoundary, getMPISizeWorld, HAVE_SYMBOLS
-from esys.finley import Rectangle, Brick, JoinFaces, ReadMesh
+from esys.escript import FunctionOnBoundary, FunctionOnContactZero, \
+        ContinuousFunction, Scalar, getMPISizeWorld, integrate, sin, \
+        HAVE_SYMBOLS
+from esys.finley import Rectangle, Brick, GlueFaces, JoinFaces, ReadMesh
+import numpy as np
 import os
 
 if HAVE_SYMBOLS:
@@ -337,6 +340,76 @@ class Test_Util_SpatialFunctionsOnFinleyHex3DOrder2useElementsOnFacewithContact(
         del self.order
         del self.domain
 
+class Test_FindMatchingFacesOnFinley(unittest.TestCase):
+    RES_TOL=1.e-8
+    # distorts the mesh by a periodic function which keeps the planes
+    # x0=0, 0.5, 1 and the outer boundary in place. The second mesh is
+    # shifted by a tiny amount below the matching tolerance so the centres
+    # of matching faces are close but not equal.
+    def makeMeshes(self, dim, order):
+        if dim == 2:
+            d1 = Rectangle(n0=NE,n1=NE,l0=0.5,order=order,useElementsOnFace=0)
+            d2 = Rectangle(n0=NE,n1=NE,l0=0.5,order=order,useElementsOnFace=0)
+        else:
+            d1 = Brick(n0=NE,n1=NE,n2=NE,l0=0.5,order=order,useElementsOnFace=0)
+            d2 = Brick(n0=NE,n1=NE,n2=NE,l0=0.5,order=order,useElementsOnFace=0)
+        shift = np.zeros((dim,))
+        shift[0] = 0.5
+        d2.setX(d2.getX()+shift)
+        for d, jitter in ((d1, 0.), (d2, 1.e-13)):
+            x = d.getX()
+            e = np.eye(dim)
+            dx = 0.02*sin(4*np.pi*x[0])*sin(2*np.pi*x[1])*e[0] + jitter*sin(37.*x[1])*e[0]
+            for i in range(1, dim):
+                dx += 0.03*sin(2*np.pi*x[i])*e[i]
+            d.setX(x+dx)
+        return d1, d2
+
+    def checkGlue(self, dim, order):
+        d1, d2 = self.makeMeshes(dim, order)
+        dom = GlueFaces([d1,d2],optimize=False)
+        if dim == 2:
+            ref = Rectangle(n0=2*NE,n1=NE,order=order,useElementsOnFace=0)
+        else:
+            ref = Brick(n0=2*NE,n1=NE,n2=NE,order=order,useElementsOnFace=0)
+        self.assertEqual(ContinuousFunction(dom).getX().getNumberOfDataPoints(),
+                         ContinuousFunction(ref).getX().getNumberOfDataPoints(),
+                         "not all matching nodes were glued")
+        area = integrate(Scalar(1., FunctionOnBoundary(dom)))
+        self.assertLess(abs(area-2*dim), self.RES_TOL, "boundary is wrong")
+
+    def checkJoin(self, dim, order):
+        d1, d2 = self.makeMeshes(dim, order)
+        dom = JoinFaces([d1,d2],optimize=False)
+        area = integrate(Scalar(1., FunctionOnContactZero(dom)))
+        self.assertLess(abs(area-1.), self.RES_TOL, "contact area is wrong")
+        area = integrate(Scalar(1., FunctionOnBoundary(dom)))
+        self.assertLess(abs(area-2*dim), self.RES_TOL, "boundary is wrong")
+
+    @unittest.skipIf(getMPISizeWorld() > 1, FINLEY_MERGE_ERROR)
+    def test_glue_2D_order1(self):
+        self.checkGlue(2, 1)
+
+    @unittest.skipIf(getMPISizeWorld() > 1, FINLEY_MERGE_ERROR)
+    def test_glue_2D_order2(self):
+        self.checkGlue(2, 2)
+
+    @unittest.skipIf(getMPISizeWorld() > 1, FINLEY_MERGE_ERROR)
+    def test_glue_3D_order1(self):
+        self.checkGlue(3, 1)
+
+    @unittest.skipIf(getMPISizeWorld() > 1, FINLEY_MERGE_ERROR)
+    def test_glue_3D_order2(self):
+        self.checkGlue(3, 2)
+
+    @unittest.skipIf(getMPISizeWorld() > 1, FINLEY_MERGE_ERROR)
+    def test_join_2D_order1(self):
+        self.checkJoin(2, 1)
+
+    @unittest.skipIf(getMPISizeWorld() > 1, FINLEY_MERGE_ERROR)
+    def test_join_3D_order2(self):
+        self.checkJoin(3, 2)
+
 class Test_2D_Point_Data_Integration(Test_Util_Point_Data_Interpolation):
     def setUp(self):
         Stations = [ (0.,0.), (1.,0), (0,1), (1,1) ]
@@ -17,10 +17,175 @@
 
 #include "Coupler.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring> // memcpy
 
 namespace paso {
 
+namespace {
+
+bool defaultModeSet = false;
+CouplerMode defaultMode = COUPLER_P2P;
+
+} // anonymous namespace
+
+#ifdef ESYS_MPI
+/// the shared memory windows of the ranks on one node. They are cached on
+/// the communicator of the Couplers and handed out to COUPLER_SHARED
+/// Couplers since creating a window is collective and expensive.
+struct NodeWindows
+{
+    struct Slot
+    {
+        MPI_Win win;
+        char* base;
+        size_t size;
+        bool inUse;
+    };
+
+    explicit NodeWindows(MPI_Comm parent)
+    {
+        MPI_Comm_split_type(parent, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL,
+                            &comm);
+    }
+
+    ~NodeWindows()
+    {
+        for (size_t i=0; i < slots.size(); ++i) {
+            if (slots[i].win != MPI_WIN_NULL)
+                MPI_Win_free(&slots[i].win);
+        }
+        MPI_Comm_free(&comm);
+    }
+
+    /// returns the index of a window in which this rank owns at least
+    /// `size` bytes and which no other Coupler on this node is using.
+    /// Collective over comm.
+    int acquire(size_t size)
+    {
+        // 2: free and large enough, 1: free, 0: in use, on all ranks
+        std::vector<int> state(slots.size());
+        for (size_t i=0; i < slots.size(); ++i) {
+            if (slots[i].inUse)
+                state[i] = 0;
+            else if (slots[i].win != MPI_WIN_NULL && slots[i].size >= size)
+                state[i] = 2;
+            else
+                state[i] = 1;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, state.data(), state.size(), MPI_INT,
+                      MPI_MIN, comm);
+        int slot = -1;
+        for (size_t i=0; i < slots.size() && slot < 0; ++i) {
+            if (state[i] == 2)
+                slot = i;
+        }
+        if (slot < 0) {
+            // windows that are too small for somebody are replaced rather
+            // than kept around. The state is the same on all ranks.
+            for (size_t i=0; i < slots.size(); ++i) {
+                if (state[i] == 1) {
+                    if (slots[i].win != MPI_WIN_NULL)
+                        MPI_Win_free(&slots[i].win);
+                    slots[i].base = NULL;
+                    slots[i].size = 0;
+                    if (slot < 0)
+                        slot = i;
+                }
+            }
+            if (slot < 0) {
+                slot = slots.size();
+                slots.push_back(Slot());
+            }
+            Slot& s = slots[slot];
+            MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, comm, &s.base,
+                                    &s.win);
+            s.size = size;
+        }
+        slots[slot].inUse = true;
+        return slot;
+    }
+
+    /// returns window `slot` to the pool
+    inline void release(int slot) { slots[slot].inUse = false; }
+
+    MPI_Comm comm;
+    std::vector<Slot> slots;
+};
+
+namespace {
+
+int nodeWindowsKey = MPI_KEYVAL_INVALID;
+int finalizeKey = MPI_KEYVAL_INVALID;
+// communicators with cached windows
+std::vector<MPI_Comm> cachedComms;
+
+int deleteNodeWindows(MPI_Comm comm, int, void* value, void*)
+{
+    delete static_cast<NodeWindows*>(value);
+    cachedComms.erase(std::remove(cachedComms.begin(), cachedComms.end(),
+                                  comm), cachedComms.end());
+    return MPI_SUCCESS;
+}
+
+// MPI_Finalize deletes the attributes of MPI_COMM_SELF first so windows
+// cached on communicators which are never freed (like MPI_COMM_WORLD) are
+// released while MPI is still fully functional
+int deleteAllNodeWindows(MPI_Comm, int, void*, void*)
+{
+    while (!cachedComms.empty())
+        MPI_Comm_delete_attr(cachedComms.back(), nodeWindowsKey);
+    return MPI_SUCCESS;
+}
+
+/// returns the windows of the node cached on comm, they are created by the
+/// first call for comm which is collective and freed with comm
+NodeWindows* getNodeWindows(MPI_Comm comm)
+{
+    if (nodeWindowsKey == MPI_KEYVAL_INVALID) {
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, deleteNodeWindows,
+                               &nodeWindowsKey, NULL);
+        MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, deleteAllNodeWindows,
+                               &finalizeKey, NULL);
+        MPI_Comm_set_attr(MPI_COMM_SELF, finalizeKey, NULL);
+    }
+    NodeWindows* windows = NULL;
+    int found = 0;
+    MPI_Comm_get_attr(comm, nodeWindowsKey, &windows, &found);
+    if (!found) {
+        windows = new NodeWindows(comm);
+        MPI_Comm_set_attr(comm, nodeWindowsKey, windows);
+        cachedComms.push_back(comm);
+    }
+    return windows;
+}
+
+} // anonymous namespace
+#endif
+
+CouplerMode getDefaultCouplerMode()
+{
+    if (defaultModeSet)
+        return defaultMode;
+    const char* env = getenv("PASO_COUPLER_MODE");
+    if (env != NULL) {
+        if (!strcmp(env, "persistent"))
+            return COUPLER_PERSISTENT;
+        else if (!strcmp(env, "neighbour"))
+            return COUPLER_NEIGHBOUR;
+        else if (!strcmp(env, "shared"))
+            return COUPLER_SHARED;
+    }
+    return COUPLER_P2P;
+}
+
+void setDefaultCouplerMode(CouplerMode mode)
+{
+    defaultMode = mode;
+    defaultModeSet = true;
+}
+
 /****************************************************************************
  *
  * allocates a Coupler
@@ -33,22 +198,43 @@ Coupler<Scalar>::Coupler(const_Connector_ptr conn, dim_t blockSize,
     connector(conn),
     block_size(blockSize),
     in_use(false),
+    mode(getDefaultCouplerMode()),
     data(NULL),
     send_buffer(NULL),
     recv_buffer(NULL),
     mpi_requests(NULL),
     mpi_stati(NULL),
-    mpi_info(mpiInfo)
+    mpi_info(mpiInfo),
+    coupler_comm(MPI_COMM_NULL),
+    node_windows(NULL),
+    node_slot(-1),
+    node_exposed(false)
 {
 #ifdef ESYS_MPI
+    node_win = MPI_WIN_NULL;
+    node_readers = node_sources = MPI_GROUP_NULL;
+    for (dim_t i=0; i < conn->recv->neighbour.size(); ++i)
+        remote_recv.push_back(i);
+    for (dim_t i=0; i < conn->send->neighbour.size(); ++i)
+        remote_send.push_back(i);
     mpi_requests = new MPI_Request[conn->send->neighbour.size() +
-                                   conn->recv->neighbour.size()];
+                                   conn->recv->neighbour.size() + 1];
     mpi_stati = new MPI_Status[conn->send->neighbour.size() +
-                               conn->recv->neighbour.size()];
+                               conn->recv->neighbour.size() + 1];
     if (mpi_info->size > 1) {
         send_buffer = new Scalar[conn->send->numSharedComponents * block_size];
         recv_buffer = new Scalar[conn->recv->numSharedComponents * block_size];
+        if (mode == COUPLER_PERSISTENT)
+            setupPersistent();
+        else if (mode == COUPLER_NEIGHBOUR)
+            setupNeighbour();
+        else if (mode == COUPLER_SHARED)
+            setupShared();
+    } else {
+        mode = COUPLER_P2P;
     }
+#else
+    mode = COUPLER_P2P;
 #endif
 }
 
@@ -56,6 +242,32 @@ template<typename Scalar>
 Coupler<Scalar>::~Coupler()
 {
 #ifdef ESYS_MPI
+    int mpiFinalized = 0;
+    MPI_Finalized(&mpiFinalized);
+    if (!mpiFinalized) {
+        if (mode == COUPLER_PERSISTENT) {
+            const dim_t numRequests = connector->recv->neighbour.size() +
+                                      connector->send->neighbour.size();
+            for (dim_t i=0; i < numRequests; ++i)
+                MPI_Request_free(&mpi_requests[i]);
+        }
+        if (coupler_comm != MPI_COMM_NULL)
+            MPI_Comm_free(&coupler_comm);
+        if (node_windows != NULL) {
+            // readers must be done with our values before the window goes
+            // back to the pool
+            if (node_exposed)
+                MPI_Win_wait(node_win);
+            if (node_readers != MPI_GROUP_NULL)
+                MPI_Group_free(&node_readers);
+            if (node_sources != MPI_GROUP_NULL)
+                MPI_Group_free(&node_sources);
+            node_windows->release(node_slot);
+        }
+    }
+    // the send buffer belongs to the window
+    if (node_windows != NULL)
+        send_buffer = NULL;
     delete[] send_buffer;
     delete[] recv_buffer;
     delete[] mpi_requests;
@@ -63,6 +275,139 @@ Coupler<Scalar>::~Coupler()
 #endif
 }
 
+/// creates the send and receive requests once on a private duplicate of
+/// the communicator so they cannot match messages of other Couplers
+template<typename Scalar>
+void Coupler<Scalar>::setupPersistent()
+{
+#ifdef ESYS_MPI
+    MPI_Comm_dup(mpi_info->comm, &coupler_comm);
+    MPI_Datatype mpiType = (sizeof(Scalar) == sizeof(double) ? MPI_DOUBLE : MPI_DOUBLE_COMPLEX);
+    const dim_t numRecv = connector->recv->neighbour.size();
+    for (dim_t i=0; i < numRecv; ++i) {
+        MPI_Recv_init(&recv_buffer[connector->recv->offsetInShared[i]*block_size],
+                (connector->recv->offsetInShared[i+1]-connector->recv->offsetInShared[i])*block_size,
+                mpiType, connector->recv->neighbour[i], 0,
+                coupler_comm, &mpi_requests[i]);
+    }
+    for (dim_t i=0; i < connector->send->neighbour.size(); ++i) {
+        MPI_Send_init(&send_buffer[connector->send->offsetInShared[i]*block_size],
+                (connector->send->offsetInShared[i+1] - connector->send->offsetInShared[i])*block_size,
+                mpiType, connector->send->neighbour[i], 0,
+                coupler_comm, &mpi_requests[i+numRecv]);
+    }
+#endif
+}
+
+/// creates the graph communicator from the neighbour lists of the Connector
+/// and computes the counts and displacements for the neighbourhood collective
+template<typename Scalar>
+void Coupler<Scalar>::setupNeighbour()
+{
+#ifdef ESYS_MPI
+    const dim_t numSend = connector->send->neighbour.size();
+    const dim_t numRecv = connector->recv->neighbour.size();
+    send_counts.resize(numSend);
+    send_displs.resize(numSend);
+    recv_counts.resize(numRecv);
+    recv_displs.resize(numRecv);
+    for (dim_t i=0; i < numSend; ++i) {
+        send_displs[i] = connector->send->offsetInShared[i]*block_size;
+        send_counts[i] = connector->send->offsetInShared[i+1]*block_size - send_displs[i];
+    }
+    for (dim_t i=0; i < numRecv; ++i) {
+        recv_displs[i] = connector->recv->offsetInShared[i]*block_size;
+        recv_counts[i] = connector->recv->offsetInShared[i+1]*block_size - recv_displs[i];
+    }
+    MPI_Dist_graph_create_adjacent(mpi_info->comm,
+            numRecv, connector->recv->neighbour.data(), MPI_UNWEIGHTED,
+            numSend, connector->send->neighbour.data(), MPI_UNWEIGHTED,
+            MPI_INFO_NULL, 0, &coupler_comm);
+#endif
+}
+
+/// takes a shared memory window of the ranks on this node from the pool
+/// which replaces the send buffer. Neighbours on this node find out where
+/// their values are in our send buffer.
+template<typename Scalar>
+void Coupler<Scalar>::setupShared()
+{
+#ifdef ESYS_MPI
+    node_windows = getNodeWindows(mpi_info->comm);
+    const MPI_Comm nodeComm = node_windows->comm;
+    // ranks of the neighbours in nodeComm, MPI_UNDEFINED if on another node
+    const dim_t numRecv = connector->recv->neighbour.size();
+    const dim_t numSend = connector->send->neighbour.size();
+    std::vector<int> recvNode(numRecv), sendNode(numSend);
+    MPI_Group group, nodeGroup;
+    MPI_Comm_group(mpi_info->comm, &group);
+    MPI_Comm_group(nodeComm, &nodeGroup);
+    MPI_Group_translate_ranks(group, numRecv, connector->recv->neighbour.data(),
+                              nodeGroup, recvNode.data());
+    MPI_Group_translate_ranks(group, numSend, connector->send->neighbour.data(),
+                              nodeGroup, sendNode.data());
+    MPI_Group_free(&group);
+
+    const size_t numValues = connector->send->numSharedComponents*block_size;
+    node_slot = node_windows->acquire(numValues*sizeof(Scalar));
+    node_win = node_windows->slots[node_slot].win;
+    delete[] send_buffer;
+    send_buffer = reinterpret_cast<Scalar*>(node_windows->slots[node_slot].base);
+
+    // exchange the offsets into the send buffers with neighbours on this node
+    std::vector<long> recvOffset(numRecv), sendOffset(numSend);
+    std::vector<int> readers, sources;
+    std::vector<MPI_Request> reqs;
+    reqs.reserve(numRecv+numSend);
+    remote_recv.clear();
+    remote_send.clear();
+    for (dim_t i=0; i < numRecv; ++i) {
+        if (recvNode[i] == MPI_UNDEFINED) {
+            remote_recv.push_back(i);
+        } else {
+            local_recv.push_back(i);
+            sources.push_back(recvNode[i]);
+            reqs.push_back(MPI_REQUEST_NULL);
+            MPI_Irecv(&recvOffset[i], 1, MPI_LONG, recvNode[i], 0, nodeComm,
+                      &reqs.back());
+        }
+    }
+    for (dim_t i=0; i < numSend; ++i) {
+        if (sendNode[i] == MPI_UNDEFINED) {
+            remote_send.push_back(i);
+        } else {
+            readers.push_back(sendNode[i]);
+            sendOffset[i] = connector->send->offsetInShared[i]*block_size;
+            reqs.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(&sendOffset[i], 1, MPI_LONG, sendNode[i], 0, nodeComm,
+                      &reqs.back());
+        }
+    }
+    MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+
+    for (size_t k=0; k < local_recv.size(); ++k) {
+        const dim_t i = local_recv[k];
+        MPI_Aint size;
+        int dispUnit;
+        char* ptr;
+        MPI_Win_shared_query(node_win, recvNode[i], &size, &dispUnit, &ptr);
+        local_recv_src.push_back(reinterpret_cast<const Scalar*>(ptr)
+                                 + recvOffset[i]);
+    }
+    // groups for the exposure (post/wait) and access (start/complete) epochs
+    // which replace messages to neighbours on this node
+    if (!readers.empty()) {
+        MPI_Group_incl(nodeGroup, readers.size(), readers.data(),
+                       &node_readers);
+    }
+    if (!sources.empty()) {
+        MPI_Group_incl(nodeGroup, sources.size(), sources.data(),
+                       &node_sources);
+    }
+    MPI_Group_free(&nodeGroup);
+#endif
+}
+
 template<typename Scalar>
 void Coupler<Scalar>::startCollect(const Scalar* in)
 {
@@ -73,13 +418,27 @@ void Coupler<Scalar>::startCollect(const Scalar* in)
             throw PasoException("Coupler::startCollect: Coupler in use.");
         }
         MPI_Datatype mpiType = (sizeof(Scalar) == sizeof(double) ? MPI_DOUBLE : MPI_DOUBLE_COMPLEX);
+        const dim_t numRecv = connector->recv->neighbour.size();
+        const dim_t numSend = connector->send->neighbour.size();
         // start receiving input
-        for (dim_t i=0; i < connector->recv->neighbour.size(); ++i) {
-            MPI_Irecv(&recv_buffer[connector->recv->offsetInShared[i]*block_size],
-                    (connector->recv->offsetInShared[i+1]-connector->recv->offsetInShared[i])*block_size,
-                    mpiType, connector->recv->neighbour[i],
-                    mpi_info->counter()+connector->recv->neighbour[i],
-                    mpi_info->comm, &mpi_requests[i]);
+        if (mode == COUPLER_PERSISTENT) {
+            if (numRecv > 0)
+                MPI_Startall(numRecv, mpi_requests);
+        } else if (mode != COUPLER_NEIGHBOUR) {
+            for (size_t k=0; k < remote_recv.size(); ++k) {
+                const dim_t i = remote_recv[k];
+                MPI_Irecv(&recv_buffer[connector->recv->offsetInShared[i]*block_size],
+                        (connector->recv->offsetInShared[i+1]-connector->recv->offsetInShared[i])*block_size,
+                        mpiType, connector->recv->neighbour[i],
+                        mpi_info->counter()+connector->recv->neighbour[i],
+                        mpi_info->comm, &mpi_requests[k]);
+            }
+        }
+        if (node_exposed) {
+            // neighbours on this node must have read the previous values
+            // before they are overwritten
+            MPI_Win_wait(node_win);
+            node_exposed = false;
         }
         // collect values into buffer
         const int numSharedSend = connector->send->numSharedComponents;
@@ -98,14 +457,31 @@ void Coupler<Scalar>::startCollect(const Scalar* in)
             }
         }
         // send buffer out
-        for (dim_t i=0; i < connector->send->neighbour.size(); ++i) {
-            MPI_Issend(&send_buffer[connector->send->offsetInShared[i]*block_size],
-                    (connector->send->offsetInShared[i+1] - connector->send->offsetInShared[i])*block_size,
-                    mpiType, connector->send->neighbour[i],
-                    mpi_info->counter()+mpi_info->rank, mpi_info->comm,
-                    &mpi_requests[i+connector->recv->neighbour.size()]);
-        }
-        mpi_info->incCounter(mpi_info->size);
+        if (mode == COUPLER_PERSISTENT) {
+            if (numSend > 0)
+                MPI_Startall(numSend, &mpi_requests[numRecv]);
+        } else if (mode == COUPLER_NEIGHBOUR) {
+            MPI_Ineighbor_alltoallv(send_buffer, send_counts.data(),
+                    send_displs.data(), mpiType, recv_buffer,
+                    recv_counts.data(), recv_displs.data(), mpiType,
+                    coupler_comm, mpi_requests);
+        } else {
+            if (node_readers != MPI_GROUP_NULL) {
+                // expose the new values to neighbours on this node
+                MPI_Win_post(node_readers, MPI_MODE_NOPUT, node_win);
+                node_exposed = true;
+            }
+            const size_t numRemoteRecv = remote_recv.size();
+            for (size_t k=0; k < remote_send.size(); ++k) {
+                const dim_t i = remote_send[k];
+                MPI_Issend(&send_buffer[connector->send->offsetInShared[i]*block_size],
+                        (connector->send->offsetInShared[i+1] - connector->send->offsetInShared[i])*block_size,
+                        mpiType, connector->send->neighbour[i],
+                        mpi_info->counter()+mpi_info->rank, mpi_info->comm,
+                        &mpi_requests[numRemoteRecv+k]);
+            }
+            mpi_info->incCounter(mpi_info->size);
+        }
         in_use = true;
     }
 #endif
@@ -120,8 +496,28 @@ Scalar* Coupler<Scalar>::finishCollect()
             throw PasoException("Coupler::finishCollect: Communication has not been initiated.");
         }
         // wait for receive
-        MPI_Waitall(connector->recv->neighbour.size() +
-                    connector->send->neighbour.size(), mpi_requests, mpi_stati);
+        if (mode == COUPLER_NEIGHBOUR) {
+            MPI_Wait(mpi_requests, mpi_stati);
+        } else if (mode == COUPLER_PERSISTENT) {
+            MPI_Waitall(connector->recv->neighbour.size() +
+                        connector->send->neighbour.size(), mpi_requests, mpi_stati);
+        } else {
+            const int numRequests = remote_recv.size() + remote_send.size();
+            if (node_sources != MPI_GROUP_NULL) {
+                // the access epoch starts once all neighbours on this node
+                // have exposed their values
+                MPI_Win_start(node_sources, 0, node_win);
+                for (size_t k=0; k < local_recv.size(); ++k) {
+                    const dim_t i = local_recv[k];
+                    const index_t first = connector->recv->offsetInShared[i]*block_size;
+                    const index_t last = connector->recv->offsetInShared[i+1]*block_size;
+                    memcpy(&recv_buffer[first], local_recv_src[k],
+                           (last-first)*sizeof(Scalar));
+                }
+                MPI_Win_complete(node_win);
+            }
+            MPI_Waitall(numRequests, mpi_requests, mpi_stati);
+        }
         in_use = false;
     }
 #endif
@@ -39,6 +39,33 @@ struct Connector;
 typedef boost::shared_ptr<Connector> Connector_ptr;
 typedef boost::shared_ptr<const Connector> const_Connector_ptr;
 
+/// how a Coupler exchanges values with its neighbours
+enum CouplerMode {
+    /// MPI_Irecv/MPI_Issend are posted for every exchange
+    COUPLER_P2P,
+    /// persistent requests are set up once and restarted for every exchange
+    COUPLER_PERSISTENT,
+    /// MPI-3 neighbourhood collective on a graph communicator built from
+    /// the Connector
+    COUPLER_NEIGHBOUR,
+    /// neighbours on the same node read values directly from each other's
+    /// send buffers in an MPI shared memory window, other neighbours use
+    /// COUPLER_P2P
+    COUPLER_SHARED
+};
+
+/// returns the mode used by new Couplers. Unless set by
+/// setDefaultCouplerMode() it is taken from the PASO_COUPLER_MODE
+/// environment variable ("p2p", "persistent", "neighbour" or "shared") at
+/// the time of the call and defaults to COUPLER_P2P.
+PASO_DLL_API
+CouplerMode getDefaultCouplerMode();
+
+/// sets the mode used by Couplers created from now on
+PASO_DLL_API
+void setDefaultCouplerMode(CouplerMode mode);
+
+struct NodeWindows;
 template<typename Scalar> struct Coupler;
 template<typename T> using Coupler_ptr = boost::shared_ptr<Coupler<T> >;
 template<typename T> using const_Coupler_ptr = boost::shared_ptr<const Coupler<T> >;
@@ -99,6 +126,8 @@ struct Connector
 template<typename Scalar>
 struct Coupler
 {
+    /// except for COUPLER_P2P the constructor is collective over the
+    /// communicator of mpiInfo
     Coupler(const_Connector_ptr, dim_t blockSize, escript::JMPI mpiInfo);
     ~Coupler();
 
@@ -140,6 +169,7 @@ struct Coupler
     const_Connector_ptr connector;
     dim_t block_size;
     bool in_use;
+    CouplerMode mode;
 
     // unmanaged pointer to data to be sent
     Scalar* data;
@@ -148,6 +178,35 @@ struct Coupler
     MPI_Request* mpi_requests;
     MPI_Status* mpi_stati;
     escript::JMPI mpi_info;
+
+private:
+    void setupPersistent();
+    void setupNeighbour();
+    void setupShared();
+
+    // communicator private to this Coupler, a duplicate of mpi_info->comm
+    // for COUPLER_PERSISTENT and a graph communicator for COUPLER_NEIGHBOUR
+    MPI_Comm coupler_comm;
+    std::vector<int> send_counts, send_displs;
+    std::vector<int> recv_counts, recv_displs;
+
+    // COUPLER_SHARED: the send buffer lives in a shared memory window of
+    // the ranks on this node, taken from the pool cached on mpi_info->comm
+    NodeWindows* node_windows;
+    int node_slot;
+#ifdef ESYS_MPI
+    MPI_Win node_win;
+    // ranks on this node reading from our window and the ones we read from
+    MPI_Group node_readers, node_sources;
+#endif
+    // true while the values of the last exchange are exposed to node_readers
+    bool node_exposed;
+    // neighbours on other nodes (indices into the neighbour lists)
+    std::vector<dim_t> remote_recv, remote_send;
+    // neighbours on this node we receive from and the start of our values
+    // in their send buffers
+    std::vector<dim_t> local_recv;
+    std::vector<const Scalar*> local_recv_src;
 };
 
 
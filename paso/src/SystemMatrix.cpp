@@ -49,6 +49,9 @@ SystemMatrix::SystemMatrix()
 /// If patternIsUnrolled and type & MATRIX_FORMAT_BLK1, it is assumed
 /// that the pattern is already unrolled to match the requested block size
 /// and offsets. Otherwise unrolling and offset adjustment will be performed.
+/// If type & MATRIX_FORMAT_COMPLEX the block sizes refer to complex
+/// components and the values are stored with twice the block size (real
+/// equivalent form) so all real kernels, solvers and preconditioners apply.
 SystemMatrix::SystemMatrix(SystemMatrixType ntype,
                            SystemMatrixPattern_ptr npattern, dim_t rowBlockSize,
                            dim_t colBlockSize, bool patternIsUnrolled,
@@ -64,6 +67,10 @@ SystemMatrix::SystemMatrix(SystemMatrixType ntype,
     solver_package(PASO_PASO),
     solver_p(NULL)
 {
+    if (ntype & MATRIX_FORMAT_COMPLEX) {
+        rowBlockSize *= 2;
+        colBlockSize *= 2;
+    }
     if (patternIsUnrolled) {
         if ((ntype & MATRIX_FORMAT_OFFSET1) != (npattern->type & MATRIX_FORMAT_OFFSET1)) {
             throw PasoException("SystemMatrix: requested offset and pattern offset do not match.");
@@ -266,6 +273,23 @@ void SystemMatrix::nullifyRowsAndCols(escript::Data& row_q,
     double* mask_row = row_q.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();
     double* mask_col = col_q.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();
 
+    // a complex matrix has two real rows/columns per mask entry
+    std::vector<double> complex_mask_row, complex_mask_col;
+    if (isComplex()) {
+        const dim_t numRows = row_q.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).size();
+        const dim_t numCols = col_q.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).size();
+        complex_mask_row.resize(2*numRows);
+        complex_mask_col.resize(2*numCols);
+#pragma omp parallel for
+        for (index_t i = 0; i < numRows; i++)
+            complex_mask_row[2*i] = complex_mask_row[2*i+1] = mask_row[i];
+#pragma omp parallel for
+        for (index_t i = 0; i < numCols; i++)
+            complex_mask_col[2*i] = complex_mask_col[2*i+1] = mask_col[i];
+        mask_row = &complex_mask_row[0];
+        mask_col = &complex_mask_col[0];
+    }
+
     if (mpi_info->size > 1) {
         if (type & MATRIX_FORMAT_CSC) {
             throw PasoException("SystemMatrix::nullifyRowsAndCols: "
@@ -314,7 +338,7 @@ void SystemMatrix::resetValues(bool preserveSolverData)
 void SystemMatrix::setToSolution(escript::Data& out, escript::Data& in,
                                  boost::python::object& options) const
 {
-    if (in.isComplex() || out.isComplex())
+    if ((in.isComplex() || out.isComplex()) && !isComplex())
     {
         throw PasoException("SystemMatrix::setToSolution: complex arguments not supported.");
     }
@@ -329,19 +353,34 @@ void SystemMatrix::setToSolution(escript::Data& out, escript::Data& in,
     } else if (in.getFunctionSpace() != getRowFunctionSpace()) {
         throw PasoException("solve: row function space and function space of right hand side don't match.");
     }
-    out.expand();
-    in.expand();
-    out.requireWrite();
-    in.requireWrite();
-    double* out_dp = out.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();        
-    double* in_dp = in.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();                
-    solve(out_dp, in_dp, &paso_options);
+    if (isComplex()) {
+        // complex values are stored as (re,im) pairs which is exactly the
+        // layout of the real equivalent vectors
+        escript::Data rhs(in);
+        rhs.complicate();
+        out.complicate();
+        out.expand();
+        rhs.expand();
+        out.requireWrite();
+        rhs.requireWrite();
+        double* out_dp = reinterpret_cast<double*>(out.getExpandedVectorReference(static_cast<escript::DataTypes::cplx_t>(0)).data());
+        double* in_dp = reinterpret_cast<double*>(rhs.getExpandedVectorReference(static_cast<escript::DataTypes::cplx_t>(0)).data());
+        solve(out_dp, in_dp, &paso_options);
+    } else {
+        out.expand();
+        in.expand();
+        out.requireWrite();
+        in.requireWrite();
+        double* out_dp = out.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();        
+        double* in_dp = in.getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();                
+        solve(out_dp, in_dp, &paso_options);
+    }
     paso_options.updateEscriptDiagnostics(options);
 }
 
 void SystemMatrix::ypAx(escript::Data& y, escript::Data& x) const 
 {
-    if (x.isComplex() || y.isComplex())
+    if ((x.isComplex() || y.isComplex()) && !isComplex())
     {
         throw PasoException("SystemMatrix::ypAx: complex arguments not supported.");
     }  
@@ -354,6 +393,19 @@ void SystemMatrix::ypAx(escript::Data& y, escript::Data& x) const
     } else if (y.getFunctionSpace() != getRowFunctionSpace()) {
         throw PasoException("matrix vector product: row function space and function space of output don't match.");
     }
+    if (isComplex()) {
+        escript::Data xc(x);
+        xc.complicate();
+        y.complicate();
+        xc.expand();
+        y.expand();
+        xc.requireWrite();
+        y.requireWrite();
+        double* x_dp = reinterpret_cast<double*>(xc.getExpandedVectorReference(static_cast<escript::DataTypes::cplx_t>(0)).data());
+        double* y_dp = reinterpret_cast<double*>(y.getExpandedVectorReference(static_cast<escript::DataTypes::cplx_t>(0)).data());
+        MatrixVector(1., x_dp, 1., y_dp);
+        return;
+    }
     x.expand();
     y.expand();
     x.requireWrite();
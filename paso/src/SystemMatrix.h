@@ -182,6 +182,13 @@ public:
         return row_coupler->finishCollect();
     }
 
+    /// returns true if this matrix holds complex values in real equivalent
+    /// form (see MATRIX_FORMAT_COMPLEX)
+    inline bool isComplex() const
+    {
+        return (type & MATRIX_FORMAT_COMPLEX);
+    }
+
     inline dim_t getNumRows() const
     {
         return mainBlock->numRows;
@@ -55,6 +55,7 @@
 #include <boost/math/special_functions/fpclassify.hpp>	// for isnan
 #include <boost/scoped_array.hpp>
 
+#include <algorithm>
 #include <iomanip>
 #include <limits>
 
@@ -365,14 +366,12 @@ void Brick::readNcGrid(escript::Data& out, string filename, string varname,
     }
 
     // check if this rank contributes anything
-    if (params.first[0] >= m_offset[0]+myN0 ||
+    const bool contributes = !(params.first[0] >= m_offset[0]+myN0 ||
             params.first[0]+params.numValues[0]*params.multiplier[0] <= m_offset[0] ||
             params.first[1] >= m_offset[1]+myN1 ||
             params.first[1]+params.numValues[1]*params.multiplier[1] <= m_offset[1] ||
             params.first[2] >= m_offset[2]+myN2 ||
-            params.first[2]+params.numValues[2]*params.multiplier[2] <= m_offset[2]) {
-        return;
-    }
+            params.first[2]+params.numValues[2]*params.multiplier[2] <= m_offset[2]);
 
     // now determine how much this rank has to write
 
@@ -384,17 +383,20 @@ void Brick::readNcGrid(escript::Data& out, string filename, string varname,
     dim_t idx0 = max(dim_t(0), m_offset[0]-params.first[0]);
     dim_t idx1 = max(dim_t(0), m_offset[1]-params.first[1]);
     dim_t idx2 = max(dim_t(0), m_offset[2]-params.first[2]);
-    // number of values to read
-    const dim_t num0 = min(params.numValues[0]-idx0, myN0-first0);
-    const dim_t num1 = min(params.numValues[1]-idx1, myN1-first1);
-    const dim_t num2 = min(params.numValues[2]-idx2, myN2-first2);
+    // number of values to read, ranks without data still take part in the
+    // (collective) read
+    const dim_t num0 = (contributes ? min(params.numValues[0]-idx0, myN0-first0) : 0);
+    const dim_t num1 = (contributes ? min(params.numValues[1]-idx1, myN1-first1) : 0);
+    const dim_t num2 = (contributes ? min(params.numValues[2]-idx2, myN2-first2) : 0);
 
     // make sure we read the right block if going backwards through file
-    if (params.reverse[0])
+    if (!contributes)
+        idx0 = idx1 = idx2 = 0;
+    else if (params.reverse[0])
         idx0 = edges[dims-1]-num0-idx0;
-    if (dims>1 && params.reverse[1])
+    if (contributes && dims>1 && params.reverse[1])
         idx1 = edges[dims-2]-num1-idx1;
-    if (dims>2 && params.reverse[2])
+    if (contributes && dims>2 && params.reverse[2])
         idx2 = edges[dims-3]-num2-idx2;
 
 
@@ -402,28 +404,32 @@ void Brick::readNcGrid(escript::Data& out, string filename, string varname,
     vector<size_t> startindex;
     vector<size_t> counts;
     if (dims==3) {
-        //var->set_cur(idx2, idx1, idx0);             // from old API
         startindex.push_back(idx2);
         startindex.push_back(idx1);
         startindex.push_back(idx0);
         counts.push_back(num2);
         counts.push_back(num1);
         counts.push_back(num0);
-        var.getVar(startindex, counts, &values[0]);
     } else if (dims==2) {
-        // var->set_cur(idx1, idx0);                // from old API
         startindex.push_back(idx1);
         startindex.push_back(idx0);
         counts.push_back(num1);
         counts.push_back(num0);
-        var.getVar(startindex, counts, &values[0]);
     } else {
-        //var->set_cur(idx0);
-        //var->get(&values[0], num0);
         startindex.push_back(idx0);
         counts.push_back(num0);
-        var.getVar(startindex, counts, &values[0]);
     }
+    // read all hyperslabs with one collective call if the netCDF library
+    // supports parallel access, otherwise every rank reads its own
+    if (m_mpiInfo->size == 1 || !escript::readNcHyperslabParallel(
+                m_mpiInfo->comm, filename, varname, startindex, counts,
+                values.data())) {
+        if (contributes)
+            var.getVar(startindex, counts, &values[0]);
+    }
+
+    if (!contributes)
+        return;
 
     const int dpp = out.getNumDataPointsPerSample();
     out.requireWrite();
@@ -629,13 +635,13 @@ void Brick::readBinaryGridFromZipped(escript::Data& out, string filename,
     // supported platforms
     switch (params.dataType) {
         case DATATYPE_INT32:
-            readBinaryGridZippedImpl<int>(out, filename, params);
+            readBinaryGridImpl<int>(out, filename, params, true);
             break;
         case DATATYPE_FLOAT32:
-            readBinaryGridZippedImpl<float>(out, filename, params);
+            readBinaryGridImpl<float>(out, filename, params, true);
             break;
         case DATATYPE_FLOAT64:
-            readBinaryGridZippedImpl<double>(out, filename, params);
+            readBinaryGridImpl<double>(out, filename, params, true);
             break;
         default:
             throw ValueError("readBinaryGridZipped(): invalid or unsupported datatype");
@@ -667,7 +673,8 @@ void Brick::readBinaryGrid(escript::Data& out, string filename,
 
 template<typename ValueType>
 void Brick::readBinaryGridImpl(escript::Data& out, const string& filename,
-                               const ReaderParameters& params) const
+                               const ReaderParameters& params,
+                               bool zipped) const
 {
     // check destination function space
     dim_t myN0, myN1, myN2;
@@ -697,30 +704,26 @@ void Brick::readBinaryGridImpl(escript::Data& out, const string& filename,
     if (params.reverse[0] != 0 || params.reverse[1] != 0)
         throw RipleyException("readBinaryGrid(): reversing only supported in Z-direction currently");
 
-    // check file existence and size
-    std::ifstream f(filename.c_str(), std::ifstream::binary);
-    if (f.fail()) {
+    // check file existence and size. The uncompressed size of a zipped
+    // file is unknown until it has been decompressed so running out of data
+    // is detected while reading in that case
+    const dim_t filesize = getFileSize(m_mpiInfo, filename);
+    if (filesize < 0) {
         throw RipleyException("readBinaryGrid(): cannot open file " + filename);
     }
-    f.seekg(0, std::ios::end);
     const int numComp = out.getDataPointSize();
-    const dim_t filesize = f.tellg();
     const dim_t reqsize = params.numValues[0]*params.numValues[1]*params.numValues[2]*numComp*sizeof(ValueType);
-    if (filesize < reqsize) {
-        f.close();
+    if (!zipped && filesize < reqsize) {
         throw RipleyException("readBinaryGrid(): not enough data in file");
     }
 
     // check if this rank contributes anything
-    if (params.first[0] >= m_offset[0]+myN0 ||
+    const bool contributes = !(params.first[0] >= m_offset[0]+myN0 ||
             params.first[0]+params.numValues[0]*params.multiplier[0] <= m_offset[0] ||
             params.first[1] >= m_offset[1]+myN1 ||
             params.first[1]+params.numValues[1]*params.multiplier[1] <= m_offset[1] ||
             params.first[2] >= m_offset[2]+myN2 ||
-            params.first[2]+params.numValues[2]*params.multiplier[2] <= m_offset[2]) {
-        f.close();
-        return;
-    }
+            params.first[2]+params.numValues[2]*params.multiplier[2] <= m_offset[2]);
 
     // now determine how much this rank has to write
 
@@ -729,8 +732,8 @@ void Brick::readBinaryGridImpl(escript::Data& out, const string& filename,
     const dim_t first1 = max(dim_t(0), params.first[1]-m_offset[1]);
     const dim_t first2 = max(dim_t(0), params.first[2]-m_offset[2]);
     // indices to first value in file (not accounting for reverse yet)
-    dim_t idx0 = max(dim_t(0), (m_offset[0]/params.multiplier[0])-params.first[0]);
-    dim_t idx1 = max(dim_t(0), (m_offset[1]/params.multiplier[1])-params.first[1]);
+    const dim_t idx0 = max(dim_t(0), (m_offset[0]/params.multiplier[0])-params.first[0]);
+    const dim_t idx1 = max(dim_t(0), (m_offset[1]/params.multiplier[1])-params.first[1]);
     dim_t idx2 = max(dim_t(0), (m_offset[2]/params.multiplier[2])-params.first[2]);
     // if restX > 0 the first value in the respective dimension has been
     // written restX times already in a previous rank so this rank only
@@ -739,76 +742,77 @@ void Brick::readBinaryGridImpl(escript::Data& out, const string& filename,
     const dim_t rest1 = m_offset[1]%params.multiplier[1];
     const dim_t rest2 = m_offset[2]%params.multiplier[2];
 
-    // number of values to read
-    const dim_t num0 = min(params.numValues[0]-idx0, myN0-first0);
-    const dim_t num1 = min(params.numValues[1]-idx1, myN1-first1);
-    const dim_t num2 = min(params.numValues[2]-idx2, myN2-first2);
+    // number of values to read, ranks without data still take part in the
+    // (collective) read
+    const dim_t num0 = (contributes ? min(params.numValues[0]-idx0, myN0-first0) : 0);
+    const dim_t num1 = (contributes ? min(params.numValues[1]-idx1, myN1-first1) : 0);
+    const dim_t num2 = (contributes ? min(params.numValues[2]-idx2, myN2-first2) : 0);
 
     // make sure we read the right block if going backwards through file
     if (params.reverse[2])
-        idx2 = params.numValues[2]-idx2-1;
+        idx2 = params.numValues[2]-idx2-num2;
 
-    // helpers for reversing
-    const int z_mult = (params.reverse[2] ? -1 : 1);
+    // the block of this rank is fetched row by row, z-y-x ordering in file
+    const dim_t gridSize[3] = { params.numValues[2], params.numValues[1],
+                                params.numValues[0] };
+    const dim_t blockStart[3] = { idx2, idx1, idx0 };
+    const dim_t blockCount[3] = { num2, num1, num0 };
 
     out.requireWrite();
-    vector<ValueType> values(num0*numComp);
     const int dpp = out.getNumDataPointsPerSample();
 
-    for (dim_t z=0; z<num2; z++) {
+    // expands one row of num0 file values into the Data object. Rows may be
+    // handed over concurrently but never write to the same samples
+    auto expandRow = [&](dim_t row, const char* data) {
+        const dim_t y = row%num1;
+        const dim_t blockZ = row/num1;
+        // helper for reversing
+        const dim_t z = (params.reverse[2] ? num2-1-blockZ : blockZ);
         const dim_t m2limit = (z==0 ? params.multiplier[2]-rest2 : params.multiplier[2]);
         dim_t dataZbase = first2 + z*params.multiplier[2];
         if (z>0)
             dataZbase -= rest2;
-
-        for (dim_t y=0; y<num1; y++) {
-            const dim_t fileofs = numComp*(idx0 +
-                                (idx1+y)*params.numValues[0] +
-                                (idx2+z_mult*z)*params.numValues[0]*params.numValues[1]);
-            f.seekg(fileofs*sizeof(ValueType));
-            f.read((char*)&values[0], num0*numComp*sizeof(ValueType));
-            const dim_t m1limit = (y==0 ? params.multiplier[1]-rest1 : params.multiplier[1]);
-            dim_t dataYbase = first1 + y*params.multiplier[1];
-            if (y>0)
-                dataYbase -= rest1;
-
-            for (dim_t x=0; x<num0; x++) {
-                const dim_t m0limit = (x==0 ? params.multiplier[0]-rest0 : params.multiplier[0]);
-                dim_t dataXbase = first0 + x*params.multiplier[0];
-                if (x>0)
-                    dataXbase -= rest0;
-                // write a block of mult0 x mult1 x mult2 identical values into
-                // Data object
-                for (dim_t m2=0; m2 < m2limit; m2++) {
-                    const dim_t dataZ = dataZbase + m2;
-                    if (dataZ >= myN2)
+        const dim_t m1limit = (y==0 ? params.multiplier[1]-rest1 : params.multiplier[1]);
+        dim_t dataYbase = first1 + y*params.multiplier[1];
+        if (y>0)
+            dataYbase -= rest1;
+
+        for (dim_t x=0; x<num0; x++) {
+            const dim_t m0limit = (x==0 ? params.multiplier[0]-rest0 : params.multiplier[0]);
+            dim_t dataXbase = first0 + x*params.multiplier[0];
+            if (x>0)
+                dataXbase -= rest0;
+            // write a block of mult0 x mult1 x mult2 identical values into
+            // Data object
+            for (dim_t m2=0; m2 < m2limit; m2++) {
+                const dim_t dataZ = dataZbase + m2;
+                if (dataZ >= myN2)
+                    break;
+                for (dim_t m1=0; m1 < m1limit; m1++) {
+                    const dim_t dataY = dataYbase + m1;
+                    if (dataY >= myN1)
                         break;
-                    for (dim_t m1=0; m1 < m1limit; m1++) {
-                        const dim_t dataY = dataYbase + m1;
-                        if (dataY >= myN1)
+                    for (dim_t m0=0; m0 < m0limit; m0++) {
+                        const dim_t dataX = dataXbase + m0;
+                        if (dataX >= myN0)
                             break;
-                        for (dim_t m0=0; m0 < m0limit; m0++) {
-                            const dim_t dataX = dataXbase + m0;
-                            if (dataX >= myN0)
-                                break;
-                            const dim_t dataIndex = dataX + dataY*myN0 + dataZ*myN0*myN1;
-                            double* dest = out.getSampleDataRW(dataIndex);
-                            for (int c=0; c<numComp; c++) {
-                                ValueType val = values[x*numComp+c];
-
-                                if (params.byteOrder != BYTEORDER_NATIVE) {
-                                    char* cval = reinterpret_cast<char*>(&val);
-                                    // this will alter val!!
-                                    if (sizeof(ValueType)>4) {
-                                        byte_swap64(cval);
-                                    } else {
-                                        byte_swap32(cval);
-                                    }
+                        const dim_t dataIndex = dataX + dataY*myN0 + dataZ*myN0*myN1;
+                        double* dest = out.getSampleDataRW(dataIndex);
+                        for (int c=0; c<numComp; c++) {
+                            ValueType val;
+                            memcpy(&val, data+(x*numComp+c)*sizeof(ValueType),
+                                   sizeof(ValueType));
+                            if (params.byteOrder != BYTEORDER_NATIVE) {
+                                char* cval = reinterpret_cast<char*>(&val);
+                                if (sizeof(ValueType)>4) {
+                                    byte_swap64(cval);
+                                } else {
+                                    byte_swap32(cval);
                                 }
-                                if (!bm::isnan(val)) {
-                                    for (int q=0; q<dpp; q++) {
-                                        *dest++ = static_cast<double>(val);
-                                    }
+                            }
+                            if (!bm::isnan(val)) {
+                                for (int q=0; q<dpp; q++) {
+                                    *dest++ = static_cast<double>(val);
                                 }
                             }
                         }
@@ -816,129 +820,18 @@ void Brick::readBinaryGridImpl(escript::Data& out, const string& filename,
                 }
             }
         }
-    }
-
-    f.close();
-}
+    };
 
+    if (zipped) {
 #ifdef ESYS_HAVE_BOOST_IO
-template<typename ValueType>
-void Brick::readBinaryGridZippedImpl(escript::Data& out, const string& filename,
-                               const ReaderParameters& params) const
-{
-    // check destination function space
-    dim_t myN0, myN1, myN2;
-    if (out.getFunctionSpace().getTypeCode() == Nodes) {
-        myN0 = m_NN[0];
-        myN1 = m_NN[1];
-        myN2 = m_NN[2];
-    } else if (out.getFunctionSpace().getTypeCode() == Elements ||
-                out.getFunctionSpace().getTypeCode() == ReducedElements) {
-        myN0 = m_NE[0];
-        myN1 = m_NE[1];
-        myN2 = m_NE[2];
-    } else
-        throw ValueError("readBinaryGridFromZipped(): invalid function space for output data object");
-
-    if (params.first.size() != 3)
-        throw ValueError("readBinaryGridFromZipped(): argument 'first' must have 3 entries");
-
-    if (params.numValues.size() != 3)
-        throw ValueError("readBinaryGridFromZipped(): argument 'numValues' must have 3 entries");
-
-    if (params.multiplier.size() != 3)
-        throw ValueError("readBinaryGridFromZipped(): argument 'multiplier' must have 3 entries");
-    for (size_t i=0; i<params.multiplier.size(); i++)
-        if (params.multiplier[i]<1)
-            throw ValueError("readBinaryGridFromZipped(): all multipliers must be positive");
-
-    // check file existence and size
-    std::ifstream f(filename.c_str(), std::ifstream::binary);
-    if (f.fail()) {
-        throw RipleyException("readBinaryGridFromZipped(): cannot open file " + filename);
-    }
-    f.seekg(0, std::ios::end);
-    const int numComp = out.getDataPointSize();
-    dim_t filesize = f.tellg();
-    f.seekg(0, ios::beg);
-    vector<char> compressed(filesize);
-    f.read((char*)&compressed[0], filesize);
-    f.close();
-    vector<char> decompressed = unzip(compressed);
-    filesize = decompressed.size();
-    const dim_t reqsize = params.numValues[0]*params.numValues[1]*params.numValues[2]*numComp*sizeof(ValueType);
-    if (filesize < reqsize) {
-        throw RipleyException("readBinaryGridFromZipped(): not enough data in file");
-    }
-
-    // check if this rank contributes anything
-    if (params.first[0] >= m_offset[0]+myN0 ||
-            params.first[0]+params.numValues[0]*params.multiplier[0] <= m_offset[0] ||
-            params.first[1] >= m_offset[1]+myN1 ||
-            params.first[1]+params.numValues[1]*params.multiplier[1] <= m_offset[1] ||
-            params.first[2] >= m_offset[2]+myN2 ||
-            params.first[2]+params.numValues[2]*params.multiplier[2] <= m_offset[2]) {
-        return;
-    }
-
-    // now determine how much this rank has to write
-
-    // first coordinates in data object to write to
-    const dim_t first0 = max(dim_t(0), params.first[0]-m_offset[0]);
-    const dim_t first1 = max(dim_t(0), params.first[1]-m_offset[1]);
-    const dim_t first2 = max(dim_t(0), params.first[2]-m_offset[2]);
-    // indices to first value in file
-    const dim_t idx0 = max(dim_t(0), m_offset[0]-params.first[0]);
-    const dim_t idx1 = max(dim_t(0), m_offset[1]-params.first[1]);
-    const dim_t idx2 = max(dim_t(0), m_offset[2]-params.first[2]);
-    // number of values to read
-    const dim_t num0 = min(params.numValues[0]-idx0, myN0-first0);
-    const dim_t num1 = min(params.numValues[1]-idx1, myN1-first1);
-    const dim_t num2 = min(params.numValues[2]-idx2, myN2-first2);
-
-    out.requireWrite();
-    vector<ValueType> values(num0*numComp);
-    const int dpp = out.getNumDataPointsPerSample();
-
-    for (dim_t z=0; z<num2; z++) {
-        for (dim_t y=0; y<num1; y++) {
-            const dim_t fileofs = numComp*(idx0+(idx1+y)*params.numValues[0]
-                             +(idx2+z)*params.numValues[0]*params.numValues[1]);
-            memcpy((char*)&values[0], (char*)&decompressed[fileofs*sizeof(ValueType)], num0*numComp*sizeof(ValueType));
-
-            for (dim_t x=0; x<num0; x++) {
-                const dim_t baseIndex = first0+x*params.multiplier[0]
-                                     +(first1+y*params.multiplier[1])*myN0
-                                     +(first2+z*params.multiplier[2])*myN0*myN1;
-                for (dim_t m2=0; m2<params.multiplier[2]; m2++) {
-                    for (dim_t m1=0; m1<params.multiplier[1]; m1++) {
-                        for (dim_t m0=0; m0<params.multiplier[0]; m0++) {
-                            const dim_t dataIndex = baseIndex+m0
-                                           +m1*myN0
-                                           +m2*myN0*myN1;
-                            double* dest = out.getSampleDataRW(dataIndex);
-                            for (int c=0; c<numComp; c++) {
-                                ValueType val = values[x*numComp+c];
-
-                                if (params.byteOrder != BYTEORDER_NATIVE) {
-                                    char* cval = reinterpret_cast<char*>(&val);
-                                    // this will alter val!!
-                                    byte_swap32(cval);
-                                }
-                                if (!bm::isnan(val)) {
-                                    for (int q=0; q<dpp; q++) {
-                                        *dest++ = static_cast<double>(val);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        readZippedGridBlock(filename, 3, gridSize, blockStart, blockCount,
+                            numComp*sizeof(ValueType), expandRow);
+#endif
+    } else {
+        readGridBlock(m_mpiInfo, filename, 3, gridSize, blockStart, blockCount,
+                      numComp*sizeof(ValueType), expandRow);
     }
 }
-#endif
 
 void Brick::writeBinaryGrid(const escript::Data& in, string filename,
                             int byteOrder, int dataType) const
@@ -964,25 +857,36 @@ template<typename ValueType>
 void Brick::writeBinaryGridImpl(const escript::Data& in,
                                 const string& filename, int byteOrder) const
 {
-    // check function space and determine number of points
-    dim_t myN0, myN1, myN2;
+    // check function space and determine the block of points this rank
+    // writes. Points shared with the preceding rank are written by that rank.
+    dim_t myN0, myN1;
+    dim_t ownN0, ownN1, ownN2;
     dim_t totalN0, totalN1, totalN2;
     dim_t offset0, offset1, offset2;
+    const dim_t left0 = (m_offset[0]>0 ? 1 : 0);
+    const dim_t left1 = (m_offset[1]>0 ? 1 : 0);
+    const dim_t left2 = (m_offset[2]>0 ? 1 : 0);
+    dim_t first0 = 0, first1 = 0, first2 = 0;
     if (in.getFunctionSpace().getTypeCode() == Nodes) {
         myN0 = m_NN[0];
         myN1 = m_NN[1];
-        myN2 = m_NN[2];
+        ownN0 = (m_gNE[0]+1)/m_NX[0];
+        ownN1 = (m_gNE[1]+1)/m_NX[1];
+        ownN2 = (m_gNE[2]+1)/m_NX[2];
         totalN0 = m_gNE[0]+1;
         totalN1 = m_gNE[1]+1;
         totalN2 = m_gNE[2]+1;
-        offset0 = m_offset[0];
-        offset1 = m_offset[1];
-        offset2 = m_offset[2];
+        first0 = left0;
+        first1 = left1;
+        first2 = left2;
+        offset0 = m_offset[0]+left0;
+        offset1 = m_offset[1]+left1;
+        offset2 = m_offset[2]+left2;
     } else if (in.getFunctionSpace().getTypeCode() == DegreesOfFreedom ||
             in.getFunctionSpace().getTypeCode() == ReducedDegreesOfFreedom) {
-        myN0 = (m_gNE[0]+1)/m_NX[0];
-        myN1 = (m_gNE[1]+1)/m_NX[1];
-        myN2 = (m_gNE[2]+1)/m_NX[2];
+        myN0 = ownN0 = (m_gNE[0]+1)/m_NX[0];
+        myN1 = ownN1 = (m_gNE[1]+1)/m_NX[1];
+        ownN2 = (m_gNE[2]+1)/m_NX[2];
         totalN0 = m_gNE[0]+1;
         totalN1 = m_gNE[1]+1;
         totalN2 = m_gNE[2]+1;
@@ -993,53 +897,59 @@ void Brick::writeBinaryGridImpl(const escript::Data& in,
                 in.getFunctionSpace().getTypeCode() == ReducedElements) {
         myN0 = m_NE[0];
         myN1 = m_NE[1];
-        myN2 = m_NE[2];
+        ownN0 = m_ownNE[0];
+        ownN1 = m_ownNE[1];
+        ownN2 = m_ownNE[2];
         totalN0 = m_gNE[0];
         totalN1 = m_gNE[1];
         totalN2 = m_gNE[2];
-        offset0 = m_offset[0];
-        offset1 = m_offset[1];
-        offset2 = m_offset[2];
+        first0 = left0;
+        first1 = left1;
+        first2 = left2;
+        offset0 = m_offset[0]+left0;
+        offset1 = m_offset[1]+left1;
+        offset2 = m_offset[2]+left2;
     } else
         throw RipleyException("writeBinaryGrid(): unsupported function space");
 
+    if (in.isComplex())
+        throw RipleyException("writeBinaryGrid(): complex data not supported");
+
+    // all data points and components of a sample are stored consecutively
     const int numComp = in.getDataPointSize();
     const int dpp = in.getNumDataPointsPerSample();
-    const dim_t fileSize = sizeof(ValueType)*numComp*dpp*totalN0*totalN1*totalN2;
-
-    if (numComp > 1 || dpp > 1)
-        throw RipleyException("writeBinaryGrid(): only scalar, single-value data supported");
-
-    // from here on we know that each sample consists of one value
-    FileWriter fw(m_mpiInfo->comm);
-    fw.openFile(filename, fileSize, true);
-    MPIBarrier();
-
-    for (index_t z=0; z<myN2; z++) {
-        for (index_t y=0; y<myN1; y++) {
-            const dim_t fileofs = (offset0+(offset1+y)*totalN0
-                                +(offset2+z)*totalN0*totalN1)*sizeof(ValueType);
-            std::ostringstream oss;
-
-            for (index_t x=0; x<myN0; x++) {
-                const double* sample = in.getSampleDataRO(z*myN0*myN1+y*myN0+x);
-                ValueType fvalue = static_cast<ValueType>(*sample);
-                if (byteOrder == BYTEORDER_NATIVE) {
-                    oss.write((char*)&fvalue, sizeof(fvalue));
-                } else {
-                    char* value = reinterpret_cast<char*>(&fvalue);
-                    if (sizeof(fvalue)>4) {
-                        byte_swap64(value);
-                    } else {
-                        byte_swap32(value);
+    const dim_t valuesPerPoint = numComp*dpp;
+
+    // pack this rank's block into one contiguous buffer
+    vector<ValueType> values(ownN0*ownN1*ownN2*valuesPerPoint);
+#pragma omp parallel for
+    for (index_t z=0; z<ownN2; z++) {
+        for (index_t y=0; y<ownN1; y++) {
+            ValueType* dest = &values[(z*ownN1+y)*ownN0*valuesPerPoint];
+            for (index_t x=0; x<ownN0; x++) {
+                const double* sample = in.getSampleDataRO(
+                        (first2+z)*myN0*myN1+(first1+y)*myN0+first0+x);
+                for (index_t i=0; i<valuesPerPoint; i++) {
+                    ValueType fvalue = static_cast<ValueType>(sample[i]);
+                    if (byteOrder != BYTEORDER_NATIVE) {
+                        char* value = reinterpret_cast<char*>(&fvalue);
+                        if (sizeof(fvalue)>4) {
+                            byte_swap64(value);
+                        } else {
+                            byte_swap32(value);
+                        }
                     }
-                    oss.write(value, sizeof(fvalue));
+                    *dest++ = fvalue;
                 }
             }
-            fw.writeAt(oss, fileofs);
         }
     }
-    fw.close();
+
+    const dim_t gridSize[3] = { totalN2, totalN1, totalN0 };
+    const dim_t blockStart[3] = { offset2, offset1, offset0 };
+    const dim_t blockCount[3] = { ownN2, ownN1, ownN0 };
+    writeGridBlock(m_mpiInfo, filename, 3, gridSize, blockStart, blockCount,
+                   valuesPerPoint*sizeof(ValueType), (const char*)values.data());
 }
 
 void Brick::write(const std::string& filename) const
@@ -3827,87 +3737,90 @@ escript::Data Brick::randomFillWorker(
 
     Block block(ext[0], ext[1], ext[2], inset, xmidlen, ymidlen, zmidlen, numvals);
 
-    MPI_Request reqs[50]; // a non-tight upper bound on how many we need
-    MPI_Status stats[50];
-    short rused=0;
-
     messvec incoms;
     messvec outcoms;
 
     grid.generateInNeighbours(X, Y, Z ,incoms);
     grid.generateOutNeighbours(X, Y, Z, outcoms);
 
-    block.copyAllToBuffer(src);
+    BlockExchange<Block> exchange(block, m_mpiInfo->comm);
+    bool comsok=exchange.start(incoms, outcoms, src);
 
-    int comserr=0;
-    for (size_t i=0; i < incoms.size(); ++i) {
-        message& m = incoms[i];
-        comserr |= MPI_Irecv(block.getInBuffer(m.destbuffid),
-                           block.getBuffSize(m.destbuffid), MPI_DOUBLE,
-                           m.sourceID, m.tag, m_mpiInfo->comm, reqs+(rused++));
-        block.setUsed(m.destbuffid);
-    }
+    // values in this region of src are final already
+    size_t lo[3], hi[3];
+    block.getUntouchedRegion(lo, hi);
+#else
+    const size_t lo[3]={0, 0, 0};
+    const size_t hi[3]={ext[0], ext[1], ext[2]};
+#endif // ESYS_MPI
 
-    for (size_t i=0; i<outcoms.size(); ++i) {
-        message& m=outcoms[i];
-        comserr |= MPI_Isend(block.getOutBuffer(m.srcbuffid),
-                             block.getBuffSize(m.srcbuffid), MPI_DOUBLE,
-                             m.destID, m.tag, m_mpiInfo->comm, reqs+(rused++));
-    }
+    // the truth of either should imply the truth of the other but let's be safe
+    const bool filtered=!(radius==0 || numvals>1);
+    // how far beyond a point (in src) its result depends on
+    const size_t reach=(filtered ? 2*radius : 0);
+
+    escript::FunctionSpace fs(getPtr(), getContinuousFunctionCode());
+    escript::Data resdat(0, filtered ? escript::DataTypes::scalarShape : shape,
+                         fs, true);
+    // don't need to check for exwrite because we just made it
+    escript::DataTypes::RealVectorType& dv=resdat.getExpandedVectorReference();
+    double* convolution=(filtered ? get3DGauss(radius, sigma) : NULL);
+
+    auto fillPoint = [&](size_t x, size_t y, size_t z) {
+        if (filtered) {
+            dv[x+y*(internal[0])+z*internal[0]*internal[1]]=Convolve3D(convolution, src, x+radius, y+radius, z+radius, radius, ext[0], ext[1]);
+        } else {
+            for (unsigned int i=0; i < numvals; ++i) {
+                dv[i+(x+y*(internal[0])+z*internal[0]*internal[1])*numvals]=src[i+(x+y*ext[0]+z*ext[0]*ext[1])*numvals];
+            }
+        }
+    };
 
-    if (!comserr) {
-        comserr=MPI_Waitall(rused, reqs, stats);
+    // points which do not depend on values from other ranks are computed
+    // while the exchange is in progress
+    size_t ilo[3], ihi[3];
+    for (int d=0; d<3; d++) {
+        ilo[d]=std::min(lo[d], (size_t)internal[d]);
+        ihi[d]=(hi[d]>reach ? std::min(hi[d]-reach, (size_t)internal[d]) : 0);
+        ihi[d]=std::max(ihi[d], ilo[d]);
+    }
+    for (size_t z=ilo[2]; z<ihi[2]; ++z) {
+        for (size_t y=ilo[1]; y<ihi[1]; ++y) {
+            for (size_t x=ilo[0]; x<ihi[0]; ++x) {
+                fillPoint(x, y, z);
+            }
+        }
+#ifdef ESYS_MPI
+        exchange.test();
+#endif
     }
 
-    if (comserr) {
+#ifdef ESYS_MPI
+    comsok=exchange.finish(src) && comsok;
+    if (!comsok) {
+        delete[] convolution;
+        delete[] src;
         // Yes this is throwing an exception as a result of an MPI error.
         // and no we don't inform the other ranks that we are doing this.
         // however, we have no reason to believe coms work at this point anyway
         throw RipleyException("Error in coms for randomFill");
     }
-
-    block.copyUsedFromBuffer(src);
 #endif // ESYS_MPI
 
-    // the truth of either should imply the truth of the other but let's be safe
-    if (radius==0 || numvals>1) {
-        escript::FunctionSpace fs(getPtr(), getContinuousFunctionCode());
-        escript::Data resdat(0, shape, fs , true);
-        // don't need to check for exwrite because we just made it
-        escript::DataTypes::RealVectorType& dv=resdat.getExpandedVectorReference();
-
-        // now we need to copy values over
-        for (size_t z=0; z < internal[2]; ++z) {
-            for (size_t y=0; y < internal[1]; ++y) {
-                for (size_t x=0; x < internal[0]; ++x) {
-                    for (unsigned int i=0; i < numvals; ++i) {
-                        dv[i+(x+y*(internal[0])+z*internal[0]*internal[1])*numvals]=src[i+(x+y*ext[0]+z*ext[0]*ext[1])*numvals];
-                    }
-                }
-            }
-        }
-        delete[] src;
-        return resdat;
-    } else { // filter enabled
-        escript::FunctionSpace fs(getPtr(), getContinuousFunctionCode());
-        escript::Data resdat(0, escript::DataTypes::scalarShape, fs , true);
-        // don't need to check for exwrite because we just made it
-        escript::DataTypes::RealVectorType& dv=resdat.getExpandedVectorReference();
-        double* convolution=get3DGauss(radius, sigma);
-
-        for (size_t z=0;z<(internal[2]);++z) {
-            for (size_t y=0;y<(internal[1]);++y) {
-                for (size_t x=0;x<(internal[0]);++x) {
-                    dv[x+y*(internal[0])+z*internal[0]*internal[1]]=Convolve3D(convolution, src, x+radius, y+radius, z+radius, radius, ext[0], ext[1]);
-
-                }
+    // now the rest
+    for (size_t z=0; z<internal[2]; ++z) {
+        for (size_t y=0; y<internal[1]; ++y) {
+            const bool inner=(z>=ilo[2] && z<ihi[2] && y>=ilo[1] && y<ihi[1]);
+            for (size_t x=0; x<internal[0]; ++x) {
+                if (inner && x>=ilo[0] && x<ihi[0])
+                    continue;
+                fillPoint(x, y, z);
             }
         }
-
-        delete[] convolution;
-        delete[] src;
-        return resdat;
     }
+    delete[] convolution;
+    delete[] src;
+    return resdat;
 }
 
 dim_t Brick::findNode(const double *coords) const
@@ -19,6 +19,7 @@
 #define __RIPLEY_BRICK_H__
 
 #include <ripley/RipleyDomain.h>
+#include <escript/ElementTiling.h>
 
 namespace ripley {
 
@@ -258,19 +259,19 @@ protected:
 
     template<typename ValueType>
     void readBinaryGridImpl(escript::Data& out, const std::string& filename,
-                            const ReaderParameters& params) const;
-#ifdef ESYS_HAVE_BOOST_IO
-    template<typename ValueType>
-    void readBinaryGridZippedImpl(escript::Data& out,
-                                  const std::string& filename,
-                                  const ReaderParameters& params) const;
-#endif
+                            const ReaderParameters& params,
+                            bool zipped = false) const;
     template<typename ValueType>
     void writeBinaryGridImpl(const escript::Data& in,
                              const std::string& filename, int byteOrder) const;
 
     dim_t findNode(const double *coords) const;
 
+    /// returns the colouring of element tiles used for threaded assembly
+    escript::ElementTiling getElementTiling() const {
+        return escript::ElementTiling(m_NE, m_tileSize);
+    }
+
     virtual escript::Data randomFillWorker(
             const escript::DataTypes::ShapeType& shape, long seed,
             const boost::python::tuple& filter) const;
@@ -229,22 +229,28 @@ void DefaultAssembler3D<Scalar>::assemblePDESingle(AbstractSystemMatrix* mat,
     const double w29 = w27*(4*SQRT3 + 7);
     const dim_t NE0 = m_NE[0];
     const dim_t NE1 = m_NE[1];
-    const dim_t NE2 = m_NE[2];
     const bool add_EM_S = (!A.isEmpty() || !B.isEmpty() || !C.isEmpty() || !D.isEmpty());
     const bool add_EM_F = (!X.isEmpty() || !Y.isEmpty());
     const Scalar zero = static_cast<Scalar>(0);
     rhs.requireWrite();
 
+    const escript::ElementTiling tiling(domain->getElementTiling());
 #pragma omp parallel
     {
         vector<Scalar> EM_S(8*8);
         vector<Scalar> EM_F(8);
 
-        for (index_t k2_0=0; k2_0<2; k2_0++) { // colouring
+        for (int colour=0; colour<tiling.getNumColours(); colour++) { // colouring
+            const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp for
-            for (index_t k2=k2_0; k2<NE2; k2+=2) {
-                for (index_t k1=0; k1<NE1; ++k1) {
-                    for (index_t k0=0; k0<NE0; ++k0)  {
+            for (dim_t tile=0; tile<numTiles; tile++) {
+                index_t first[3], last[3];
+                tiling.getTileRange(colour, tile, first, last);
+                const dim_t tileNE1 = last[1]-first[1];
+                for (dim_t row=0; row<tileNE1*(last[2]-first[2]); row++) {
+                    const index_t k1 = first[1] + row%tileNE1;
+                    const index_t k2 = first[2] + row/tileNE1;
+                    for (index_t k0=first[0]; k0<last[0]; ++k0)  {
                         const index_t e = k0 + NE0*k1 + NE0*NE1*k2;
                         if (add_EM_S)
                             fill(EM_S.begin(), EM_S.end(), zero);
@@ -2219,8 +2225,8 @@ void DefaultAssembler3D<Scalar>::assemblePDESingle(AbstractSystemMatrix* mat,
                         domain->addToMatrixAndRHS(mat, rhs, EM_S, EM_F,
                                                add_EM_S, add_EM_F, firstNode);
                     } // end k0 loop
-                } // end k1 loop
-            } // end k2 loop
+                } // end row loop
+            } // end tile loop
         } // end of colouring
     } // end of parallel region
 }
@@ -2906,22 +2912,28 @@ void DefaultAssembler3D<Scalar>::assemblePDESingleReduced(
     const double w0 = m_dx[1]*m_dx[2]/(16*m_dx[0]);
     const dim_t NE0 = m_NE[0];
     const dim_t NE1 = m_NE[1];
-    const dim_t NE2 = m_NE[2];
     const bool add_EM_S = (!A.isEmpty() || !B.isEmpty() || !C.isEmpty() || !D.isEmpty());
     const bool add_EM_F = (!X.isEmpty() || !Y.isEmpty());
     const Scalar zero = static_cast<Scalar>(0);
     rhs.requireWrite();
 
+    const escript::ElementTiling tiling(domain->getElementTiling());
 #pragma omp parallel
     {
         vector<Scalar> EM_S(8*8, zero);
         vector<Scalar> EM_F(8, zero);
 
-        for (index_t k2_0=0; k2_0<2; k2_0++) { // colouring
+        for (int colour=0; colour<tiling.getNumColours(); colour++) { // colouring
+            const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp for
-            for (index_t k2=k2_0; k2<NE2; k2+=2) {
-                for (index_t k1=0; k1<NE1; ++k1) {
-                    for (index_t k0=0; k0<NE0; ++k0)  {
+            for (dim_t tile=0; tile<numTiles; tile++) {
+                index_t first[3], last[3];
+                tiling.getTileRange(colour, tile, first, last);
+                const dim_t tileNE1 = last[1]-first[1];
+                for (dim_t row=0; row<tileNE1*(last[2]-first[2]); row++) {
+                    const index_t k1 = first[1] + row%tileNE1;
+                    const index_t k2 = first[2] + row/tileNE1;
+                    for (index_t k0=first[0]; k0<last[0]; ++k0)  {
                         const index_t e = k0 + NE0*k1 + NE0*NE1*k2;
                         if (add_EM_S)
                             fill(EM_S.begin(), EM_S.end(), zero);
@@ -3260,8 +3272,8 @@ void DefaultAssembler3D<Scalar>::assemblePDESingleReduced(
                         domain->addToMatrixAndRHS(mat, rhs, EM_S, EM_F,
                                                add_EM_S, add_EM_F, firstNode);
                     } // end k0 loop
-                } // end k1 loop
-            } // end k2 loop
+                } // end row loop
+            } // end tile loop
         } // end of colouring
     } // end of parallel region
 }
@@ -3715,22 +3727,28 @@ void DefaultAssembler3D<Scalar>::assemblePDESystem(AbstractSystemMatrix* mat,
     const double w29 = w27*(4*SQRT3 + 7);
     const dim_t NE0 = m_NE[0];
     const dim_t NE1 = m_NE[1];
-    const dim_t NE2 = m_NE[2];
     const bool add_EM_S = (!A.isEmpty() || !B.isEmpty() || !C.isEmpty() || !D.isEmpty());
     const bool add_EM_F = (!X.isEmpty() || !Y.isEmpty());
     const Scalar zero = static_cast<Scalar>(0);
     rhs.requireWrite();
 
+    const escript::ElementTiling tiling(domain->getElementTiling());
 #pragma omp parallel
     {
         vector<Scalar> EM_S(8*8*numEq*numComp, zero);
         vector<Scalar> EM_F(8*numEq, zero);
 
-        for (index_t k2_0=0; k2_0<2; k2_0++) { // colouring
+        for (int colour=0; colour<tiling.getNumColours(); colour++) { // colouring
+            const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp for
-            for (index_t k2=k2_0; k2<NE2; k2+=2) {
-                for (index_t k1=0; k1<NE1; ++k1) {
-                    for (index_t k0=0; k0<NE0; ++k0)  {
+            for (dim_t tile=0; tile<numTiles; tile++) {
+                index_t first[3], last[3];
+                tiling.getTileRange(colour, tile, first, last);
+                const dim_t tileNE1 = last[1]-first[1];
+                for (dim_t row=0; row<tileNE1*(last[2]-first[2]); row++) {
+                    const index_t k1 = first[1] + row%tileNE1;
+                    const index_t k2 = first[2] + row/tileNE1;
+                    for (index_t k0=first[0]; k0<last[0]; ++k0)  {
                         const index_t e = k0 + NE0*k1 + NE0*NE1*k2;
                         if (add_EM_S)
                             fill(EM_S.begin(), EM_S.end(), zero);
@@ -5739,8 +5757,8 @@ void DefaultAssembler3D<Scalar>::assemblePDESystem(AbstractSystemMatrix* mat,
                         domain->addToMatrixAndRHS(mat, rhs, EM_S, EM_F,
                                 add_EM_S, add_EM_F, firstNode, numEq, numComp);
                     } // end k0 loop
-                } // end k1 loop
-            } // end k2 loop
+                } // end row loop
+            } // end tile loop
         } // end of colouring
     } // end of parallel region
 }
@@ -6489,22 +6507,28 @@ void DefaultAssembler3D<Scalar>::assemblePDESystemReduced(
     const double w9 = m_dx[0]*m_dx[1]*m_dx[2]/64;
     const dim_t NE0 = m_NE[0];
     const dim_t NE1 = m_NE[1];
-    const dim_t NE2 = m_NE[2];
     const bool add_EM_S = (!A.isEmpty() || !B.isEmpty() || !C.isEmpty() || !D.isEmpty());
     const bool add_EM_F = (!X.isEmpty() || !Y.isEmpty());
     const Scalar zero = static_cast<Scalar>(0);
     rhs.requireWrite();
 
+    const escript::ElementTiling tiling(domain->getElementTiling());
 #pragma omp parallel
     {
         vector<Scalar> EM_S(8*8*numEq*numComp, zero);
         vector<Scalar> EM_F(8*numEq, zero);
 
-        for (index_t k2_0=0; k2_0<2; k2_0++) { // colouring
+        for (int colour=0; colour<tiling.getNumColours(); colour++) { // colouring
+            const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp for
-            for (index_t k2=k2_0; k2<NE2; k2+=2) {
-                for (index_t k1=0; k1<NE1; ++k1) {
-                    for (index_t k0=0; k0<NE0; ++k0)  {
+            for (dim_t tile=0; tile<numTiles; tile++) {
+                index_t first[3], last[3];
+                tiling.getTileRange(colour, tile, first, last);
+                const dim_t tileNE1 = last[1]-first[1];
+                for (dim_t row=0; row<tileNE1*(last[2]-first[2]); row++) {
+                    const index_t k1 = first[1] + row%tileNE1;
+                    const index_t k2 = first[2] + row/tileNE1;
+                    for (index_t k0=first[0]; k0<last[0]; ++k0)  {
                         const index_t e = k0 + NE0*k1 + NE0*NE1*k2;
                         if (add_EM_S)
                             fill(EM_S.begin(), EM_S.end(), zero);
@@ -6864,8 +6888,8 @@ void DefaultAssembler3D<Scalar>::assemblePDESystemReduced(
                         domain->addToMatrixAndRHS(mat, rhs, EM_S, EM_F,
                                 add_EM_S, add_EM_F, firstNode, numEq, numComp);
                     } // end k0 loop
-                } // end k1 loop
-            } // end k2 loop
+                } // end row loop
+            } // end tile loop
         } // end of colouring
     } // end of parallel region
 }
@@ -890,16 +890,23 @@ void LameAssembler3D::assemblePDESystem(AbstractSystemMatrix* mat, Data& rhs,
     const bool add_EM_F = (!X.isEmpty() || !Y.isEmpty());
     rhs.requireWrite();
 
+    const escript::ElementTiling tiling(domain->getElementTiling());
 #pragma omp parallel
     {
         vector<double> EM_S(8*8*numEq*numComp, 0);
         vector<double> EM_F(8*numEq, 0);
 
-        for (index_t k2_0=0; k2_0<2; k2_0++) { // colouring
+        for (int colour=0; colour<tiling.getNumColours(); colour++) { // colouring
+            const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp for
-            for (index_t k2=k2_0; k2<m_NE[2]; k2+=2) {
-                for (index_t k1=0; k1<m_NE[1]; ++k1) {
-                    for (index_t k0=0; k0<m_NE[0]; ++k0)  {
+            for (dim_t tile=0; tile<numTiles; tile++) {
+                index_t first[3], last[3];
+                tiling.getTileRange(colour, tile, first, last);
+                const dim_t tileNE1 = last[1]-first[1];
+                for (dim_t row=0; row<tileNE1*(last[2]-first[2]); row++) {
+                    const index_t k1 = first[1] + row%tileNE1;
+                    const index_t k2 = first[2] + row/tileNE1;
+                    for (index_t k0=first[0]; k0<last[0]; ++k0)  {
                         const index_t e = k0 + m_NE[0]*k1 + m_NE[0]*m_NE[1]*k2;
                         if (add_EM_S)
                             fill(EM_S.begin(), EM_S.end(), 0);
@@ -4445,8 +4452,8 @@ void LameAssembler3D::assemblePDESystem(AbstractSystemMatrix* mat, Data& rhs,
                         domain->addToMatrixAndRHS(mat, rhs, EM_S, EM_F,
                                 add_EM_S, add_EM_F, firstNode, numEq, numComp);
                     } // end k0 loop
-                } // end k1 loop
-            } // end k2 loop
+                } // end row loop
+            } // end tile loop
         } // end of colouring
     } // end of parallel region
 }
@@ -54,6 +54,7 @@
 #include <boost/math/special_functions/fpclassify.hpp>	// for isnan
 #include <boost/scoped_array.hpp>
 
+#include <algorithm>
 #include <iomanip>
 #include <limits>
 
@@ -552,13 +553,13 @@ void Rectangle::readBinaryGridFromZipped(escript::Data& out, string filename,
     // supported platforms
     switch (params.dataType) {
         case DATATYPE_INT32:
-            readBinaryGridZippedImpl<int>(out, filename, params);
+            readBinaryGridImpl<int>(out, filename, params, true);
             break;
         case DATATYPE_FLOAT32:
-            readBinaryGridZippedImpl<float>(out, filename, params);
+            readBinaryGridImpl<float>(out, filename, params, true);
             break;
         case DATATYPE_FLOAT64:
-            readBinaryGridZippedImpl<double>(out, filename, params);
+            readBinaryGridImpl<double>(out, filename, params, true);
             break;
         default:
             throw ValueError("readBinaryGridFromZipped(): invalid or unsupported datatype");
@@ -570,7 +571,8 @@ void Rectangle::readBinaryGridFromZipped(escript::Data& out, string filename,
 
 template<typename ValueType>
 void Rectangle::readBinaryGridImpl(escript::Data& out, const string& filename,
-                                   const ReaderParameters& params) const
+                                   const ReaderParameters& params,
+                                   bool zipped) const
 {
     // check destination function space
     dim_t myN0, myN1;
@@ -598,28 +600,24 @@ void Rectangle::readBinaryGridImpl(escript::Data& out, const string& filename,
     if (params.reverse[0] != 0 || params.reverse[1] != 0)
         throw NotImplementedError("readBinaryGrid(): reversing not supported yet");
 
-    // check file existence and size
-    std::ifstream f(filename.c_str(), std::ifstream::binary);
-    if (f.fail()) {
+    // check file existence and size. The uncompressed size of a zipped
+    // file is unknown until it has been decompressed so running out of data
+    // is detected while reading in that case
+    const dim_t filesize = getFileSize(m_mpiInfo, filename);
+    if (filesize < 0) {
         throw IOError("readBinaryGrid(): cannot open file " + filename);
     }
-    f.seekg(0, ios::end);
     const int numComp = out.getDataPointSize();
-    const dim_t filesize = f.tellg();
     const dim_t reqsize = params.numValues[0]*params.numValues[1]*numComp*sizeof(ValueType);
-    if (filesize < reqsize) {
-        f.close();
+    if (!zipped && filesize < reqsize) {
         throw IOError("readBinaryGrid(): not enough data in file");
     }
 
     // check if this rank contributes anything
-    if (params.first[0] >= m_offset[0]+myN0 ||
+    const bool contributes = !(params.first[0] >= m_offset[0]+myN0 ||
             params.first[0]+(params.numValues[0]*params.multiplier[0]) <= m_offset[0] ||
             params.first[1] >= m_offset[1]+myN1 ||
-            params.first[1]+(params.numValues[1]*params.multiplier[1]) <= m_offset[1]) {
-        f.close();
-        return;
-    }
+            params.first[1]+(params.numValues[1]*params.multiplier[1]) <= m_offset[1]);
 
     // now determine how much this rank has to write
 
@@ -634,18 +632,22 @@ void Rectangle::readBinaryGridImpl(escript::Data& out, const string& filename,
     // contributes (multiplier-rank) copies of that value
     const dim_t rest0 = m_offset[0]%params.multiplier[0];
     const dim_t rest1 = m_offset[1]%params.multiplier[1];
-    // number of values to read
-    const dim_t num0 = min(params.numValues[0]-idx0, myN0-first0);
-    const dim_t num1 = min(params.numValues[1]-idx1, myN1-first1);
+    // number of values to read, ranks without data still take part in the
+    // (collective) read
+    const dim_t num0 = (contributes ? min(params.numValues[0]-idx0, myN0-first0) : 0);
+    const dim_t num1 = (contributes ? min(params.numValues[1]-idx1, myN1-first1) : 0);
+
+    // the block of this rank is fetched row by row, y-x ordering in file
+    const dim_t gridSize[2] = { params.numValues[1], params.numValues[0] };
+    const dim_t blockStart[2] = { idx1, idx0 };
+    const dim_t blockCount[2] = { num1, num0 };
 
     out.requireWrite();
-    vector<ValueType> values(num0*numComp);
     const int dpp = out.getNumDataPointsPerSample();
 
-    for (dim_t y=0; y<num1; y++) {
-        const dim_t fileofs = numComp*(idx0+(idx1+y)*params.numValues[0]);
-        f.seekg(fileofs*sizeof(ValueType));
-        f.read((char*)&values[0], num0*numComp*sizeof(ValueType));
+    // expands one row of num0 file values into the Data object. Rows may be
+    // handed over concurrently but never write to the same samples
+    auto expandRow = [&](dim_t y, const char* data) {
         const dim_t m1limit = (y==0 ? params.multiplier[1]-rest1 : params.multiplier[1]);
         dim_t dataYbase = first1+y*params.multiplier[1];
         if (y>0)
@@ -667,11 +669,11 @@ void Rectangle::readBinaryGridImpl(escript::Data& out, const string& filename,
                     const dim_t dataIndex = dataX+dataY*myN0;
                     double* dest = out.getSampleDataRW(dataIndex);
                     for (int c=0; c<numComp; c++) {
-                        ValueType val = values[x*numComp+c];
-
+                        ValueType val;
+                        memcpy(&val, data+(x*numComp+c)*sizeof(ValueType),
+                               sizeof(ValueType));
                         if (params.byteOrder != BYTEORDER_NATIVE) {
                             char* cval = reinterpret_cast<char*>(&val);
-                            // this will alter val!!
                             if (sizeof(ValueType) > 4) {
                                 byte_swap64(cval);
                             } else {
@@ -687,104 +689,18 @@ void Rectangle::readBinaryGridImpl(escript::Data& out, const string& filename,
                 }
             }
         }
-    }
-
-    f.close();
-}
+    };
 
+    if (zipped) {
 #ifdef ESYS_HAVE_BOOST_IO
-template<typename ValueType>
-void Rectangle::readBinaryGridZippedImpl(escript::Data& out, const string& filename,
-                                   const ReaderParameters& params) const
-{
-    // check destination function space
-    dim_t myN0, myN1;
-    if (out.getFunctionSpace().getTypeCode() == Nodes) {
-        myN0 = m_NN[0];
-        myN1 = m_NN[1];
-    } else if (out.getFunctionSpace().getTypeCode() == Elements ||
-                out.getFunctionSpace().getTypeCode() == ReducedElements) {
-        myN0 = m_NE[0];
-        myN1 = m_NE[1];
-    } else
-        throw ValueError("readBinaryGrid(): invalid function space for output data object");
-
-    // check file existence and size
-    std::ifstream f(filename.c_str(), std::ifstream::binary);
-    if (f.fail()) {
-        throw IOError("readBinaryGridFromZipped(): cannot open file" + filename);
-    }
-    f.seekg(0, ios::end);
-    const int numComp = out.getDataPointSize();
-    dim_t filesize = f.tellg();
-    f.seekg(0, ios::beg);
-    vector<char> compressed(filesize);
-    f.read((char*)&compressed[0], filesize);
-    f.close();
-    vector<char> decompressed = unzip(compressed);
-    filesize = decompressed.size();
-    const dim_t reqsize = params.numValues[0]*params.numValues[1]*numComp*sizeof(ValueType);
-    if (filesize < reqsize) {
-        throw IOError("readBinaryGridFromZipped(): not enough data in file");
-    }
-
-    // check if this rank contributes anything
-    if (params.first[0] >= m_offset[0]+myN0 ||
-            params.first[0]+params.numValues[0] <= m_offset[0] ||
-            params.first[1] >= m_offset[1]+myN1 ||
-            params.first[1]+params.numValues[1] <= m_offset[1]) {
-        f.close();
-        return;
-    }
-
-    // now determine how much this rank has to write
-
-    // first coordinates in data object to write to
-    const dim_t first0 = max(dim_t(0), params.first[0]-m_offset[0]);
-    const dim_t first1 = max(dim_t(0), params.first[1]-m_offset[1]);
-    // indices to first value in file
-    const dim_t idx0 = max(dim_t(0), m_offset[0]-params.first[0]);
-    const dim_t idx1 = max(dim_t(0), m_offset[1]-params.first[1]);
-    // number of values to read
-    const dim_t num0 = min(params.numValues[0]-idx0, myN0-first0);
-    const dim_t num1 = min(params.numValues[1]-idx1, myN1-first1);
-
-    out.requireWrite();
-    vector<ValueType> values(num0*numComp);
-    const int dpp = out.getNumDataPointsPerSample();
-
-    for (dim_t y=0; y<num1; y++) {
-        const dim_t fileofs = numComp*(idx0+(idx1+y)*params.numValues[0]);
-            memcpy((char*)&values[0], (char*)&decompressed[fileofs*sizeof(ValueType)], num0*numComp*sizeof(ValueType));
-        for (dim_t x=0; x<num0; x++) {
-            const dim_t baseIndex = first0+x*params.multiplier[0]
-                                    +(first1+y*params.multiplier[1])*myN0;
-            for (int m1=0; m1<params.multiplier[1]; m1++) {
-                for (int m0=0; m0<params.multiplier[0]; m0++) {
-                    const dim_t dataIndex = baseIndex+m0+m1*myN0;
-                    double* dest = out.getSampleDataRW(dataIndex);
-                    for (int c=0; c<numComp; c++) {
-                        ValueType val = values[x*numComp+c];
-
-                        if (params.byteOrder != BYTEORDER_NATIVE) {
-                            char* cval = reinterpret_cast<char*>(&val);
-                            // this will alter val!!
-                            byte_swap32(cval);
-                        }
-                        if (!bm::isnan(val)) {
-                            for (int q=0; q<dpp; q++) {
-                                *dest++ = static_cast<double>(val);
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        readZippedGridBlock(filename, 2, gridSize, blockStart, blockCount,
+                            numComp*sizeof(ValueType), expandRow);
+#endif
+    } else {
+        readGridBlock(m_mpiInfo, filename, 2, gridSize, blockStart, blockCount,
+                      numComp*sizeof(ValueType), expandRow);
     }
-
-    f.close();
 }
-#endif
 
 void Rectangle::writeBinaryGrid(const escript::Data& in, string filename,
                                 int byteOrder, int dataType) const
@@ -810,21 +726,29 @@ template<typename ValueType>
 void Rectangle::writeBinaryGridImpl(const escript::Data& in,
                                     const string& filename, int byteOrder) const
 {
-    // check function space and determine number of points
-    dim_t myN0, myN1;
+    // check function space and determine the block of points this rank
+    // writes. Points shared with the preceding rank are written by that rank.
+    dim_t myN0;
+    dim_t ownN0, ownN1;
     dim_t totalN0, totalN1;
     dim_t offset0, offset1;
+    const dim_t left0 = (m_offset[0]>0 ? 1 : 0);
+    const dim_t left1 = (m_offset[1]>0 ? 1 : 0);
+    dim_t first0 = 0, first1 = 0;
     if (in.getFunctionSpace().getTypeCode() == Nodes) {
         myN0 = m_NN[0];
-        myN1 = m_NN[1];
+        ownN0 = (m_gNE[0]+1)/m_NX[0];
+        ownN1 = (m_gNE[1]+1)/m_NX[1];
         totalN0 = m_gNE[0]+1;
         totalN1 = m_gNE[1]+1;
-        offset0 = m_offset[0];
-        offset1 = m_offset[1];
+        first0 = left0;
+        first1 = left1;
+        offset0 = m_offset[0]+left0;
+        offset1 = m_offset[1]+left1;
     } else if (in.getFunctionSpace().getTypeCode() == DegreesOfFreedom ||
             in.getFunctionSpace().getTypeCode() == ReducedDegreesOfFreedom) {
-        myN0 = (m_gNE[0]+1)/m_NX[0];
-        myN1 = (m_gNE[1]+1)/m_NX[1];
+        myN0 = ownN0 = (m_gNE[0]+1)/m_NX[0];
+        ownN1 = (m_gNE[1]+1)/m_NX[1];
         totalN0 = m_gNE[0]+1;
         totalN1 = m_gNE[1]+1;
         offset0 = (m_offset[0]>0 ? m_offset[0]+1 : 0);
@@ -832,49 +756,52 @@ void Rectangle::writeBinaryGridImpl(const escript::Data& in,
     } else if (in.getFunctionSpace().getTypeCode() == Elements ||
                 in.getFunctionSpace().getTypeCode() == ReducedElements) {
         myN0 = m_NE[0];
-        myN1 = m_NE[1];
+        ownN0 = m_ownNE[0];
+        ownN1 = m_ownNE[1];
         totalN0 = m_gNE[0];
         totalN1 = m_gNE[1];
-        offset0 = m_offset[0];
-        offset1 = m_offset[1];
+        first0 = left0;
+        first1 = left1;
+        offset0 = m_offset[0]+left0;
+        offset1 = m_offset[1]+left1;
     } else
         throw ValueError("writeBinaryGrid(): unsupported function space");
 
+    if (in.isComplex())
+        throw NotImplementedError("writeBinaryGrid(): complex data not supported");
+
+    // all data points and components of a sample are stored consecutively
     const int numComp = in.getDataPointSize();
     const int dpp = in.getNumDataPointsPerSample();
+    const dim_t valuesPerPoint = numComp*dpp;
 
-    if (numComp > 1 || dpp > 1)
-        throw NotImplementedError("writeBinaryGrid(): only scalar, single-value data supported");
-
-    const dim_t fileSize = sizeof(ValueType)*numComp*dpp*totalN0*totalN1;
-
-    // from here on we know that each sample consists of one value
-    FileWriter fw(m_mpiInfo->comm);
-    fw.openFile(filename, fileSize, true);
-    MPIBarrier();
-
-    for (index_t y=0; y<myN1; y++) {
-        const dim_t fileofs = (offset0+(offset1+y)*totalN0)*sizeof(ValueType);
-        std::ostringstream oss;
-
-        for (index_t x=0; x<myN0; x++) {
-            const double* sample = in.getSampleDataRO(y*myN0+x);
-            ValueType fvalue = static_cast<ValueType>(*sample);
-            if (byteOrder == BYTEORDER_NATIVE) {
-                oss.write((char*)&fvalue, sizeof(fvalue));
-            } else {
-                char* value = reinterpret_cast<char*>(&fvalue);
-                if (sizeof(fvalue)>4) {
-                    byte_swap64(value);
-                } else {
-                    byte_swap32(value);
+    // pack this rank's block into one contiguous buffer
+    vector<ValueType> values(ownN0*ownN1*valuesPerPoint);
+#pragma omp parallel for
+    for (index_t y=0; y<ownN1; y++) {
+        ValueType* dest = &values[y*ownN0*valuesPerPoint];
+        for (index_t x=0; x<ownN0; x++) {
+            const double* sample = in.getSampleDataRO((first1+y)*myN0+first0+x);
+            for (index_t i=0; i<valuesPerPoint; i++) {
+                ValueType fvalue = static_cast<ValueType>(sample[i]);
+                if (byteOrder != BYTEORDER_NATIVE) {
+                    char* value = reinterpret_cast<char*>(&fvalue);
+                    if (sizeof(fvalue)>4) {
+                        byte_swap64(value);
+                    } else {
+                        byte_swap32(value);
+                    }
                 }
-                oss.write(value, sizeof(fvalue));
+                *dest++ = fvalue;
             }
         }
-        fw.writeAt(oss, fileofs);
     }
-    fw.close();
+
+    const dim_t gridSize[2] = { totalN1, totalN0 };
+    const dim_t blockStart[2] = { offset1, offset0 };
+    const dim_t blockCount[2] = { ownN1, ownN0 };
+    writeGridBlock(m_mpiInfo, filename, 2, gridSize, blockStart, blockCount,
+                   valuesPerPoint*sizeof(ValueType), (const char*)values.data());
 }
 
 void Rectangle::write(const std::string& filename) const
@@ -2666,82 +2593,86 @@ escript::Data Rectangle::randomFillWorker(
 
     Block2 block(ext[0], ext[1], inset, xmidlen, ymidlen, numvals);
 
-    // a non-tight upper bound on how many we need
-    MPI_Request reqs[40];
-    MPI_Status stats[40];
-    short rused=0;
-
     messvec incoms;
     messvec outcoms;
 
     grid.generateInNeighbours(X, Y, incoms);
     grid.generateOutNeighbours(X, Y, outcoms);
 
-    block.copyAllToBuffer(src);
-
-    int comserr = 0;
-    for (size_t i=0; i < incoms.size(); ++i) {
-        message& m = incoms[i];
-        comserr |= MPI_Irecv(block.getInBuffer(m.destbuffid),
-                             block.getBuffSize(m.destbuffid), MPI_DOUBLE,
-                             m.sourceID, m.tag, m_mpiInfo->comm,
-                             reqs+(rused++));
-        block.setUsed(m.destbuffid);
-    }
+    BlockExchange<Block2> exchange(block, m_mpiInfo->comm);
+    bool comsok = exchange.start(incoms, outcoms, src);
 
-    for (size_t i=0; i < outcoms.size(); ++i) {
-        message& m = outcoms[i];
-        comserr |= MPI_Isend(block.getOutBuffer(m.srcbuffid),
-                             block.getBuffSize(m.srcbuffid), MPI_DOUBLE,
-                             m.destID, m.tag, m_mpiInfo->comm, reqs+(rused++));
-    }
+    // values in this region of src are final already
+    size_t lo[2], hi[2];
+    block.getUntouchedRegion(lo, hi);
+#else
+    const size_t lo[2] = { 0, 0 };
+    const size_t hi[2] = { ext[0], ext[1] };
+#endif
 
-    if (!comserr) {
-        comserr = MPI_Waitall(rused, reqs, stats);
+    // the truth of either should imply the truth of the other but let's be safe
+    const bool filtered = !(radius==0 || numvals > 1);
+    // how far beyond a point (in src) its result depends on
+    const size_t reach = (filtered ? 2*radius : 0);
+
+    escript::FunctionSpace fs(getPtr(), getContinuousFunctionCode());
+    escript::Data resdat(0, filtered ? escript::DataTypes::scalarShape : shape,
+                         fs, true);
+    // don't need to check for exwrite because we just made it
+    escript::DataTypes::RealVectorType& dv = resdat.getExpandedVectorReference();
+    double* convolution = (filtered ? get2DGauss(radius, sigma) : NULL);
+
+    auto fillPoint = [&](size_t x, size_t y) {
+        if (filtered) {
+            dv[x+y*(internal[0])] = Convolve2D(convolution, src, x+radius, y+radius, radius, ext[0]);
+        } else {
+            for (unsigned int i=0; i < numvals; ++i) {
+                dv[i+(x+y*(internal[0]))*numvals]=src[i+(x+y*ext[0])*numvals];
+            }
+        }
+    };
+
+    // points which do not depend on values from other ranks are computed
+    // while the exchange is in progress
+    size_t ilo[2], ihi[2];
+    for (int d=0; d < 2; d++) {
+        ilo[d] = std::min(lo[d], (size_t)internal[d]);
+        ihi[d] = (hi[d] > reach ? std::min(hi[d]-reach, (size_t)internal[d]) : 0);
+        ihi[d] = std::max(ihi[d], ilo[d]);
+    }
+    for (size_t y=ilo[1]; y < ihi[1]; ++y) {
+        for (size_t x=ilo[0]; x < ihi[0]; ++x) {
+            fillPoint(x, y);
+        }
+#ifdef ESYS_MPI
+        exchange.test();
+#endif
     }
 
-    if (comserr) {
+#ifdef ESYS_MPI
+    comsok = exchange.finish(src) && comsok;
+    if (!comsok) {
+        delete[] convolution;
+        delete[] src;
         // Yes this is throwing an exception as a result of an MPI error
         // and no we don't inform the other ranks that we are doing this.
         // However, we have no reason to believe coms work at this point anyway
         throw RipleyException("Error in coms for randomFill");
     }
-
-    block.copyUsedFromBuffer(src);
 #endif
 
-    // the truth of either should imply the truth of the other but let's be safe
-    if (radius==0 || numvals > 1) {
-        escript::FunctionSpace fs(getPtr(), getContinuousFunctionCode());
-        escript::Data resdat(0, shape, fs, true);
-        // don't need to check for exwrite because we just made it
-        escript::DataTypes::RealVectorType& dv = resdat.getExpandedVectorReference();
-
-        // now we need to copy values over
-        for (size_t y=0; y < internal[1]; ++y) {
-            for (size_t x=0; x < internal[0]; ++x) {
-                for (unsigned int i=0; i < numvals; ++i) {
-                    dv[i+(x+y*(internal[0]))*numvals]=src[i+(x+y*ext[0])*numvals];
-                }
-            }
-        }
-        delete[] src;
-        return resdat;
-    } else { // filter enabled
-        escript::FunctionSpace fs(getPtr(), getContinuousFunctionCode());
-        escript::Data resdat(0, escript::DataTypes::scalarShape, fs, true);
-        // don't need to check for exwrite because we just made it
-        escript::DataTypes::RealVectorType& dv=resdat.getExpandedVectorReference();
-        double* convolution=get2DGauss(radius, sigma);
-        for (size_t y=0; y < internal[1]; ++y) {
-            for (size_t x=0; x < internal[0]; ++x) {
-                dv[x+y*(internal[0])] = Convolve2D(convolution, src, x+radius, y+radius, radius, ext[0]);
-            }
+    // now the rest
+    for (size_t y=0; y < internal[1]; ++y) {
+        const bool inner = (y >= ilo[1] && y < ihi[1]);
+        for (size_t x=0; x < internal[0]; ++x) {
+            if (inner && x >= ilo[0] && x < ihi[0])
+                continue;
+            fillPoint(x, y);
         }
-        delete[] convolution;
-        delete[] src;
-        return resdat;
     }
+    delete[] convolution;
+    delete[] src;
+    return resdat;
 }
 
 dim_t Rectangle::findNode(const double *coords) const
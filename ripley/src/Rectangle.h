@@ -267,13 +267,8 @@ protected:
 
     template<typename ValueType>
     void readBinaryGridImpl(escript::Data& out, const std::string& filename,
-                            const ReaderParameters& params) const;
-
-#ifdef ESYS_HAVE_BOOST_IO
-    template<typename ValueType>
-    void readBinaryGridZippedImpl(escript::Data& out, 
-            const std::string& filename, const ReaderParameters& params) const;
-#endif
+                            const ReaderParameters& params,
+                            bool zipped = false) const;
 
     template<typename ValueType>
     void writeBinaryGridImpl(const escript::Data& in,
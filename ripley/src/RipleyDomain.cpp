@@ -85,6 +85,7 @@ RipleyDomain::RipleyDomain(dim_t dim, escript::SubWorld_ptr p) :
         m_mpiInfo = p->getMPI();
 
     assembler_type = DEFAULT_ASSEMBLER;
+    m_tileSize[0] = m_tileSize[1] = m_tileSize[2] = 0;
 }
 
 RipleyDomain::~RipleyDomain()
@@ -917,13 +918,14 @@ int RipleyDomain::getSystemMatrixTypeId(const bp::object& options) const
 #endif
     }
 #ifdef ESYS_HAVE_PASO
-    if (sb.isComplex()) {
-        throw NotImplementedError("Paso does not support complex-valued matrices");
-    }
-    // in all other cases we use PASO
-    return (int)SMT_PASO | paso::SystemMatrix::getSystemMatrixTypeId(
+    // in all other cases we use PASO, complex-valued problems are solved
+    // in real equivalent form
+    int type = (int)SMT_PASO | paso::SystemMatrix::getSystemMatrixTypeId(
             method, sb.getPreconditioner(), sb.getPackage(),
             sb.isSymmetric(), m_mpiInfo);
+    if (sb.isComplex())
+        type |= MATRIX_FORMAT_COMPLEX;
+    return type;
 #else
     throw RipleyException("Unable to find a working solver library!");
 #endif
@@ -1038,6 +1040,13 @@ Assembler_ptr RipleyDomain::createAssemblerFromPython(const string type,
     return createAssembler(type, mapping);
 }
 
+void RipleyDomain::setAssemblyTiling(dim_t t0, dim_t t1, dim_t t2)
+{
+    m_tileSize[0] = t0;
+    m_tileSize[1] = t1;
+    m_tileSize[2] = t2;
+}
+
 void RipleyDomain::addToRHSFromPython(escript::Data& rhs, const bp::list& data,
                                       Assembler_ptr assembler) const
 {
@@ -1416,21 +1425,36 @@ esys_trilinos::const_TrilinosGraph_ptr RipleyDomain::createTrilinosGraph(
 
 //protected
 template<>
-void RipleyDomain::addToSystemMatrix<real_t>(escript::AbstractSystemMatrix* mat,
+void RipleyDomain::addToSystemMatrix<cplx_t>(escript::AbstractSystemMatrix* mat,
                                          const IndexVector& nodes, dim_t numEq,
-                                         const DoubleVector& array) const
+                                         const vector<cplx_t>& array) const
 {
 #ifdef ESYS_HAVE_PASO
     paso::SystemMatrix* psm = dynamic_cast<paso::SystemMatrix*>(mat);
     if (psm) {
-        addToPasoMatrix(psm, nodes, numEq, array);
-        return;
-    }
-#endif
-#ifdef ESYS_HAVE_CUDA
-    SystemMatrix* rsm = dynamic_cast<SystemMatrix*>(mat);
-    if (rsm) {
-        rsm->add(nodes, array);
+        if (!psm->isComplex())
+            throw RipleyException("addToSystemMatrix: cannot add complex "
+                                  "values to a real-valued Paso matrix");
+        // paso stores complex matrices in real equivalent form so every
+        // entry a+ib becomes the 2x2 block [a -b; b a]
+        const dim_t numNodes = nodes.size();
+        const dim_t numEq2 = 2*numEq;
+        DoubleVector realArray(numEq2*numEq2*numNodes*numNodes);
+        for (dim_t k_Sol = 0; k_Sol < numNodes; ++k_Sol) {
+            for (dim_t k_Eq = 0; k_Eq < numNodes; ++k_Eq) {
+                for (dim_t i_Sol = 0; i_Sol < numEq; ++i_Sol) {
+                    for (dim_t i_Eq = 0; i_Eq < numEq; ++i_Eq) {
+                        const cplx_t a = array[INDEX4(i_Eq, i_Sol, k_Eq, k_Sol,
+                                                   numEq, numEq, numNodes)];
+                        realArray[INDEX4(2*i_Eq, 2*i_Sol, k_Eq, k_Sol, numEq2, numEq2, numNodes)] = a.real();
+                        realArray[INDEX4(2*i_Eq, 2*i_Sol+1, k_Eq, k_Sol, numEq2, numEq2, numNodes)] = -a.imag();
+                        realArray[INDEX4(2*i_Eq+1, 2*i_Sol, k_Eq, k_Sol, numEq2, numEq2, numNodes)] = a.imag();
+                        realArray[INDEX4(2*i_Eq+1, 2*i_Sol+1, k_Eq, k_Sol, numEq2, numEq2, numNodes)] = a.real();
+                    }
+                }
+            }
+        }
+        addToPasoMatrix(psm, nodes, numEq2, realArray);
         return;
     }
 #endif
@@ -1446,10 +1470,29 @@ void RipleyDomain::addToSystemMatrix<real_t>(escript::AbstractSystemMatrix* mat,
 
 //protected
 template<>
-void RipleyDomain::addToSystemMatrix<cplx_t>(escript::AbstractSystemMatrix* mat,
+void RipleyDomain::addToSystemMatrix<real_t>(escript::AbstractSystemMatrix* mat,
                                          const IndexVector& nodes, dim_t numEq,
-                                         const vector<cplx_t>& array) const
+                                         const DoubleVector& array) const
 {
+#ifdef ESYS_HAVE_PASO
+    paso::SystemMatrix* psm = dynamic_cast<paso::SystemMatrix*>(mat);
+    if (psm) {
+        if (psm->isComplex()) {
+            const vector<cplx_t> carray(array.begin(), array.end());
+            addToSystemMatrix<cplx_t>(mat, nodes, numEq, carray);
+        } else {
+            addToPasoMatrix(psm, nodes, numEq, array);
+        }
+        return;
+    }
+#endif
+#ifdef ESYS_HAVE_CUDA
+    SystemMatrix* rsm = dynamic_cast<SystemMatrix*>(mat);
+    if (rsm) {
+        rsm->add(nodes, array);
+        return;
+    }
+#endif
 #ifdef ESYS_HAVE_TRILINOS
     TrilinosMatrixAdapter* tm = dynamic_cast<TrilinosMatrixAdapter*>(mat);
     if (tm) {
@@ -1457,8 +1500,7 @@ void RipleyDomain::addToSystemMatrix<cplx_t>(escript::AbstractSystemMatrix* mat,
         return;
     }
 #endif
-    throw RipleyException("addToSystemMatrix: only Trilinos matrices support "
-                          "complex-valued assembly!");
+    throw RipleyException("addToSystemMatrix: unknown system matrix type");
 }
 
 #ifdef ESYS_HAVE_PASO
@@ -766,6 +766,14 @@ public:
     Assembler_ptr createAssemblerFromPython(std::string type,
                                      const boost::python::list& options) const;
 
+    /**
+       \brief
+       sets the extent of the element tiles used to parallelise assembly
+       over threads. Values <= 0 select the extent in that dimension
+       automatically.
+    */
+    void setAssemblyTiling(dim_t t0, dim_t t1, dim_t t2);
+
 
 protected:
     int m_numDim;
@@ -778,6 +786,8 @@ protected:
     std::vector<DiracPoint> m_diracPoints;
     IndexVector m_diracPointNodeIDs; //for borrowSampleID
     assembler_t assembler_type;
+    /// requested element tile extents for threaded assembly
+    dim_t m_tileSize[3];
 
     /// copies data in 'in' to 'out' (both must be on same function space)
     template<typename Scalar>
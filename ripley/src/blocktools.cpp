@@ -273,6 +273,32 @@ void Block::copyUsedFromBuffer(double* dest)
     }
 }
 
+// Every in-buffer other than the (nonexistent) centre one lies within inset
+// of at least one face so excluding the inset along each dimension in which
+// a used subblock sits at the start or end is sufficient.
+void Block::getUntouchedRegion(size_t lo[3], size_t hi[3]) const
+{
+    const size_t s[3]={sx, sy, sz};
+    for (int d=0;d<3;++d)
+    {
+	lo[d]=0;
+	hi[d]=s[d];
+    }
+    for (unsigned char i=0;i<27;++i)
+    {
+	if (!used[i])
+	    continue;
+	const unsigned char sub[3]={(unsigned char)(i%3), (unsigned char)((i/3)%3), (unsigned char)(i/9)};
+	for (int d=0;d<3;++d)
+	{
+	    if (sub[d]==0)
+		lo[d]=inset;
+	    else if (sub[d]==2)
+		hi[d]=s[d]-inset;
+	}
+    }
+}
+
 // s? specifiy the size (in points) of each dimension
 // maxb? gives the largest block number in each dimension in the overall grid (number from zero)
 Block::Block(size_t sx, size_t sy, size_t sz, size_t inset, size_t xmidlen, 
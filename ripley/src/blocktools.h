@@ -41,7 +41,8 @@
  * lowz -> highz.
  *
  * Please don't mix external calls into this file, it may be useful to separate
- * it for debugging purposes.
+ * it for debugging purposes. The one exception is BlockExchange at the end
+ * which moves the buffers of a block between MPI ranks.
  *
  * Types required:
  *     neighbourID_t - Stores the label of a neighbouring block.
@@ -158,6 +159,10 @@ public:
 
     void setUsed(unsigned char buffid);
 
+    // Computes the box [lo, hi) of points in the flat array which are not
+    // overwritten by copyUsedFromBuffer()
+    void getUntouchedRegion(size_t lo[3], size_t hi[3]) const;
+
 private:
 
     // determines the dimensions of each subblock
@@ -265,6 +270,10 @@ public:
 
     void setUsed(unsigned char buffid);
 
+    // Computes the box [lo, hi) of points in the flat array which are not
+    // overwritten by copyUsedFromBuffer()
+    void getUntouchedRegion(size_t lo[2], size_t hi[2]) const;
+
 private:
 
     // determines the dimensions of each subblock
@@ -301,5 +310,85 @@ int getTag2(unsigned char destx, unsigned char desty, bool deltax, bool deltay);
 // the booleans indicate whether a negative shift in that direction is required
 unsigned char getSrcBuffID2(unsigned char destx, unsigned char desty, bool deltax, bool deltay);
 
+
+#ifdef ESYS_MPI
+/* BlockExchange transfers the subblocks of a Block or Block2 without
+ * blocking so the caller can overlap communication with computation:
+ *
+ *     exchange.start(incoms, outcoms, src);
+ *     // work on points inside block.getUntouchedRegion(),
+ *     // optionally calling exchange.test() now and then
+ *     exchange.finish(src);
+ *     // work on the remaining points
+ *
+ * start() and finish() return false if any MPI call failed.
+*/
+template <typename B>
+class BlockExchange
+{
+public:
+    BlockExchange(B& b, MPI_Comm c) : block(b), comm(c), comserr(0) {}
+
+    ~BlockExchange()
+    {
+        // don't let MPI write into buffers which are about to disappear
+        if (!reqs.empty() && !comserr)
+            MPI_Waitall(reqs.size(), &reqs[0], MPI_STATUSES_IGNORE);
+    }
+
+    // Loads the out buffers from src and posts all receives and sends
+    bool start(const messvec& incoms, const messvec& outcoms, double* src)
+    {
+        block.copyAllToBuffer(src);
+        reqs.resize(incoms.size()+outcoms.size());
+        size_t rused=0;
+        for (size_t i=0; i < incoms.size(); ++i) {
+            const message& m = incoms[i];
+            comserr |= MPI_Irecv(block.getInBuffer(m.destbuffid),
+                                 block.getBuffSize(m.destbuffid), MPI_DOUBLE,
+                                 m.sourceID, m.tag, comm, &reqs[rused++]);
+            block.setUsed(m.destbuffid);
+        }
+        for (size_t i=0; i < outcoms.size(); ++i) {
+            const message& m = outcoms[i];
+            comserr |= MPI_Isend(block.getOutBuffer(m.srcbuffid),
+                                 block.getBuffSize(m.srcbuffid), MPI_DOUBLE,
+                                 m.destID, m.tag, comm, &reqs[rused++]);
+        }
+        return !comserr;
+    }
+
+    // Progresses outstanding transfers, returns true once all are complete
+    bool test()
+    {
+        if (reqs.empty() || comserr)
+            return true;
+        int done = 0;
+        comserr |= MPI_Testall(reqs.size(), &reqs[0], &done,
+                               MPI_STATUSES_IGNORE);
+        return done;
+    }
+
+    // Waits for all transfers and copies the received subblocks into dest
+    bool finish(double* dest)
+    {
+        if (!reqs.empty() && !comserr) {
+            comserr = MPI_Waitall(reqs.size(), &reqs[0], MPI_STATUSES_IGNORE);
+        }
+        reqs.clear();
+        if (comserr)
+            return false;
+        block.copyUsedFromBuffer(dest);
+        return true;
+    }
+
+private:
+    B& block;
+    MPI_Comm comm;
+    std::vector<MPI_Request> reqs;
+    int comserr;
+};
+#endif // ESYS_MPI
+
 #endif // __RIPLEY_BLOCKTOOLS_H__
 
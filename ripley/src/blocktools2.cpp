@@ -242,6 +242,30 @@ void Block2::copyUsedFromBuffer(double* dest)
     }
 }
 
+// see Block::getUntouchedRegion()
+void Block2::getUntouchedRegion(size_t lo[2], size_t hi[2]) const
+{
+    const size_t s[2]={sx, sy};
+    for (int d=0;d<2;++d)
+    {
+	lo[d]=0;
+	hi[d]=s[d];
+    }
+    for (unsigned char i=0;i<9;++i)
+    {
+	if (!used[i])
+	    continue;
+	const unsigned char sub[2]={(unsigned char)(i%3), (unsigned char)(i/3)};
+	for (int d=0;d<2;++d)
+	{
+	    if (sub[d]==0)
+		lo[d]=inset;
+	    else if (sub[d]==2)
+		hi[d]=s[d]-inset;
+	}
+    }
+}
+
 // s? specifiy the size (in points) of each dimension
 // maxb? gives the largest block number in each dimension in the overall grid (number from zero)
 Block2::Block2(size_t sx, size_t sy, size_t inset, size_t xmidlen, 
@@ -17,15 +17,30 @@
 
 #include <ripley/domainhelpers.h>
 #include <ripley/RipleyException.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 #ifdef ESYS_HAVE_BOOST_IO
+#include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #endif
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace ripley {
 
+/// upper limit in bytes for the buffer each rank uses in collective grid reads
+static const size_t GRID_READ_BUFFER_SIZE = 16*1024*1024;
+
 void factorise(std::vector<int>& factors, int product)
 {
     int current = product;
@@ -40,6 +55,250 @@ void factorise(std::vector<int>& factors, int product)
     }
 }
 
+/// returns the file index of the first entry of row 'row' of a block
+static dim_t getRowStart(int dims, const dim_t* size, const dim_t* start,
+                         const dim_t* count, dim_t row)
+{
+    dim_t fileIndex = start[dims-1];
+    dim_t stride = size[dims-1];
+    for (int i = dims-2; i >= 0; i--) {
+        fileIndex += (start[i] + row%count[i])*stride;
+        row /= count[i];
+        stride *= size[i];
+    }
+    return fileIndex;
+}
+
+dim_t getFileSize(escript::JMPI mpiInfo, const std::string& filename)
+{
+    long filesize = -1;
+    if (mpiInfo->rank == 0) {
+        std::ifstream f(filename.c_str(), std::ifstream::binary);
+        if (!f.fail()) {
+            f.seekg(0, std::ios::end);
+            filesize = f.tellg();
+        }
+    }
+#ifdef ESYS_MPI
+    if (mpiInfo->size > 1)
+        MPI_Bcast(&filesize, 1, MPI_LONG, 0, mpiInfo->comm);
+#endif
+    return filesize;
+}
+
+void readGridBlock(escript::JMPI mpiInfo, const std::string& filename,
+                   int dims, const dim_t* size, const dim_t* start,
+                   const dim_t* count, size_t entrySize,
+                   const GridRowHandler& handler)
+{
+    dim_t numEntries = 1;
+    for (int i = 0; i < dims; i++)
+        numEntries *= count[i];
+    // the block is processed one contiguous row of the fastest varying
+    // dimension at a time
+    const dim_t rowLength = (numEntries > 0 ? count[dims-1] : 1);
+    const dim_t numRows = numEntries/rowLength;
+    const size_t rowSize = rowLength*entrySize;
+
+    if (mpiInfo->size > 1) {
+#ifdef ESYS_MPI
+        MPI_File fileHandle;
+        int mpiErr = MPI_File_open(mpiInfo->comm,
+                const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY,
+                MPI_INFO_NULL, &fileHandle);
+        if (mpiErr != MPI_SUCCESS)
+            throw RipleyException("readGridBlock(): cannot open file " + filename);
+
+        // rows are fetched in rounds of at most GRID_READ_BUFFER_SIZE bytes
+        // per rank. Every rank takes part in every round of the collective
+        // reads, also after an error or once it has run out of rows.
+        const dim_t rowsPerRound = std::max(dim_t(1),
+                                    dim_t(GRID_READ_BUFFER_SIZE/rowSize));
+        long myRounds = (numRows+rowsPerRound-1)/rowsPerRound;
+        long numRounds = 0;
+        MPI_Allreduce(&myRounds, &numRounds, 1, MPI_LONG, MPI_MAX,
+                      mpiInfo->comm);
+        const dim_t bufferRows = std::min(numRows, rowsPerRound);
+        std::vector<char> buffer(bufferRows*rowSize);
+        std::vector<MPI_Aint> displacements(bufferRows);
+
+        MPI_Datatype entryType;
+        MPI_Type_contiguous(entrySize, MPI_BYTE, &entryType);
+        MPI_Type_commit(&entryType);
+        for (long round = 0; round < numRounds; round++) {
+            const dim_t firstRow = round*rowsPerRound;
+            const dim_t n = std::max(dim_t(0),
+                                     std::min(rowsPerRound, numRows-firstRow));
+            MPI_Datatype rowsType;
+            if (n > 0) {
+                for (dim_t r = 0; r < n; r++) {
+                    displacements[r] = getRowStart(dims, size, start, count,
+                                                   firstRow+r)*entrySize;
+                }
+                MPI_Type_create_hindexed_block(n, rowLength, &displacements[0],
+                                               entryType, &rowsType);
+            } else {
+                MPI_Type_dup(entryType, &rowsType);
+            }
+            MPI_Type_commit(&rowsType);
+            int err = MPI_File_set_view(fileHandle, 0, entryType, rowsType,
+                                  const_cast<char*>("native"), MPI_INFO_NULL);
+            if (err == MPI_SUCCESS) {
+                MPI_Status status;
+                err = MPI_File_read_all(fileHandle, buffer.data(), n*rowLength,
+                                        entryType, &status);
+            }
+            MPI_Type_free(&rowsType);
+            if (err != MPI_SUCCESS) {
+                mpiErr = err;
+            } else if (mpiErr == MPI_SUCCESS) {
+#pragma omp parallel for
+                for (dim_t r = 0; r < n; r++)
+                    handler(firstRow+r, &buffer[r*rowSize]);
+            }
+        }
+        MPI_Type_free(&entryType);
+        MPI_File_close(&fileHandle);
+        if (mpiErr != MPI_SUCCESS)
+            throw RipleyException("readGridBlock(): error reading from file " + filename);
+#endif
+    } else if (numEntries > 0) {
+#ifndef _WIN32
+        // map the file so rows are handed over straight from the page cache
+        // rather than going through the stream buffers
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw RipleyException("readGridBlock(): cannot open file " + filename);
+        struct stat st;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+            mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+            // the last row of the block ends furthest into the file
+            const dim_t endIndex = getRowStart(dims, size, start, count,
+                                               numRows-1) + rowLength;
+            if (endIndex*entrySize > size_t(st.st_size)) {
+                munmap(mapped, st.st_size);
+                throw RipleyException("readGridBlock(): error reading from file " + filename);
+            }
+            const char* data = static_cast<const char*>(mapped);
+#pragma omp parallel for
+            for (dim_t row = 0; row < numRows; row++) {
+                const dim_t fileIndex = getRowStart(dims, size, start, count, row);
+                handler(row, data+fileIndex*entrySize);
+            }
+            munmap(mapped, st.st_size);
+            return;
+        }
+#endif
+        std::ifstream f(filename.c_str(), std::ifstream::binary);
+        if (f.fail())
+            throw RipleyException("readGridBlock(): cannot open file " + filename);
+
+        std::vector<char> buffer(rowSize);
+        for (dim_t row = 0; row < numRows; row++) {
+            const dim_t fileIndex = getRowStart(dims, size, start, count, row);
+            f.seekg(fileIndex*entrySize);
+            f.read(&buffer[0], rowSize);
+            if (f.fail())
+                throw RipleyException("readGridBlock(): error reading from file " + filename);
+            handler(row, &buffer[0]);
+        }
+    }
+}
+
+void writeGridBlock(escript::JMPI mpiInfo, const std::string& filename,
+                    int dims, const dim_t* size, const dim_t* start,
+                    const dim_t* count, size_t entrySize, const char* buffer)
+{
+    dim_t numEntries = 1;
+    dim_t totalEntries = 1;
+    for (int i = 0; i < dims; i++) {
+        numEntries *= count[i];
+        totalEntries *= size[i];
+    }
+
+    if (mpiInfo->size > 1) {
+#ifdef ESYS_MPI
+        // remove file first if it exists
+        int error = 0;
+        if (mpiInfo->rank == 0) {
+            std::ifstream f(filename.c_str());
+            if (f.is_open()) {
+                f.close();
+                if (std::remove(filename.c_str()))
+                    error = 1;
+            }
+        }
+        int mpiErr;
+        MPI_Allreduce(&error, &mpiErr, 1, MPI_INT, MPI_MAX, mpiInfo->comm);
+        if (mpiErr != 0)
+            throw RipleyException("writeGridBlock(): error removing " + filename);
+
+        MPI_File fileHandle;
+        mpiErr = MPI_File_open(mpiInfo->comm,
+                const_cast<char*>(filename.c_str()),
+                MPI_MODE_CREATE|MPI_MODE_WRONLY|MPI_MODE_UNIQUE_OPEN,
+                MPI_INFO_NULL, &fileHandle);
+        if (mpiErr != MPI_SUCCESS)
+            throw RipleyException("writeGridBlock(): cannot open file " + filename);
+
+        MPI_Datatype entryType, blockType;
+        MPI_Type_contiguous(entrySize, MPI_BYTE, &entryType);
+        MPI_Type_commit(&entryType);
+        if (numEntries > 0) {
+            std::vector<int> sizes(dims), subsizes(dims), starts(dims);
+            for (int i = 0; i < dims; i++) {
+                sizes[i] = size[i];
+                subsizes[i] = count[i];
+                starts[i] = start[i];
+            }
+            MPI_Type_create_subarray(dims, &sizes[0], &subsizes[0],
+                                     &starts[0], MPI_ORDER_C, entryType,
+                                     &blockType);
+        } else {
+            // ranks without data still take part in the collective write
+            MPI_Type_dup(entryType, &blockType);
+        }
+        MPI_Type_commit(&blockType);
+        mpiErr = MPI_File_set_size(fileHandle, totalEntries*entrySize);
+        if (mpiErr == MPI_SUCCESS) {
+            mpiErr = MPI_File_set_view(fileHandle, 0, entryType, blockType,
+                                  const_cast<char*>("native"), MPI_INFO_NULL);
+        }
+        if (mpiErr == MPI_SUCCESS) {
+            MPI_Status status;
+            mpiErr = MPI_File_write_all(fileHandle, const_cast<char*>(buffer),
+                                        numEntries, entryType, &status);
+        }
+        MPI_Type_free(&blockType);
+        MPI_Type_free(&entryType);
+        MPI_File_close(&fileHandle);
+        if (mpiErr != MPI_SUCCESS)
+            throw RipleyException("writeGridBlock(): error writing to file " + filename);
+#endif
+    } else {
+        std::ofstream f(filename.c_str(), std::ofstream::binary);
+        if (f.fail())
+            throw RipleyException("writeGridBlock(): cannot open file " + filename);
+        if (totalEntries > 0)
+            f.seekp(totalEntries*entrySize-1).put(0);
+
+        // write one contiguous row of the fastest varying dimension at a time
+        const dim_t rowLength = (numEntries > 0 ? count[dims-1] : 1);
+        const dim_t numRows = numEntries/rowLength;
+        for (dim_t row = 0; row < numRows; row++) {
+            const dim_t fileIndex = getRowStart(dims, size, start, count, row);
+            f.seekp(fileIndex*entrySize);
+            f.write(buffer+row*rowLength*entrySize, rowLength*entrySize);
+        }
+        if (f.fail())
+            throw RipleyException("writeGridBlock(): error writing to file " + filename);
+    }
+}
+
 #ifdef ESYS_HAVE_BOOST_IO
 std::vector<char> unzip(const std::vector<char>& compressed)
 {
@@ -67,6 +326,46 @@ std::vector<char> unzip(const std::vector<char>& compressed)
     }
     return decompressed;
 }
+
+void readZippedGridBlock(const std::string& filename, int dims,
+                         const dim_t* size, const dim_t* start,
+                         const dim_t* count, size_t entrySize,
+                         const GridRowHandler& handler)
+{
+    dim_t numEntries = 1;
+    for (int i = 0; i < dims; i++)
+        numEntries *= count[i];
+    if (numEntries == 0)
+        return;
+
+    boost::iostreams::filtering_istream in;
+    in.push(boost::iostreams::gzip_decompressor());
+    in.push(boost::iostreams::file_source(filename, std::ios::binary));
+    if (!in.component<boost::iostreams::file_source>(1)->is_open())
+        throw RipleyException("readBinaryGridFromZipped(): cannot open file " + filename);
+
+    // rows of the block appear in increasing file order so the stream is
+    // decompressed once, skipping everything outside the block
+    const dim_t rowLength = count[dims-1];
+    const dim_t numRows = numEntries/rowLength;
+    std::vector<char> buffer(rowLength*entrySize);
+    dim_t streamPos = 0;
+    try {
+        for (dim_t row = 0; row < numRows; row++) {
+            const dim_t fileIndex = getRowStart(dims, size, start, count, row);
+            const std::streamsize skip = (fileIndex-streamPos)*entrySize;
+            if (skip > 0)
+                in.ignore(skip);
+            in.read(&buffer[0], buffer.size());
+            if (!in)
+                throw RipleyException("readBinaryGridFromZipped(): not enough data in file");
+            handler(row, &buffer[0]);
+            streamPos = fileIndex+rowLength;
+        }
+    } catch (boost::iostreams::gzip_error& e) {
+        throw RipleyException("readBinaryGridFromZipped(): decompressing failed");
+    }
+}
 #endif
 
 } // namespace ripley
@@ -20,6 +20,8 @@
 #include <ripley/Ripley.h>
 #include <escript/Data.h>
 
+#include <functional>
+
 namespace ripley {
 
 typedef std::map<std::string, escript::Data> DataMap;
@@ -60,11 +62,65 @@ inline void doublyLink(std::vector<ripley::IndexVector>& va,
 */
 void factorise(std::vector<int>& factors, int product);
 
+/**
+    returns the size of file 'filename' in bytes or -1 if the file cannot be
+    opened. The size is determined on the first rank and broadcast so this
+    must be called by all ranks of 'mpiInfo'.
+*/
+dim_t getFileSize(escript::JMPI mpiInfo, const std::string& filename);
+
+/**
+    receives row 'row' of a grid block read by readGridBlock(), i.e. the
+    count[dims-1] consecutive entries of the fastest varying dimension at
+    block index 'row' of the remaining dimensions (the last of which varies
+    fastest). 'data' is only valid during the call.
+*/
+typedef std::function<void(dim_t row, const char* data)> GridRowHandler;
+
+/**
+    reads the block of count[0] x ... x count[dims-1] entries starting at
+    index 'start' of a row-major grid of global extent 'size' (slowest
+    varying dimension first) stored in 'filename'. Each entry consists of
+    'entrySize' bytes. The block is passed to 'handler' one row at a time
+    so it is never held in memory as a whole. Rows may be handed over
+    concurrently from several threads.
+    With more than one rank the rows are fetched in a few collective MPI-IO
+    reads of bounded size so all ranks of 'mpiInfo' must call this
+    function, ranks without data pass a zero count.
+*/
+void readGridBlock(escript::JMPI mpiInfo, const std::string& filename,
+                   int dims, const dim_t* size, const dim_t* start,
+                   const dim_t* count, size_t entrySize,
+                   const GridRowHandler& handler);
+
+/**
+    writes the block of count[0] x ... x count[dims-1] entries in 'buffer'
+    to index 'start' of a row-major grid of global extent 'size' (slowest
+    varying dimension first) in 'filename', replacing any existing file.
+    Each entry consists of 'entrySize' bytes. With more than one rank all
+    blocks are written with a single collective MPI-IO call so all ranks of
+    'mpiInfo' must call this function, ranks without data pass a zero count.
+*/
+void writeGridBlock(escript::JMPI mpiInfo, const std::string& filename,
+                    int dims, const dim_t* size, const dim_t* start,
+                    const dim_t* count, size_t entrySize, const char* buffer);
+
 #ifdef ESYS_HAVE_BOOST_IO
 /**
     converts the given gzip compressed char vector into an uncompressed form 
 */
 std::vector<char> unzip(const std::vector<char>& compressed);
+
+/**
+    like readGridBlock() but for a gzip compressed grid file. The file is
+    decompressed as a stream and only one row of the requested block is
+    held in memory at a time. Rows are handed over in order from the calling
+    thread. Every rank reads the file independently.
+*/
+void readZippedGridBlock(const std::string& filename, int dims,
+                         const dim_t* size, const dim_t* start,
+                         const dim_t* count, size_t entrySize,
+                         const GridRowHandler& handler);
 #endif // ESYS_HAVE_BOOST_IO
 
 } // namespace ripley
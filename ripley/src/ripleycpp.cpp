@@ -632,6 +632,15 @@ BOOST_PYTHON_MODULE(ripleycpp)
             "supported, using the supplied options (if provided)"
             ":param typename:\n:type typename: `string`\n"
             ":param options:\n:type options: `list`\n")
+        .def("setAssemblyTiling", &ripley::RipleyDomain::setAssemblyTiling,
+                (arg("t0")=0, arg("t1")=0, arg("t2")=0),
+                "Sets the extent of the element tiles used to assemble PDEs "
+                "with multiple threads. Tiles are coloured so that tiles of "
+                "the same colour are assembled concurrently. A value of 0 "
+                "selects the extent in that direction automatically.\n\n"
+                ":param t0: number of elements per tile in direction 0\n:type t0: ``int``\n"
+                ":param t1: number of elements per tile in direction 1\n:type t1: ``int``\n"
+                ":param t2: number of elements per tile in direction 2\n:type t2: ``int``")
         .def("addPDEToTransportProblem",&ripley::RipleyDomain::addPDEToTransportProblemFromPython,
             args("tp", "source", "data"),
             ":param tp:\n:type tp: `TransportProblemAdapter`\n"
@@ -337,6 +337,24 @@ class Test_RipleyLameAssemblers3D(RipleyLameAssemblerTestBase):
     def tearDown(self):
         del self.domain
 
+class Test_RipleyAssemblyTiling3D(RipleyLameAssemblerTestBase):
+    def setUp(self):
+        self.domain = Brick(9,10,11)
+
+    def tearDown(self):
+        del self.domain
+
+    def test_tilingIndependence(self):
+        #result must not depend on the tile shape used for threaded assembly
+        for fast in (False, True):
+            self.domain.setAssemblyTiling()
+            ref = self.run_lame(fast, EXPANDED)
+            for tiles in ((9,10,1), (1,1,1), (2,3,4), (100,100,100)):
+                self.domain.setAssemblyTiling(*tiles)
+                res = self.run_lame(fast, EXPANDED)
+                self.assertLess(Lsup(ref - res), 1e-8,
+                        "Solution differs for assembly tiling %s"%str(tiles))
+
 
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
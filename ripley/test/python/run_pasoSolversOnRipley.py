@@ -31,7 +31,9 @@ from test_simplesolve import SimpleSolveTestCase
 import esys.escriptcore.utestselect as unittest
 from esys.escriptcore.testing import *
 
-from esys.escript import getMPISizeWorld, hasFeature, sqrt
+from esys.escript import getMPISizeWorld, hasFeature, sqrt, Lsup, \
+                         Solution, inner, kronecker, whereZero
+from esys.escript.linearPDEs import LinearPDE
 from esys.ripley import Rectangle, Brick
 from esys.escript.linearPDEs import SolverOptions
 
@@ -139,7 +141,52 @@ class Test_SimpleSolveRipley3D_Paso_TFQMR_RILU(SimpleSolveOnPaso):
     def tearDown(self):
         del self.domain
 
+@unittest.skipIf(not HAVE_PASO, "PASO not available")
+class ComplexSolveOnPaso(unittest.TestCase):
+    """
+    solves -div(grad(u)) + D*u = Y with complex D and a complex linear
+    exact solution using the real equivalent form of the paso matrix
+    """
+    REL_TOL = 1.e-6
+    SOLVER_TOL = 1.e-8
+    D = 1.+2.j
+
+    def test_single(self):
+        dim = self.domain.getDim()
+        x = Solution(self.domain).getX()
+        g_ex = [(2.-1.j), (3.+0.5j), (-1.+4.j)][:dim]
+        u_ex = (1.+1.j) + sum(g_ex[i]*x[i] for i in range(dim))
+        pde = LinearPDE(self.domain, numEquations=1, isComplex=True)
+        pde.setValue(A=kronecker(dim), D=self.D, Y=self.D*u_ex,
+                     y=inner(g_ex, self.domain.getNormal()),
+                     q=whereZero(x[0]), r=u_ex)
+        so = pde.getSolverOptions()
+        so.setPackage(SolverOptions.PASO)
+        so.setSolverMethod(self.method)
+        so.setPreconditioner(self.preconditioner)
+        so.setTolerance(self.SOLVER_TOL)
+        u = pde.getSolution()
+        self.assertTrue(u.isComplex())
+        error = Lsup(u-u_ex)
+        self.assertLess(error, self.REL_TOL*Lsup(u_ex), "solution error %s is too big."%error)
+
+class Test_ComplexSolveRipley2D_Paso_BICGSTAB_Jacobi(ComplexSolveOnPaso):
+    def setUp(self):
+        self.domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        self.method = SolverOptions.BICGSTAB
+        self.preconditioner = SolverOptions.JACOBI
+
+    def tearDown(self):
+        del self.domain
+
+class Test_ComplexSolveRipley3D_Paso_GMRES_ILU0(ComplexSolveOnPaso):
+    def setUp(self):
+        self.domain = Brick(n0=NE0*NXb-1, n1=NE1*NYb-1, n2=NE2*NZb-1, d0=NXb, d1=NYb, d2=NZb)
+        self.method = SolverOptions.GMRES
+        self.preconditioner = SolverOptions.ILU0
+
+    def tearDown(self):
+        del self.domain
 
 if __name__ == '__main__':
    run_tests(__name__, exit_on_failure=True)
-
@@ -110,6 +110,25 @@ class WriteBinaryGridTestBase(unittest.TestCase): #subclassing required
             self.assertAlmostEqual(Lsup(ref-result), 0, delta=1e-9,
                     msg="Data doesn't match for "+str(ftype(self.domain)))
 
+    def test_writeVectorGrid3D(self):
+        self.NE = [self.NX, self.NX, self.NZ]
+        self.domain = Brick(self.NE[0], self.NE[1], self.NE[2], d2=0)
+        for ftype,fcode in [(ReducedFunction,'RFv'), (ContinuousFunction,'CFv')]:
+            data, ref = self.generateUniqueData(ftype)
+            vdata = Vector(0., ftype(self.domain))
+            vdata[0] = data
+            vdata[1] = 2*data
+            vdata[2] = -data
+            filename = os.path.join(RIPLEY_WORKDIR, "_wgrid3d%s"%fcode)
+            filename = filename + self.dtype.replace('<','L').replace('>','B')
+            self.domain.writeBinaryGrid(vdata, filename, self.byteorder, self.datatype)
+            MPIBarrierWorld()
+            result = np.fromfile(filename, dtype=self.dtype).reshape(
+                    tuple(reversed(adjust(self.NE,ftype)))+(3,))
+            for i,f in enumerate((1,2,-1)):
+                self.assertAlmostEqual(Lsup(f*ref-result[...,i]), 0, delta=1e-9,
+                        msg="Component %d doesn't match for %s"%(i,str(ftype(self.domain))))
+
 class Test_writeBinaryGridRipley_LITTLE_FLOAT32(WriteBinaryGridTestBase):
     def setUp(self):
         self.byteorder = BYTEORDER_LITTLE_ENDIAN
@@ -19,6 +19,7 @@
 #define __Speckley_BRICK_H__
 
 #include <speckley/SpeckleyDomain.h>
+#include <escript/ElementTiling.h>
 
 namespace speckley {
 
@@ -333,6 +334,11 @@ private:
 
     dim_t findNode(const double *coords) const;
 
+    /// returns the colouring of element tiles used for threaded assembly
+    escript::ElementTiling getElementTiling() const {
+        return escript::ElementTiling(m_NE, m_tileSize);
+    }
+
 
     escript::Data randomFillWorker(const escript::DataTypes::ShapeType& shape,
        long seed, const boost::python::tuple& filter) const;
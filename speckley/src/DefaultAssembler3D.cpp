@@ -265,7 +265,6 @@ void DefaultAssembler3D::assemblePDESystem(AbstractSystemMatrix* mat, Data& rhs,
     const double volume_product = m_dx[0]*m_dx[1]*m_dx[2]/8.;
     const int NE0 = m_NE[0];
     const int NE1 = m_NE[1];
-    const int NE2 = m_NE[2];
     const int quads = order + 1;
     const int max_x = m_NN[0];
     const int max_y = m_NN[1];
@@ -297,11 +296,18 @@ void DefaultAssembler3D::assemblePDESystem(AbstractSystemMatrix* mat, Data& rhs,
     if (!D.isEmpty() && (!X.isEmpty() || !Y.isEmpty()))
         throw SpeckleyException("assemblers can't deal with adding both lhs and rhs right now");
 
-    for (dim_t colouring = 0; colouring < 2; colouring++) {
+    const escript::ElementTiling tiling(domain->getElementTiling());
+    for (int colour = 0; colour < tiling.getNumColours(); colour++) {
+        const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp parallel for
-        for (dim_t ez = colouring; ez < NE2; ez += 2) {
-            for (dim_t ey = 0; ey < NE1; ey++) {
-                for (dim_t ex = 0; ex < NE0; ex++) {
+        for (dim_t tile = 0; tile < numTiles; tile++) {
+            index_t first[3], last[3];
+            tiling.getTileRange(colour, tile, first, last);
+            const dim_t tileNE1 = last[1] - first[1];
+            for (dim_t row = 0; row < tileNE1*(last[2] - first[2]); row++) {
+                const dim_t ey = first[1] + row % tileNE1;
+                const dim_t ez = first[2] + row / tileNE1;
+                for (dim_t ex = first[0]; ex < last[0]; ex++) {
                     const index_t e_index = INDEX3(ex,ey,ez,NE0,NE1); //element number for Elements
                     const index_t start = order * (INDEX3(ex, ey, ez, max_x, max_y)); //node start for Nodes
                     if (!D.isEmpty()) {
@@ -450,7 +456,6 @@ void DefaultAssembler3D::assembleComplexPDESystem(AbstractSystemMatrix* mat, Dat
     const double volume_product = m_dx[0]*m_dx[1]*m_dx[2]/8.;
     const int NE0 = m_NE[0];
     const int NE1 = m_NE[1];
-    const int NE2 = m_NE[2];
     const int quads = order + 1;
     const int max_x = m_NN[0];
     const int max_y = m_NN[1];
@@ -482,11 +487,18 @@ void DefaultAssembler3D::assembleComplexPDESystem(AbstractSystemMatrix* mat, Dat
     if (!D.isEmpty() && (!X.isEmpty() || !Y.isEmpty()))
         throw SpeckleyException("assemblers can't deal with adding both lhs and rhs right now");
 
-    for (dim_t colouring = 0; colouring < 2; colouring++) {
+    const escript::ElementTiling tiling(domain->getElementTiling());
+    for (int colour = 0; colour < tiling.getNumColours(); colour++) {
+        const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp parallel for
-        for (dim_t ez = colouring; ez < NE2; ez += 2) {
-            for (dim_t ey = 0; ey < NE1; ey++) {
-                for (dim_t ex = 0; ex < NE0; ex++) {
+        for (dim_t tile = 0; tile < numTiles; tile++) {
+            index_t first[3], last[3];
+            tiling.getTileRange(colour, tile, first, last);
+            const dim_t tileNE1 = last[1] - first[1];
+            for (dim_t row = 0; row < tileNE1*(last[2] - first[2]); row++) {
+                const dim_t ey = first[1] + row % tileNE1;
+                const dim_t ez = first[2] + row / tileNE1;
+                for (dim_t ex = first[0]; ex < last[0]; ex++) {
                     const index_t e_index = INDEX3(ex,ey,ez,NE0,NE1); //element number for Elements
                     const index_t start = order * (INDEX3(ex, ey, ez, max_x, max_y)); //node start for Nodes
                     if (!D.isEmpty()) {
@@ -687,7 +699,6 @@ void DefaultAssembler3D::assemblePDESingle(escript::AbstractSystemMatrix *mat,
     const double volume_product = m_dx[0]*m_dx[1]*m_dx[2]/8.;
     const int NE0 = m_NE[0];
     const int NE1 = m_NE[1];
-    const int NE2 = m_NE[2];
     const int quads = order + 1;
     const int max_x = m_NN[0];
     const int max_y = m_NN[1];
@@ -697,11 +708,18 @@ void DefaultAssembler3D::assemblePDESingle(escript::AbstractSystemMatrix *mat,
     if (!D.isEmpty() && (!X.isEmpty() || !Y.isEmpty()))
         throw SpeckleyException("assemblers can't deal with adding both lhs and rhs right now");
 
-    for (dim_t colouring = 0; colouring < 2; colouring++) {
+    const escript::ElementTiling tiling(domain->getElementTiling());
+    for (int colour = 0; colour < tiling.getNumColours(); colour++) {
+        const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp parallel for
-        for (dim_t ez = colouring; ez < NE2; ez += 2) {
-            for (dim_t ey = 0; ey < NE1; ey++) {
-                for (dim_t ex = 0; ex < NE0; ex++) {
+        for (dim_t tile = 0; tile < numTiles; tile++) {
+            index_t first[3], last[3];
+            tiling.getTileRange(colour, tile, first, last);
+            const dim_t tileNE1 = last[1] - first[1];
+            for (dim_t row = 0; row < tileNE1*(last[2] - first[2]); row++) {
+                const dim_t ey = first[1] + row % tileNE1;
+                const dim_t ez = first[2] + row / tileNE1;
+                for (dim_t ex = first[0]; ex < last[0]; ex++) {
                     const index_t e_index = INDEX3(ex,ey,ez,NE0,NE1); //element number for Elements
                     const index_t start = order * (INDEX3(ex, ey, ez, max_x, max_y)); //node start for Nodes
                     if (!D.isEmpty()) {
@@ -840,7 +858,6 @@ void DefaultAssembler3D::assembleComplexPDESingle(escript::AbstractSystemMatrix
     const double volume_product = m_dx[0]*m_dx[1]*m_dx[2]/8.;
     const int NE0 = m_NE[0];
     const int NE1 = m_NE[1];
-    const int NE2 = m_NE[2];
     const int quads = order + 1;
     const int max_x = m_NN[0];
     const int max_y = m_NN[1];
@@ -850,11 +867,18 @@ void DefaultAssembler3D::assembleComplexPDESingle(escript::AbstractSystemMatrix
     if (!D.isEmpty() && (!X.isEmpty() || !Y.isEmpty()))
         throw SpeckleyException("assemblers can't deal with adding both lhs and rhs right now");
 
-    for (dim_t colouring = 0; colouring < 2; colouring++) {
+    const escript::ElementTiling tiling(domain->getElementTiling());
+    for (int colour = 0; colour < tiling.getNumColours(); colour++) {
+        const dim_t numTiles = tiling.getNumTiles(colour);
 #pragma omp parallel for
-        for (dim_t ez = colouring; ez < NE2; ez += 2) {
-            for (dim_t ey = 0; ey < NE1; ey++) {
-                for (dim_t ex = 0; ex < NE0; ex++) {
+        for (dim_t tile = 0; tile < numTiles; tile++) {
+            index_t first[3], last[3];
+            tiling.getTileRange(colour, tile, first, last);
+            const dim_t tileNE1 = last[1] - first[1];
+            for (dim_t row = 0; row < tileNE1*(last[2] - first[2]); row++) {
+                const dim_t ey = first[1] + row % tileNE1;
+                const dim_t ez = first[2] + row / tileNE1;
+                for (dim_t ex = first[0]; ex < last[0]; ex++) {
                     const index_t e_index = INDEX3(ex,ey,ez,NE0,NE1); //element number for Elements
                     const index_t start = order * (INDEX3(ex, ey, ez, max_x, max_y)); //node start for Nodes
                     if (!D.isEmpty()) {
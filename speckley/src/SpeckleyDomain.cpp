@@ -59,6 +59,7 @@ SpeckleyDomain::SpeckleyDomain(dim_t dim, int order, escript::SubWorld_ptr p) :
         m_mpiInfo = p->getMPI();
 
     assembler_type = DEFAULT_ASSEMBLER;
+    m_tileSize[0] = m_tileSize[1] = m_tileSize[2] = 0;
 }
 
 SpeckleyDomain::~SpeckleyDomain()
@@ -748,6 +749,13 @@ Assembler_ptr SpeckleyDomain::createAssemblerFromPython(const string type,
     return createAssembler(type, mapping);
 }
 
+void SpeckleyDomain::setAssemblyTiling(dim_t t0, dim_t t1, dim_t t2)
+{
+    m_tileSize[0] = t0;
+    m_tileSize[1] = t1;
+    m_tileSize[2] = t2;
+}
+
 void SpeckleyDomain::addToRHSFromPython(escript::Data& rhs,
             const bp::list& data, Assembler_ptr assembler) const
 {
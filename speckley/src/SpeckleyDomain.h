@@ -729,6 +729,14 @@ public:
     Assembler_ptr createAssemblerFromPython(const std::string type,
                                 const boost::python::list& options) const;
 
+    /**
+       \brief
+       sets the extent of the element tiles used to parallelise assembly
+       over threads. Values <= 0 select the extent in that dimension
+       automatically.
+    */
+    void setAssemblyTiling(dim_t t0, dim_t t1, dim_t t2);
+
     /**
        \brief
        returns the lengths of the domain
@@ -751,6 +759,8 @@ protected:
     std::vector<DiracPoint> m_diracPoints;
     IndexVector m_diracPointNodeIDs; //for borrowSampleID
     assembler_t assembler_type;
+    /// requested element tile extents for threaded assembly
+    dim_t m_tileSize[3];
     /// element order (will be m_order + 1 quad points in each axis)
     int m_order;
     
@@ -280,5 +280,45 @@ class Test_Complex_Assembler(unittest.TestCase):
         self.assertTrue(Lsup(pde.getSolution())==1.0, "Failed test_complex_params_Brick")
         del domain
 
+class Test_SpeckleyAssemblyTiling3D(unittest.TestCase):
+    def setUp(self):
+        self.domain = Brick(3, 5, 6, 7, l0=5., l1=6., l2=7.)
+
+    def tearDown(self):
+        del self.domain
+
+    def solve_single(self, isComplex):
+        pde = LinearSinglePDE(self.domain, isComplex=isComplex)
+        pde.getSolverOptions().setSolverMethod(SolverOptions.HRZ_LUMPING)
+        x = Function(self.domain).getX()
+        D = 1. + x[0]*x[1] + x[2]**2
+        if isComplex:
+            D = D + 1j*x[0]
+        pde.setValue(D=D, Y=sin(x[0]) + x[1]*x[2])
+        return pde.getSolution()
+
+    def solve_wave(self):
+        c = {}
+        for name in ("c11", "c12", "c13", "c33", "c44", "c66"):
+            c[name] = Scalar(float(name[1:]), ReducedFunction(self.domain))
+        pde = WavePDE(self.domain, list(c.items()))
+        pde.getSolverOptions().setSolverMethod(SolverOptions.HRZ_LUMPING)
+        X = self.domain.getX()
+        pde.setValue(D=2500.*kronecker(3), du=grad(X*X))
+        return pde.getSolution()
+
+    def test_tilingIndependence(self):
+        #result must not depend on the tile shape used for threaded assembly
+        solvers = (lambda: self.solve_single(False),
+                   lambda: self.solve_single(True), self.solve_wave)
+        for solve in solvers:
+            self.domain.setAssemblyTiling()
+            ref = solve()
+            for tiles in ((5,6,1), (1,1,1), (2,3,4), (100,100,100)):
+                self.domain.setAssemblyTiling(*tiles)
+                res = solve()
+                self.assertLess(Lsup(ref - res), 1e-12*Lsup(ref),
+                        "Solution differs for assembly tiling %s"%str(tiles))
+
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
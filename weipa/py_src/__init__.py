@@ -25,7 +25,7 @@ http://www.apache.org/licenses/LICENSE-2.0"""
 __url__="https://launchpad.net/escript-finley"
 
 from esys.escript import convertToNumpy, hasFeature
-from .weipacpp import visitInitialize, visitPublishData
+from .weipacpp import visitInitialize, visitPublishData, AsyncWriter
 
 __nodocorecursion=['weipacpp']
 
@@ -77,7 +77,13 @@ def createDataset(domain=None, **data):
     objects. The returned object provides methods to access and export data.
     """
     from .weipacpp import EscriptDataset
-    dataset=EscriptDataset()
+    return initDataset(EscriptDataset(), domain, **data)
+
+def initDataset(dataset, domain=None, **data):
+    """
+    Sets the domain and adds the `Data` objects to an esys.weipa dataset or
+    `AsyncWriter` and returns it.
+    """
     domain,new_data=interpolateEscriptData(domain, data)
     dataset.setDomain(domain)
     for n,d in sorted(new_data.items()):
@@ -86,7 +92,7 @@ def createDataset(domain=None, **data):
     return dataset
 
 def saveSilo(filename, domain=None, write_meshdata=False, time=0., cycle=0,
-        **data):
+        writer=None, **data):
     """
     Writes `Data` objects and their mesh to a file using the SILO file format.
 
@@ -112,19 +118,26 @@ def saveSilo(filename, domain=None, write_meshdata=False, time=0., cycle=0,
     :type time: ``float``
     :param cycle: the cycle (or timestep) of the data
     :type cycle: ``int``
+    :param writer: if given, the file is written in the background by this
+                   writer and the function returns immediately
+    :type writer: `AsyncWriter`
     :keyword <name>: writes the assigned value to the Silo file using <name> as
                      identifier
     :note: All data objects have to be defined on the same domain but they may
            be defined on separate `FunctionSpace` s.
     """
 
-    dataset = createDataset(domain, **data)
+    if writer is None:
+        dataset = createDataset(domain, **data)
+    else:
+        dataset = initDataset(writer, domain, **data)
     dataset.setCycleAndTime(cycle, time)
     dataset.setSaveMeshData(write_meshdata)
     return dataset.saveSilo(filename)
 
 def saveVTK(filename, domain=None, metadata='', metadata_schema=None,
-        write_meshdata=False, time=0., cycle=0, **data):
+        write_meshdata=False, time=0., cycle=0, binary=False, pvtu=False,
+        double_precision=False, compress=False, writer=None, **data):
     """
     Writes `Data` objects and their mesh to a file using the VTK XML file
     format.
@@ -172,13 +185,33 @@ def saveVTK(filename, domain=None, metadata='', metadata_schema=None,
     :type time: ``float``
     :param cycle: the cycle (or timestep) of the data
     :type cycle: ``int``
+    :param binary: whether to write the values as raw binary data appended
+                   to the file instead of text. This is much faster and
+                   produces smaller files.
+    :type binary: ``bool``
+    :param pvtu: whether every rank writes its own binary piece
+                 ('<filename>_<rank>.vtu') referenced by a '.pvtu' file
+                 instead of all ranks writing to one file
+    :type pvtu: ``bool``
+    :param double_precision: whether to write binary values as 64-bit
+                             instead of 32-bit floats
+    :type double_precision: ``bool``
+    :param compress: whether to compress the pieces with zlib. Requires
+                     ``pvtu=True`` and escript built with compression support.
+    :type compress: ``bool``
+    :param writer: if given, the file is written in the background by this
+                   writer and the function returns immediately
+    :type writer: `AsyncWriter`
     :note: All data objects have to be defined on the same domain. They may not
            be in the same `FunctionSpace` but not all combinations of
            `FunctionSpace` s can be written to a single VTK file.
            Typically, data on the boundary and on the interior cannot be mixed.
     """
 
-    dataset = createDataset(domain, **data)
+    if writer is None:
+        dataset = createDataset(domain, **data)
+    else:
+        dataset = initDataset(writer, domain, **data)
     dataset.setCycleAndTime(cycle, time)
     ss=''
     ms=''
@@ -192,7 +225,7 @@ def saveVTK(filename, domain=None, metadata='', metadata_schema=None,
             ss=metadata_schema
     dataset.setMetadataSchemaString(ss.strip(), ms.strip())
     dataset.setSaveMeshData(write_meshdata)
-    return dataset.saveVTK(filename)
+    return dataset.saveVTK(filename, binary, pvtu, double_precision, compress)
 
 def saveVoxet(filename, **data):
     """
@@ -0,0 +1,365 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+#include <weipa/AsyncWriter.h>
+#include <weipa/EscriptDataset.h>
+#include <weipa/WeipaException.h>
+
+#include <iostream>
+
+using namespace std;
+
+namespace weipa {
+
+/// everything needed to convert and write one dataset. The Data objects
+/// are copies sharing their values with the originals until those are
+/// modified.
+struct DatasetSnapshot
+{
+    escript::const_Domain_ptr domain;
+    vector<escript::Data> data;
+    StringVec names;
+    StringVec units;
+    int cycle;
+    double time;
+    string mdSchema, mdString;
+    bool wantsMeshVars;
+
+    string fileName;
+    bool silo;
+    bool useMultiMesh;
+    bool binary, perRankFiles, doublePrecision, compress;
+
+    /// write on the calling thread, e.g. if MPI is not thread-safe
+    bool synchronous;
+#if WEIPA_HAVE_MPI
+    /// communicator for the dataset, MPI_COMM_NULL to use the domain's
+    MPI_Comm comm;
+#endif
+};
+
+//
+// Constructor
+//
+AsyncWriter::AsyncWriter(int maxPending) :
+    maxPending(max(maxPending, 1)),
+    numPending(0),
+    stopping(false)
+#if WEIPA_HAVE_MPI
+    , domainComm(MPI_COMM_NULL),
+    ioComm(MPI_COMM_NULL)
+#endif
+{
+    worker = thread(&AsyncWriter::run, this);
+}
+
+//
+// Destructor
+//
+AsyncWriter::~AsyncWriter()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    worker.join();
+    finished.clear();
+    if (!error.empty()) {
+        cerr << "AsyncWriter: " << error << endl;
+    }
+#if WEIPA_HAVE_MPI
+    int mpiFinalized = 0;
+    MPI_Finalized(&mpiFinalized);
+    if (ioComm != MPI_COMM_NULL && !mpiFinalized) {
+        MPI_Comm_free(&ioComm);
+    }
+#endif
+}
+
+//
+//
+//
+bool AsyncWriter::setDomain(const escript::AbstractDomain* domain)
+{
+    current.reset();
+    if (!domain) {
+        cerr << "Domain is NULL!" << endl;
+        return false;
+    }
+
+    DatasetSnapshot_ptr snap(new DatasetSnapshot);
+    snap->domain = domain->getPtr();
+    snap->cycle = 0;
+    snap->time = 0.;
+    snap->wantsMeshVars = false;
+    snap->synchronous = false;
+#if WEIPA_HAVE_MPI
+    snap->comm = MPI_COMM_NULL;
+    if (domain->getMPISize() > 1) {
+        int threadLevel;
+        MPI_Query_thread(&threadLevel);
+        if (threadLevel < MPI_THREAD_MULTIPLE) {
+            snap->synchronous = true;
+        } else {
+            // the I/O thread gets its own communicator so its collective
+            // calls cannot interfere with the ones of the simulation
+            if (ioComm == MPI_COMM_NULL || domainComm != domain->getMPIComm()) {
+                // pending datasets may still be using the old one
+                wait();
+                if (ioComm != MPI_COMM_NULL)
+                    MPI_Comm_free(&ioComm);
+                domainComm = domain->getMPIComm();
+                MPI_Comm_dup(domainComm, &ioComm);
+            }
+            snap->comm = ioComm;
+        }
+    }
+#endif
+    current = snap;
+    return true;
+}
+
+//
+//
+//
+bool AsyncWriter::addData(escript::Data& data, const string name,
+                          const string units)
+{
+    if (!current)
+        return false;
+
+    escript::Data copy(data);
+    // lazy expressions must not be evaluated outside the main thread
+    if (copy.isLazy())
+        copy.resolve();
+    current->data.push_back(copy);
+    current->names.push_back(name);
+    current->units.push_back(units);
+    return true;
+}
+
+//
+//
+//
+void AsyncWriter::setCycleAndTime(int c, double t)
+{
+    if (current) {
+        current->cycle = c;
+        current->time = t;
+    }
+}
+
+//
+//
+//
+void AsyncWriter::setMetadataSchemaString(const string schema,
+                                          const string metadata)
+{
+    if (current) {
+        current->mdSchema = schema;
+        current->mdString = metadata;
+    }
+}
+
+//
+//
+//
+void AsyncWriter::setSaveMeshData(bool flag)
+{
+    if (current)
+        current->wantsMeshVars = flag;
+}
+
+//
+//
+//
+bool AsyncWriter::saveSilo(const string fileName, bool useMultiMesh)
+{
+    if (!current)
+        throw WeipaException("AsyncWriter::saveSilo No data was passed to saveSilo");
+
+    current->fileName = fileName;
+    current->silo = true;
+    current->useMultiMesh = useMultiMesh;
+    submit(current);
+    current.reset();
+    return true;
+}
+
+//
+//
+//
+void AsyncWriter::saveVTK(string fileName, bool binary, bool perRankFiles,
+                          bool doublePrecision, bool compress)
+{
+    if (!current)
+        throw WeipaException("AsyncWriter::saveVTK No data was passed to saveVTK");
+
+    current->fileName = fileName;
+    current->silo = false;
+    current->binary = binary;
+    current->perRankFiles = perRankFiles;
+    current->doublePrecision = doublePrecision;
+    current->compress = compress;
+    submit(current);
+    // the dataset now belongs to the I/O thread and holding on to the Data
+    // copies would make the simulation copy its values unnecessarily
+    current.reset();
+}
+
+//
+//
+//
+void AsyncWriter::wait()
+{
+    {
+        unique_lock<mutex> lock(queueMutex);
+        jobDone.wait(lock, [this] { return numPending == 0; });
+    }
+    releaseFinished();
+    checkError();
+}
+
+//
+//
+//
+int AsyncWriter::getNumPending()
+{
+    lock_guard<mutex> lock(queueMutex);
+    return numPending;
+}
+
+//
+// Hands a dataset to the I/O thread, blocks while too many are pending.
+//
+void AsyncWriter::submit(DatasetSnapshot_ptr job)
+{
+    releaseFinished();
+    checkError();
+
+    if (job->synchronous) {
+        wait();
+        write(job);
+        return;
+    }
+
+    {
+        unique_lock<mutex> lock(queueMutex);
+        jobDone.wait(lock, [this] { return numPending < maxPending; });
+        queue.push_back(job);
+        numPending++;
+    }
+    jobAvailable.notify_one();
+    releaseFinished();
+}
+
+//
+// Main loop of the I/O thread.
+//
+void AsyncWriter::run()
+{
+    unique_lock<mutex> lock(queueMutex);
+    while (true) {
+        jobAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+        // pending datasets are written before stopping
+        if (queue.empty())
+            break;
+        DatasetSnapshot_ptr job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        string msg;
+        try {
+            write(job);
+        } catch (const exception& e) {
+            msg = e.what();
+        } catch (...) {
+            msg = "Unknown error while writing " + job->fileName;
+        }
+
+        lock.lock();
+        if (!msg.empty() && error.empty())
+            error = msg;
+        // the Data copies and the domain reference are released by the
+        // main thread so destructors never run here
+        finished.push_back(job);
+        job.reset();
+        numPending--;
+        jobDone.notify_all();
+    }
+}
+
+//
+//
+//
+void AsyncWriter::releaseFinished()
+{
+    vector<DatasetSnapshot_ptr> done;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        done.swap(finished);
+    }
+}
+
+//
+// Rethrows the first error reported by the I/O thread.
+//
+void AsyncWriter::checkError()
+{
+    string msg;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        msg.swap(error);
+    }
+    if (!msg.empty())
+        throw WeipaException("AsyncWriter: " + msg);
+}
+
+//
+// Converts and writes a dataset. Runs on the I/O thread unless the dataset
+// is synchronous.
+//
+void AsyncWriter::write(DatasetSnapshot_ptr job)
+{
+#if WEIPA_HAVE_MPI
+    EscriptDataset_ptr dataset(job->comm == MPI_COMM_NULL ?
+            new EscriptDataset() : new EscriptDataset(job->comm));
+#else
+    EscriptDataset_ptr dataset(new EscriptDataset());
+#endif
+    if (!dataset->setDomain(job->domain.get()))
+        throw WeipaException("Error initializing domain for " + job->fileName);
+
+    for (size_t i = 0; i < job->data.size(); i++) {
+        dataset->addData(job->data[i], job->names[i], job->units[i]);
+    }
+    dataset->setCycleAndTime(job->cycle, job->time);
+    dataset->setMetadataSchemaString(job->mdSchema, job->mdString);
+    dataset->setSaveMeshData(job->wantsMeshVars);
+
+    if (job->silo) {
+        if (!dataset->saveSilo(job->fileName, job->useMultiMesh))
+            throw WeipaException("Error writing " + job->fileName);
+    } else {
+        dataset->saveVTK(job->fileName, job->binary, job->perRankFiles,
+                         job->doublePrecision, job->compress);
+    }
+}
+
+} // namespace weipa
+
@@ -0,0 +1,126 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2020 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014-2017 by Centre for Geoscience Computing (GeoComp)
+* Development from 2019 by School of Earth and Environmental Sciences
+**
+*****************************************************************************/
+
+#ifndef __WEIPA_ASYNCWRITER_H__
+#define __WEIPA_ASYNCWRITER_H__
+
+#include <weipa/weipa.h>
+
+#include <escript/AbstractDomain.h>
+#include <escript/Data.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace weipa {
+
+struct DatasetSnapshot;
+typedef boost::shared_ptr<DatasetSnapshot> DatasetSnapshot_ptr;
+
+/// \brief Writes escript datasets in a background thread.
+///
+/// This class has the same interface as EscriptDataset for setting up a
+/// dataset but instead of converting the data immediately it only keeps
+/// copies of the escript::Data objects. Since Data is copy-on-write this is
+/// cheap and the values seen by the writer do not change when the
+/// simulation continues to update its Data objects.
+/// saveSilo() and saveVTK() queue the dataset and return immediately, the
+/// conversion and file output are done by a dedicated I/O thread.
+///
+/// At most `maxPending` datasets are queued or being written at any time,
+/// saving another dataset blocks until one of them has been completed.
+/// Errors from the I/O thread are reported by the next call to wait(),
+/// saveSilo() or saveVTK().
+///
+/// \note The domain must not be modified (e.g. rebalanced) while datasets
+///       on it are pending, call wait() first.
+/// \note With more than one MPI rank the I/O thread uses a duplicate of the
+///       domain communicator. This requires MPI_THREAD_MULTIPLE, otherwise
+///       datasets are written synchronously.
+class WEIPA_DLL_API AsyncWriter
+{
+public:
+    /// \brief Constructor with the maximum number of pending datasets.
+    AsyncWriter(int maxPending=2);
+
+    /// \brief Destructor. Waits for all pending datasets to be written.
+    ~AsyncWriter();
+
+    /// \brief Starts a new dataset on the given escript domain.
+    bool setDomain(const escript::AbstractDomain* domain);
+
+    /// \brief Adds a copy of an escript data instance to the current dataset.
+    bool addData(escript::Data& data, const std::string name,
+                 const std::string units = "");
+
+    /// \brief Sets the cycle number and time value for the current dataset.
+    void setCycleAndTime(int c, double t);
+
+    /// \brief Sets a metadata schema and content for the current dataset.
+    void setMetadataSchemaString(const std::string schema,
+                                 const std::string metadata);
+
+    /// \brief Enables/Disables saving of mesh-related data.
+    void setSaveMeshData(bool flag);
+
+    /// \brief Queues the current dataset for saving in the Silo file format.
+    bool saveSilo(const std::string fileName, bool useMultiMesh=true);
+
+    /// \brief Queues the current dataset for saving in the VTK XML file
+    ///        format. See EscriptDataset::saveVTK() for the options.
+    void saveVTK(std::string fileName, bool binary=false,
+                 bool perRankFiles=false, bool doublePrecision=false,
+                 bool compress=false);
+
+    /// \brief Blocks until all pending datasets have been written.
+    ///
+    /// Throws a WeipaException if writing any of them failed.
+    void wait();
+
+    /// \brief Returns the number of datasets queued or being written.
+    int getNumPending();
+
+private:
+    void submit(DatasetSnapshot_ptr job);
+    void run();
+    void releaseFinished();
+    void checkError();
+    static void write(DatasetSnapshot_ptr job);
+
+    int maxPending;
+    DatasetSnapshot_ptr current;
+    std::deque<DatasetSnapshot_ptr> queue;
+    std::vector<DatasetSnapshot_ptr> finished;
+    int numPending;
+    bool stopping;
+    std::string error;
+    std::mutex queueMutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobDone;
+    std::thread worker;
+#if WEIPA_HAVE_MPI
+    MPI_Comm domainComm;
+    MPI_Comm ioComm;
+#endif
+};
+
+} // namespace weipa
+
+#endif // __WEIPA_ASYNCWRITER_H__
+
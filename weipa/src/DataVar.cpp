@@ -37,6 +37,7 @@
 #include <silo.h>
 #endif
 
+#include <algorithm> // for min
 #include <numeric> // for accumulate
 #include <iostream> // for cerr
 #include <sstream>
@@ -684,6 +685,57 @@ void DataVar::writeToVTK(ostream& os, int ownIndex)
     }
 }
 
+//
+//
+//
+void DataVar::getValuesVTK(FloatVec& values, int ownIndex)
+{
+    if (numSamples == 0)
+        return;
+
+    const int numComps = (rank == 0 ? 1 : (rank == 1 ? 3 : 9));
+    IntVec indices;
+    if (isNodeCentered()) {
+        // see writeToVTK() for why the node order is used here
+        const IntVec& requiredIDs = domain->getNodes()->getNodeIDs();
+        const IntVec& nodeGNI = domain->getNodes()->getGlobalNodeIndices();
+        const IntVec& nodeDist = domain->getNodes()->getNodeDistribution();
+        IndexMap sampleID2idx = buildIndexMap();
+        for (size_t i=0; i<nodeGNI.size(); i++) {
+            if (ownIndex < 0 || (nodeDist[ownIndex] <= nodeGNI[i] &&
+                                 nodeGNI[i] < nodeDist[ownIndex+1])) {
+                IndexMap::const_iterator it = sampleID2idx.find(requiredIDs[i]);
+                indices.push_back(it==sampleID2idx.end() ? -1 : (int)it->second);
+            }
+        }
+    } else {
+        int toWrite = domain->getElementsByName(meshName)->getNumElements();
+        for (int i=0; i<toWrite; i++)
+            indices.push_back(i);
+    }
+
+    // vectors are padded to 3 and tensors to 3x3 components with zeros,
+    // missing samples are written as zeros
+    size_t pos = values.size();
+    values.resize(pos + indices.size()*numComps, 0.f);
+    for (size_t i=0; i<indices.size(); i++, pos+=numComps) {
+        const int idx = indices[i];
+        if (idx < 0)
+            continue;
+        if (rank == 0) {
+            values[pos] = dataArray[0][idx];
+        } else if (rank == 1) {
+            for (int c=0; c<std::min(shape[0], 3); c++)
+                values[pos+c] = dataArray[c][idx];
+        } else {
+            const int d = std::min(shape[1], 3);
+            for (int r=0; r<d; r++)
+                for (int c=0; c<d; c++)
+                    values[pos+3*r+c] = dataArray[r*d+c][idx];
+        }
+    }
+}
+
 ///////////////////////////////
 // SILO related methods follow
 ///////////////////////////////
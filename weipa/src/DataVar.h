@@ -72,6 +72,13 @@ public:
     /// \brief Writes the data values to ostream in VTK text format.
     void writeToVTK(std::ostream& os, int ownIndex);
 
+    /// \brief Appends the data values in VTK order to `values`, i.e. one,
+    ///        three or nine components per sample depending on the rank.
+    ///
+    /// Node centered data is restricted to the nodes owned by ownIndex
+    /// unless ownIndex is negative in which case all local nodes are used.
+    void getValuesVTK(FloatVec& values, int ownIndex);
+
     /// \brief Returns the rank of the data.
     int getRank() const { return rank; }
 
@@ -49,11 +49,20 @@
 using escript::FileWriter;
 #endif
 
+#include <cstdint>
 #include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <numeric> // for std::accumulate
 #include <sstream> // for std::ostringstream
 
+#ifdef ESYS_HAVE_BOOST_IO
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#endif
+
 #if ESYS_HAVE_SILO
 #include <silo.h>
 
@@ -70,6 +79,125 @@ namespace weipa {
 
 const char* MESH_VARS = "mesh_vars/";
 
+namespace {
+
+/// one DataArray of a binary VTK file with the local values
+struct VTKArray
+{
+    VTKArray(const string& n, const char* t, int c) :
+        name(n), type(t), numComps(c) {}
+    string name;
+    const char* type;
+    int numComps;
+    vector<char> data;
+};
+
+typedef vector<VTKArray> VTKArrays;
+
+/// appends n values converted to type T to the raw bytes in out
+template<typename T, typename S>
+void appendValues(vector<char>& out, const S* values, size_t n)
+{
+    const size_t pos = out.size();
+    out.resize(pos + n*sizeof(T));
+    T* dest = reinterpret_cast<T*>(out.data()+pos);
+    for (size_t i=0; i<n; i++)
+        dest[i] = static_cast<T>(values[i]);
+}
+
+void appendFloats(vector<char>& out, const FloatVec& values,
+                  bool doublePrecision)
+{
+    if (doublePrecision)
+        appendValues<double>(out, values.data(), values.size());
+    else
+        appendValues<float>(out, values.data(), values.size());
+}
+
+/// appends the coordinates of the nodes owned by ownIndex (all nodes if
+/// ownIndex is negative) as x,y,z triples
+void appendCoordinatesVTK(vector<char>& out, NodeData_ptr nodes, int ownIndex,
+                          bool doublePrecision)
+{
+    const int numNodes = nodes->getNumNodes();
+    const int numDims = nodes->getNumDims();
+    const CoordArray& coords = nodes->getCoords();
+    const IntVec& nodeGNI = nodes->getGlobalNodeIndices();
+    const IntVec& nodeDist = nodes->getNodeDistribution();
+    FloatVec xyz;
+    xyz.reserve(3*numNodes);
+    for (int i=0; i<numNodes; i++) {
+        if (ownIndex < 0 || (nodeDist[ownIndex] <= nodeGNI[i] &&
+                             nodeGNI[i] < nodeDist[ownIndex+1])) {
+            xyz.push_back(coords[0][i]);
+            xyz.push_back(coords[1][i]);
+            xyz.push_back(numDims == 3 ? coords[2][i] : 0.f);
+        }
+    }
+    appendFloats(out, xyz, doublePrecision);
+}
+
+/// returns the DataArray element for an appended array at offset
+string getVTKArrayXML(const VTKArray& array, size_t offset)
+{
+    ostringstream oss;
+    oss << "<DataArray";
+    if (!array.name.empty())
+        oss << " Name=\"" << array.name << "\"";
+    oss << " type=\"" << array.type << "\" NumberOfComponents=\""
+        << array.numComps << "\" format=\"appended\" offset=\"" << offset
+        << "\"/>" << endl;
+    return oss.str();
+}
+
+/// encodes a block of appended data. Without compression the data is
+/// preceded by its size, otherwise it is split into zlib compressed blocks
+/// following the layout of vtkZLibDataCompressor.
+vector<char> encodeVTKBlock(const vector<char>& data, bool compress)
+{
+    vector<char> block;
+    if (!compress) {
+        const uint64_t size = data.size();
+        appendValues<char>(block, reinterpret_cast<const char*>(&size), sizeof(size));
+        block.insert(block.end(), data.begin(), data.end());
+        return block;
+    }
+#ifdef ESYS_HAVE_BOOST_IO
+    const uint64_t blockSize = 65536;
+    const uint64_t numBlocks = (data.size()+blockSize-1)/blockSize;
+    vector<uint64_t> header(3+numBlocks);
+    header[0] = numBlocks;
+    header[1] = blockSize;
+    header[2] = data.size() % blockSize;
+    vector<char> compressed;
+    for (uint64_t b=0; b<numBlocks; b++) {
+        const size_t start = b*blockSize;
+        const size_t size = min<size_t>(blockSize, data.size()-start);
+        const size_t before = compressed.size();
+        {
+            boost::iostreams::filtering_ostream os;
+            os.push(boost::iostreams::zlib_compressor());
+            os.push(boost::iostreams::back_inserter(compressed));
+            os.write(&data[start], size);
+        }
+        header[3+b] = compressed.size()-before;
+    }
+    appendValues<char>(block, reinterpret_cast<const char*>(header.data()),
+                       header.size()*sizeof(uint64_t));
+    block.insert(block.end(), compressed.begin(), compressed.end());
+#endif
+    return block;
+}
+
+/// returns the file name without directory
+string getBaseName(const string& fileName)
+{
+    const size_t pos = fileName.find_last_of("/\\");
+    return (pos == string::npos ? fileName : fileName.substr(pos+1));
+}
+
+} // anonymous namespace
+
 //
 // Default constructor
 //
@@ -77,6 +205,7 @@ EscriptDataset::EscriptDataset() :
     cycle(0),
     time(0.),
     externalDomain(false),
+    externalComm(false),
     wantsMeshVars(false),
     mpiRank(0),
     mpiSize(1)
@@ -91,6 +220,7 @@ EscriptDataset::EscriptDataset(MPI_Comm comm) :
     cycle(0),
     time(0.),
     externalDomain(false),
+    externalComm(true),
     wantsMeshVars(false),
     mpiComm(comm)
 {
@@ -123,9 +253,12 @@ bool EscriptDataset::setDomain(const escript::AbstractDomain* domain)
         myError = 1;
     } else {
 #if WEIPA_HAVE_MPI
-        mpiComm = domain->getMPIComm();
-        mpiRank = domain->getMPIRank();
-        mpiSize = domain->getMPISize();
+        // a communicator passed to the constructor takes precedence
+        if (!externalComm) {
+            mpiComm = domain->getMPIComm();
+            mpiRank = domain->getMPIRank();
+            mpiSize = domain->getMPISize();
+        }
 #endif
 
         // this is here to allow using 'else if' for all selectively compiled
@@ -485,8 +618,16 @@ bool EscriptDataset::saveSilo(string fileName, bool useMultiMesh)
 //
 //
 //
-void EscriptDataset::saveVTK(string fileName)
+void EscriptDataset::saveVTK(string fileName, bool binary, bool perRankFiles,
+                             bool doublePrecision, bool compress)
 {
+    if (compress && !perRankFiles)
+        throw WeipaException("EscriptDataset::saveVTK Compression requires one file per rank");
+#ifndef ESYS_HAVE_BOOST_IO
+    if (compress)
+        throw WeipaException("EscriptDataset::saveVTK escript was built without compression support");
+#endif
+
     if (domainChunks.size() == 0)
         throw WeipaException("EscriptDataset::saveVTK No data was passed to saveVTK");
 
@@ -529,24 +670,38 @@ void EscriptDataset::saveVTK(string fileName)
         }
     }
 
-    if (fileName.length() < 5 || fileName.compare(fileName.length()-4, 4, ".vtu") != 0) {
-        fileName+=".vtu";
+    // pieces are indexed by a .pvtu file
+    const string ext(perRankFiles ? ".pvtu" : ".vtu");
+    if (perRankFiles && fileName.length() > 4 &&
+            fileName.compare(fileName.length()-4, 4, ".vtu") == 0) {
+        fileName = fileName.substr(0, fileName.length()-4);
+    }
+    if (fileName.length() < ext.length()+1 || fileName.compare(fileName.length()-ext.length(), ext.length(), ext) != 0) {
+        fileName+=ext;
     }
 
     if (varsPerMesh.empty()) {
         // no valid variables so just write default mesh
-        saveVTKsingle(fileName, "Elements", VarVector());
-    } else {
-        // write one file per required mesh
-        string newName(fileName);
-        string filePrefix(fileName.substr(0, fileName.length()-4));
-        bool prependMeshName=(varsPerMesh.size()>1);
-        map<string,VarVector>::const_iterator vpmIt;
-        for (vpmIt=varsPerMesh.begin(); vpmIt!=varsPerMesh.end(); vpmIt++) {
-            if (prependMeshName) {
-                newName=filePrefix+"_"+vpmIt->first+".vtu";
-            }
-            // attempt to write all files even if one fails
+        varsPerMesh["Elements"] = VarVector();
+    }
+
+    // write one file per required mesh
+    string newName(fileName);
+    string filePrefix(fileName.substr(0, fileName.length()-ext.length()));
+    bool prependMeshName=(varsPerMesh.size()>1);
+    map<string,VarVector>::const_iterator vpmIt;
+    for (vpmIt=varsPerMesh.begin(); vpmIt!=varsPerMesh.end(); vpmIt++) {
+        if (prependMeshName) {
+            newName=filePrefix+"_"+vpmIt->first+ext;
+        }
+        // attempt to write all files even if one fails
+        if (perRankFiles) {
+            saveVTKpieces(newName, vpmIt->first, vpmIt->second,
+                          doublePrecision, compress);
+        } else if (binary) {
+            saveVTKsingleBinary(newName, vpmIt->first, vpmIt->second,
+                                doublePrecision);
+        } else {
             saveVTKsingle(newName, vpmIt->first, vpmIt->second);
         }
     }
@@ -579,12 +734,10 @@ void EscriptDataset::setMeshUnits(const string x, const string y, const string z
 //
 //
 //
-void EscriptDataset::saveVTKsingle(const string& fileName,
-                                   const string& meshName,
-                                   const VarVector& vars)
+void EscriptDataset::getVTKVariables(const string& meshName,
+                                     const VarVector& vars,
+                                     VarVector& nodalVars, VarVector& cellVars)
 {
-#ifndef VISIT_PLUGIN
-    VarVector nodalVars, cellVars;
     VarVector::const_iterator viIt;
     for (viIt = vars.begin(); viIt != vars.end(); viIt++) {
         const DataChunks& varChunks = viIt->dataChunks;
@@ -610,6 +763,19 @@ void EscriptDataset::saveVTKsingle(const string& fileName,
             }
         }
     }
+}
+
+//
+//
+//
+void EscriptDataset::saveVTKsingle(const string& fileName,
+                                   const string& meshName,
+                                   const VarVector& vars)
+{
+#ifndef VISIT_PLUGIN
+    VarVector nodalVars, cellVars;
+    VarVector::const_iterator viIt;
+    getVTKVariables(meshName, vars, nodalVars, cellVars);
 
     DomainChunks::iterator domIt;
     int gNumPoints;
@@ -831,6 +997,402 @@ void EscriptDataset::writeVarToVTK(const VarInfo& varInfo, ostream& os)
     }
 }
 
+//
+// Returns the opening of a VTK XML file including meta data
+//
+string EscriptDataset::getVTKFileHeader(const char* type, bool compress) const
+{
+    const int one = 1;
+    const bool littleEndian = (*reinterpret_cast<const char*>(&one) == 1);
+    ostringstream oss;
+    oss << "<?xml version=\"1.0\"?>" << endl;
+    oss << "<VTKFile type=\"" << type << "\" version=\"1.0\" byte_order=\""
+        << (littleEndian ? "LittleEndian" : "BigEndian")
+        << "\" header_type=\"UInt64\"";
+    if (compress) {
+        oss << " compressor=\"vtkZLibDataCompressor\"";
+    }
+    if (mdSchema.length()>0) {
+        oss << " " << mdSchema;
+    }
+    oss << ">" << endl;
+    if (mdString.length()>0) {
+        oss << "<MetaData>" << endl << mdString << endl
+            << "</MetaData>" << endl;
+    }
+    return oss.str();
+}
+
+//
+// Writes one VTK file with appended binary data. Every rank writes its
+// portion of each array at offsets computed from the local array sizes.
+//
+void EscriptDataset::saveVTKsingleBinary(const string& fileName,
+                                         const string& meshName,
+                                         const VarVector& vars,
+                                         bool doublePrecision)
+{
+#ifndef VISIT_PLUGIN
+    VarVector nodalVars, cellVars;
+    VarVector::const_iterator viIt;
+    getVTKVariables(meshName, vars, nodalVars, cellVars);
+
+    const char* floatType = (doublePrecision ? "Float64" : "Float32");
+    const bool parallel = (mpiSize > 1);
+
+    if (parallel) {
+        domainChunks[0]->removeGhostZones(mpiRank);
+    } else if (domainChunks.size() > 1) {
+        for (size_t idx = 0; idx < domainChunks.size(); idx++)
+            domainChunks[idx]->removeGhostZones(idx);
+    }
+
+    // collect local values of coordinates, connectivity and variables
+    VTKArrays arrays;
+    arrays.push_back(VTKArray("", floatType, 3));
+    arrays.push_back(VTKArray("connectivity", "Int32", 1));
+    int myNumCells = 0;
+    int cellSizeAndType[2] = { 0, 0 };
+    int blockNum = (parallel ? mpiRank : 0);
+    DomainChunks::iterator domIt;
+    for (domIt = domainChunks.begin(); domIt != domainChunks.end(); domIt++, blockNum++) {
+        appendCoordinatesVTK(arrays[0].data, (*domIt)->getNodes(), blockNum,
+                             doublePrecision);
+        ElementData_ptr el = (*domIt)->getElementsByName(meshName);
+        if (el) {
+            const IntVec& gNI = el->getNodes()->getGlobalNodeIndices();
+            const IntVec& nodeList = el->getNodeList();
+            IntVec conn(el->getNumElements()*el->getNodesPerElement());
+            for (size_t i=0; i<conn.size(); i++)
+                conn[i] = gNI[nodeList[i]];
+            appendValues<int32_t>(arrays[1].data, conn.data(), conn.size());
+            myNumCells += el->getNumElements();
+            if (cellSizeAndType[0] == 0) {
+                cellSizeAndType[0] = el->getNodesPerElement();
+                cellSizeAndType[1] = el->getType();
+            }
+        }
+    }
+
+    // cell offsets continue across ranks so the global cell index is needed
+    int firstCell = 0;
+    int gCellSizeAndType[2] = { cellSizeAndType[0], cellSizeAndType[1] };
+#if WEIPA_HAVE_MPI
+    if (parallel) {
+        MPI_Exscan(&myNumCells, &firstCell, 1, MPI_INT, MPI_SUM, mpiComm);
+        if (mpiRank == 0)
+            firstCell = 0;
+        MPI_Allreduce(cellSizeAndType, gCellSizeAndType, 2, MPI_INT, MPI_MAX,
+                      mpiComm);
+    }
+#endif
+    arrays.push_back(VTKArray("offsets", "Int32", 1));
+    arrays.push_back(VTKArray("types", "UInt8", 1));
+    IntVec offsets(myNumCells);
+    for (int i=0; i<myNumCells; i++)
+        offsets[i] = (firstCell+i+1)*gCellSizeAndType[0];
+    appendValues<int32_t>(arrays[2].data, offsets.data(), offsets.size());
+    arrays[3].data.assign(myNumCells, static_cast<char>(gCellSizeAndType[1]));
+
+    const size_t firstNodalVar = arrays.size();
+    for (int pass=0; pass<2; pass++) {
+        const VarVector& pvars = (pass==0 ? nodalVars : cellVars);
+        for (viIt = pvars.begin(); viIt != pvars.end(); viIt++) {
+            const int rank = viIt->dataChunks[0]->getRank();
+            arrays.push_back(VTKArray(viIt->varName, floatType,
+                                      rank==0 ? 1 : (rank==1 ? 3 : 9)));
+            FloatVec values;
+            blockNum = (parallel ? mpiRank : 0);
+            DataChunks::const_iterator blockIt;
+            for (blockIt = viIt->dataChunks.begin(); blockIt != viIt->dataChunks.end(); blockIt++, blockNum++) {
+                (*blockIt)->getValuesVTK(values, blockNum);
+            }
+            appendFloats(arrays.back().data, values, doublePrecision);
+        }
+    }
+    const size_t firstCellVar = firstNodalVar + nodalVars.size();
+
+    // global array sizes and the position of this rank's values
+    const size_t numArrays = arrays.size();
+    vector<long> mySizes(numArrays), gSizes(numArrays), myOffsets(numArrays, 0);
+    for (size_t i=0; i<numArrays; i++)
+        mySizes[i] = arrays[i].data.size();
+    gSizes = mySizes;
+    int gNumCells = myNumCells;
+#if WEIPA_HAVE_MPI
+    if (parallel) {
+        MPI_Allreduce(&mySizes[0], &gSizes[0], numArrays, MPI_LONG, MPI_SUM,
+                      mpiComm);
+        MPI_Exscan(&mySizes[0], &myOffsets[0], numArrays, MPI_LONG, MPI_SUM,
+                   mpiComm);
+        if (mpiRank == 0)
+            myOffsets.assign(numArrays, 0);
+        MPI_Allreduce(&myNumCells, &gNumCells, 1, MPI_INT, MPI_SUM, mpiComm);
+    }
+#endif
+    const int gNumPoints = gSizes[0] / ((doublePrecision ? sizeof(double) : sizeof(float))*3);
+
+    // every block is preceded by its size
+    vector<long> blockOffsets(numArrays+1, 0);
+    for (size_t i=0; i<numArrays; i++)
+        blockOffsets[i+1] = blockOffsets[i] + sizeof(uint64_t) + gSizes[i];
+
+    ostringstream oss;
+    oss << getVTKFileHeader("UnstructuredGrid", false);
+    oss << "<UnstructuredGrid>" << endl;
+    oss << "<FieldData>" << endl;
+    oss << "<DataArray Name=\"TIME\" type=\"Float64\" format=\"ascii\" NumberOfTuples=\"1\">" << endl;
+    oss.setf(ios_base::scientific, ios_base::floatfield);
+    oss << time << endl;
+    oss << "</DataArray>" << endl;
+    oss << "<DataArray Name=\"CYCLE\" type=\"Int32\" format=\"ascii\" NumberOfTuples=\"1\">" << endl;
+    oss << cycle << endl;
+    oss << "</DataArray>" << endl << "</FieldData>" << endl;
+    oss << "<Piece NumberOfPoints=\"" << gNumPoints
+        << "\" NumberOfCells=\"" << gNumCells << "\">" << endl;
+    oss << "<Points>" << endl << getVTKArrayXML(arrays[0], blockOffsets[0])
+        << "</Points>" << endl;
+    oss << "<Cells>" << endl;
+    for (size_t i=1; i<firstNodalVar; i++)
+        oss << getVTKArrayXML(arrays[i], blockOffsets[i]);
+    oss << "</Cells>" << endl;
+    if (!nodalVars.empty()) {
+        oss << "<PointData>" << endl;
+        for (size_t i=firstNodalVar; i<firstCellVar; i++)
+            oss << getVTKArrayXML(arrays[i], blockOffsets[i]);
+        oss << "</PointData>" << endl;
+    }
+    if (!cellVars.empty()) {
+        oss << "<CellData>" << endl;
+        for (size_t i=firstCellVar; i<numArrays; i++)
+            oss << getVTKArrayXML(arrays[i], blockOffsets[i]);
+        oss << "</CellData>" << endl;
+    }
+    oss << "</Piece>" << endl << "</UnstructuredGrid>" << endl;
+    oss << "<AppendedData encoding=\"raw\">" << endl << "_";
+    const string header(oss.str());
+    const string footer("\n</AppendedData>\n</VTKFile>\n");
+    long dataStart = header.length();
+#if WEIPA_HAVE_MPI
+    // only the header of rank 0 is written
+    if (parallel)
+        MPI_Bcast(&dataStart, 1, MPI_LONG, 0, mpiComm);
+#endif
+
+    boost::scoped_ptr<FileWriter> fw(NULL);
+    if (parallel) {
+#if WEIPA_HAVE_MPI
+        fw.reset(new FileWriter(mpiComm));
+#endif
+    } else {
+        fw.reset(new FileWriter());
+    }
+
+    if (!fw->openFile(fileName, dataStart+blockOffsets[numArrays]+footer.length(), true)) {
+        throw WeipaException("EscriptDataset::saveVTKsingleBinary Could not open file ");
+    }
+
+    bool success = fw->writeAtAll(header.c_str(),
+                                  mpiRank == 0 ? header.length() : 0, 0);
+    for (size_t i=0; i<numArrays; i++) {
+        const long pos = dataStart + blockOffsets[i];
+        if (mpiRank == 0) {
+            // rank 0 writes the block size in front of its values
+            const uint64_t size = gSizes[i];
+            vector<char> block;
+            appendValues<char>(block, reinterpret_cast<const char*>(&size), sizeof(size));
+            block.insert(block.end(), arrays[i].data.begin(), arrays[i].data.end());
+            success = fw->writeAtAll(block.data(), block.size(), pos) && success;
+        } else {
+            success = fw->writeAtAll(arrays[i].data.data(), arrays[i].data.size(),
+                             pos + sizeof(uint64_t) + myOffsets[i]) && success;
+        }
+    }
+    success = fw->writeAtAll(footer.c_str(), mpiRank == 0 ? footer.length() : 0,
+                             dataStart + blockOffsets[numArrays]) && success;
+    if (!success) {
+        cerr << "Warning, ignoring file write error!" << endl;
+    }
+    fw->close();
+#else // VISIT_PLUGIN
+    throw WeipaException("EscriptDataset::saveVTKsingleBinary Escripts was build without VisIt");
+#endif
+}
+
+//
+// Every chunk is written to its own VTK file with appended binary data and
+// rank 0 writes a .pvtu file referencing all pieces. Pieces contain all
+// nodes used by their cells so nodes at the chunk boundaries are repeated.
+//
+void EscriptDataset::saveVTKpieces(const string& fileName,
+                                   const string& meshName,
+                                   const VarVector& vars,
+                                   bool doublePrecision, bool compress)
+{
+#ifndef VISIT_PLUGIN
+    VarVector nodalVars, cellVars;
+    VarVector::const_iterator viIt;
+    getVTKVariables(meshName, vars, nodalVars, cellVars);
+
+    const char* floatType = (doublePrecision ? "Float64" : "Float32");
+    const bool parallel = (mpiSize > 1);
+    const string filePrefix(fileName.substr(0, fileName.length()-5));
+    const int numPieces = (parallel ? mpiSize : domainChunks.size());
+
+    int error = 0;
+    int blockNum = (parallel ? mpiRank : 0);
+    for (size_t chunk = 0; chunk < domainChunks.size(); chunk++, blockNum++) {
+        DomainChunk_ptr dom = domainChunks[chunk];
+        if (numPieces > 1)
+            dom->removeGhostZones(blockNum);
+
+        VTKArrays arrays;
+        arrays.push_back(VTKArray("", floatType, 3));
+        arrays.push_back(VTKArray("connectivity", "Int32", 1));
+        arrays.push_back(VTKArray("offsets", "Int32", 1));
+        arrays.push_back(VTKArray("types", "UInt8", 1));
+        NodeData_ptr nodes = dom->getNodes();
+        appendCoordinatesVTK(arrays[0].data, nodes, -1, doublePrecision);
+        const int numPoints = nodes->getNumNodes();
+        int numCells = 0;
+        ElementData_ptr el = dom->getElementsByName(meshName);
+        if (el) {
+            numCells = el->getNumElements();
+            const int nodesPerElement = el->getNodesPerElement();
+            const IntVec& nodeList = el->getNodeList();
+            IntVec conn(numCells*nodesPerElement);
+            if (el->getNodes() == nodes) {
+                copy(nodeList.begin(), nodeList.begin()+conn.size(), conn.begin());
+            } else {
+                // elements refer to a different node mesh so use the global
+                // node indices to find the points
+                IndexMap gNI2idx;
+                const IntVec& gNI = nodes->getGlobalNodeIndices();
+                for (size_t i=0; i<gNI.size(); i++)
+                    gNI2idx[gNI[i]] = i;
+                const IntVec& elGNI = el->getNodes()->getGlobalNodeIndices();
+                for (size_t i=0; i<conn.size(); i++)
+                    conn[i] = gNI2idx[elGNI[nodeList[i]]];
+            }
+            appendValues<int32_t>(arrays[1].data, conn.data(), conn.size());
+            IntVec offsets(numCells);
+            for (int i=0; i<numCells; i++)
+                offsets[i] = (i+1)*nodesPerElement;
+            appendValues<int32_t>(arrays[2].data, offsets.data(), offsets.size());
+            arrays[3].data.assign(numCells, static_cast<char>(el->getType()));
+        }
+        for (viIt = nodalVars.begin(); viIt != nodalVars.end(); viIt++) {
+            const int rank = viIt->dataChunks[chunk]->getRank();
+            arrays.push_back(VTKArray(viIt->varName, floatType,
+                                      rank==0 ? 1 : (rank==1 ? 3 : 9)));
+            FloatVec values;
+            viIt->dataChunks[chunk]->getValuesVTK(values, -1);
+            appendFloats(arrays.back().data, values, doublePrecision);
+        }
+        for (viIt = cellVars.begin(); viIt != cellVars.end(); viIt++) {
+            const int rank = viIt->dataChunks[chunk]->getRank();
+            arrays.push_back(VTKArray(viIt->varName, floatType,
+                                      rank==0 ? 1 : (rank==1 ? 3 : 9)));
+            FloatVec values;
+            viIt->dataChunks[chunk]->getValuesVTK(values, -1);
+            appendFloats(arrays.back().data, values, doublePrecision);
+        }
+
+        vector<vector<char> > blocks;
+        vector<size_t> blockOffsets(1, 0);
+        for (size_t i=0; i<arrays.size(); i++) {
+            blocks.push_back(encodeVTKBlock(arrays[i].data, compress));
+            blockOffsets.push_back(blockOffsets.back()+blocks.back().size());
+            vector<char>().swap(arrays[i].data);
+        }
+
+        ostringstream oss;
+        oss << getVTKFileHeader("UnstructuredGrid", compress);
+        oss << "<UnstructuredGrid>" << endl;
+        oss << "<FieldData>" << endl;
+        oss << "<DataArray Name=\"TIME\" type=\"Float64\" format=\"ascii\" NumberOfTuples=\"1\">" << endl;
+        oss.setf(ios_base::scientific, ios_base::floatfield);
+        oss << time << endl;
+        oss << "</DataArray>" << endl;
+        oss << "<DataArray Name=\"CYCLE\" type=\"Int32\" format=\"ascii\" NumberOfTuples=\"1\">" << endl;
+        oss << cycle << endl;
+        oss << "</DataArray>" << endl << "</FieldData>" << endl;
+        oss << "<Piece NumberOfPoints=\"" << numPoints
+            << "\" NumberOfCells=\"" << numCells << "\">" << endl;
+        oss << "<Points>" << endl << getVTKArrayXML(arrays[0], blockOffsets[0])
+            << "</Points>" << endl;
+        oss << "<Cells>" << endl;
+        for (size_t i=1; i<4; i++)
+            oss << getVTKArrayXML(arrays[i], blockOffsets[i]);
+        oss << "</Cells>" << endl;
+        size_t i = 4;
+        if (!nodalVars.empty()) {
+            oss << "<PointData>" << endl;
+            for (; i<4+nodalVars.size(); i++)
+                oss << getVTKArrayXML(arrays[i], blockOffsets[i]);
+            oss << "</PointData>" << endl;
+        }
+        if (!cellVars.empty()) {
+            oss << "<CellData>" << endl;
+            for (; i<arrays.size(); i++)
+                oss << getVTKArrayXML(arrays[i], blockOffsets[i]);
+            oss << "</CellData>" << endl;
+        }
+        oss << "</Piece>" << endl << "</UnstructuredGrid>" << endl;
+        oss << "<AppendedData encoding=\"raw\">" << endl << "_";
+
+        ostringstream pieceName;
+        pieceName << filePrefix << "_" << setw(4) << setfill('0') << blockNum
+                  << ".vtu";
+        ofstream ofs(pieceName.str().c_str(), ios_base::out|ios_base::binary);
+        ofs << oss.str();
+        for (size_t b=0; b<blocks.size(); b++)
+            ofs.write(blocks[b].data(), blocks[b].size());
+        ofs << endl << "</AppendedData>" << endl << "</VTKFile>" << endl;
+        if (ofs.fail())
+            error = 1;
+        ofs.close();
+    }
+
+    if (mpiRank == 0) {
+        ostringstream oss;
+        oss << getVTKFileHeader("PUnstructuredGrid", compress);
+        oss << "<PUnstructuredGrid GhostLevel=\"0\">" << endl;
+        oss << "<PPoints>" << endl << "<PDataArray type=\"" << floatType
+            << "\" NumberOfComponents=\"3\"/>" << endl << "</PPoints>" << endl;
+        for (int pass=0; pass<2; pass++) {
+            const VarVector& pvars = (pass==0 ? nodalVars : cellVars);
+            if (pvars.empty())
+                continue;
+            oss << (pass==0 ? "<PPointData>" : "<PCellData>") << endl;
+            for (viIt = pvars.begin(); viIt != pvars.end(); viIt++) {
+                const int rank = viIt->dataChunks[0]->getRank();
+                oss << "<PDataArray Name=\"" << viIt->varName << "\" type=\""
+                    << floatType << "\" NumberOfComponents=\""
+                    << (rank==0 ? 1 : (rank==1 ? 3 : 9)) << "\"/>" << endl;
+            }
+            oss << (pass==0 ? "</PPointData>" : "</PCellData>") << endl;
+        }
+        const string baseName(getBaseName(filePrefix));
+        for (int p=0; p<numPieces; p++) {
+            oss << "<Piece Source=\"" << baseName << "_" << setw(4)
+                << setfill('0') << p << ".vtu\"/>" << endl;
+        }
+        oss << "</PUnstructuredGrid>" << endl << "</VTKFile>" << endl;
+        ofstream ofs(fileName.c_str());
+        ofs << oss.str();
+        if (ofs.fail())
+            error = 1;
+    }
+
+    if (error) {
+        cerr << "Warning, ignoring file write error!" << endl;
+    }
+#else // VISIT_PLUGIN
+    throw WeipaException("EscriptDataset::saveVTKpieces Escripts was build without VisIt");
+#endif
+}
+
 //
 // Sets the domain from dump files.
 //
@@ -67,7 +67,9 @@ public:
     EscriptDataset();
 
 #if WEIPA_HAVE_MPI
-    /// \brief Constructor with communicator.
+    /// \brief Constructor with communicator. The communicator is also used
+    ///        when the dataset is initialised through setDomain() and must
+    ///        then span the same ranks as the domain.
     EscriptDataset(MPI_Comm comm);
 #endif
 
@@ -137,7 +139,18 @@ public:
     bool saveSilo(const std::string fileName, bool useMultiMesh=true);
 
     /// \brief Saves the dataset in the VTK XML file format.
-    void saveVTK(const std::string fileName);
+    ///
+    /// \param binary if true the values are written as raw binary appended
+    ///               data instead of text
+    /// \param perRankFiles if true every rank writes its own binary .vtu
+    ///                     piece and rank 0 writes a .pvtu index file
+    /// \param doublePrecision if true binary values are written as Float64,
+    ///                        otherwise as Float32
+    /// \param compress if true the pieces are zlib compressed. Requires
+    ///                 perRankFiles.
+    void saveVTK(std::string fileName, bool binary=false,
+                 bool perRankFiles=false, bool doublePrecision=false,
+                 bool compress=false);
 
     /// \brief Returns the dataset's converted domain so it can be reused.
     DomainChunks getConvertedDomain() { return domainChunks; }
@@ -167,15 +180,24 @@ private:
     void putSiloMultiTensor(DBfile* dbfile, const VarInfo& vi);
     void putSiloMultiVar(DBfile* dbfile, const VarInfo& vi,
                          bool useMeshFile = false);
+    void getVTKVariables(const std::string& meshName, const VarVector& vars,
+                         VarVector& nodalVars, VarVector& cellVars);
     void saveVTKsingle(const std::string& fileName,
                        const std::string& meshName, const VarVector& vars);
+    void saveVTKsingleBinary(const std::string& fileName,
+                             const std::string& meshName,
+                             const VarVector& vars, bool doublePrecision);
+    void saveVTKpieces(const std::string& fileName,
+                       const std::string& meshName, const VarVector& vars,
+                       bool doublePrecision, bool compress);
+    std::string getVTKFileHeader(const char* type, bool compress) const;
     void writeVarToVTK(const VarInfo& varInfo, std::ostream& os);
 
     int cycle;
     double time;
     std::string mdSchema, mdString;
     StringVec meshLabels, meshUnits;
-    bool externalDomain, wantsMeshVars;
+    bool externalDomain, externalComm, wantsMeshVars;
     DomainChunks domainChunks;
     VarVector variables, meshVariables;
     int mpiRank, mpiSize;
@@ -17,6 +17,7 @@
 
 #include <escript/Data.h>
 
+#include <weipa/AsyncWriter.h>
 #include <weipa/EscriptDataset.h>
 #include <weipa/VisItControl.h>
 
@@ -44,7 +45,18 @@ BOOST_PYTHON_MODULE(weipacpp)
         .def("setMetadataSchemaString", &weipa::EscriptDataset::setMetadataSchemaString, (arg("schema")="", arg("metadata")=""))
         .def("setSaveMeshData", &weipa::EscriptDataset::setSaveMeshData)
         .def("saveSilo", &weipa::EscriptDataset::saveSilo, (arg("filename"), arg("useMultimesh")=true))
-        .def("saveVTK", &weipa::EscriptDataset::saveVTK, args("filename"));
+        .def("saveVTK", &weipa::EscriptDataset::saveVTK, (arg("filename"), arg("binary")=false, arg("pvtu")=false, arg("double_precision")=false, arg("compress")=false));
+
+    class_<weipa::AsyncWriter, boost::noncopyable>("AsyncWriter","Writes escript datasets in a background thread. It provides the dataset interface of EscriptDataset but saveSilo and saveVTK only queue a copy-on-write snapshot of the data and return immediately. At most max_pending datasets are queued or being written at any time.", init<int>((arg("max_pending")=2)))
+        .def("setDomain", &weipa::AsyncWriter::setDomain)
+        .def("addData", &weipa::AsyncWriter::addData, (arg("data"), arg("name"), arg("units")=""))
+        .def("setCycleAndTime", &weipa::AsyncWriter::setCycleAndTime, args("cycle","time"))
+        .def("setMetadataSchemaString", &weipa::AsyncWriter::setMetadataSchemaString, (arg("schema")="", arg("metadata")=""))
+        .def("setSaveMeshData", &weipa::AsyncWriter::setSaveMeshData)
+        .def("saveSilo", &weipa::AsyncWriter::saveSilo, (arg("filename"), arg("useMultimesh")=true))
+        .def("saveVTK", &weipa::AsyncWriter::saveVTK, (arg("filename"), arg("binary")=false, arg("pvtu")=false, arg("double_precision")=false, arg("compress")=false))
+        .def("wait", &weipa::AsyncWriter::wait, "Blocks until all queued datasets have been written. Raises an exception if writing any of them failed.")
+        .def("getNumPending", &weipa::AsyncWriter::getNumPending, "Returns the number of datasets queued or being written.");
 
     // VisIt Control
     def("visitInitialize", weipa::VisItControl::initialize, (arg("simFile"), arg("comment")=""));
@@ -23,7 +23,7 @@ __license__="""Licensed under the Apache License, version 2.0
 http://www.apache.org/licenses/LICENSE-2.0"""
 __url__="https://launchpad.net/escript-finley"
 
-import os, math
+import os, math, struct, zlib
 import esys.escriptcore.utestselect as unittest
 from esys.escriptcore.testing import *
 from xml.dom import minidom
@@ -31,8 +31,8 @@ from esys.escript import ContinuousFunction, Function, ReducedFunction,\
             FunctionOnBoundary, ReducedFunctionOnBoundary,\
             FunctionOnContactZero, ReducedFunctionOnContactZero,\
             FunctionOnContactOne, ReducedFunctionOnContactOne,\
-            Solution, ReducedSolution, getMPISizeWorld
-from esys.weipa import saveVTK
+            Solution, ReducedSolution, getMPISizeWorld, hasFeature
+from esys.weipa import saveVTK, AsyncWriter
 
 try:
     from esys import dudley
@@ -67,9 +67,46 @@ class VTKParser():
     def __init__(self):
         self.doc=None
 
+    def decodeAppendedData(self, raw):
+        """
+        Converts the appended (raw or zlib compressed) data arrays of a VTK
+        file to inline ascii arrays and returns the resulting XML.
+        """
+        pos=raw.find(b'<AppendedData')
+        start=raw.index(b'_', pos)+1
+        doc=minidom.parseString(raw[:pos]+b'</VTKFile>')
+        root=doc.documentElement
+        order='<' if root.getAttribute('byte_order')=='LittleEndian' else '>'
+        compressed=(root.getAttribute('compressor')=='vtkZLibDataCompressor')
+        fmt={'Float32':'f', 'Float64':'d', 'Int32':'i', 'UInt8':'B'}
+        for d in doc.getElementsByTagName('DataArray'):
+            if d.getAttribute('format')!='appended':
+                continue
+            offset=start+int(d.getAttribute('offset'))
+            if compressed:
+                nBlocks=struct.unpack_from(order+'Q', raw, offset)[0]
+                header=struct.unpack_from(order+'%dQ'%(3+nBlocks), raw, offset)
+                offset+=8*(3+nBlocks)
+                data=b''
+                for size in header[3:]:
+                    data+=zlib.decompress(raw[offset:offset+size])
+                    offset+=size
+            else:
+                size=struct.unpack_from(order+'Q', raw, offset)[0]
+                data=raw[offset+8:offset+8+size]
+            t=fmt[d.getAttribute('type')]
+            values=struct.unpack(order+'%d%s'%(len(data)//struct.calcsize(t), t), data)
+            d.setAttribute('format', 'ascii')
+            d.appendChild(doc.createTextNode(' '.join(map(repr, values))))
+        return doc.toxml()
+
     def parse(self, filename):
         # load file and remove superfluous whitespace
-        dom=minidom.parse(filename)
+        raw=open(filename, 'rb').read()
+        if raw.find(b'<AppendedData')>=0:
+            dom=minidom.parseString(self.decodeAppendedData(raw))
+        else:
+            dom=minidom.parseString(raw)
         dom=minidom.parseString(dom.toxml()
                 .replace('>\n','>').replace('\n<','<').replace('\n',' '))
         self.doc = dom.documentElement
@@ -275,17 +312,19 @@ class Test_VTKSaver(unittest.TestCase):
                     cdata1[name], cdata2[name], elementMap1to2),
                     "Cell data in '%s' does not match" % name)
 
-    def check_vtk(self, reference, fspaces=[], **data):
+    def check_vtk(self, reference, fspaces=[], vtkargs={}, **data):
         outFileBase="out_"+reference
-        saveVTK(os.path.join(WEIPA_WORKDIR, outFileBase), write_meshdata=True, **data)
+        saveVTK(os.path.join(WEIPA_WORKDIR, outFileBase), write_meshdata=True, **dict(vtkargs, **data))
+        # with one rank the only piece contains the full mesh
+        suffix="_0000.vtu" if vtkargs.get('pvtu', False) else ".vtu"
         if len(fspaces)>0:
             for fs in fspaces:
                 ref=os.path.join(WEIPA_TEST_MESHES, reference+"_"+fs+".vtu")
-                out=os.path.join(WEIPA_WORKDIR, outFileBase+"_"+fs+".vtu")
+                out=os.path.join(WEIPA_WORKDIR, outFileBase+"_"+fs+suffix)
                 self.compareVTKfiles(out, ref)
         else:
             ref=os.path.join(WEIPA_TEST_MESHES, reference+".vtu")
-            out=os.path.join(WEIPA_WORKDIR, outFileBase+".vtu")
+            out=os.path.join(WEIPA_WORKDIR, outFileBase+suffix)
             self.compareVTKfiles(out, ref)
 
 
@@ -607,6 +646,66 @@ class Test_Finley_SaveVTK(Test_VTKSaver):
                     data_vc=x_c[0]*[1.,2.],
                     data_tc=x_c[0]*[[11.,12.],[21.,22.]])
 
+  def test_hex_2D_order2_CellsPoints_AllData_binary(self):
+     dom=finley.ReadMesh(os.path.join(WEIPA_TEST_MESHES,"hex_2D_order2.msh"),optimize=False)
+     x_c=Function(dom).getX()
+     x_p=ContinuousFunction(dom).getX()
+     for dp in (False, True):
+        self.check_vtk("hex_2D_o2_cellnode_all", ['Elements','ReducedElements'],
+                    vtkargs=dict(binary=True, double_precision=dp),
+                    data_sp=x_p[0],
+                    data_vp=x_p[0]*[1.,2.],
+                    data_tp=x_p[0]*[[11.,12.],[21.,22.]],
+                    data_sc=x_c[0],
+                    data_vc=x_c[0]*[1.,2.],
+                    data_tc=x_c[0]*[[11.,12.],[21.,22.]])
+
+  @unittest.skipIf(getMPISizeWorld()>1, "Pieces can only be compared to the reference on one rank")
+  def test_hex_2D_order2_CellsPoints_AllData_pvtu(self):
+     dom=finley.ReadMesh(os.path.join(WEIPA_TEST_MESHES,"hex_2D_order2.msh"),optimize=False)
+     x_c=Function(dom).getX()
+     x_p=ContinuousFunction(dom).getX()
+     args=[dict(pvtu=True)]
+     if hasFeature('unzip'):
+        args.append(dict(pvtu=True, compress=True))
+     for a in args:
+        self.check_vtk("hex_2D_o2_cellnode_all", ['Elements','ReducedElements'],
+                    vtkargs=a,
+                    data_sp=x_p[0],
+                    data_vp=x_p[0]*[1.,2.],
+                    data_tp=x_p[0]*[[11.,12.],[21.,22.]],
+                    data_sc=x_c[0],
+                    data_vc=x_c[0]*[1.,2.],
+                    data_tc=x_c[0]*[[11.,12.],[21.,22.]])
+        index=minidom.parse(os.path.join(WEIPA_WORKDIR, "out_hex_2D_o2_cellnode_all_Elements.pvtu"))
+        pieces=index.getElementsByTagName('Piece')
+        self.assertEqual(len(pieces), 1)
+        self.assertEqual(pieces[0].getAttribute('Source'), "out_hex_2D_o2_cellnode_all_Elements_0000.vtu")
+
+  def test_hex_2D_order2_CellsPoints_AllData_async(self):
+     dom=finley.ReadMesh(os.path.join(WEIPA_TEST_MESHES,"hex_2D_order2.msh"),optimize=False)
+     x_c=Function(dom).getX()
+     x_p=ContinuousFunction(dom).getX()
+     data_sp=x_p[0]*1.
+     writer=AsyncWriter(max_pending=1)
+     outFileBase="out_hex_2D_o2_cellnode_all_async"
+     saveVTK(os.path.join(WEIPA_WORKDIR, outFileBase), write_meshdata=True,
+             writer=writer,
+             data_sp=data_sp,
+             data_vp=x_p[0]*[1.,2.],
+             data_tp=x_p[0]*[[11.,12.],[21.,22.]],
+             data_sc=x_c[0],
+             data_vc=x_c[0]*[1.,2.],
+             data_tc=x_c[0]*[[11.,12.],[21.,22.]])
+     # the queued snapshot must not see changes made after saving
+     data_sp+=1.
+     writer.wait()
+     self.assertEqual(writer.getNumPending(), 0)
+     for fs in ['Elements','ReducedElements']:
+        ref=os.path.join(WEIPA_TEST_MESHES, "hex_2D_o2_cellnode_all_"+fs+".vtu")
+        out=os.path.join(WEIPA_WORKDIR, outFileBase+"_"+fs+".vtu")
+        self.compareVTKfiles(out, ref)
+
   # === Finley hex 2D order 2 (full) ==========================================
 
   def test_hex_2D_order2p_empty(self):